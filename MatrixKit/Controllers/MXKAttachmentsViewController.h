@@ -19,6 +19,7 @@ limitations under the License.
 #import "MXKViewController.h"
 #import "MXKAttachment.h"
 #import "MXKAttachmentAnimator.h"
+#import "MXKAttachmentPrefetcher.h"
 
 @protocol MXKAttachmentsViewControllerDelegate;
 
@@ -47,6 +48,12 @@ limitations under the License.
  */
 @property (nonatomic, weak) id<MXKAttachmentsViewControllerDelegate> delegate;
 
+/**
+ The prefetcher which prepares the images next to the displayed one in the swipe direction.
+ Its metrics tell how often a swipe lands on an image which is ready to be displayed.
+ */
+@property (nonatomic, readonly) MXKAttachmentPrefetcher *attachmentPrefetcher;
+
 #pragma mark - Class methods
 
 /**
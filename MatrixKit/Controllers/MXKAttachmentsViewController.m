@@ -153,6 +153,11 @@
     [super finalizeInit];
     
     tempFile = nil;
+    
+    // Decode the prefetched images at the screen resolution
+    UIScreen *screen = [UIScreen mainScreen];
+    CGFloat maxPixelSize = MAX(screen.bounds.size.width, screen.bounds.size.height) * screen.scale;
+    _attachmentPrefetcher = [[MXKAttachmentPrefetcher alloc] initWithMaxPixelSize:maxPixelSize];
 }
 
 - (void)viewDidLoad
@@ -333,6 +338,12 @@
         self.sourceViewController = nil;
     }
     
+    if (_attachmentPrefetcher)
+    {
+        MXLogDebug(@"[MXKAttachmentsVC] destroy: prefetch hit rate: %.2f (%tu hits, %tu misses, %tu cancelled)", _attachmentPrefetcher.hitRate, _attachmentPrefetcher.hitCount, _attachmentPrefetcher.missCount, _attachmentPrefetcher.cancelledCount);
+        [_attachmentPrefetcher destroy];
+    }
+    
     [super destroy];
 }
 
@@ -530,6 +541,9 @@
                 [self.delegate displayedNewAttachmentWithEventId:attachment.eventId];
             }
             
+            // Prepare the next attachments in the swipe direction
+            [_attachmentPrefetcher prefetchAttachments:attachments aroundIndex:item];
+            
             // Check attachment type
             if (attachment.type == MXKAttachmentTypeImage && attachment.contentURL && ![mimeType isEqualToString:@"image/gif"])
             {
@@ -539,11 +553,20 @@
                 {
                     MXKMediaCollectionViewCell *mediaCollectionViewCell = (MXKMediaCollectionViewCell*)cell;
                     
-                    // Load high res image
+                    // Load high res image, unless it has been prefetched
+                    // (the prefetch metrics are counted when the cell is displayed)
                     mediaCollectionViewCell.mxkImageView.stretchable = YES;
                     mediaCollectionViewCell.mxkImageView.enableInMemoryCache = NO;
                     
-                    [mediaCollectionViewCell.mxkImageView setAttachment:attachment];
+                    UIImage *decodedImage = [_attachmentPrefetcher existingDecodedImageForAttachment:attachment];
+                    if (decodedImage)
+                    {
+                        [mediaCollectionViewCell.mxkImageView setAttachment:attachment withDecodedImage:decodedImage];
+                    }
+                    else
+                    {
+                        [mediaCollectionViewCell.mxkImageView setAttachment:attachment];
+                    }
                 }
             }
         }
@@ -775,17 +798,26 @@
                     onFailure(error);
                 }];
             }
-            else if (indexPath.item == currentVisibleItemIndex)
-            {
-                // Load high res image
-                cell.mxkImageView.stretchable = YES;
-                [cell.mxkImageView setAttachment:attachment];
-            }
             else
             {
-                // Use the thumbnail here - Full res images should only be downloaded explicitly when requested (see [self refreshCurrentVisibleItemIndex])
                 cell.mxkImageView.stretchable = YES;
-                [cell.mxkImageView setAttachmentThumb:attachment];
+                
+                // Use the prefetched image (if any)
+                UIImage *decodedImage = [_attachmentPrefetcher decodedImageForAttachment:attachment];
+                if (decodedImage)
+                {
+                    [cell.mxkImageView setAttachment:attachment withDecodedImage:decodedImage];
+                }
+                else if (indexPath.item == currentVisibleItemIndex)
+                {
+                    // Load high res image
+                    [cell.mxkImageView setAttachment:attachment];
+                }
+                else
+                {
+                    // Use the thumbnail here - Full res images should only be downloaded explicitly when requested (see [self refreshCurrentVisibleItemIndex])
+                    [cell.mxkImageView setAttachmentThumb:attachment];
+                }
             }
         }
         else if (attachment.type == MXKAttachmentTypeVideo && attachment.contentURL)
@@ -22,6 +22,7 @@
 #import "MXKAppSettings.h"
 #import "MXKSoundPlayer.h"
 #import "MXKTools.h"
+#import "MXKCallPeerResolver.h"
 #import "NSBundle+MatrixKit.h"
 
 #import "MXKSwiftHeader.h"
@@ -63,6 +64,10 @@ static const CGFloat kLocalPreviewMargin = 20;
     
     //  Current peer display name
     NSString *peerDisplayName;
+    
+    // The resolvers of the peers of the current call and of the call on hold
+    MXKCallPeerResolver *peerResolver;
+    MXKCallPeerResolver *peerOnHoldResolver;
 }
 
 @property (nonatomic, assign) Boolean isRinging;
@@ -299,11 +304,13 @@ static const CGFloat kLocalPreviewMargin = 20;
         [self removeObservers];
         
         mxCall = nil;
+        peerResolver = nil;
     }
     
     if (call && call.room)
     {
         mxCall = call;
+        peerResolver = [[MXKCallPeerResolver alloc] initWithCall:call];
         
         [self addMatrixSession:mxCall.room.mxSession];
 
@@ -316,7 +323,8 @@ static const CGFloat kLocalPreviewMargin = 20;
             // Consider only live events
             if (self->mxCall && direction == MXTimelineDirectionForwards)
             {
-                // The room state has been changed
+                // The room state has been changed, the peer is resolved again only if this event concerns it
+                [self->peerResolver handleRoomEvent:event];
                 [self callRoomStateDidChange:nil];
             }
         }];
@@ -330,6 +338,7 @@ static const CGFloat kLocalPreviewMargin = 20;
             {
                 // The existing room history has been flushed during server sync.
                 // Take into account the updated room state
+                [self->peerResolver reset];
                 [self callRoomStateDidChange:nil];
             }
             
@@ -409,38 +418,26 @@ static const CGFloat kLocalPreviewMargin = 20;
         [self.onHoldCallContainerView setUserInteractionEnabled:YES];
         
         // Handle peer here
-        if (mxCallOnHold.isIncoming)
-        {
-            self.peerOnHold = [mxCallOnHold.room.mxSession getOrCreateUser:mxCallOnHold.callerId];
-        }
-        else
-        {
-            // For 1:1 call, find the other peer
-            // Else, the room information will be used to display information about the call
-            MXWeakify(self);
-            [mxCallOnHold.room state:^(MXRoomState *roomState) {
-                MXStrongifyAndReturnIfNil(self);
+        peerOnHoldResolver = [[MXKCallPeerResolver alloc] initWithCall:mxCallOnHold];
+        MXKCallPeerResolver *resolver = peerOnHoldResolver;
+        
+        MXWeakify(self);
+        [peerOnHoldResolver resolvePeer:^(MXUser *peer) {
+            MXStrongifyAndReturnIfNil(self);
             
-                MXUser *theMember = nil;
-                NSArray *members = roomState.members.joinedMembers;
-                for (MXUser *member in members)
-                {
-                    if (![member.userId isEqualToString:self->mxCallOnHold.callerId])
-                    {
-                        theMember = member;
-                        break;
-                    }
-                }
-
-                self.peerOnHold = theMember;
-            }];
-        }
+            // Ignore the result if the call on hold has changed in the meantime
+            if (self->peerOnHoldResolver == resolver)
+            {
+                self.peerOnHold = peer;
+            }
+        }];
     }
     else
     {
         [self.onHoldCallContainerView removeGestureRecognizer:self.onHoldCallContainerTapRecognizer];
         [self.onHoldCallContainerView setUserInteractionEnabled:NO];
         self.onHoldCallContainerView.hidden = YES;
+        peerOnHoldResolver = nil;
         self.peerOnHold = nil;
     }
 }
@@ -1209,51 +1206,36 @@ static const CGFloat kLocalPreviewMargin = 20;
 - (void)callRoomStateDidChange:(dispatch_block_t)onComplete
 {
     // Handle peer here
-    if (mxCall.isIncoming)
+    // For 1:1 call, the peer is resolved once and kept until a membership change concerns it.
+    // Else, the room information will be used to display information about the call
+    if (!peerResolver)
     {
-        self.peer = [mxCall.room.mxSession getOrCreateUser:mxCall.callerId];
+        self.peer = nil;
         if (onComplete)
         {
             onComplete();
         }
+        return;
     }
-    else
-    {
-        // For 1:1 call, find the other peer
-        // Else, the room information will be used to display information about the call
-        if (!mxCall.isConferenceCall)
+    
+    MXKCallPeerResolver *resolver = peerResolver;
+    
+    MXWeakify(self);
+    [peerResolver resolvePeer:^(MXUser *peer) {
+        MXStrongifyAndReturnIfNil(self);
+        
+        // Ignore the result if the call has changed in the meantime
+        if (self->peerResolver != resolver)
         {
-            MXWeakify(self);
-            [mxCall.room state:^(MXRoomState *roomState) {
-                MXStrongifyAndReturnIfNil(self);
-            
-                MXUser *theMember = nil;
-                NSArray *members = roomState.members.joinedMembers;
-                for (MXUser *member in members)
-                {
-                    if (![member.userId isEqualToString:self->mxCall.callerId])
-                    {
-                        theMember = member;
-                        break;
-                    }
-                }
-
-                self.peer = theMember;
-                if (onComplete)
-                {
-                    onComplete();
-                }
-            }];
+            return;
         }
-        else
+        
+        self.peer = peer;
+        if (onComplete)
         {
-            self.peer = nil;
-            if (onComplete)
-            {
-                onComplete();
-            }
+            onComplete();
         }
-    }
+    }];
 }
 
 - (BOOL)isBuiltInReceiverAudioOuput
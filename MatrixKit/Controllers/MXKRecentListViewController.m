@@ -162,7 +162,7 @@
     ignoreSearchRequest = NO;
 
     // Observe server sync at room data source level too
-    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(onMatrixSessionChange) name:kMXKRoomDataSourceSyncStatusChanged object:nil];
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(onMatrixSessionChange) name:kMXKRoomDataSourceManagerServerSyncProcessingDidChangeNotification object:nil];
     
     // Observe the server sync
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(onSyncNotification) name:kMXSessionDidSyncNotification object:nil];
@@ -184,7 +184,7 @@
         [self searchBarCancelButtonClicked:self.recentsSearchBar];
     }
     
-    [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXKRoomDataSourceSyncStatusChanged object:nil];
+    [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXKRoomDataSourceManagerServerSyncProcessingDidChangeNotification object:nil];
     [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXSessionDidSyncNotification object:nil];
     
     [self removeReconnectingView];
@@ -388,10 +388,47 @@
 
 - (void)dataSource:(MXKDataSource *)dataSource didCellChange:(id)changes
 {
+    if ([changes isKindOfClass:NSArray.class] && [[changes firstObject] isKindOfClass:MXKRecentCellDataChange.class])
+    {
+        // The recents order is unchanged, refresh only the rows of the updated cell data
+        [self refreshRecentsTableRowsWithChanges:changes];
+        return;
+    }
+    
     // For now, do a simple full reload
     [self refreshRecentsTable];
 }
 
+- (void)refreshRecentsTableRowsWithChanges:(NSArray<MXKRecentCellDataChange*>*)changes
+{
+    // The updated cell data replace the rendered ones, find them by room
+    NSMutableDictionary<NSString*, MXKCellData*> *updatedCellDataByRoomId = [NSMutableDictionary dictionaryWithCapacity:changes.count];
+    for (MXKRecentCellDataChange *change in changes)
+    {
+        if (change.roomId)
+        {
+            updatedCellDataByRoomId[change.roomId] = (MXKCellData*)change.cellData;
+        }
+    }
+    
+    for (UITableViewCell *cell in self.recentsTableView.visibleCells)
+    {
+        if ([cell conformsToProtocol:@protocol(MXKCellRendering)] && [cell respondsToSelector:@selector(renderedCellData)])
+        {
+            id<MXKCellRendering> cellRendering = (id<MXKCellRendering>)cell;
+            MXKCellData *cellData = cellRendering.renderedCellData;
+            if ([cellData conformsToProtocol:@protocol(MXKRecentCellDataStoring)])
+            {
+                MXKCellData *updatedCellData = updatedCellDataByRoomId[((id<MXKRecentCellDataStoring>)cellData).roomIdentifier];
+                if (updatedCellData)
+                {
+                    [cellRendering render:updatedCellData];
+                }
+            }
+        }
+    }
+}
+
 - (void)dataSource:(MXKDataSource *)dataSource didAddMatrixSession:(MXSession *)mxSession
 {
     [self addMatrixSession:mxSession];
@@ -19,6 +19,8 @@
 
 #import "MXKViewController.h"
 #import "MXKRoomDataSource.h"
+#import "MXKRoomReadPositionTracker.h"
+#import "MXKRoomPaginationPredictor.h"
 #import "MXKRoomTitleView.h"
 #import "MXKRoomInputToolbarView.h"
 #import "MXKRoomActivitiesView.h"
@@ -126,6 +128,12 @@ typedef NS_ENUM(NSUInteger, MXKRoomViewControllerJoinRoomResult) {
  */
 @property (nonatomic) BOOL updateRoomReadMarker;
 
+/**
+ The tracker which coalesces the read receipts and the read marker updates triggered by the table scrolling.
+ It is created when a room data source is displayed.
+ */
+@property (nonatomic, readonly) MXKRoomReadPositionTracker *readPositionTracker;
+
 /**
  When the room view controller displays a room data source based on a timeline with an initial event,
  the bubble table view content is scrolled by default to display the top of this event at the center of the screen
@@ -153,16 +161,24 @@ typedef NS_ENUM(NSUInteger, MXKRoomViewControllerJoinRoomResult) {
 /**
  The threshold used to trigger inconspicuous back pagination, or forwards pagination
  for non live timeline. A pagination is triggered when the vertical content offset
- is lower this threshold.
+ is lower this threshold, plus the distance the user is expected to scroll during the pagination
+ (see `paginationPredictor`).
  Default is 300.
  */
 @property (nonatomic) NSUInteger paginationThreshold;
 
 /**
- The maximum number of messages to retrieve during a pagination. Default is 30.
+ The minimum number of messages to retrieve during a pagination. More messages are requested
+ when the user scrolls fast (see `paginationPredictor`). Default is 30.
  */
 @property (nonatomic) NSUInteger paginationLimit;
 
+/**
+ The predictor which triggers the inconspicuous paginations from the scroll velocity, and sizes them.
+ It exposes the metrics on how often the user reaches the pagination spinner.
+ */
+@property (nonatomic, readonly) MXKRoomPaginationPredictor *paginationPredictor;
+
 /**
  Enable/disable saving of the current typed text in message composer when view disappears.
  The message composer is prefilled with this text when the room is opened again.
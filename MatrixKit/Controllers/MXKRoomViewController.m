@@ -29,6 +29,7 @@
 #import "MXKImageView.h"
 
 #import "MXKRoomDataSourceManager.h"
+#import "MXKRoomAttachmentsTimeline.h"
 
 #import "MXKRoomInputToolbarViewWithSimpleTextView.h"
 
@@ -81,6 +82,11 @@
      */
     BOOL isPaginationInProgress;
     
+    /**
+     The direction of the pagination in progress.
+     */
+    MXTimelineDirection paginationDirection;
+    
     /**
      The back pagination spinner view.
      */
@@ -106,6 +112,11 @@
      */
     Class attachmentsViewerClass;
     
+    /**
+     The media timeline which feeds the attachments viewer with the attachments older than the loaded ones.
+     */
+    MXKRoomAttachmentsTimeline *attachmentsTimeline;
+    
     /**
      The class used to display event details.
      */
@@ -167,7 +178,7 @@
 @end
 
 @implementation MXKRoomViewController
-@synthesize roomDataSource, titleView, inputToolbarView, activitiesView;
+@synthesize roomDataSource, titleView, inputToolbarView, activitiesView, readPositionTracker;
 
 #pragma mark - Class methods
 
@@ -195,6 +206,7 @@
     // Default pagination settings
     _paginationThreshold = 300;
     _paginationLimit = 30;
+    _paginationPredictor = [[MXKRoomPaginationPredictor alloc] initWithThreshold:_paginationThreshold minimumLimit:_paginationLimit];
     
     // Save progress text input by default
     _saveProgressTextInput = YES;
@@ -375,6 +387,9 @@
     [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXKRoomDataSourceTimelineError object:nil];
     [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXSessionDidSyncNotification object:nil];
     
+    // Send the pending read receipt
+    [readPositionTracker flush];
+    
     [self removeReconnectingView];
 }
 
@@ -568,6 +583,14 @@
         roomDataSource.delegate = nil;
     }
     
+    [readPositionTracker destroy];
+    readPositionTracker = nil;
+    
+    [attachmentsTimeline destroy];
+    attachmentsTimeline = nil;
+    
+    MXLogDebug(@"[MXKRoomViewController] destroy: %tu paginations, %tu reached the spinner (%.0f%%)", _paginationPredictor.paginationCount, _paginationPredictor.stallCount, _paginationPredictor.stallRate * 100);
+    
     if (_hasRoomDataSourceOwnership)
     {
         // Release the room data source
@@ -670,6 +693,14 @@
 
 - (void)displayRoom:(MXKRoomDataSource *)dataSource
 {
+    // Send the pending read receipt of the previous room
+    [readPositionTracker destroy];
+    readPositionTracker = nil;
+    [_paginationPredictor resetVelocity];
+    
+    [attachmentsTimeline destroy];
+    attachmentsTimeline = nil;
+    
     if (roomDataSource)
     {
         if (self.hasRoomDataSourceOwnership)
@@ -702,6 +733,8 @@
         roomDataSource.delegate = self;
         roomDataSource.paginationLimitAroundInitialEvent = _paginationLimit;
         
+        readPositionTracker = [[MXKRoomReadPositionTracker alloc] initWithRoomDataSource:roomDataSource];
+        
         // Report the matrix session at view controller level to update UI according to session state
         [self addMatrixSession:roomDataSource.mxSession];
         
@@ -1019,6 +1052,13 @@
     _bubblesTableView.dataSource = nil;
     _bubblesTableView.delegate = nil;
     
+    [readPositionTracker destroy];
+    readPositionTracker = nil;
+    [_paginationPredictor resetVelocity];
+    
+    [attachmentsTimeline destroy];
+    attachmentsTimeline = nil;
+    
     if (self.hasRoomDataSourceOwnership)
     {
         // Release the room data source
@@ -1042,9 +1082,16 @@
     [self updateViewControllerAppearanceOnRoomDataSourceState];
 }
 
+- (void)setPaginationThreshold:(NSUInteger)paginationThreshold
+{
+    _paginationThreshold = paginationThreshold;
+    _paginationPredictor.threshold = paginationThreshold;
+}
+
 - (void)setPaginationLimit:(NSUInteger)paginationLimit
 {
     _paginationLimit = paginationLimit;
+    _paginationPredictor.minimumLimit = paginationLimit;
 
     // Use the same value when loading messages around the initial event
     roomDataSource.paginationLimitAroundInitialEvent = _paginationLimit;
@@ -1903,6 +1950,18 @@
  @param direction backwards or forwards.
  */
 - (void)triggerPagination:(NSUInteger)limit direction:(MXTimelineDirection)direction
+{
+    [self triggerPagination:limit direction:direction onlyFromStore:NO];
+}
+
+/**
+ Trigger an inconspicuous pagination.
+
+ @param limit the maximum number of messages to retrieve.
+ @param direction backwards or forwards.
+ @param onlyFromStore if YES, retrieve only the messages available in the store.
+ */
+- (void)triggerPagination:(NSUInteger)limit direction:(MXTimelineDirection)direction onlyFromStore:(BOOL)onlyFromStore
 {
     // Paginate only if possible
     if (isPaginationInProgress || roomDataSource.state != MXKDataSourceStateReady || NO == [roomDataSource.timeline canPaginate:direction])
@@ -1919,14 +1978,18 @@
     }
     
     isPaginationInProgress = YES;
+    paginationDirection = direction;
+    [_paginationPredictor didStartPagination];
     
     MXWeakify(self);
     
     // Trigger pagination
-    [roomDataSource paginate:limit direction:direction onlyFromStore:NO success:^(NSUInteger addedCellNumber) {
+    [roomDataSource paginate:limit direction:direction onlyFromStore:onlyFromStore success:^(NSUInteger addedCellNumber) {
         
         MXStrongifyAndReturnIfNil(self);
         
+        [self.paginationPredictor didEndPagination];
+        
         // We will adjust the vertical offset in order to unchange the current display (pagination should be inconspicuous)
         CGFloat verticalOffset = 0;
 
@@ -1962,6 +2025,7 @@
         [self.bubblesTableView setScrollEnabled:NO];
 
         CGPoint contentOffset = self.bubblesTableView.contentOffset;
+        CGFloat contentOffsetBeforeReload = contentOffset.y;
 
         BOOL hasBeenScrolledToBottom = [self reloadBubblesTable:NO];
 
@@ -1985,6 +2049,9 @@
         [self.bubblesTableView setShowsVerticalScrollIndicator:YES];
         [self.bubblesTableView setScrollEnabled:YES];
 
+        // The offset compensation is not a user scroll
+        [self.paginationPredictor didShiftContentOffsetBy:(self.bubblesTableView.contentOffset.y - contentOffsetBeforeReload)];
+
         self.bubbleTableViewDisplayInTransition = NO;
         self->isPaginationInProgress = NO;
 
@@ -1994,6 +2061,12 @@
         {
             [self updateCurrentEventIdAtTableBottom:NO];
         }
+        
+        // Keep the history buffer ahead of the viewport if the user is still scrolling fast
+        if (addedCellNumber)
+        {
+            [self triggerPredictivePagination:NO];
+        }
 
     } failure:^(NSError *error) {
         
@@ -2001,6 +2074,8 @@
         
         self.bubbleTableViewDisplayInTransition = YES;
         
+        [self.paginationPredictor didEndPagination];
+        
         // Reload table on failure because some changes may have been ignored during pagination (see[dataSource:didCellChange:])
         self->isPaginationInProgress = NO;
         self->_bubblesTableView.tableHeaderView = self->backPaginationActivityView = nil;
@@ -2012,78 +2087,95 @@
     }];
 }
 
+/**
+ Trigger an inconspicuous pagination when the content ahead of the viewport will run out before
+ a pagination can complete, according to the scroll velocity (see `paginationPredictor`).
+
+ @param wasScrollingToBottom tell whether the table was being scrolled to bottom programmatically.
+ */
+- (void)triggerPredictivePagination:(BOOL)wasScrollingToBottom
+{
+    if (isPaginationInProgress)
+    {
+        return;
+    }
+    
+    UIScrollView *scrollView = _bubblesTableView;
+    CGFloat distanceToTop = scrollView.contentOffset.y;
+    CGFloat distanceToBottom = scrollView.contentSize.height - scrollView.contentOffset.y - scrollView.frame.size.height;
+    
+    // Trigger inconspicuous pagination when user scrolls toward the top
+    if ([_paginationPredictor shouldPaginateInDirection:MXTimelineDirectionBackwards distanceToEdge:distanceToTop])
+    {
+        NSUInteger limit = [_paginationPredictor paginationLimitInDirection:MXTimelineDirectionBackwards
+                                                             distanceToEdge:distanceToTop
+                                                          averageCellHeight:self.averageBubbleCellHeight];
+        
+        // Serve the messages available in the store first, the homeserver is requested once the store is exhausted
+        NSUInteger remainingMessagesInStore = [roomDataSource.timeline remainingMessagesForBackPaginationInStore];
+        if (remainingMessagesInStore)
+        {
+            [self triggerPagination:MIN(limit, remainingMessagesInStore) direction:MXTimelineDirectionBackwards onlyFromStore:YES];
+        }
+        else
+        {
+            [self triggerPagination:limit direction:MXTimelineDirectionBackwards onlyFromStore:NO];
+        }
+    }
+    // Enable forwards pagination when displaying non live timeline
+    else if (!roomDataSource.isLive && !wasScrollingToBottom && [_paginationPredictor shouldPaginateInDirection:MXTimelineDirectionForwards distanceToEdge:distanceToBottom])
+    {
+        NSUInteger limit = [_paginationPredictor paginationLimitInDirection:MXTimelineDirectionForwards
+                                                             distanceToEdge:distanceToBottom
+                                                          averageCellHeight:self.averageBubbleCellHeight];
+        [self triggerPagination:limit direction:MXTimelineDirectionForwards];
+    }
+}
+
+- (CGFloat)averageBubbleCellHeight
+{
+    NSInteger rowCount = roomDataSource ? [roomDataSource tableView:_bubblesTableView numberOfRowsInSection:0] : 0;
+    return rowCount ? _bubblesTableView.contentSize.height / rowCount : 0;
+}
+
 - (void)triggerAttachmentBackPagination:(NSString*)eventId
 {
-    // Paginate only if possible
-    if (NO == [roomDataSource.timeline canPaginate:MXTimelineDirectionBackwards] && self.attachmentsViewer)
+    // Check whether the attachments viewer is still visible
+    if (!self.attachmentsViewer)
     {
+        [attachmentsTimeline destroy];
+        attachmentsTimeline = nil;
         return;
     }
     
-    isPaginationInProgress = YES;
+    // Paginate only if possible
+    if (!attachmentsTimeline.canPaginateBackwards)
+    {
+        self.attachmentsViewer.complete = YES;
+        return;
+    }
     
     MXWeakify(self);
     
-    // Trigger back pagination to find previous attachments
-    [roomDataSource paginate:_paginationLimit direction:MXTimelineDirectionBackwards onlyFromStore:NO success:^(NSUInteger addedCellNumber) {
+    // Retrieve the previous attachments from the media timeline. The room timeline is not paginated,
+    // so that the other events are neither formatted nor displayed in the bubbles table.
+    [attachmentsTimeline paginateBackwards:^(NSArray<MXKAttachment *> *addedAttachments) {
         
         MXStrongifyAndReturnIfNil(self);
         
-        // Check whether attachments viewer is still visible
         if (self.attachmentsViewer)
         {
-            // Check whether some older attachments have been added.
-            // Note: the stickers are excluded from the attachments list returned by the room datasource.
-            BOOL isDone = NO;
-            NSArray *attachmentsWithThumbnail = self.roomDataSource.attachmentsWithThumbnail;
-            if (attachmentsWithThumbnail.count)
-            {
-                MXKAttachment *attachment = attachmentsWithThumbnail.firstObject;
-                isDone = ![attachment.eventId isEqualToString:eventId];
-            }
-            
             // Check whether pagination is still available
-            self.attachmentsViewer.complete = ([self->roomDataSource.timeline canPaginate:MXTimelineDirectionBackwards] == NO);
+            self.attachmentsViewer.complete = (self->attachmentsTimeline.canPaginateBackwards == NO);
             
-            if (isDone || self.attachmentsViewer.complete)
-            {
-                // Refresh the current attachments list.
-                [self.attachmentsViewer displayAttachments:attachmentsWithThumbnail focusOn:nil];
-                
-                // Trigger a full table reload without scrolling. We could not only insert new cells related to back pagination,
-                // because some other changes may have been ignored during back pagination (see[dataSource:didCellChange:]).
-                self.bubbleTableViewDisplayInTransition = YES;
-                self->isPaginationInProgress = NO;
-                [self reloadBubblesTable:YES];
-                self.bubbleTableViewDisplayInTransition = NO;
-                
-                // Done
-                return;
-            }
-            
-            // Here a new back pagination is required
-            [self triggerAttachmentBackPagination:eventId];
-        }
-        else
-        {
-            // Trigger a full table reload without scrolling. We could not only insert new cells related to back pagination,
-            // because some other changes may have been ignored during back pagination (see[dataSource:didCellChange:]).
-            self.bubbleTableViewDisplayInTransition = YES;
-            self->isPaginationInProgress = NO;
-            [self reloadBubblesTable:YES];
-            self.bubbleTableViewDisplayInTransition = NO;
+            // Refresh the current attachments list.
+            [self.attachmentsViewer displayAttachments:self->attachmentsTimeline.attachments focusOn:nil];
         }
         
     } failure:^(NSError *error) {
         
         MXStrongifyAndReturnIfNil(self);
         
-        // Reload table on failure because some changes may have been ignored during back pagination (see[dataSource:didCellChange:])
-        self.bubbleTableViewDisplayInTransition = YES;
-        self->isPaginationInProgress = NO;
-        [self reloadBubblesTable:YES];
-        self.bubbleTableViewDisplayInTransition = NO;
-        
         if (self.attachmentsViewer)
         {
             // Force attachments update to cancel potential loading wheel
@@ -2446,22 +2538,8 @@
                     if (acknowledge && self.isEventsAcknowledgementEnabled)
                     {
                         // Indicate to the homeserver that the user has read this event.
-                        
-                        // Check whether the read marker must be updated.
-                        BOOL updateReadMarker = _updateRoomReadMarker;
-                        if (updateReadMarker && roomDataSource.room.accountData.readMarkerEventId)
-                        {
-                            MXEvent *currentReadMarkerEvent = [roomDataSource.mxSession.store eventWithEventId:roomDataSource.room.accountData.readMarkerEventId inRoom:roomDataSource.roomId];
-                            if (!currentReadMarkerEvent)
-                            {
-                                currentReadMarkerEvent = [roomDataSource eventWithEventId:roomDataSource.room.accountData.readMarkerEventId];
-                            }
-                            
-                            // Update the read marker only if the current event is available, and the new event is posterior to it.
-                            updateReadMarker = (currentReadMarkerEvent && (currentReadMarkerEvent.originServerTs <= component.event.originServerTs));
-                        }
-                        
-                        [roomDataSource.room acknowledgeEvent:component.event andUpdateReadMarker:updateReadMarker];
+                        // The update is coalesced with the next ones during scrolling.
+                        [readPositionTracker updateWithEvent:component.event updateReadMarker:_updateRoomReadMarker];
                     }
                     break;
                 }
@@ -2565,8 +2643,16 @@
     if (self.attachmentsViewer)
     {
         // Refresh the current attachments list without changing the current displayed attachment (see focus = nil).
-        NSArray *attachmentsWithThumbnail = self.roomDataSource.attachmentsWithThumbnail;
-        [self.attachmentsViewer displayAttachments:attachmentsWithThumbnail focusOn:nil];
+        // The attachments retrieved by the media timeline are kept.
+        [attachmentsTimeline updateRecentAttachments:self.roomDataSource.attachmentsWithThumbnail];
+        [self.attachmentsViewer displayAttachments:attachmentsTimeline.attachments focusOn:nil];
+    }
+    
+    if ([changes isKindOfClass:NSArray.class])
+    {
+        // Only the state of some bubbles has changed, their height is unchanged
+        [self refreshBubblesTableRowsWithChangedCellData:changes];
+        return;
     }
     
     self.bubbleTableViewDisplayInTransition = YES;
@@ -2586,6 +2672,24 @@
     self.bubbleTableViewDisplayInTransition = NO;
 }
 
+- (void)refreshBubblesTableRowsWithChangedCellData:(NSArray<id<MXKRoomBubbleCellDataStoring>>*)changedCellData
+{
+    NSSet *updatedCellData = [NSSet setWithArray:changedCellData];
+    
+    for (UITableViewCell *cell in self.bubblesTableView.visibleCells)
+    {
+        if ([cell isKindOfClass:MXKRoomBubbleTableViewCell.class])
+        {
+            MXKRoomBubbleTableViewCell *roomBubbleTableViewCell = (MXKRoomBubbleTableViewCell*)cell;
+            MXKRoomBubbleCellData *bubbleData = roomBubbleTableViewCell.bubbleData;
+            if (bubbleData && [updatedCellData containsObject:bubbleData])
+            {
+                [roomBubbleTableViewCell render:bubbleData];
+            }
+        }
+    }
+}
+
 - (void)dataSource:(MXKDataSource *)dataSource didStateChange:(MXKDataSourceState)state
 {
     [self updateViewControllerAppearanceOnRoomDataSourceState];
@@ -3256,6 +3360,9 @@
         if (!decelerate)
         {
             [self updateCurrentEventIdAtTableBottom:YES];
+            
+            // The scrolling is paused, send the read receipt now
+            [readPositionTracker flush];
         }
     }
 }
@@ -3267,6 +3374,7 @@
         // do not dispatch the upateCurrentEventIdAtTableBottom call
         // else it might triggers weird UI lags.
         [self updateCurrentEventIdAtTableBottom:YES];
+        [readPositionTracker flush];
         [self managePullToKick:scrollView];
     }
 }
@@ -3302,16 +3410,25 @@
                 [self managePullToKick:scrollView];
             }
             
-            // Trigger inconspicuous pagination when user scrolls toward the top
-            if (scrollView.contentOffset.y < _paginationThreshold)
-            {
-                [self triggerPagination:_paginationLimit direction:MXTimelineDirectionBackwards];
-            }
-            // Enable forwards pagination when displaying non live timeline
-            else if (!roomDataSource.isLive && !wasScrollingToBottom && ((scrollView.contentSize.height - scrollView.contentOffset.y - scrollView.frame.size.height) < _paginationThreshold))
+            if (!self.bubbleTableViewDisplayInTransition)
             {
-                [self triggerPagination:_paginationLimit direction:MXTimelineDirectionForwards];
+                [_paginationPredictor updateWithContentOffset:scrollView.contentOffset.y timestamp:CACurrentMediaTime()];
+                
+                // Count the times the user reaches the pagination spinner
+                if (isPaginationInProgress)
+                {
+                    if (paginationDirection == MXTimelineDirectionBackwards && scrollView.contentOffset.y <= -scrollView.adjustedContentInset.top)
+                    {
+                        [_paginationPredictor didReachContentEdge];
+                    }
+                    else if (paginationDirection == MXTimelineDirectionForwards && scrollView.contentOffset.y + scrollView.frame.size.height >= scrollView.contentSize.height + scrollView.adjustedContentInset.bottom)
+                    {
+                        [_paginationPredictor didReachContentEdge];
+                    }
+                }
             }
+            
+            [self triggerPredictivePagination:wasScrollingToBottom];
         }
         
         if (wasScrollingToBottom)
@@ -3618,6 +3735,11 @@
                     // Note: the stickers are presently excluded from the attachments list returned by the room dataSource.
                     NSArray *attachmentsWithThumbnail = self.roomDataSource.attachmentsWithThumbnail;
                     
+                    // The older attachments will be retrieved by a dedicated media timeline
+                    [attachmentsTimeline destroy];
+                    attachmentsTimeline = [[MXKRoomAttachmentsTimeline alloc] initWithRoomId:roomDataSource.roomId andMatrixSession:roomDataSource.mxSession];
+                    [attachmentsTimeline updateRecentAttachments:attachmentsWithThumbnail];
+                    
                     MXKAttachmentsViewController *attachmentsViewer;
                     
                     // Present an attachment viewer
@@ -3632,6 +3754,11 @@
                     
                     attachmentsViewer.delegate = self;
                     attachmentsViewer.complete = ([roomDataSource.timeline canPaginate:MXTimelineDirectionBackwards] == NO);
+                    if (attachmentsViewer.complete)
+                    {
+                        // The whole room history is already loaded
+                        [attachmentsTimeline destroy];
+                    }
                     attachmentsViewer.hidesBottomBarWhenPushed = YES;
                     [attachmentsViewer displayAttachments:attachmentsWithThumbnail focusOn:selectedAttachment.eventId];
                     
@@ -3864,7 +3991,7 @@
 {
     [self triggerAttachmentBackPagination:eventId];
     
-    return [self.roomDataSource.timeline canPaginate:MXTimelineDirectionBackwards];
+    return attachmentsTimeline.canPaginateBackwards;
 }
 
 - (void)displayedNewAttachmentWithEventId:(NSString *)eventId {
@@ -743,6 +743,74 @@ public class MatrixKitL10n: NSObject {
   public static var noticeAvatarUrlChangedByYou: String { 
     return MatrixKitL10n.tr("notice_avatar_url_changed_by_you") 
   }
+  /// 1 avatar change
+  public static var noticeCollapsedSeriesAvatarChange: String { 
+    return MatrixKitL10n.tr("notice_collapsed_series_avatar_change") 
+  }
+  /// %@ avatar changes
+  public static func noticeCollapsedSeriesAvatarChanges(_ p1: String) -> String {
+    return MatrixKitL10n.tr("notice_collapsed_series_avatar_changes", p1)
+  }
+  /// 1 ban
+  public static var noticeCollapsedSeriesBan: String { 
+    return MatrixKitL10n.tr("notice_collapsed_series_ban") 
+  }
+  /// %@ bans
+  public static func noticeCollapsedSeriesBans(_ p1: String) -> String {
+    return MatrixKitL10n.tr("notice_collapsed_series_bans", p1)
+  }
+  /// 1 display name change
+  public static var noticeCollapsedSeriesDisplayNameChange: String { 
+    return MatrixKitL10n.tr("notice_collapsed_series_display_name_change") 
+  }
+  /// %@ display name changes
+  public static func noticeCollapsedSeriesDisplayNameChanges(_ p1: String) -> String {
+    return MatrixKitL10n.tr("notice_collapsed_series_display_name_changes", p1)
+  }
+  /// 1 invite
+  public static var noticeCollapsedSeriesInvite: String { 
+    return MatrixKitL10n.tr("notice_collapsed_series_invite") 
+  }
+  /// %@ invites
+  public static func noticeCollapsedSeriesInvites(_ p1: String) -> String {
+    return MatrixKitL10n.tr("notice_collapsed_series_invites", p1)
+  }
+  /// 1 join
+  public static var noticeCollapsedSeriesJoin: String { 
+    return MatrixKitL10n.tr("notice_collapsed_series_join") 
+  }
+  /// %@ joins
+  public static func noticeCollapsedSeriesJoins(_ p1: String) -> String {
+    return MatrixKitL10n.tr("notice_collapsed_series_joins", p1)
+  }
+  /// 1 kick
+  public static var noticeCollapsedSeriesKick: String { 
+    return MatrixKitL10n.tr("notice_collapsed_series_kick") 
+  }
+  /// %@ kicks
+  public static func noticeCollapsedSeriesKicks(_ p1: String) -> String {
+    return MatrixKitL10n.tr("notice_collapsed_series_kicks", p1)
+  }
+  /// 1 leave
+  public static var noticeCollapsedSeriesLeave: String { 
+    return MatrixKitL10n.tr("notice_collapsed_series_leave") 
+  }
+  /// %@ leaves
+  public static func noticeCollapsedSeriesLeaves(_ p1: String) -> String {
+    return MatrixKitL10n.tr("notice_collapsed_series_leaves", p1)
+  }
+  /// 1 other event
+  public static var noticeCollapsedSeriesOtherEvent: String { 
+    return MatrixKitL10n.tr("notice_collapsed_series_other_event") 
+  }
+  /// %@ other events
+  public static func noticeCollapsedSeriesOtherEvents(_ p1: String) -> String {
+    return MatrixKitL10n.tr("notice_collapsed_series_other_events", p1)
+  }
+  /// , 
+  public static var noticeCollapsedSeriesSeparator: String { 
+    return MatrixKitL10n.tr("notice_collapsed_series_separator") 
+  }
   /// VoIP conference finished
   public static var noticeConferenceCallFinished: String { 
     return MatrixKitL10n.tr("notice_conference_call_finished") 
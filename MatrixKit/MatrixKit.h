@@ -30,8 +30,14 @@
 #import "UIViewController+MatrixKit.h"
 
 #import "MXKEventFormatter.h"
+#import "MXKSimpleHTMLRenderer.h"
 
 #import "MXKTools.h"
+#import "MXKTextAnalysis.h"
+#import "MXKSearchFilter.h"
+#import "MXKImageSendEncoder.h"
+#import "MXKCallPeerResolver.h"
+#import "MXKDateFormatterPool.h"
 
 #import "MXKErrorPresentation.h"
 #import "MXKErrorPresentable.h"
@@ -72,11 +78,16 @@
 #import "MXKRoomInputToolbarViewWithHPGrowingText.h"
 
 #import "MXKRoomDataSourceManager.h"
+#import "MXKRoomReadPositionTracker.h"
+#import "MXKRoomPaginationPredictor.h"
+#import "MXKRoomAttachmentsTimeline.h"
+#import "MXKCollapsedSeriesSummary.h"
 
 #import "MXKRoomBubbleCellData.h"
 #import "MXKRoomBubbleCellDataWithAppendingMode.h"
 
 #import "MXKAttachment.h"
+#import "MXKAttachmentPrefetcher.h"
 
 #import "MXKRecentTableViewCell.h"
 #import "MXKInterleavedRecentTableViewCell.h"
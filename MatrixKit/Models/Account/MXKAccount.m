@@ -928,6 +928,9 @@ static NSArray<NSNumber*> *initialSyncSilentErrorsHTTPStatusCodes;
             // Clean other stores
             [mxSession.scanManager deleteAllAntivirusScans];
             [mxSession.aggregations resetData];
+            
+            // The video thumbnails are generated from the media of the session
+            [MXKVideoThumbnailGenerator.shared clearCache];
         }
         else
         {
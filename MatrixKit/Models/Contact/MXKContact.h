@@ -143,7 +143,8 @@ extern NSString *const kMXKContactDefaultContactPrefixId;
  The contact thumbnail with a prefered size.
  
  If the thumbnail is already loaded, this method returns this one by ignoring prefered size.
- The prefered size is used only if a server request is required.
+ The prefered size is used only if a server request is required, or to decode the contacts book thumbnail
+ the first time it is displayed (its encoded data is kept as is in the contacts cache).
  
  @return thumbnail with a prefered size
  */
@@ -20,6 +20,7 @@
 
 #import "MXKEmail.h"
 #import "MXKPhoneNumber.h"
+#import "MXKTools.h"
 
 NSString *const kMXKContactThumbnailUpdateNotification = @"kMXKContactThumbnailUpdateNotification";
 
@@ -29,7 +30,12 @@ NSString *const kMXKContactDefaultContactPrefixId = @"Default_";
 
 @interface MXKContact()
 {
+    // The encoded thumbnail, as provided by the contacts book or the cache. It is archived as is.
+    NSData* contactThumbnailData;
+    // The thumbnail decoded at display size from contactThumbnailData (or provided at init).
     UIImage* contactThumbnail;
+    // The pixel size of the last decoding of contactThumbnailData (successful or not).
+    CGSize contactThumbnailDecodingSize;
     UIImage* matrixThumbnail;
     
     // The matrix id of the contact (used when the contact is not defined in the contacts book)
@@ -210,8 +216,8 @@ NSString *const kMXKContactDefaultContactPrefixId = @"Default_";
             dataRef = ABPersonCopyImageDataWithFormat(record, kABPersonImageFormatThumbnail);
             if (dataRef)
             {
-                contactThumbnail = [UIImage imageWithData:(__bridge NSData*)dataRef];
-                CFRelease(dataRef);
+                // The image is decoded only when it is displayed
+                contactThumbnailData = (__bridge_transfer NSData*)dataRef;
             }
         }
     }
@@ -520,6 +526,37 @@ NSString *const kMXKContactDefaultContactPrefixId = @"Default_";
 - (UIImage*)thumbnailWithPreferedSize:(CGSize)size
 {
     // Consider first the local thumbnail if any.
+    @synchronized(self)
+    {
+        if (contactThumbnailData)
+        {
+            if (size.width <= 0 || size.height <= 0)
+            {
+                // The view is not laid out yet, the thumbnail will be decoded at the next request
+                return contactThumbnail;
+            }
+            
+            // Decode the thumbnail at display size, and again when a larger size is requested
+            CGFloat scale = [UIScreen mainScreen].scale;
+            CGSize pixelSize = CGSizeMake(size.width * scale, size.height * scale);
+            if (pixelSize.width > contactThumbnailDecodingSize.width || pixelSize.height > contactThumbnailDecodingSize.height)
+            {
+                contactThumbnailDecodingSize = CGSizeMake(MAX(pixelSize.width, contactThumbnailDecodingSize.width), MAX(pixelSize.height, contactThumbnailDecodingSize.height));
+                
+                UIImage *thumbnail = [MXKTools resizeImageWithData:contactThumbnailData toFitInSize:contactThumbnailDecodingSize];
+                if (thumbnail)
+                {
+                    contactThumbnail = thumbnail;
+                }
+                else
+                {
+                    // Keep the data, it is archived as is
+                    MXLogDebug(@"[MXKContact] thumbnailWithPreferedSize: Unable to decode the thumbnail of %@", _contactID);
+                }
+            }
+        }
+    }
+    
     if (contactThumbnail)
     {
         return contactThumbnail;
@@ -617,10 +654,8 @@ NSString *const kMXKContactDefaultContactPrefixId = @"Default_";
         data = [coder decodeObjectForKey:@"contactBookThumbnail"];
     }
     
-    if (data)
-    {
-        contactThumbnail = [UIImage imageWithData:data];
-    }
+    // Keep the encoded thumbnail, it is decoded only when it is displayed
+    contactThumbnailData = data;
     
     return self;
 }
@@ -646,13 +681,20 @@ NSString *const kMXKContactDefaultContactPrefixId = @"Default_";
         [coder encodeObject:_emailAddresses forKey:@"emailAddresses"];
     }
     
-    if (contactThumbnail)
+    NSData *thumbnailData;
+    @synchronized(self)
     {
-        @autoreleasepool
+        if (!contactThumbnailData && contactThumbnail)
         {
-            NSData *data = UIImageJPEGRepresentation(contactThumbnail, 0.8);
-            [coder encodeObject:data forKey:@"contactThumbnail"];
+            // Compress the provided thumbnail once, the next archivings write these bytes as is
+            contactThumbnailData = UIImageJPEGRepresentation(contactThumbnail, 0.8);
         }
+        thumbnailData = contactThumbnailData;
+    }
+    
+    if (thumbnailData)
+    {
+        [coder encodeObject:thumbnailData forKey:@"contactThumbnail"];
     }
 }
 
@@ -22,11 +22,25 @@
  */
 extern NSString *const kMXKGroupCellIdentifier;
 
+/**
+ The default maximum number of group summary requests in progress at the same time.
+ */
+#define MXKSESSIONGROUPSDATASOURCE_DEFAULT_MAX_CONCURRENT_SUMMARY_REFRESHES 3
+
+/**
+ The default duration (in seconds) during which a refreshed group summary is considered up to date.
+ */
+#define MXKSESSIONGROUPSDATASOURCE_DEFAULT_SUMMARY_STALENESS_INTERVAL 300
+
 /**
  'MXKSessionGroupsDataSource' is a base class to handle the groups of a matrix session.
  A 'MXKSessionGroupsDataSource' instance provides the data source for `MXKGroupListViewController`.
  
  A section is created to handle the invitations to a group, the first one if any.
+ 
+ The group summaries are refreshed by a scheduler which limits the number of concurrent requests,
+ and which skips the groups refreshed recently (see `summaryStalenessInterval`).
+ The summary updates received in a row are applied with a single incremental re-sort of the groups.
  */
 @interface MXKSessionGroupsDataSource : MXKDataSource <UITableViewDataSource>
 {    
@@ -48,13 +62,29 @@ extern NSString *const kMXKGroupCellIdentifier;
 @property (nonatomic) NSInteger groupInvitesSection;
 @property (nonatomic) NSInteger joinedGroupsSection;
 
+/**
+ The maximum number of group summary requests in progress at the same time.
+ Default is MXKSESSIONGROUPSDATASOURCE_DEFAULT_MAX_CONCURRENT_SUMMARY_REFRESHES.
+ */
+@property (nonatomic) NSUInteger maxConcurrentSummaryRefreshes;
+
+/**
+ The duration (in seconds) during which a group summary successfully refreshed is not requested again.
+ Set 0 to refresh all the groups on each refresh.
+ Default is MXKSESSIONGROUPSDATASOURCE_DEFAULT_SUMMARY_STALENESS_INTERVAL.
+ */
+@property (nonatomic) NSTimeInterval summaryStalenessInterval;
+
 #pragma mark - Life cycle
 
 /**
  Refresh all the groups summary.
  The group data are not synced with the server, use this method to refresh them according to your needs.
  
- @param completion the block to execute when a request has been done for each group (whatever the result of the requests).
+ The groups refreshed for less than `summaryStalenessInterval` are skipped. The requests of the other groups
+ are queued: at most `maxConcurrentSummaryRefreshes` requests are in progress at the same time.
+ 
+ @param completion the block to execute when a request has been done for each stale group (whatever the result of the requests).
  You may specify nil for this parameter.
  */
 - (void)refreshGroupsSummary:(void (^)(void))completion;
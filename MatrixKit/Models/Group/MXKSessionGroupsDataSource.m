@@ -51,6 +51,31 @@ NSString *const kMXKGroupCellIdentifier = @"kMXKGroupCellIdentifier";
      Store the current search patterns list.
      */
     NSArray* searchPatternsList;
+    
+    /**
+     The date of the last successful summary refresh by group id.
+     */
+    NSMutableDictionary<NSString*, NSDate*> *summaryRefreshDates;
+    
+    /**
+     The groups waiting for a summary request.
+     */
+    NSMutableArray<MXGroup*> *summaryRefreshQueue;
+    
+    /**
+     The blocks to call when the summary request of a group is done, by group id (for the queued and running requests).
+     */
+    NSMutableDictionary<NSString*, NSMutableArray<void (^)(void)>*> *summaryRefreshCompletions;
+    
+    /**
+     The number of summary requests in progress.
+     */
+    NSUInteger summaryRefreshCount;
+    
+    /**
+     The cell data updated since the last sort.
+     */
+    NSMutableSet<id<MXKGroupCellDataStoring>> *cellDataToSort;
 }
 
 @end
@@ -68,6 +93,13 @@ NSString *const kMXKGroupCellIdentifier = @"kMXKGroupCellIdentifier";
         
         isDataChangePending = NO;
         
+        _maxConcurrentSummaryRefreshes = MXKSESSIONGROUPSDATASOURCE_DEFAULT_MAX_CONCURRENT_SUMMARY_REFRESHES;
+        _summaryStalenessInterval = MXKSESSIONGROUPSDATASOURCE_DEFAULT_SUMMARY_STALENESS_INTERVAL;
+        summaryRefreshDates = [NSMutableDictionary dictionary];
+        summaryRefreshQueue = [NSMutableArray array];
+        summaryRefreshCompletions = [NSMutableDictionary dictionary];
+        cellDataToSort = [NSMutableSet set];
+        
         // Set default data and view classes
         [self registerCellDataClass:MXKGroupCellData.class forCellIdentifier:kMXKGroupCellIdentifier];
     }
@@ -84,6 +116,11 @@ NSString *const kMXKGroupCellIdentifier = @"kMXKGroupCellIdentifier";
     
     searchPatternsList = nil;
     
+    summaryRefreshDates = nil;
+    summaryRefreshQueue = nil;
+    summaryRefreshCompletions = nil;
+    cellDataToSort = nil;
+    
     [timer invalidate];
     timer = nil;
     
@@ -113,38 +150,13 @@ NSString *const kMXKGroupCellIdentifier = @"kMXKGroupCellIdentifier";
 {
     MXLogDebug(@"[MXKSessionGroupsDataSource] refreshGroupsSummary");
     
-    __block NSUInteger count = internalCellDataArray.count;
-    
-    if (count)
-    {
-        for (id<MXKGroupCellDataStoring> groupData in internalCellDataArray)
-        {
-            // Force the matrix session to refresh the group summary.
-            [self.mxSession updateGroupSummary:groupData.group success:^{
-                
-                if (completion && !(--count))
-                {
-                    // All the requests have been done.
-                    completion ();
-                }
-                
-            } failure:^(NSError *error) {
-                
-                MXLogDebug(@"[MXKSessionGroupsDataSource] refreshGroupsSummary: group summary update failed %@", groupData.group.groupId);
-                
-                if (completion && !(--count))
-                {
-                    // All the requests have been done.
-                    completion ();
-                }
-                
-            }];
-        }
-    }
-    else if (completion)
+    NSMutableArray<MXGroup*> *groups = [NSMutableArray arrayWithCapacity:internalCellDataArray.count];
+    for (id<MXKGroupCellDataStoring> groupData in internalCellDataArray)
     {
-        completion();
+        [groups addObject:groupData.group];
     }
+    
+    [self refreshSummaryOfGroups:groups completion:completion];
 }
 
 - (void)searchWithPatterns:(NSArray*)patternsList
@@ -246,16 +258,14 @@ NSString *const kMXKGroupCellIdentifier = @"kMXKGroupCellIdentifier";
         if (cellData)
         {
             [internalCellDataArray addObject:cellData];
-            
-            // Force the matrix session to refresh the group summary.
-            [self.mxSession updateGroupSummary:group success:nil failure:^(NSError *error) {
-                MXLogDebug(@"[MXKSessionGroupsDataSource] loadData: group summary update failed %@", group.groupId);
-            }];
         }
     }
     
     MXLogDebug(@"[MXKSessionGroupsDataSource] Loaded %tu groups in %.3fms", groups.count, [[NSDate date] timeIntervalSinceDate:startDate] * 1000);
     
+    // Force the matrix session to refresh the group summaries
+    [self refreshGroupsSummary:nil];
+    
     [self sortCellData];
     [self onCellDataChange];
 }
@@ -269,12 +279,16 @@ NSString *const kMXKGroupCellIdentifier = @"kMXKGroupCellIdentifier";
         if (groupData)
         {
             [groupData updateWithGroup:group];
+            
+            // The group will be moved at its new position with the other updated groups when the changes are notified
+            [cellDataToSort addObject:groupData];
+            [self onCellDataChange];
         }
         else
         {
             MXLogDebug(@"[MXKSessionGroupsDataSource] didUpdateGroup: Cannot find the changed group for %@ (%@). It is probably not managed by this group data source", group.groupId, group);
-            return;
         }
+        return;
     }
     
     [self sortCellData];
@@ -354,6 +368,7 @@ NSString *const kMXKGroupCellIdentifier = @"kMXKGroupCellIdentifier";
         MXLogDebug(@"MXKSessionGroupsDataSource] Remove left group: %@", groupId);
         
         [internalCellDataArray removeObject:groupData];
+        [summaryRefreshDates removeObjectForKey:groupId];
         
         [self sortCellData];
         [self onCellDataChange];
@@ -391,29 +406,72 @@ NSString *const kMXKGroupCellIdentifier = @"kMXKGroupCellIdentifier";
     }
 }
 
-- (void)sortCellData
+- (NSComparator)cellDataComparator
 {
     // Order alphabetically the groups
-    [internalCellDataArray sortUsingComparator:^NSComparisonResult(id<MXKGroupCellDataStoring> cellData1, id<MXKGroupCellDataStoring> cellData2)
-     {
-         if (cellData1.sortingDisplayname.length && cellData2.sortingDisplayname.length)
-         {
-             return [cellData1.sortingDisplayname compare:cellData2.sortingDisplayname options:NSCaseInsensitiveSearch];
-         }
-         else if (cellData1.sortingDisplayname.length)
-         {
-             return NSOrderedAscending;
-         }
-         else if (cellData2.sortingDisplayname.length)
-         {
-             return NSOrderedDescending;
-         }
-         return NSOrderedSame;
-     }];
+    return ^NSComparisonResult(id<MXKGroupCellDataStoring> cellData1, id<MXKGroupCellDataStoring> cellData2)
+    {
+        if (cellData1.sortingDisplayname.length && cellData2.sortingDisplayname.length)
+        {
+            return [cellData1.sortingDisplayname compare:cellData2.sortingDisplayname options:NSCaseInsensitiveSearch];
+        }
+        else if (cellData1.sortingDisplayname.length)
+        {
+            return NSOrderedAscending;
+        }
+        else if (cellData2.sortingDisplayname.length)
+        {
+            return NSOrderedDescending;
+        }
+        return NSOrderedSame;
+    };
+}
+
+- (void)sortCellData
+{
+    [internalCellDataArray sortUsingComparator:[self cellDataComparator]];
+    [cellDataToSort removeAllObjects];
+}
+
+- (void)sortUpdatedCellData
+{
+    if (!cellDataToSort.count)
+    {
+        return;
+    }
+    
+    if (cellDataToSort.count > internalCellDataArray.count / 2)
+    {
+        // Most of the groups have changed
+        [self sortCellData];
+        return;
+    }
+    
+    // Remove the updated groups, the other ones are still sorted
+    NSIndexSet *indexes = [internalCellDataArray indexesOfObjectsPassingTest:^BOOL(id<MXKGroupCellDataStoring> cellData, NSUInteger idx, BOOL *stop) {
+        return [self->cellDataToSort containsObject:cellData];
+    }];
+    NSArray<id<MXKGroupCellDataStoring>> *updatedCellDataArray = [internalCellDataArray objectsAtIndexes:indexes];
+    [internalCellDataArray removeObjectsAtIndexes:indexes];
+    
+    // And insert them at their new position
+    NSComparator comparator = [self cellDataComparator];
+    for (id<MXKGroupCellDataStoring> cellData in updatedCellDataArray)
+    {
+        NSUInteger index = [internalCellDataArray indexOfObject:cellData
+                                                 inSortedRange:NSMakeRange(0, internalCellDataArray.count)
+                                                       options:NSBinarySearchingInsertionIndex
+                                               usingComparator:comparator];
+        [internalCellDataArray insertObject:cellData atIndex:index];
+    }
+    [cellDataToSort removeAllObjects];
 }
 
 - (void)prepareCellDataAndNotifyChanges
 {
+    // Apply the pending group updates
+    [self sortUpdatedCellData];
+    
     // Prepare the cell data arrays by considering the potential filter.
     [groupsInviteCellDataArray removeAllObjects];
     [groupsCellDataArray removeAllObjects];
@@ -472,6 +530,114 @@ NSString *const kMXKGroupCellIdentifier = @"kMXKGroupCellIdentifier";
     return theGroupData;
 }
 
+#pragma mark - Group summaries refresh
+
+- (void)refreshSummaryOfGroups:(NSArray<MXGroup*>*)groups completion:(void (^)(void))completion
+{
+    // Skip the groups which have been refreshed recently
+    NSDate *now = [NSDate date];
+    NSMutableArray<MXGroup*> *staleGroups = [NSMutableArray arrayWithCapacity:groups.count];
+    for (MXGroup *group in groups)
+    {
+        NSDate *refreshDate = summaryRefreshDates[group.groupId];
+        if (!refreshDate || [now timeIntervalSinceDate:refreshDate] >= _summaryStalenessInterval)
+        {
+            [staleGroups addObject:group];
+        }
+    }
+    
+    MXLogDebug(@"[MXKSessionGroupsDataSource] refreshSummaryOfGroups: %tu stale groups among %tu", staleGroups.count, groups.count);
+    
+    if (!staleGroups.count)
+    {
+        if (completion)
+        {
+            completion();
+        }
+        return;
+    }
+    
+    __block NSUInteger count = staleGroups.count;
+    void (^onGroupRefreshed)(void) = ^{
+        
+        if (completion && !(--count))
+        {
+            // All the requests have been done.
+            completion();
+        }
+    };
+    
+    for (MXGroup *group in staleGroups)
+    {
+        NSMutableArray<void (^)(void)> *completions = summaryRefreshCompletions[group.groupId];
+        if (!completions)
+        {
+            // There is no request yet for this group
+            completions = [NSMutableArray array];
+            summaryRefreshCompletions[group.groupId] = completions;
+            [summaryRefreshQueue addObject:group];
+        }
+        [completions addObject:onGroupRefreshed];
+    }
+    
+    [self startQueuedSummaryRefreshes];
+}
+
+- (void)startQueuedSummaryRefreshes
+{
+    while (summaryRefreshQueue.count && summaryRefreshCount < MAX(_maxConcurrentSummaryRefreshes, 1))
+    {
+        MXGroup *group = summaryRefreshQueue.firstObject;
+        [summaryRefreshQueue removeObjectAtIndex:0];
+        summaryRefreshCount++;
+        
+        __weak typeof(self) weakSelf = self;
+        
+        // Force the matrix session to refresh the group summary.
+        [self.mxSession updateGroupSummary:group success:^{
+            
+            if (weakSelf)
+            {
+                typeof(self) self = weakSelf;
+                [self didRefreshSummaryOfGroup:group success:YES];
+            }
+            
+        } failure:^(NSError *error) {
+            
+            MXLogDebug(@"[MXKSessionGroupsDataSource] refreshGroupsSummary: group summary update failed %@", group.groupId);
+            
+            if (weakSelf)
+            {
+                typeof(self) self = weakSelf;
+                [self didRefreshSummaryOfGroup:group success:NO];
+            }
+            
+        }];
+    }
+}
+
+- (void)didRefreshSummaryOfGroup:(MXGroup*)group success:(BOOL)success
+{
+    if (summaryRefreshCount)
+    {
+        summaryRefreshCount--;
+    }
+    
+    if (success)
+    {
+        summaryRefreshDates[group.groupId] = [NSDate date];
+    }
+    
+    NSArray<void (^)(void)> *completions = summaryRefreshCompletions[group.groupId];
+    [summaryRefreshCompletions removeObjectForKey:group.groupId];
+    for (void (^completion)(void) in completions)
+    {
+        completion();
+    }
+    
+    [self startQueuedSummaryRefreshes];
+}
+
 #pragma mark - UITableViewDataSource
 
 - (NSInteger)numberOfSectionsInTableView:(UITableView *)tableView
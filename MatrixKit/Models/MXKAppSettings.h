@@ -16,6 +16,8 @@
  */
 #import <MatrixSDK/MatrixSDK.h>
 
+#import "MXKAppSettingsSnapshot.h"
+
 typedef NS_ENUM(NSUInteger, MXKKeyPreSharingStrategy)
 {
     MXKKeyPreSharingNone = 0,
@@ -261,6 +263,17 @@ typedef NS_ENUM(NSUInteger, MXKKeyPreSharingStrategy)
  */
 @property (nonatomic, getter=isCallKitEnabled) BOOL enableCallKit;
 
+#pragma mark - Snapshot
+
+/**
+ An immutable copy of the settings used to render room events.
+
+ Reading a value from the snapshot is cheaper than calling the corresponding getter, which may require
+ an `NSUserDefaults` lookup. The snapshot is read without lock. A new snapshot (with a new version) is published
+ only when one of these settings changes value.
+ */
+@property (atomic, readonly) MXKAppSettingsSnapshot *snapshot;
+
 #pragma mark - Shared userDefaults
 
 /**
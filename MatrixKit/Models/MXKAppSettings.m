@@ -27,6 +27,9 @@
 
 static MXKAppSettings *standardAppSettings = nil;
 
+// The version of the last created settings snapshot, shared by all the settings instances.
+static NSUInteger lastSnapshotVersion = 0;
+
 static NSString *const kMXAppGroupID = @"group.org.matrix";
 
 @interface MXKAppSettings ()
@@ -34,8 +37,14 @@ static NSString *const kMXAppGroupID = @"group.org.matrix";
     NSMutableArray <NSString*> *eventsFilterForMessages;
     NSMutableArray <NSString*> *allEventTypesForMessages;
     NSMutableArray <NSString*> *lastMessageEventTypesAllowList;
+    
 }
 
+/**
+ The current snapshot of the settings, read without lock. nil until the first read or change.
+ */
+@property (atomic) MXKAppSettingsSnapshot *publishedSnapshot;
+
 @property (nonatomic, readwrite) NSUserDefaults *sharedUserDefaults;
 @property (nonatomic) NSString *currentApplicationGroup;
 
@@ -57,6 +66,9 @@ static NSString *const kMXAppGroupID = @"group.org.matrix";
         if(standardAppSettings == nil)
         {
             standardAppSettings = [[super allocWithZone:NULL] init];
+            
+            // The shared settings are stored in the user defaults which may be modified directly
+            [[NSNotificationCenter defaultCenter] addObserver:standardAppSettings selector:@selector(userDefaultsDidChange:) name:NSUserDefaultsDidChangeNotification object:[NSUserDefaults standardUserDefaults]];
         }
     }
     return standardAppSettings;
@@ -251,6 +263,8 @@ static NSString *const kMXAppGroupID = @"group.org.matrix";
         
         enableCallKit = YES;
     }
+    
+    [self publishSnapshot];
 }
 
 - (NSUserDefaults *)sharedUserDefaults
@@ -285,6 +299,52 @@ static NSString *const kMXAppGroupID = @"group.org.matrix";
     return sharedUserDefaults;
 }
 
+#pragma mark - Snapshot
+
+- (MXKAppSettingsSnapshot *)snapshot
+{
+    MXKAppSettingsSnapshot *snapshot = self.publishedSnapshot;
+    if (!snapshot)
+    {
+        // First read
+        snapshot = [self publishSnapshot];
+    }
+    return snapshot;
+}
+
+- (MXKAppSettingsSnapshot *)publishSnapshot
+{
+    // This must be called once the new value is stored.
+    @synchronized(self)
+    {
+        NSUInteger version;
+        @synchronized(MXKAppSettings.class)
+        {
+            version = ++lastSnapshotVersion;
+        }
+        MXKAppSettingsSnapshot *snapshot = [[MXKAppSettingsSnapshot alloc] initWithAppSettings:self version:version];
+        
+        // Keep the current snapshot (and its version) while its values do not change
+        MXKAppSettingsSnapshot *publishedSnapshot = self.publishedSnapshot;
+        if (publishedSnapshot && [publishedSnapshot hasSameValuesAsSnapshot:snapshot])
+        {
+            return publishedSnapshot;
+        }
+        
+        self.publishedSnapshot = snapshot;
+        return snapshot;
+    }
+}
+
+- (void)userDefaultsDidChange:(NSNotification *)notif
+{
+    // Most of the changes do not concern the snapshot, which is then kept
+    if (self.publishedSnapshot)
+    {
+        [self publishSnapshot];
+    }
+}
+
 #pragma mark - Calls
 
 - (BOOL)syncWithLazyLoadOfRoomMembers
@@ -344,6 +404,8 @@ static NSString *const kMXAppGroupID = @"group.org.matrix";
     {
         showAllEventsInRoomHistory = boolValue;
     }
+    
+    [self publishSnapshot];
 }
 
 - (NSArray *)eventsFilterForMessages
@@ -405,6 +467,8 @@ static NSString *const kMXAppGroupID = @"group.org.matrix";
     {
         showRedactionsInRoomHistory = boolValue;
     }
+    
+    [self publishSnapshot];
 }
 
 - (BOOL)showUnsupportedEventsInRoomHistory
@@ -429,6 +493,22 @@ static NSString *const kMXAppGroupID = @"group.org.matrix";
     {
         showUnsupportedEventsInRoomHistory = boolValue;
     }
+    
+    [self publishSnapshot];
+}
+
+- (void)setHidePreJoinedUndecryptableEvents:(BOOL)hidePreJoinedUndecryptableEvents
+{
+    _hidePreJoinedUndecryptableEvents = hidePreJoinedUndecryptableEvents;
+    
+    [self publishSnapshot];
+}
+
+- (void)setHideUndecryptableEvents:(BOOL)hideUndecryptableEvents
+{
+    _hideUndecryptableEvents = hideUndecryptableEvents;
+    
+    [self publishSnapshot];
 }
 
 - (NSString *)httpLinkScheme
@@ -457,6 +537,8 @@ static NSString *const kMXAppGroupID = @"group.org.matrix";
     {
         httpLinkScheme = stringValue;
     }
+    
+    [self publishSnapshot];
 }
 
 - (NSString *)httpsLinkScheme
@@ -485,6 +567,8 @@ static NSString *const kMXAppGroupID = @"group.org.matrix";
     {
         httpsLinkScheme = stringValue;
     }
+    
+    [self publishSnapshot];
 }
 
 - (BOOL)enableBubbleComponentLinkDetection
@@ -509,6 +593,8 @@ static NSString *const kMXAppGroupID = @"group.org.matrix";
     {
         enableBubbleComponentLinkDetection = storeLinksInBubbleComponents;
     }
+    
+    [self publishSnapshot];
 }
 
 - (NSArray<NSString *> *)firstURLDetectionIgnoredHosts
@@ -538,6 +624,8 @@ static NSString *const kMXAppGroupID = @"group.org.matrix";
     {
         firstURLDetectionIgnoredHosts = ignoredHosts;
     }
+    
+    [self publishSnapshot];
 }
 
 #pragma mark - Room members
@@ -564,6 +652,8 @@ static NSString *const kMXAppGroupID = @"group.org.matrix";
     {
         sortRoomMembersUsingLastSeenTime = boolValue;
     }
+    
+    [self publishSnapshot];
 }
 
 - (BOOL)showLeftMembersInRoomMemberList
@@ -588,6 +678,8 @@ static NSString *const kMXAppGroupID = @"group.org.matrix";
     {
         showLeftMembersInRoomMemberList = boolValue;
     }
+    
+    [self publishSnapshot];
 }
 
 #pragma mark - Contacts
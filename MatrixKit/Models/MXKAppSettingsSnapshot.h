@@ -0,0 +1,125 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class MXKAppSettings;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `MXKAppSettingsSnapshot` is an immutable copy of the `MXKAppSettings` values read while rendering room events.
+
+ A snapshot is cheap to read from any thread: no lock and no `NSUserDefaults` lookup is involved.
+ Capture it once (see `[MXKAppSettings snapshot]`) before handling a batch of events.
+
+ A new snapshot is published each time one of these settings is modified. Its `version` is unique
+ among all the snapshots created during the application lifetime, so that it can be used as a cache key
+ for the data computed from these settings. Two snapshots are equal when they have the same version.
+ */
+@interface MXKAppSettingsSnapshot : NSObject <NSCopying>
+
+/**
+ Create a snapshot of the current values of the provided settings.
+
+ @param settings the application settings.
+ @param version the version of this snapshot.
+ @return the newly created instance.
+ */
+- (instancetype)initWithAppSettings:(MXKAppSettings*)settings version:(NSUInteger)version NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ The version of the snapshot.
+ */
+@property (nonatomic, readonly) NSUInteger version;
+
+/**
+ Tell whether another snapshot has the same values, whatever their versions.
+
+ @param snapshot the other snapshot.
+ @return YES if all the values are equal.
+ */
+- (BOOL)hasSameValuesAsSnapshot:(MXKAppSettingsSnapshot*)snapshot;
+
+#pragma mark - Room display
+
+/**
+ See `[MXKAppSettings showAllEventsInRoomHistory]`.
+ */
+@property (nonatomic, readonly) BOOL showAllEventsInRoomHistory;
+
+/**
+ See `[MXKAppSettings showRedactionsInRoomHistory]`.
+ */
+@property (nonatomic, readonly) BOOL showRedactionsInRoomHistory;
+
+/**
+ See `[MXKAppSettings showUnsupportedEventsInRoomHistory]`.
+ */
+@property (nonatomic, readonly) BOOL showUnsupportedEventsInRoomHistory;
+
+/**
+ See `[MXKAppSettings httpLinkScheme]`.
+ */
+@property (nonatomic, readonly) NSString *httpLinkScheme;
+
+/**
+ See `[MXKAppSettings httpsLinkScheme]`.
+ */
+@property (nonatomic, readonly) NSString *httpsLinkScheme;
+
+/**
+ YES when the link schemes are the default ones ("http" and "https"): the links do not need to be rewritten.
+ */
+@property (nonatomic, readonly) BOOL hasDefaultLinkSchemes;
+
+/**
+ See `[MXKAppSettings enableBubbleComponentLinkDetection]`.
+ */
+@property (nonatomic, readonly) BOOL enableBubbleComponentLinkDetection;
+
+/**
+ See `[MXKAppSettings firstURLDetectionIgnoredHosts]`.
+ */
+@property (nonatomic, readonly) NSArray<NSString *> *firstURLDetectionIgnoredHosts;
+
+/**
+ See `[MXKAppSettings hidePreJoinedUndecryptableEvents]`.
+ */
+@property (nonatomic, readonly) BOOL hidePreJoinedUndecryptableEvents;
+
+/**
+ See `[MXKAppSettings hideUndecryptableEvents]`.
+ */
+@property (nonatomic, readonly) BOOL hideUndecryptableEvents;
+
+#pragma mark - Room members
+
+/**
+ See `[MXKAppSettings sortRoomMembersUsingLastSeenTime]`.
+ */
+@property (nonatomic, readonly) BOOL sortRoomMembersUsingLastSeenTime;
+
+/**
+ See `[MXKAppSettings showLeftMembersInRoomMemberList]`.
+ */
+@property (nonatomic, readonly) BOOL showLeftMembersInRoomMemberList;
+
+@end
+
+NS_ASSUME_NONNULL_END
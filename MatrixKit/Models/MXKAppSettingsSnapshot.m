@@ -0,0 +1,94 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXKAppSettingsSnapshot.h"
+
+#import "MXKAppSettings.h"
+
+@implementation MXKAppSettingsSnapshot
+
+- (instancetype)initWithAppSettings:(MXKAppSettings *)settings version:(NSUInteger)version
+{
+    self = [super init];
+    if (self)
+    {
+        _version = version;
+
+        _showAllEventsInRoomHistory = settings.showAllEventsInRoomHistory;
+        _showRedactionsInRoomHistory = settings.showRedactionsInRoomHistory;
+        _showUnsupportedEventsInRoomHistory = settings.showUnsupportedEventsInRoomHistory;
+
+        _httpLinkScheme = [settings.httpLinkScheme copy] ?: @"http";
+        _httpsLinkScheme = [settings.httpsLinkScheme copy] ?: @"https";
+        _hasDefaultLinkSchemes = [_httpLinkScheme isEqualToString:@"http"] && [_httpsLinkScheme isEqualToString:@"https"];
+
+        _enableBubbleComponentLinkDetection = settings.enableBubbleComponentLinkDetection;
+        _firstURLDetectionIgnoredHosts = [settings.firstURLDetectionIgnoredHosts copy] ?: @[];
+
+        _hidePreJoinedUndecryptableEvents = settings.hidePreJoinedUndecryptableEvents;
+        _hideUndecryptableEvents = settings.hideUndecryptableEvents;
+
+        _sortRoomMembersUsingLastSeenTime = settings.sortRoomMembersUsingLastSeenTime;
+        _showLeftMembersInRoomMemberList = settings.showLeftMembersInRoomMemberList;
+    }
+    return self;
+}
+
+- (BOOL)hasSameValuesAsSnapshot:(MXKAppSettingsSnapshot *)snapshot
+{
+    return _showAllEventsInRoomHistory == snapshot.showAllEventsInRoomHistory
+    && _showRedactionsInRoomHistory == snapshot.showRedactionsInRoomHistory
+    && _showUnsupportedEventsInRoomHistory == snapshot.showUnsupportedEventsInRoomHistory
+    && [_httpLinkScheme isEqualToString:snapshot.httpLinkScheme]
+    && [_httpsLinkScheme isEqualToString:snapshot.httpsLinkScheme]
+    && _enableBubbleComponentLinkDetection == snapshot.enableBubbleComponentLinkDetection
+    && [_firstURLDetectionIgnoredHosts isEqualToArray:snapshot.firstURLDetectionIgnoredHosts]
+    && _hidePreJoinedUndecryptableEvents == snapshot.hidePreJoinedUndecryptableEvents
+    && _hideUndecryptableEvents == snapshot.hideUndecryptableEvents
+    && _sortRoomMembersUsingLastSeenTime == snapshot.sortRoomMembersUsingLastSeenTime
+    && _showLeftMembersInRoomMemberList == snapshot.showLeftMembersInRoomMemberList;
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    // The snapshot is immutable
+    return self;
+}
+
+- (BOOL)isEqual:(id)object
+{
+    if (self == object)
+    {
+        return YES;
+    }
+    if (![object isKindOfClass:MXKAppSettingsSnapshot.class])
+    {
+        return NO;
+    }
+    return _version == ((MXKAppSettingsSnapshot*)object).version;
+}
+
+- (NSUInteger)hash
+{
+    return _version;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<MXKAppSettingsSnapshot: %p> version: %tu", self, _version];
+}
+
+@end
@@ -0,0 +1,152 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+
+#import "MXKAttachment.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The default number of attachments prefetched in the swipe direction.
+ */
+#define MXKATTACHMENTPREFETCHER_DEFAULT_PREFETCH_COUNT 2
+
+/**
+ The default memory budget of the decoded images (in bytes).
+ */
+#define MXKATTACHMENTPREFETCHER_DEFAULT_DECODED_IMAGES_COST_LIMIT (48 * 1024 * 1024)
+
+/**
+ `MXKAttachmentPrefetcher` prepares the images which are about to be displayed by an attachments viewer.
+
+ The neighbors of the displayed attachment, in the swipe direction, are downloaded, decrypted and decoded
+ at the provided pixel size in background. The pending prefetches which are not relevant anymore
+ (for example when the swipe direction changes) are cancelled.
+
+ The decoded images are kept in memory within the `decodedImagesCostLimit` budget.
+
+ Only the static images are prefetched (the animated gifs and the videos are ignored).
+ This class must be used on the main thread.
+ */
+@interface MXKAttachmentPrefetcher : NSObject
+
+/**
+ Create a prefetcher.
+
+ @param maxPixelSize the maximum width or height (in pixels) of the decoded images.
+ @return the newly created instance.
+ */
+- (instancetype)initWithMaxPixelSize:(CGFloat)maxPixelSize;
+
+/**
+ The maximum width or height (in pixels) of the decoded images.
+ */
+@property (nonatomic, readonly) CGFloat maxPixelSize;
+
+/**
+ The number of attachments prefetched in the swipe direction.
+ Default is MXKATTACHMENTPREFETCHER_DEFAULT_PREFETCH_COUNT.
+ */
+@property (nonatomic) NSUInteger prefetchCount;
+
+/**
+ The memory budget of the decoded images (in bytes).
+ Default is MXKATTACHMENTPREFETCHER_DEFAULT_DECODED_IMAGES_COST_LIMIT.
+ */
+@property (nonatomic) NSUInteger decodedImagesCostLimit;
+
+/**
+ Prefetch the neighbors of the displayed attachment.
+
+ The swipe direction is deduced from the previous displayed index. Both sides are prefetched the first time.
+
+ @param attachments the attachments of the viewer.
+ @param index the index of the displayed attachment.
+ */
+- (void)prefetchAttachments:(NSArray<MXKAttachment*>*)attachments aroundIndex:(NSUInteger)index;
+
+/**
+ Get the decoded image of an attachment, if it is available.
+
+ Each call is counted as a hit or a miss in the prefetch metrics: call it once per displayed attachment.
+
+ @param attachment the attachment.
+ @return the decoded image, nil if the attachment has not been prefetched (yet).
+ */
+- (nullable UIImage*)decodedImageForAttachment:(MXKAttachment*)attachment;
+
+/**
+ Get the decoded image of an attachment, if it is available, without counting it in the prefetch metrics.
+
+ @param attachment the attachment.
+ @return the decoded image, nil if the attachment has not been prefetched (yet).
+ */
+- (nullable UIImage*)existingDecodedImageForAttachment:(MXKAttachment*)attachment;
+
+/**
+ Cancel all the pending prefetches.
+ */
+- (void)cancelAll;
+
+/**
+ Cancel all the pending prefetches and release the decoded images.
+ */
+- (void)destroy;
+
+#pragma mark - Metrics
+
+/**
+ The number of decoded images found by `decodedImageForAttachment:`.
+ */
+@property (nonatomic, readonly) NSUInteger hitCount;
+
+/**
+ The number of `decodedImageForAttachment:` calls for which no decoded image was available.
+ */
+@property (nonatomic, readonly) NSUInteger missCount;
+
+/**
+ The number of prefetches cancelled before their end.
+ */
+@property (nonatomic, readonly) NSUInteger cancelledCount;
+
+/**
+ The ratio of hits among the `decodedImageForAttachment:` calls (0 when there was no call).
+ */
+@property (nonatomic, readonly) double hitRate;
+
+/**
+ Reset the metrics.
+ */
+- (void)resetMetrics;
+
+#pragma mark - Decoding
+
+/**
+ Decode an image at a maximum pixel size, without going through a full size bitmap.
+
+ The image orientation is applied. This method may be called on any thread.
+
+ @param data the encoded image.
+ @param maxPixelSize the maximum width or height of the decoded image.
+ @return the decoded image, nil if the data cannot be decoded.
+ */
++ (nullable UIImage*)decodedImageWithData:(NSData*)data maxPixelSize:(CGFloat)maxPixelSize;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,344 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXKAttachmentPrefetcher.h"
+
+#import <ImageIO/ImageIO.h>
+
+@interface MXKAttachmentPrefetcher ()
+{
+    /**
+     The decoded images by attachment key.
+     */
+    NSCache<NSString*, UIImage*> *decodedImages;
+
+    /**
+     The attachments being prefetched by attachment key.
+     */
+    NSMutableDictionary<NSString*, MXKAttachment*> *pendingAttachments;
+
+    /**
+     The identifiers of the downloads triggered by the prefetcher. Only these ones are cancelled.
+     */
+    NSMutableSet<NSString*> *prefetchDownloadIds;
+
+    /**
+     The queue used to decrypt and decode the images.
+     */
+    dispatch_queue_t decodingQueue;
+
+    /**
+     The last displayed index (NSNotFound at first) and the swipe direction (-1, 1 or 0 when it is unknown).
+     */
+    NSUInteger lastIndex;
+    NSInteger direction;
+}
+
+@end
+
+@implementation MXKAttachmentPrefetcher
+
+- (instancetype)initWithMaxPixelSize:(CGFloat)maxPixelSize
+{
+    self = [super init];
+    if (self)
+    {
+        _maxPixelSize = maxPixelSize;
+        _prefetchCount = MXKATTACHMENTPREFETCHER_DEFAULT_PREFETCH_COUNT;
+        _decodedImagesCostLimit = MXKATTACHMENTPREFETCHER_DEFAULT_DECODED_IMAGES_COST_LIMIT;
+
+        decodedImages = [[NSCache alloc] init];
+        decodedImages.totalCostLimit = _decodedImagesCostLimit;
+
+        pendingAttachments = [NSMutableDictionary dictionary];
+        prefetchDownloadIds = [NSMutableSet set];
+        decodingQueue = dispatch_queue_create("MXKAttachmentPrefetcher", DISPATCH_QUEUE_SERIAL);
+
+        lastIndex = NSNotFound;
+        direction = 0;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self destroy];
+}
+
+- (void)destroy
+{
+    [self cancelAll];
+    [decodedImages removeAllObjects];
+    lastIndex = NSNotFound;
+    direction = 0;
+}
+
+- (void)setDecodedImagesCostLimit:(NSUInteger)decodedImagesCostLimit
+{
+    _decodedImagesCostLimit = decodedImagesCostLimit;
+    decodedImages.totalCostLimit = decodedImagesCostLimit;
+}
+
+#pragma mark - Prefetch
+
+- (void)prefetchAttachments:(NSArray<MXKAttachment *> *)attachments aroundIndex:(NSUInteger)index
+{
+    if (index >= attachments.count)
+    {
+        return;
+    }
+
+    if (lastIndex != NSNotFound && index != lastIndex)
+    {
+        direction = (index > lastIndex) ? 1 : -1;
+    }
+    lastIndex = index;
+
+    // List the neighbors in the swipe direction (on both sides when the direction is unknown)
+    NSMutableDictionary<NSString*, MXKAttachment*> *neighbors = [NSMutableDictionary dictionary];
+    for (NSUInteger distance = 1; distance <= _prefetchCount; distance++)
+    {
+        if (direction >= 0 && index + distance < attachments.count)
+        {
+            MXKAttachment *attachment = attachments[index + distance];
+            NSString *key = [self keyForAttachment:attachment];
+            if (key)
+            {
+                neighbors[key] = attachment;
+            }
+        }
+        if (direction <= 0 && index >= distance)
+        {
+            MXKAttachment *attachment = attachments[index - distance];
+            NSString *key = [self keyForAttachment:attachment];
+            if (key)
+            {
+                neighbors[key] = attachment;
+            }
+        }
+    }
+
+    // Cancel the prefetches which are not relevant anymore.
+    // The displayed attachment is kept: its decoded image will be used if the user comes back on it.
+    NSString *displayedAttachmentKey = [self keyForAttachment:attachments[index]];
+    for (NSString *key in pendingAttachments.allKeys)
+    {
+        if (!neighbors[key] && ![key isEqualToString:displayedAttachmentKey])
+        {
+            [self cancelPrefetchWithKey:key];
+        }
+    }
+
+    [neighbors enumerateKeysAndObjectsUsingBlock:^(NSString *key, MXKAttachment *attachment, BOOL *stop) {
+        if (!self->pendingAttachments[key] && ![self->decodedImages objectForKey:key])
+        {
+            [self startPrefetchOfAttachment:attachment withKey:key];
+        }
+    }];
+}
+
+- (UIImage *)decodedImageForAttachment:(MXKAttachment *)attachment
+{
+    if (![self keyForAttachment:attachment])
+    {
+        return nil;
+    }
+
+    UIImage *image = [self existingDecodedImageForAttachment:attachment];
+    if (image)
+    {
+        _hitCount++;
+    }
+    else
+    {
+        _missCount++;
+    }
+    return image;
+}
+
+- (UIImage *)existingDecodedImageForAttachment:(MXKAttachment *)attachment
+{
+    NSString *key = [self keyForAttachment:attachment];
+    return key ? [decodedImages objectForKey:key] : nil;
+}
+
+- (void)cancelAll
+{
+    for (NSString *key in pendingAttachments.allKeys)
+    {
+        [self cancelPrefetchWithKey:key];
+    }
+}
+
+#pragma mark - Metrics
+
+- (double)hitRate
+{
+    NSUInteger lookupCount = _hitCount + _missCount;
+    return lookupCount ? (double)_hitCount / lookupCount : 0;
+}
+
+- (void)resetMetrics
+{
+    _hitCount = 0;
+    _missCount = 0;
+    _cancelledCount = 0;
+}
+
+#pragma mark - Decoding
+
++ (UIImage *)decodedImageWithData:(NSData *)data maxPixelSize:(CGFloat)maxPixelSize
+{
+    NSDictionary *sourceOptions = @{(NSString*)kCGImageSourceShouldCache: @NO};
+    CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)data, (__bridge CFDictionaryRef)sourceOptions);
+    if (!source)
+    {
+        return nil;
+    }
+
+    // Decode now at the right size, instead of decoding the full size bitmap on the main thread when the image is drawn
+    NSDictionary *thumbnailOptions = @{
+                                       (NSString*)kCGImageSourceCreateThumbnailFromImageAlways: @YES,
+                                       (NSString*)kCGImageSourceCreateThumbnailWithTransform: @YES,
+                                       (NSString*)kCGImageSourceShouldCacheImmediately: @YES,
+                                       (NSString*)kCGImageSourceThumbnailMaxPixelSize: @(maxPixelSize)
+                                       };
+    CGImageRef cgImage = CGImageSourceCreateThumbnailAtIndex(source, 0, (__bridge CFDictionaryRef)thumbnailOptions);
+    CFRelease(source);
+
+    if (!cgImage)
+    {
+        return nil;
+    }
+
+    UIImage *image = [UIImage imageWithCGImage:cgImage];
+    CGImageRelease(cgImage);
+    return image;
+}
+
+#pragma mark - Private methods
+
+- (NSString*)keyForAttachment:(MXKAttachment*)attachment
+{
+    // Only the static images are prefetched
+    if (attachment.type != MXKAttachmentTypeImage || !attachment.contentURL
+        || [attachment.contentInfo[@"mimetype"] isEqualToString:@"image/gif"])
+    {
+        return nil;
+    }
+    return attachment.eventId ?: attachment.contentURL;
+}
+
+- (void)startPrefetchOfAttachment:(MXKAttachment*)attachment withKey:(NSString*)key
+{
+    pendingAttachments[key] = attachment;
+
+    NSString *downloadId = attachment.downloadId;
+    if (downloadId
+        && ![[NSFileManager defaultManager] fileExistsAtPath:attachment.cacheFilePath]
+        && ![MXMediaManager existingDownloaderWithIdentifier:downloadId])
+    {
+        [prefetchDownloadIds addObject:downloadId];
+    }
+
+    CGFloat maxPixelSize = _maxPixelSize;
+
+    MXWeakify(self);
+    [attachment prepare:^{
+
+        MXStrongifyAndReturnIfNil(self);
+        if (downloadId)
+        {
+            [self->prefetchDownloadIds removeObject:downloadId];
+        }
+
+        if (self->pendingAttachments[key] != attachment)
+        {
+            // Cancelled in the meantime
+            return;
+        }
+
+        // The attachment file is available, decrypt and decode it in background
+        dispatch_async(self->decodingQueue, ^{
+
+            [attachment getAttachmentData:^(NSData *data) {
+
+                UIImage *image = data ? [MXKAttachmentPrefetcher decodedImageWithData:data maxPixelSize:maxPixelSize] : nil;
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    MXStrongifyAndReturnIfNil(self);
+                    [self didPrefetchAttachment:attachment withKey:key image:image];
+                });
+
+            } failure:^(NSError *error) {
+
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    MXStrongifyAndReturnIfNil(self);
+                    [self didPrefetchAttachment:attachment withKey:key image:nil];
+                });
+            }];
+        });
+
+    } failure:^(NSError *error) {
+
+        MXStrongifyAndReturnIfNil(self);
+        if (downloadId)
+        {
+            [self->prefetchDownloadIds removeObject:downloadId];
+        }
+        [self didPrefetchAttachment:attachment withKey:key image:nil];
+    }];
+}
+
+- (void)didPrefetchAttachment:(MXKAttachment*)attachment withKey:(NSString*)key image:(UIImage*)image
+{
+    if (pendingAttachments[key] != attachment)
+    {
+        // Cancelled in the meantime
+        return;
+    }
+    [pendingAttachments removeObjectForKey:key];
+
+    if (image)
+    {
+        NSUInteger cost = CGImageGetBytesPerRow(image.CGImage) * CGImageGetHeight(image.CGImage);
+        [decodedImages setObject:image forKey:key cost:cost];
+    }
+    else
+    {
+        MXLogDebug(@"[MXKAttachmentPrefetcher] Unable to prefetch attachment %@", key);
+    }
+}
+
+- (void)cancelPrefetchWithKey:(NSString*)key
+{
+    MXKAttachment *attachment = pendingAttachments[key];
+    if (!attachment)
+    {
+        return;
+    }
+    [pendingAttachments removeObjectForKey:key];
+    _cancelledCount++;
+
+    // Stop the download if it has been triggered by the prefetch
+    NSString *downloadId = attachment.downloadId;
+    if (downloadId && [prefetchDownloadIds containsObject:downloadId])
+    {
+        [prefetchDownloadIds removeObject:downloadId];
+        [[MXMediaManager existingDownloaderWithIdentifier:downloadId] cancel];
+    }
+}
+
+@end
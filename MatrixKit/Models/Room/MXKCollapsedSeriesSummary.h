@@ -0,0 +1,113 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import <MatrixSDK/MatrixSDK.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `MXKCollapsedSeriesMemberChanges` aggregates the membership changes of a user in a collapsable series of events.
+ */
+@interface MXKCollapsedSeriesMemberChanges : NSObject
+
+/**
+ The user id (the state key of the membership events).
+ */
+@property (nonatomic, readonly) NSString *userId;
+
+/**
+ The number of joins, leaves (the user left or rejected an invite), kicks (the user has been removed by another one),
+ bans, invites, display name changes and avatar changes.
+ */
+@property (nonatomic, readonly) NSUInteger joinCount;
+@property (nonatomic, readonly) NSUInteger leaveCount;
+@property (nonatomic, readonly) NSUInteger kickCount;
+@property (nonatomic, readonly) NSUInteger banCount;
+@property (nonatomic, readonly) NSUInteger inviteCount;
+@property (nonatomic, readonly) NSUInteger displaynameChangeCount;
+@property (nonatomic, readonly) NSUInteger avatarChangeCount;
+
+/**
+ The display name of the user before the series (from the oldest event), and at the end of the series (from the most recent event).
+ */
+@property (nonatomic, readonly, nullable) NSString *previousDisplayname;
+@property (nonatomic, readonly, nullable) NSString *displayname;
+
+@end
+
+/**
+ `MXKCollapsedSeriesSummary` describes a collapsable series of events, like a storm of membership events.
+
+ The aggregates are updated in constant time when an event is added at one end of the series, so that the summary
+ string of the series can be built without going through all its events (see
+ `[MXKEventFormatter attributedStringFromCollapsedSeriesSummary:withRoomState:error:]`).
+
+ This class is not thread-safe.
+ */
+@interface MXKCollapsedSeriesSummary : NSObject
+
+/**
+ The events of the series, from the oldest one.
+ */
+@property (nonatomic, readonly) NSArray<MXEvent*> *events;
+
+/**
+ The membership changes by user, in the order of their first appearance in the series.
+ */
+@property (nonatomic, readonly) NSArray<MXKCollapsedSeriesMemberChanges*> *memberChanges;
+
+/**
+ The membership changes of a user.
+
+ @param userId the user id.
+ @return the changes of this user, nil if the series contains no membership event for this user.
+ */
+- (nullable MXKCollapsedSeriesMemberChanges*)memberChangesForUserId:(NSString*)userId;
+
+/**
+ The total counts of the membership changes in the series.
+ */
+@property (nonatomic, readonly) NSUInteger joinCount;
+@property (nonatomic, readonly) NSUInteger leaveCount;
+@property (nonatomic, readonly) NSUInteger kickCount;
+@property (nonatomic, readonly) NSUInteger banCount;
+@property (nonatomic, readonly) NSUInteger inviteCount;
+@property (nonatomic, readonly) NSUInteger displaynameChangeCount;
+@property (nonatomic, readonly) NSUInteger avatarChangeCount;
+
+/**
+ The number of events of the series which are not membership events.
+ */
+@property (nonatomic, readonly) NSUInteger otherEventCount;
+
+/**
+ Add an event at the end of the series (the most recent side).
+
+ @param event the event.
+ */
+- (void)appendEvent:(MXEvent*)event;
+
+/**
+ Add an event at the start of the series (the oldest side).
+
+ @param event the event.
+ */
+- (void)prependEvent:(MXEvent*)event;
+
+@end
+
+NS_ASSUME_NONNULL_END
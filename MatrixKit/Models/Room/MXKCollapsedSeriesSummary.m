@@ -0,0 +1,222 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXKCollapsedSeriesSummary.h"
+
+/**
+ The kind of membership change described by a membership event.
+ */
+typedef NS_ENUM(NSUInteger, MXKCollapsedSeriesMembershipChange)
+{
+    MXKCollapsedSeriesMembershipChangeNone,
+    MXKCollapsedSeriesMembershipChangeJoin,
+    MXKCollapsedSeriesMembershipChangeLeave,
+    MXKCollapsedSeriesMembershipChangeKick,
+    MXKCollapsedSeriesMembershipChangeBan,
+    MXKCollapsedSeriesMembershipChangeInvite,
+    MXKCollapsedSeriesMembershipChangeProfile
+};
+
+@interface MXKCollapsedSeriesMemberChanges ()
+
+@property (nonatomic, readwrite) NSUInteger joinCount;
+@property (nonatomic, readwrite) NSUInteger leaveCount;
+@property (nonatomic, readwrite) NSUInteger kickCount;
+@property (nonatomic, readwrite) NSUInteger banCount;
+@property (nonatomic, readwrite) NSUInteger inviteCount;
+@property (nonatomic, readwrite) NSUInteger displaynameChangeCount;
+@property (nonatomic, readwrite) NSUInteger avatarChangeCount;
+@property (nonatomic, readwrite) NSString *previousDisplayname;
+@property (nonatomic, readwrite) NSString *displayname;
+
+@end
+
+@implementation MXKCollapsedSeriesMemberChanges
+
+- (instancetype)initWithUserId:(NSString*)userId
+{
+    self = [super init];
+    if (self)
+    {
+        _userId = userId;
+    }
+    return self;
+}
+
+@end
+
+@interface MXKCollapsedSeriesSummary ()
+{
+    NSMutableArray<MXEvent*> *events;
+    NSMutableArray<MXKCollapsedSeriesMemberChanges*> *memberChanges;
+    NSMutableDictionary<NSString*, MXKCollapsedSeriesMemberChanges*> *memberChangesByUserId;
+}
+
+@end
+
+@implementation MXKCollapsedSeriesSummary
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        events = [NSMutableArray array];
+        memberChanges = [NSMutableArray array];
+        memberChangesByUserId = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (NSArray<MXEvent *> *)events
+{
+    return events;
+}
+
+- (NSArray<MXKCollapsedSeriesMemberChanges *> *)memberChanges
+{
+    return memberChanges;
+}
+
+- (MXKCollapsedSeriesMemberChanges *)memberChangesForUserId:(NSString *)userId
+{
+    return memberChangesByUserId[userId];
+}
+
+- (void)appendEvent:(MXEvent *)event
+{
+    [events addObject:event];
+    [self aggregateEvent:event appended:YES];
+}
+
+- (void)prependEvent:(MXEvent *)event
+{
+    // The array is a deque, the insertion at its start does not move the other events
+    [events insertObject:event atIndex:0];
+    [self aggregateEvent:event appended:NO];
+}
+
+#pragma mark - Private methods
+
+- (void)aggregateEvent:(MXEvent*)event appended:(BOOL)appended
+{
+    NSString *userId = event.stateKey;
+    if (event.eventType != MXEventTypeRoomMember || !userId)
+    {
+        _otherEventCount++;
+        return;
+    }
+    
+    MXKCollapsedSeriesMemberChanges *changes = memberChangesByUserId[userId];
+    if (!changes)
+    {
+        changes = [[MXKCollapsedSeriesMemberChanges alloc] initWithUserId:userId];
+        memberChangesByUserId[userId] = changes;
+        if (appended)
+        {
+            [memberChanges addObject:changes];
+        }
+        else
+        {
+            [memberChanges insertObject:changes atIndex:0];
+        }
+    }
+    
+    NSString *displayname, *prevDisplayname;
+    MXJSONModelSetString(displayname, event.content[@"displayname"]);
+    MXJSONModelSetString(prevDisplayname, event.prevContent[@"displayname"]);
+    
+    // Keep the display names at both ends of the series
+    if (appended || !changes.displayname)
+    {
+        changes.displayname = displayname;
+    }
+    if (!appended || !changes.previousDisplayname)
+    {
+        changes.previousDisplayname = prevDisplayname ?: displayname;
+    }
+    
+    switch ([self membershipChangeOfEvent:event])
+    {
+        case MXKCollapsedSeriesMembershipChangeJoin:
+            changes.joinCount++;
+            _joinCount++;
+            break;
+        case MXKCollapsedSeriesMembershipChangeLeave:
+            changes.leaveCount++;
+            _leaveCount++;
+            break;
+        case MXKCollapsedSeriesMembershipChangeKick:
+            changes.kickCount++;
+            _kickCount++;
+            break;
+        case MXKCollapsedSeriesMembershipChangeBan:
+            changes.banCount++;
+            _banCount++;
+            break;
+        case MXKCollapsedSeriesMembershipChangeInvite:
+            changes.inviteCount++;
+            _inviteCount++;
+            break;
+        case MXKCollapsedSeriesMembershipChangeProfile:
+        {
+            if (![displayname ?: @"" isEqualToString:prevDisplayname ?: @""])
+            {
+                changes.displaynameChangeCount++;
+                _displaynameChangeCount++;
+            }
+            
+            NSString *avatarURL, *prevAvatarURL;
+            MXJSONModelSetString(avatarURL, event.content[@"avatar_url"]);
+            MXJSONModelSetString(prevAvatarURL, event.prevContent[@"avatar_url"]);
+            if (![avatarURL ?: @"" isEqualToString:prevAvatarURL ?: @""])
+            {
+                changes.avatarChangeCount++;
+                _avatarChangeCount++;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+- (MXKCollapsedSeriesMembershipChange)membershipChangeOfEvent:(MXEvent*)event
+{
+    NSString *membership, *prevMembership;
+    MXJSONModelSetString(membership, event.content[@"membership"]);
+    MXJSONModelSetString(prevMembership, event.prevContent[@"membership"]);
+    
+    if ([membership isEqualToString:@"join"])
+    {
+        return [prevMembership isEqualToString:@"join"] ? MXKCollapsedSeriesMembershipChangeProfile : MXKCollapsedSeriesMembershipChangeJoin;
+    }
+    if ([membership isEqualToString:@"leave"])
+    {
+        return [event.sender isEqualToString:event.stateKey] ? MXKCollapsedSeriesMembershipChangeLeave : MXKCollapsedSeriesMembershipChangeKick;
+    }
+    if ([membership isEqualToString:@"ban"])
+    {
+        return MXKCollapsedSeriesMembershipChangeBan;
+    }
+    if ([membership isEqualToString:@"invite"])
+    {
+        return MXKCollapsedSeriesMembershipChangeInvite;
+    }
+    return MXKCollapsedSeriesMembershipChangeNone;
+}
+
+@end
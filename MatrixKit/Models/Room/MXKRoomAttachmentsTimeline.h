@@ -0,0 +1,111 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import <MatrixSDK/MatrixSDK.h>
+
+#import "MXKAttachment.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The default number of events requested to the homeserver by a media pagination.
+ */
+#define MXKROOMATTACHMENTSTIMELINE_DEFAULT_PAGINATION_LIMIT 30
+
+/**
+ `MXKRoomAttachmentsTimeline` lists the attachments with thumbnail (images and videos) of a room.
+
+ It is seeded with the most recent attachments, those already loaded by the room data source, and paginates back
+ the room history with a server-side event filter restricted to the media events. Unlike a room data source back pagination,
+ the other events of the room are neither downloaded nor formatted.
+
+ Note: the content of the encrypted events cannot be filtered by the homeserver. In an encrypted room, the filter is
+ restricted to the message event types and the attachments are selected after decryption.
+
+ This class must be used on the main thread.
+ */
+@interface MXKRoomAttachmentsTimeline : NSObject
+
+/**
+ Create a media timeline.
+
+ @param roomId the id of the room.
+ @param mxSession the Matrix session.
+ @return the newly created instance.
+ */
+- (instancetype)initWithRoomId:(NSString*)roomId andMatrixSession:(MXSession*)mxSession;
+
+/**
+ The id of the room.
+ */
+@property (nonatomic, readonly) NSString *roomId;
+
+/**
+ The Matrix session.
+ */
+@property (nonatomic, readonly, weak) MXSession *mxSession;
+
+/**
+ The known attachments, from the oldest to the most recent one.
+ */
+@property (nonatomic, readonly) NSArray<MXKAttachment*> *attachments;
+
+/**
+ The number of events requested to the homeserver by each request.
+ Default is MXKROOMATTACHMENTSTIMELINE_DEFAULT_PAGINATION_LIMIT.
+ */
+@property (nonatomic) NSUInteger paginationLimit;
+
+/**
+ Tell whether some older attachments may be available.
+ */
+@property (nonatomic, readonly) BOOL canPaginateBackwards;
+
+/**
+ Tell whether a back pagination is in progress.
+ */
+@property (nonatomic, readonly) BOOL isPaginating;
+
+/**
+ Update the most recent attachments, the ones loaded by the room data source.
+
+ The attachments retrieved by back pagination are kept (except the ones which are now part of the recent attachments).
+
+ @param recentAttachments the most recent attachments, from the oldest to the most recent one.
+ */
+- (void)updateRecentAttachments:(NSArray<MXKAttachment*>*)recentAttachments;
+
+/**
+ Retrieve the attachments sent before the oldest known attachment.
+
+ Pages without attachment are skipped: the success block is called once at least one attachment has been added,
+ or when the beginning of the room history is reached. This request is ignored if a back pagination is already in progress.
+
+ @param success a block called on success. It provides the added attachments (from the oldest one).
+ @param failure a block called on failure.
+ */
+- (void)paginateBackwards:(void (^)(NSArray<MXKAttachment*> *addedAttachments))success
+                  failure:(nullable void (^)(NSError *error))failure;
+
+/**
+ Cancel the pending requests and release the attachments.
+ */
+- (void)destroy;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,328 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXKRoomAttachmentsTimeline.h"
+
+@interface MXKRoomAttachmentsTimeline ()
+{
+    /**
+     The attachments retrieved by back pagination, from the oldest one.
+     */
+    NSMutableArray<MXKAttachment*> *olderAttachments;
+
+    /**
+     The most recent attachments, provided by the room data source.
+     */
+    NSArray<MXKAttachment*> *recentAttachments;
+
+    /**
+     The token used to paginate back the media events. nil until the first request.
+     */
+    NSString *paginationToken;
+
+    /**
+     The filter restricting the paginated events to the media events.
+     */
+    MXRoomEventFilter *roomEventFilter;
+
+    /**
+     The pending request, if any.
+     */
+    MXHTTPOperation *currentOperation;
+}
+
+@end
+
+@implementation MXKRoomAttachmentsTimeline
+
+- (instancetype)initWithRoomId:(NSString *)roomId andMatrixSession:(MXSession *)mxSession
+{
+    self = [super init];
+    if (self)
+    {
+        _roomId = roomId;
+        _mxSession = mxSession;
+        _paginationLimit = MXKROOMATTACHMENTSTIMELINE_DEFAULT_PAGINATION_LIMIT;
+        _canPaginateBackwards = YES;
+
+        olderAttachments = [NSMutableArray array];
+        recentAttachments = @[];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self destroy];
+}
+
+- (void)destroy
+{
+    [currentOperation cancel];
+    currentOperation = nil;
+    _isPaginating = NO;
+    _canPaginateBackwards = NO;
+
+    // The recent attachments belong to the room data source
+    for (MXKAttachment *attachment in olderAttachments)
+    {
+        [attachment destroy];
+    }
+    [olderAttachments removeAllObjects];
+    recentAttachments = @[];
+}
+
+- (NSArray<MXKAttachment *> *)attachments
+{
+    return [olderAttachments arrayByAddingObjectsFromArray:recentAttachments];
+}
+
+- (void)updateRecentAttachments:(NSArray<MXKAttachment *> *)attachments
+{
+    recentAttachments = attachments ? [attachments copy] : @[];
+
+    // Remove the paginated attachments which are now loaded by the room data source
+    NSMutableSet<NSString*> *recentEventIds = [NSMutableSet setWithCapacity:recentAttachments.count];
+    for (MXKAttachment *attachment in recentAttachments)
+    {
+        if (attachment.eventId)
+        {
+            [recentEventIds addObject:attachment.eventId];
+        }
+    }
+
+    NSIndexSet *indexes = [olderAttachments indexesOfObjectsPassingTest:^BOOL(MXKAttachment *attachment, NSUInteger idx, BOOL *stop) {
+        return attachment.eventId && [recentEventIds containsObject:attachment.eventId];
+    }];
+    [olderAttachments removeObjectsAtIndexes:indexes];
+}
+
+#pragma mark - Pagination
+
+- (void)paginateBackwards:(void (^)(NSArray<MXKAttachment *> *))success failure:(void (^)(NSError *))failure
+{
+    if (_isPaginating)
+    {
+        MXLogDebug(@"[MXKRoomAttachmentsTimeline] paginateBackwards: ignored, a pagination is already in progress");
+        return;
+    }
+
+    if (!_canPaginateBackwards || !_mxSession)
+    {
+        success(@[]);
+        return;
+    }
+
+    _isPaginating = YES;
+
+    if (paginationToken)
+    {
+        [self paginateBackwardsFromToken:paginationToken addedAttachments:[NSMutableArray array] success:success failure:failure];
+        return;
+    }
+
+    // The pagination starts before the oldest known attachment
+    NSString *anchorEventId = self.attachments.firstObject.eventId;
+    if (!anchorEventId || [anchorEventId hasPrefix:kMXEventLocalEventIdPrefix])
+    {
+        // There is nothing to paginate from
+        _isPaginating = NO;
+        _canPaginateBackwards = NO;
+        success(@[]);
+        return;
+    }
+
+    MXWeakify(self);
+    currentOperation = [_mxSession.matrixRestClient contextOfEvent:anchorEventId inRoom:_roomId limit:0 filter:self.roomEventFilter success:^(MXEventContext *eventContext) {
+
+        MXStrongifyAndReturnIfNil(self);
+        self->currentOperation = nil;
+
+        if (!eventContext.start)
+        {
+            self->_isPaginating = NO;
+            self->_canPaginateBackwards = NO;
+            success(@[]);
+            return;
+        }
+
+        [self paginateBackwardsFromToken:eventContext.start addedAttachments:[NSMutableArray array] success:success failure:failure];
+
+    } failure:^(NSError *error) {
+
+        MXStrongifyAndReturnIfNil(self);
+        [self didFailPaginatingWithError:error failure:failure];
+    }];
+}
+
+- (void)paginateBackwardsFromToken:(NSString*)token
+                  addedAttachments:(NSMutableArray<MXKAttachment*>*)addedAttachments
+                           success:(void (^)(NSArray<MXKAttachment *> *))success
+                           failure:(void (^)(NSError *))failure
+{
+    MXWeakify(self);
+    currentOperation = [_mxSession.matrixRestClient messagesForRoom:_roomId from:token direction:MXTimelineDirectionBackwards limit:_paginationLimit filter:self.roomEventFilter success:^(MXPaginationResponse *paginatedResponse) {
+
+        MXStrongifyAndReturnIfNil(self);
+        self->currentOperation = nil;
+
+        self->paginationToken = paginatedResponse.end;
+        if (!paginatedResponse.chunk.count || !paginatedResponse.end || [paginatedResponse.end isEqualToString:paginatedResponse.start])
+        {
+            // The beginning of the room history has been reached
+            self->_canPaginateBackwards = NO;
+        }
+
+        [self decryptEventsIfNeeded:paginatedResponse.chunk onComplete:^{
+
+            MXStrongifyAndReturnIfNil(self);
+            if (!self->_isPaginating)
+            {
+                // The timeline has been destroyed in the meantime
+                return;
+            }
+
+            // The chunk is ordered from the most recent event
+            NSArray<MXKAttachment*> *pageAttachments = [self attachmentsWithEvents:paginatedResponse.chunk.reverseObjectEnumerator.allObjects];
+            [self->olderAttachments insertObjects:pageAttachments atIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, pageAttachments.count)]];
+            [addedAttachments insertObjects:pageAttachments atIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, pageAttachments.count)]];
+
+            if (addedAttachments.count || !self->_canPaginateBackwards)
+            {
+                MXLogDebug(@"[MXKRoomAttachmentsTimeline] paginateBackwards: %tu attachments added in room %@", addedAttachments.count, self->_roomId);
+
+                self->_isPaginating = NO;
+                success(addedAttachments);
+            }
+            else
+            {
+                // This page contains only other media (files, audio...), go on
+                [self paginateBackwardsFromToken:self->paginationToken addedAttachments:addedAttachments success:success failure:failure];
+            }
+        }];
+
+    } failure:^(NSError *error) {
+
+        MXStrongifyAndReturnIfNil(self);
+        [self didFailPaginatingWithError:error failure:failure];
+    }];
+}
+
+- (void)didFailPaginatingWithError:(NSError*)error failure:(void (^)(NSError *))failure
+{
+    MXLogDebug(@"[MXKRoomAttachmentsTimeline] paginateBackwards: failed in room %@. Error: %@", _roomId, error);
+
+    currentOperation = nil;
+    _isPaginating = NO;
+
+    if (failure)
+    {
+        failure(error);
+    }
+}
+
+#pragma mark - Private methods
+
+- (MXRoomEventFilter*)roomEventFilter
+{
+    if (!roomEventFilter)
+    {
+        roomEventFilter = [[MXRoomEventFilter alloc] init];
+
+        MXRoom *room = [_mxSession roomWithRoomId:_roomId];
+        if (room.summary.isEncrypted)
+        {
+            // The homeserver cannot see the content of the encrypted events
+            roomEventFilter.types = @[kMXEventTypeStringRoomMessage, kMXEventTypeStringRoomEncrypted];
+        }
+        else
+        {
+            roomEventFilter.types = @[kMXEventTypeStringRoomMessage];
+            roomEventFilter.containsURL = YES;
+        }
+    }
+    return roomEventFilter;
+}
+
+- (void)decryptEventsIfNeeded:(NSArray<MXEvent*>*)events onComplete:(void (^)(void))onComplete
+{
+    NSMutableArray<MXEvent*> *encryptedEvents = [NSMutableArray array];
+    for (MXEvent *event in events)
+    {
+        if (event.eventType == MXEventTypeRoomEncrypted)
+        {
+            [encryptedEvents addObject:event];
+        }
+    }
+
+    if (!encryptedEvents.count || !_mxSession)
+    {
+        onComplete();
+        return;
+    }
+
+    [_mxSession decryptEvents:encryptedEvents inTimeline:nil onComplete:^(NSArray<MXEvent *> *failedEvents) {
+        dispatch_async(dispatch_get_main_queue(), onComplete);
+    }];
+}
+
+- (NSArray<MXKAttachment*>*)attachmentsWithEvents:(NSArray<MXEvent*>*)events
+{
+    NSMutableSet<NSString*> *knownEventIds = [NSMutableSet set];
+    for (MXKAttachment *attachment in self.attachments)
+    {
+        if (attachment.eventId)
+        {
+            [knownEventIds addObject:attachment.eventId];
+        }
+    }
+
+    NSMutableArray<MXKAttachment*> *attachments = [NSMutableArray array];
+    MXScanManager *scanManager = _mxSession.scanManager;
+
+    for (MXEvent *event in events)
+    {
+        // Consider only the media displayed by the attachments viewer (the stickers are excluded)
+        if (event.eventType != MXEventTypeRoomMessage || event.isRedactedEvent || [knownEventIds containsObject:event.eventId])
+        {
+            continue;
+        }
+
+        MXKAttachment *attachment = [[MXKAttachment alloc] initWithEvent:event andMediaManager:_mxSession.mediaManager];
+        if (attachment.type != MXKAttachmentTypeImage && attachment.type != MXKAttachmentTypeVideo)
+        {
+            continue;
+        }
+
+        if (scanManager)
+        {
+            // Ignore the media which are not trusted by the antivirus, like the room data source does
+            [scanManager scanEventIfNeeded:event];
+            MXEventScan *eventScan = [scanManager eventScanWithId:event.eventId];
+            if (eventScan && eventScan.antivirusScanStatus != MXAntivirusScanStatusTrusted)
+            {
+                continue;
+            }
+        }
+
+        [attachments addObject:attachment];
+        [knownEventIds addObject:event.eventId];
+    }
+
+    return attachments;
+}
+
+@end
@@ -104,6 +104,12 @@
  */
 @property (nonatomic, readonly) MXKRoomBubbleComponentDisplayFix displayFix;
 
+/**
+ The frames of the side borders to display for HTML blockquotes, in the text view coordinates (array of CGRect values).
+ They are computed during the text layout that computes `contentSize`, only when `displayFix` contains `MXKRoomBubbleComponentDisplayFixHtmlBlockquote`.
+ */
+@property (nonatomic, readonly) NSArray<NSValue*> *htmlBlockquoteBorderRects;
+
 /**
  Attachment upload
  */
@@ -31,6 +31,7 @@
 @synthesize textMessage, attributedTextMessage;
 @synthesize shouldHideSenderName, isTyping, showBubbleDateTime, showBubbleReceipts, useCustomDateTimeLabel, useCustomReceipts, useCustomUnsentButton, hasNoDisplay;
 @synthesize tag;
+@synthesize htmlBlockquoteBorderRects = _htmlBlockquoteBorderRects;
 @synthesize collapsable, collapsed, collapsedAttributedTextMessage, prevCollapsableCellData, nextCollapsableCellData, collapseState;
 
 #pragma mark - MXKRoomBubbleCellDataStoring
@@ -236,6 +237,39 @@
     return count;
 }
 
+- (BOOL)updateSentStateOfEvent:(NSString *)eventId withEvent:(MXEvent *)event
+{
+    // The subclasses which override `updateEvent:withEvent:` may update their own data on sent state changes: keep calling it for them
+    BOOL isUpdateEventOverridden = [[self class] instanceMethodForSelector:@selector(updateEvent:withEvent:)] != [MXKRoomBubbleCellData instanceMethodForSelector:@selector(updateEvent:withEvent:)];
+    
+    // An attachment bound to the previous event id must be rebuilt
+    if (!isUpdateEventOverridden && (!attachment || [attachment.eventId isEqualToString:event.eventId]))
+    {
+        @synchronized(bubbleComponents)
+        {
+            for (MXKRoomBubbleComponent *roomBubbleComponent in bubbleComponents)
+            {
+                // The local echo instance may already have its final identifier
+                if (roomBubbleComponent.event == event || [roomBubbleComponent.event.eventId isEqualToString:eventId])
+                {
+                    if ([roomBubbleComponent updateWithSentStateOfEvent:event roomState:roomDataSource.roomState session:self.mxSession])
+                    {
+                        // Rebuild the cached attributed string with the new colors.
+                        // The content size is kept: the text layout does not depend on the colors.
+                        attributedTextMessage = nil;
+                        return YES;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    
+    // The content has changed, format the event again
+    [self updateEvent:eventId withEvent:event];
+    return NO;
+}
+
 - (NSUInteger)removeEventsFromEvent:(NSString*)eventId removedEvents:(NSArray<MXEvent*>**)removedEvents;
 {
     NSMutableArray *cuttedEvents = [NSMutableArray array];
@@ -470,6 +504,11 @@
 }
 
 - (CGSize)textContentSize:(NSAttributedString*)attributedText removeVerticalInset:(BOOL)removeVerticalInset
+{
+    return [self textContentSize:attributedText removeVerticalInset:removeVerticalInset htmlBlockquoteBorderRects:NULL];
+}
+
+- (CGSize)textContentSize:(NSAttributedString*)attributedText removeVerticalInset:(BOOL)removeVerticalInset htmlBlockquoteBorderRects:(NSArray<NSValue*> **)htmlBlockquoteBorderRects
 {
     static UITextView* measurementTextView = nil;
     static UITextView* measurementTextViewWithoutInset = nil;
@@ -506,13 +545,61 @@
         {
             size.width = size.width + paragraphStyle.headIndent;
         }
+        
+        if (htmlBlockquoteBorderRects)
+        {
+            // Use the layout done by the measurement text view to locate the blockquotes
+            *htmlBlockquoteBorderRects = [self htmlBlockquoteBorderRectsInAttributedString:attributedText layoutTextView:selectedTextView];
+        }
 
         return size;
     }
     
+    if (htmlBlockquoteBorderRects)
+    {
+        *htmlBlockquoteBorderRects = nil;
+    }
+    
     return CGSizeZero;
 }
 
+/**
+ Compute the frames of the side borders of the HTML blockquotes of an attributed string.
+
+ @discussion
+ `NSAttributedString` and `UITextView` classes do not support blockquote borders natively.
+ The bubble cell adds a view for each returned frame.
+
+ @param attributedText the attributed text laid out by the text view.
+ @param textView the text view in which the text has been laid out.
+ @return the frames in the text view coordinates.
+ */
+- (NSArray<NSValue*>*)htmlBlockquoteBorderRectsInAttributedString:(NSAttributedString*)attributedText layoutTextView:(UITextView*)textView
+{
+    NSMutableArray<NSValue*> *borderRects = [NSMutableArray array];
+    
+    NSLayoutManager *layoutManager = textView.layoutManager;
+    NSTextContainer *textContainer = textView.textContainer;
+    
+    [MXKTools enumerateMarkedBlockquotesInAttributedString:attributedText usingBlock:^(NSRange range, BOOL *stop) {
+        
+        // Get the rect area of this blockquote within the text view
+        // This rect covers all the lines of the blockquote block
+        NSRange glyphRange = [layoutManager glyphRangeForCharacterRange:range actualCharacterRange:NULL];
+        CGRect textRect = [layoutManager boundingRectForGlyphRange:glyphRange inTextContainer:textContainer];
+        
+        if (!CGRectIsEmpty(textRect))
+        {
+            // Add a left border with a height that covers all the blockquote block height
+            // TODO: Manage RTL language
+            CGRect borderRect = CGRectMake(5, textRect.origin.y + textView.textContainerInset.top, 4, textRect.size.height);
+            [borderRects addObject:[NSValue valueWithCGRect:borderRect]];
+        }
+    }];
+    
+    return borderRects;
+}
+
 #pragma mark - Properties
 
 - (MXSession*)mxSession
@@ -607,6 +694,14 @@
     return NO;
 }
 
+- (NSArray<NSValue *> *)htmlBlockquoteBorderRects
+{
+    // The borders are computed with the content size
+    [self contentSize];
+    
+    return _htmlBlockquoteBorderRects;
+}
+
 - (MXKRoomBubbleComponentDisplayFix)displayFix
 {
     MXKRoomBubbleComponentDisplayFix displayFix = MXKRoomBubbleComponentDisplayFixNone;
@@ -723,16 +818,24 @@
         if (attachment == nil)
         {
             // Here the bubble is a text message
+            // Compute the blockquote borders during the same text layout, if any
+            BOOL hasHTMLBlockquotes = (self.displayFix & MXKRoomBubbleComponentDisplayFixHtmlBlockquote);
+            __block NSArray<NSValue*> *borderRects;
             if ([NSThread currentThread] != [NSThread mainThread])
             {
                 dispatch_sync(dispatch_get_main_queue(), ^{
-                    self->_contentSize = [self textContentSize:self.attributedTextMessage removeVerticalInset:NO];
+                    NSArray<NSValue*> *rects;
+                    self->_contentSize = [self textContentSize:self.attributedTextMessage removeVerticalInset:NO htmlBlockquoteBorderRects:(hasHTMLBlockquotes ? &rects : NULL)];
+                    borderRects = rects;
                 });
             }
             else
             {
-                _contentSize = [self textContentSize:self.attributedTextMessage removeVerticalInset:NO];
+                NSArray<NSValue*> *rects;
+                _contentSize = [self textContentSize:self.attributedTextMessage removeVerticalInset:NO htmlBlockquoteBorderRects:(hasHTMLBlockquotes ? &rects : NULL)];
+                borderRects = rects;
             }
+            _htmlBlockquoteBorderRects = borderRects;
         }
         else if (self.isAttachmentWithThumbnail)
         {
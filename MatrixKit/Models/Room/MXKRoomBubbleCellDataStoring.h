@@ -344,5 +344,18 @@ Update the event because its sent state changed or it is has been redacted.
  */
 - (BOOL)mergeWithBubbleCellData:(id<MXKRoomBubbleCellDataStoring>)bubbleCellData;
 
+/**
+ Update the event because only its sent state (or its identifier) changed.
+ 
+ Unlike `updateEvent:withEvent:`, the event is not formatted again when its content is unchanged:
+ only the attributes which depend on the event state (text color, encryption badge) are updated.
+ The classes which override `updateEvent:withEvent:` get the full update, so that their overrides are still called.
+ 
+ @param eventId the id of the event to change.
+ @param event the new event data
+ @return YES if the layout of the bubble is unchanged, NO if a full update has been done (see `updateEvent:withEvent:`).
+ */
+- (BOOL)updateSentStateOfEvent:(NSString*)eventId withEvent:(MXEvent*)event;
+
 
 @end
@@ -123,5 +123,19 @@ typedef enum : NSUInteger {
  */
 - (void)updateWithEvent:(MXEvent*)event roomState:(MXRoomState*)roomState session:(MXSession*)session;
 
+/**
+ Update the event because only its sent state (or its identifier) changed.
+
+ The text message is not formatted again: only the text color which depends on the event state is updated.
+ This is not possible when the content of the event has changed since the last formatting (for example when
+ a local echo is replaced by an event with a different content). `updateWithEvent:roomState:session:` must be used then.
+
+ @param event the new event data.
+ @param roomState the up-to-date state of the room.
+ @param session the related matrix session.
+ @return YES if the component has been updated, NO if a full update is required.
+ */
+- (BOOL)updateWithSentStateOfEvent:(MXEvent*)event roomState:(MXRoomState*)roomState session:(MXSession*)session;
+
 @end
 
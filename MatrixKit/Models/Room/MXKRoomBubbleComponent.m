@@ -18,6 +18,18 @@
 
 #import "MXEvent+MatrixKit.h"
 #import "MXKSwiftHeader.h"
+#import "MXKTextAnalysis.h"
+
+@interface MXKRoomBubbleComponent ()
+{
+    /**
+     The content of the event and the state dependent text color used during the last formatting.
+     */
+    NSDictionary *formattedContent;
+    UIColor *formattedTextColor;
+}
+
+@end
 
 @implementation MXKRoomBubbleComponent
 
@@ -36,6 +48,8 @@
         
         _textMessage = nil;
         _attributedTextMessage = eventString;
+        formattedContent = event.content;
+        formattedTextColor = [_eventFormatter textColorForEvent:event];
         
         // Set date time
         if (event.originServerTs != kMXUndefinedTimestamp)
@@ -84,12 +98,48 @@
 
     MXKEventFormatterError error;
     _attributedTextMessage = [_eventFormatter attributedStringFromEvent:event withRoomState:roomState error:&error];
+    formattedContent = event.content;
+    formattedTextColor = [_eventFormatter textColorForEvent:event];
     
     _showEncryptionBadge = [self shouldShowWarningBadgeForEvent:event roomState:roomState session:session];
     
     [self updateLinkWithRoomState:roomState];
 }
 
+- (BOOL)updateWithSentStateOfEvent:(MXEvent*)event roomState:(MXRoomState*)roomState session:(MXSession*)session
+{
+    // The rendered string depends on the event content, check it has not changed
+    if (!_attributedTextMessage || !formattedTextColor || event.isRedactedEvent
+        || ![event.type isEqualToString:_event.type]
+        || (event.content != formattedContent && ![event.content isEqualToDictionary:formattedContent]))
+    {
+        return NO;
+    }
+    
+    _event = event;
+    
+    UIColor *textColor = [_eventFormatter textColorForEvent:event];
+    if (textColor && ![textColor isEqual:formattedTextColor])
+    {
+        // Replace the previous state color, the other colors (links, pills, quotes...) are kept
+        NSMutableAttributedString *attributedTextMessage = [_attributedTextMessage mutableCopy];
+        UIColor *previousTextColor = formattedTextColor;
+        [_attributedTextMessage enumerateAttribute:NSForegroundColorAttributeName inRange:NSMakeRange(0, _attributedTextMessage.length) options:0 usingBlock:^(id value, NSRange range, BOOL *stop) {
+            if ([value isEqual:previousTextColor])
+            {
+                [attributedTextMessage addAttribute:NSForegroundColorAttributeName value:textColor range:range];
+            }
+        }];
+        
+        _attributedTextMessage = attributedTextMessage;
+        formattedTextColor = textColor;
+    }
+    
+    _showEncryptionBadge = [self shouldShowWarningBadgeForEvent:event roomState:roomState session:session];
+    
+    return YES;
+}
+
 - (NSString *)textMessage
 {
     if (!_textMessage)
@@ -102,7 +152,7 @@
 - (void)updateLinkWithRoomState:(MXRoomState*)roomState
 {
     // Ensure link detection has been enabled
-    if (!MXKAppSettings.standardAppSettings.enableBubbleComponentLinkDetection)
+    if (!MXKAppSettings.standardAppSettings.snapshot.enableBubbleComponentLinkDetection)
     {
         return;
     }
@@ -124,8 +174,9 @@
     
     // Detect links in the attributed string which gets updated when the message is edited.
     // Restrict detection to the unquoted string so links are only found in the sender's message.
+    // The analysis of the text is shared with the event formatter.
     NSString *body = [self.attributedTextMessage mxk_unquotedString];
-    NSURL *url = [body mxk_firstURLDetected];
+    NSURL *url = body ? [MXKTextAnalysis analysisOfString:body].firstWebURL : nil;
     
     if (!url)
     {
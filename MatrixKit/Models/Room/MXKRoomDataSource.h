@@ -34,6 +34,19 @@
  */
 #define MXKROOMDATASOURCE_PAGINATION_LIMIT_AROUND_INITIAL_EVENT 30
 
+/**
+ Define the estimated memory cost (in bytes) of a bubble and of each event it contains.
+ These values are used to compute `estimatedMemoryUsage`.
+ */
+#define MXKROOMDATASOURCE_ESTIMATED_BUBBLE_MEMORY_COST 1024
+#define MXKROOMDATASOURCE_ESTIMATED_EVENT_MEMORY_COST 2048
+
+/**
+ Define the delay (in seconds) during which the sent state changes of the local echoes are coalesced
+ into a single cell change notification (one frame).
+ */
+#define MXKROOMDATASOURCE_SENT_STATE_CHANGES_COALESCING_DELAY (1.0 / 60.0)
+
 /**
  List the supported pagination of the rendered room bubble cells
  */
@@ -64,6 +77,7 @@ extern NSString *const kMXKRoomBubbleCellDataIdentifier;
 /**
  Posted when a server sync starts or ends (depend on 'serverSyncEventCount').
  The notification object is the `MXKRoomDataSource` instance.
+ This notification is posted on the main thread.
  */
 extern NSString *const kMXKRoomDataSourceSyncStatusChanged;
 
@@ -85,6 +99,11 @@ extern NSString *const kMXKRoomDataSourceTimelineErrorErrorKey;
 
 /**
  The data source for `MXKRoomViewController`.
+ 
+ The sent state changes of the local echoes are coalesced (see MXKROOMDATASOURCE_SENT_STATE_CHANGES_COALESCING_DELAY).
+ When they have only modified the state dependent attributes of the bubbles (text color, badges), the `changes` parameter of
+ `[MXKDataSourceDelegate dataSource:didCellChange:]` is the array of the updated `MXKRoomBubbleCellDataStoring` instances: the
+ cell heights are unchanged. It is nil in the other cases.
  */
 @interface MXKRoomDataSource : MXKDataSource <UITableViewDataSource>
 {
@@ -113,6 +132,7 @@ extern NSString *const kMXKRoomDataSourceTimelineErrorErrorKey;
 
 /**
  The id of the secondary room managed by the data source. Events with specified types from the secondary room will be provided from the data source.
+ The bubbles of both rooms are kept in date order.
  @see `secondaryRoomEventTypes`.
  Can be nil.
  */
@@ -337,6 +357,17 @@ extern NSString *const kMXKRoomDataSourceTimelineErrorErrorKey;
  */
 - (void)limitMemoryUsage:(NSInteger)maxBubbleNb;
 
+/**
+ Tell whether some local echoes are being sent in the room.
+ The room data should not be released in this case.
+ */
+@property (nonatomic, readonly) BOOL hasOutgoingMessagesInProgress;
+
+/**
+ The estimated memory usage (in bytes) of the room data loaded by the data source.
+ */
+@property (nonatomic, readonly) NSUInteger estimatedMemoryUsage;
+
 /**
  Force data reload.
  */
@@ -422,6 +453,10 @@ extern NSString *const kMXKRoomDataSourceTimelineErrorErrorKey;
  
  While sending, a fake event will be echoed in the messages list.
  Once complete, this local echo will be replaced by the event saved by the homeserver.
+ 
+ The Markdown is converted in background: the local echo is added once the conversion is done.
+ The messages are handed to the room in the order of their calls: a message waits for the preparation
+ (Markdown conversion, image encoding) of the messages sent before it.
 
  @param text the text to send.
  @param success A block object called when the operation succeeds. It returns
@@ -438,6 +473,8 @@ extern NSString *const kMXKRoomDataSourceTimelineErrorErrorKey;
  While sending, a fake event will be echoed in the messages list.
  Once complete, this local echo will be replaced by the event saved by the homeserver.
  
+ The Markdown is converted in background, like in `sendTextMessage:success:failure:`.
+ 
  @param eventIdToReply the id of event to reply.
  @param text the text to send.
  @param success A block object called when the operation succeeds. It returns
@@ -463,6 +500,9 @@ extern NSString *const kMXKRoomDataSourceTimelineErrorErrorKey;
 
  While sending, a fake event will be echoed in the messages list.
  Once complete, this local echo will be replaced by the event saved by the homeserver.
+ 
+ The image is encoded in JPEG in background (see `MXKImageSendEncoder`): the local echo is added once it is encoded.
+ The messages sent after it, like a caption, wait for the encoding: they are handed to the room after the image.
 
  @param image the UIImage containing the image to send.
  @param success A block object called when the operation succeeds. It returns
@@ -27,6 +27,9 @@
 #import "MXKRoomBubbleCellData.h"
 
 #import "MXKTools.h"
+#import "MXKImageSendEncoder.h"
+#import "MXKRoomSendQueue.h"
+#import "MXKCollapsedSeriesSummary.h"
 #import "MXAggregatedReactions+MatrixKit.h"
 
 #import "MXKAppSettings.h"
@@ -50,6 +53,7 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
     MXKRoomDataSourceErrorResendGeneric = 10001,
     MXKRoomDataSourceErrorResendInvalidMessageType = 10002,
     MXKRoomDataSourceErrorResendInvalidLocalFilePath = 10003,
+    MXKRoomDataSourceErrorImageEncoding = 10004,
 };
 
 
@@ -162,6 +166,16 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
      (Such series is determined by the cell data of its oldest event).
      */
     id<MXKRoomBubbleCellDataStoring> collapsableSeriesAtEnd;
+    
+    /**
+     The last cell data of the series at the end of self.bubbles, if any.
+     */
+    id<MXKRoomBubbleCellDataStoring> collapsableSeriesAtEndTail;
+    
+    /**
+     The summaries of the collapsable series which may still be extended, by start cell data of series.
+     */
+    NSMapTable<id<MXKRoomBubbleCellDataStoring>, MXKCollapsedSeriesSummary*> *collapsedSeriesSummaries;
 
     /**
      Observe UIApplicationSignificantTimeChangeNotification to trigger cell change on time formatting change.
@@ -187,6 +201,21 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
      Emote slash command prefix @"/me "
      */
     NSString *emoteMessageSlashCommandPrefix;
+    
+    /**
+     The bubbles updated by sent state changes since the last cell change notification.
+     */
+    NSMutableSet<id<MXKRoomBubbleCellDataStoring>> *sentStateChangedBubbles;
+    
+    /**
+     Tell whether one of these changes has modified the bubble layout (a full update has been required).
+     */
+    BOOL sentStateChangesRequireReload;
+    
+    /**
+     The queue through which the messages are handed to the room, in the order of the calls.
+     */
+    MXKRoomSendQueue *sendQueue;
 }
 
 /**
@@ -271,6 +300,7 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
         MXLogVerbose(@"[MXKRoomDataSource][%p] initWithRoomId: %@", self, roomId);
         
         _roomId = roomId;
+        sendQueue = [[MXKRoomSendQueue alloc] init];
         _secondaryRoomEventTypes = @[
             kMXEventTypeStringCallInvite,
             kMXEventTypeStringCallCandidates,
@@ -416,20 +446,10 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
     if (bubbleCount > maxBubbleNb)
     {
         // Do nothing if some local echoes are in progress.
-        NSArray<MXEvent*>* outgoingMessages = _room.outgoingMessages;
-        
-        for (NSInteger index = 0; index < outgoingMessages.count; index++)
+        if (self.hasOutgoingMessagesInProgress)
         {
-            MXEvent *outgoingMessage = [outgoingMessages objectAtIndex:index];
-            
-            if (outgoingMessage.sentState == MXEventSentStateSending ||
-                outgoingMessage.sentState == MXEventSentStatePreparing ||
-                outgoingMessage.sentState == MXEventSentStateEncrypting ||
-                outgoingMessage.sentState == MXEventSentStateUploading)
-            {
-                MXLogDebug(@"[MXKRoomDataSource][%p] cancel limitMemoryUsage because some messages are being sent", self);
-                return;
-            }
+            MXLogDebug(@"[MXKRoomDataSource][%p] cancel limitMemoryUsage because some messages are being sent", self);
+            return;
         }
 
         // Reset the room data source (return in initial state: minimum memory usage).
@@ -437,6 +457,39 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
     }
 }
 
+- (BOOL)hasOutgoingMessagesInProgress
+{
+    NSArray<MXEvent*>* outgoingMessages = _room.outgoingMessages;
+    
+    for (MXEvent *outgoingMessage in outgoingMessages)
+    {
+        if (outgoingMessage.sentState == MXEventSentStateSending ||
+            outgoingMessage.sentState == MXEventSentStatePreparing ||
+            outgoingMessage.sentState == MXEventSentStateEncrypting ||
+            outgoingMessage.sentState == MXEventSentStateUploading)
+        {
+            return YES;
+        }
+    }
+    
+    return NO;
+}
+
+- (NSUInteger)estimatedMemoryUsage
+{
+    NSUInteger memoryUsage = 0;
+    
+    @synchronized(bubbles)
+    {
+        for (id<MXKRoomBubbleCellDataStoring> bubbleData in bubbles)
+        {
+            memoryUsage += MXKROOMDATASOURCE_ESTIMATED_BUBBLE_MEMORY_COST + bubbleData.events.count * MXKROOMDATASOURCE_ESTIMATED_EVENT_MEMORY_COST;
+        }
+    }
+    
+    return memoryUsage;
+}
+
 - (void)reset
 {
     [self resetNotifying:YES];
@@ -446,6 +499,10 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
 {
     [externalRelatedGroups removeAllObjects];
     
+    // Drop the pending sent state changes, the bubbles are going to be rebuilt
+    [sentStateChangedBubbles removeAllObjects];
+    sentStateChangesRequireReload = NO;
+    
     if (roomDidFlushDataNotificationObserver)
     {
         [[NSNotificationCenter defaultCenter] removeObserver:roomDidFlushDataNotificationObserver];
@@ -530,6 +587,9 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                 bubble.nextCollapsableCellData = nil;
             }
             [bubbles removeAllObjects];
+            
+            collapsableSeriesAtEndTail = nil;
+            [collapsedSeriesSummaries removeAllObjects];
         }
         
         @synchronized(eventIdToBubbleMap)
@@ -541,7 +601,13 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
         self.secondaryRoom = nil;
     }
     
-    _serverSyncEventCount = 0;
+    if (_serverSyncEventCount)
+    {
+        _serverSyncEventCount = 0;
+        
+        // Notify that sync process ends
+        [[NSNotificationCenter defaultCenter] postNotificationName:kMXKRoomDataSourceSyncStatusChanged object:self userInfo:nil];
+    }
 
     // Notify the delegate to reload its tableview
     if (notify && self.delegate)
@@ -975,6 +1041,9 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                             NSUInteger remainingEvents = [bubbleData updateEvent:redactionEvent.redacts withEvent:redactedEvent];
 
                             hasChanged = YES;
+                            
+                            // The redacted event does not count anymore in the summary of its series
+                            [self invalidateSummaryOfCollapsableSeriesContainingBubble:bubbleData];
 
                             // Remove the bubble if there is no more events
                             shouldRemoveBubbleData = (remainingEvents == 0);
@@ -1103,6 +1172,9 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                             NSUInteger remainingEvents = [bubbleData updateEvent:redactionEvent.redacts withEvent:redactedEvent];
 
                             hasChanged = YES;
+                            
+                            // The redacted event does not count anymore in the summary of its series
+                            [self invalidateSummaryOfCollapsableSeriesContainingBubble:bubbleData];
 
                             // Remove the bubble if there is no more events
                             shouldRemoveBubbleData = (remainingEvents == 0);
@@ -1667,28 +1739,34 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
 #pragma mark - Sending
 - (void)sendTextMessage:(NSString *)text success:(void (^)(NSString *))success failure:(void (^)(NSError *))failure
 {
-    __block MXEvent *localEchoEvent = nil;
-    
     BOOL isEmote = [self isMessageAnEmote:text];
     NSString *sanitizedText = [self sanitizedMessageText:text];
-    NSString *html = [self htmlMessageFromSanitizedText:sanitizedText];
     
-    // Make the request to the homeserver
-    if (isEmote)
-    {
-        [_room sendEmote:sanitizedText formattedText:html localEcho:&localEchoEvent success:success failure:failure];
-    }    
-    else
-    {
-        [_room sendTextMessage:sanitizedText formattedText:html localEcho:&localEchoEvent success:success failure:failure];
-    }
-    
-    if (localEchoEvent)
-    {
-        // Make the data source digest this fake local echo message
-        [self queueEventForProcessing:localEchoEvent withRoomState:self.roomState direction:MXTimelineDirectionForwards];
-        [self processQueuedEvents:nil];
-    }
+    // Convert the Markdown in background, the message keeps its position in the send queue
+    // Keep the room: the message is sent even if the data source is released meanwhile
+    MXRoom *room = _room;
+    void (^sendWhenReady)(dispatch_block_t) = [sendQueue reserve];
+    MXWeakify(self);
+    [self htmlMessageFromSanitizedText:sanitizedText onComplete:^(NSString *html) {
+        
+        sendWhenReady(^{
+            
+            __block MXEvent *localEchoEvent = nil;
+            
+            // Make the request to the homeserver
+            if (isEmote)
+            {
+                [room sendEmote:sanitizedText formattedText:html localEcho:&localEchoEvent success:success failure:failure];
+            }
+            else
+            {
+                [room sendTextMessage:sanitizedText formattedText:html localEcho:&localEchoEvent success:success failure:failure];
+            }
+            
+            MXStrongifyAndReturnIfNil(self);
+            [self processLocalEcho:localEchoEvent];
+        });
+    }];
 }
 
 - (void)sendReplyToEventWithId:(NSString*)eventIdToReply
@@ -1698,21 +1776,26 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
 {
     MXEvent *eventToReply = [self eventWithEventId:eventIdToReply];
     
-    __block MXEvent *localEchoEvent = nil;
-    
     NSString *sanitizedText = [self sanitizedMessageText:text];
-    NSString *html = [self htmlMessageFromSanitizedText:sanitizedText];
     
-    id<MXSendReplyEventStringLocalizerProtocol> stringLocalizer = [MXKSendReplyEventStringLocalizer new];
-    
-    [_room sendReplyToEvent:eventToReply withTextMessage:sanitizedText formattedTextMessage:html stringLocalizer:stringLocalizer localEcho:&localEchoEvent success:success failure:failure];
-    
-    if (localEchoEvent)
-    {
-        // Make the data source digest this fake local echo message
-        [self queueEventForProcessing:localEchoEvent withRoomState:self.roomState direction:MXTimelineDirectionForwards];
-        [self processQueuedEvents:nil];
-    }
+    // Keep the room: the reply is sent even if the data source is released meanwhile
+    MXRoom *room = _room;
+    void (^sendWhenReady)(dispatch_block_t) = [sendQueue reserve];
+    MXWeakify(self);
+    [self htmlMessageFromSanitizedText:sanitizedText onComplete:^(NSString *html) {
+        
+        sendWhenReady(^{
+            
+            __block MXEvent *localEchoEvent = nil;
+            
+            id<MXSendReplyEventStringLocalizerProtocol> stringLocalizer = [MXKSendReplyEventStringLocalizer new];
+            
+            [room sendReplyToEvent:eventToReply withTextMessage:sanitizedText formattedTextMessage:html stringLocalizer:stringLocalizer localEcho:&localEchoEvent success:success failure:failure];
+            
+            MXStrongifyAndReturnIfNil(self);
+            [self processLocalEcho:localEchoEvent];
+        });
+    }];
 }
 
 - (BOOL)isMessageAnEmote:(NSString*)text
@@ -1748,48 +1831,60 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
     return text;
 }
 
-- (NSString*)htmlMessageFromSanitizedText:(NSString*)sanitizedText
+- (void)htmlMessageFromSanitizedText:(NSString*)sanitizedText onComplete:(void (^)(NSString *html))onComplete
 {
-    NSString *html;
-    
-    // Did user use Markdown text?
-    NSString *htmlStringFromMarkdown = [_eventFormatter htmlStringFromMarkdownString:sanitizedText];
-    
-    if ([htmlStringFromMarkdown isEqualToString:sanitizedText])
-    {
-        // No formatted string
-        html = nil;
-    }
-    else
-    {
-        html = htmlStringFromMarkdown;
-    }
-    
-    return html;
+    // The Markdown is converted in background, the completions are called in the sending order
+    [_eventFormatter htmlStringFromMarkdownString:sanitizedText onComplete:^(NSString *htmlStringFromMarkdown) {
+        
+        NSString *html;
+        
+        // Did user use Markdown text?
+        if ([htmlStringFromMarkdown isEqualToString:sanitizedText])
+        {
+            // No formatted string
+            html = nil;
+        }
+        else
+        {
+            html = htmlStringFromMarkdown;
+        }
+        
+        onComplete(html);
+    }];
 }
 
 - (void)sendImage:(UIImage *)image success:(void (^)(NSString *))success failure:(void (^)(NSError *))failure
 {
-    // Make sure the uploaded image orientation is up
-    image = [MXKTools forceImageOrientationUp:image];
-    
-    // Only jpeg image is supported here
-    NSString *mimetype = @"image/jpeg";
-    NSData *imageData = UIImageJPEGRepresentation(image, 0.9);
-    
-    // Shall we need to consider a thumbnail?
-    UIImage *thumbnail = nil;
-    if (_room.summary.isEncrypted)
-    {
-        // Thumbnail is useful only in case of encrypted room
-        thumbnail = [MXKTools reduceImage:image toFitInSize:CGSizeMake(800, 600)];
-        if (thumbnail == image)
+    // Only jpeg image is supported here. The image is encoded in background, its orientation is kept in EXIF metadata.
+    // Thumbnail is useful only in case of encrypted room
+    // Keep the room: the image is sent even if the data source is released meanwhile
+    MXRoom *room = _room;
+    void (^sendWhenReady)(dispatch_block_t) = [sendQueue reserve];
+    MXWeakify(self);
+    [MXKImageSendEncoder encodeImage:image withThumbnail:room.summary.isEncrypted completion:^(NSData *imageData, CGSize imageSize, UIImage *thumbnail) {
+        
+        if (!imageData)
         {
-            thumbnail = nil;
+            MXLogWarning(@"[MXKRoomDataSource] sendImage: Unable to encode the image for room %@", room.roomId);
+            
+            // Release the position of the image
+            sendWhenReady(nil);
+            if (failure)
+            {
+                failure([NSError errorWithDomain:MXKRoomDataSourceErrorDomain code:MXKRoomDataSourceErrorImageEncoding userInfo:nil]);
+            }
+            return;
         }
-    }
-    
-    [self sendImageData:imageData withImageSize:image.size mimeType:mimetype andThumbnail:thumbnail success:success failure:failure];
+        
+        sendWhenReady(^{
+            
+            __block MXEvent *localEchoEvent = nil;
+            [room sendImage:imageData withImageSize:imageSize mimeType:@"image/jpeg" andThumbnail:thumbnail localEcho:&localEchoEvent success:success failure:failure];
+            
+            MXStrongifyAndReturnIfNil(self);
+            [self processLocalEcho:localEchoEvent];
+        });
+    }];
 }
 
 - (BOOL)canReplyToEventWithId:(NSString*)eventIdToReply
@@ -1800,29 +1895,27 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
 
 - (void)sendImage:(NSData *)imageData mimeType:(NSString *)mimetype success:(void (^)(NSString *))success failure:(void (^)(NSError *))failure
 {
-    UIImage *image = [UIImage imageWithData:imageData];
-    
-    // Shall we need to consider a thumbnail?
-    UIImage *thumbnail = nil;
-    if (_room.summary.isEncrypted)
-    {
-        // Thumbnail is useful only in case of encrypted room
-        thumbnail = [MXKTools reduceImage:image toFitInSize:CGSizeMake(800, 600)];
-        if (thumbnail == image)
-        {
-            thumbnail = nil;
-        }
-    }
-    
-    [self sendImageData:imageData withImageSize:image.size mimeType:mimetype andThumbnail:thumbnail success:success failure:failure];
+    // Read the image size and create the thumbnail in background, without decoding the full size image.
+    // Thumbnail is useful only in case of encrypted room
+    // Keep the room: the image is sent even if the data source is released meanwhile
+    MXRoom *room = _room;
+    void (^sendWhenReady)(dispatch_block_t) = [sendQueue reserve];
+    MXWeakify(self);
+    [MXKImageSendEncoder prepareImageData:imageData withThumbnail:room.summary.isEncrypted completion:^(CGSize imageSize, UIImage *thumbnail) {
+        
+        sendWhenReady(^{
+            
+            __block MXEvent *localEchoEvent = nil;
+            [room sendImage:imageData withImageSize:imageSize mimeType:mimetype andThumbnail:thumbnail localEcho:&localEchoEvent success:success failure:failure];
+            
+            MXStrongifyAndReturnIfNil(self);
+            [self processLocalEcho:localEchoEvent];
+        });
+    }];
 }
 
-- (void)sendImageData:(NSData*)imageData withImageSize:(CGSize)imageSize mimeType:(NSString*)mimetype andThumbnail:(UIImage*)thumbnail success:(void (^)(NSString *eventId))success failure:(void (^)(NSError *error))failure
+- (void)processLocalEcho:(MXEvent*)localEchoEvent
 {
-    __block MXEvent *localEchoEvent = nil;
-    
-    [_room sendImage:imageData withImageSize:imageSize mimeType:mimetype andThumbnail:thumbnail localEcho:&localEchoEvent success:success failure:failure];
-    
     if (localEchoEvent)
     {
         // Make the data source digest this fake local echo message
@@ -1839,30 +1932,32 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
 
 - (void)sendVideoAsset:(AVAsset *)videoAsset withThumbnail:(UIImage *)videoThumbnail success:(void (^)(NSString *))success failure:(void (^)(NSError *))failure
 {
-    __block MXEvent *localEchoEvent = nil;
-    
-    [_room sendVideoAsset:videoAsset withThumbnail:videoThumbnail localEcho:&localEchoEvent success:success failure:failure];
-    
-    if (localEchoEvent)
-    {
-        // Make the data source digest this fake local echo message
-        [self queueEventForProcessing:localEchoEvent withRoomState:self.roomState direction:MXTimelineDirectionForwards];
-        [self processQueuedEvents:nil];
-    }
+    // Wait for the messages in preparation, if any
+    MXRoom *room = _room;
+    MXWeakify(self);
+    [sendQueue send:^{
+        
+        __block MXEvent *localEchoEvent = nil;
+        [room sendVideoAsset:videoAsset withThumbnail:videoThumbnail localEcho:&localEchoEvent success:success failure:failure];
+        
+        MXStrongifyAndReturnIfNil(self);
+        [self processLocalEcho:localEchoEvent];
+    }];
 }
 
 - (void)sendAudioFile:(NSURL *)audioFileLocalURL mimeType:mimeType success:(void (^)(NSString *))success failure:(void (^)(NSError *))failure
 {
-    __block MXEvent *localEchoEvent = nil;
-    
-    [_room sendAudioFile:audioFileLocalURL mimeType:mimeType localEcho:&localEchoEvent success:success failure:failure keepActualFilename:YES];
-    
-    if (localEchoEvent)
-    {
-        // Make the data source digest this fake local echo message
-        [self queueEventForProcessing:localEchoEvent withRoomState:self.roomState direction:MXTimelineDirectionForwards];
-        [self processQueuedEvents:nil];
-    }
+    // Wait for the messages in preparation, if any
+    MXRoom *room = _room;
+    MXWeakify(self);
+    [sendQueue send:^{
+        
+        __block MXEvent *localEchoEvent = nil;
+        [room sendAudioFile:audioFileLocalURL mimeType:mimeType localEcho:&localEchoEvent success:success failure:failure keepActualFilename:YES];
+        
+        MXStrongifyAndReturnIfNil(self);
+        [self processLocalEcho:localEchoEvent];
+    }];
 }
 
 - (void)sendVoiceMessage:(NSURL *)audioFileLocalURL
@@ -1872,61 +1967,67 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                  success:(void (^)(NSString *))success
                  failure:(void (^)(NSError *))failure
 {
-    __block MXEvent *localEchoEvent = nil;
-    
-    [_room sendVoiceMessage:audioFileLocalURL mimeType:mimeType duration:duration samples:samples localEcho:&localEchoEvent success:success failure:failure keepActualFilename:YES];
-    
-    if (localEchoEvent)
-    {
-        // Make the data source digest this fake local echo message
-        [self queueEventForProcessing:localEchoEvent withRoomState:self.roomState direction:MXTimelineDirectionForwards];
-        [self processQueuedEvents:nil];
-    }
+    // Wait for the messages in preparation, if any
+    MXRoom *room = _room;
+    MXWeakify(self);
+    [sendQueue send:^{
+        
+        __block MXEvent *localEchoEvent = nil;
+        [room sendVoiceMessage:audioFileLocalURL mimeType:mimeType duration:duration samples:samples localEcho:&localEchoEvent success:success failure:failure keepActualFilename:YES];
+        
+        MXStrongifyAndReturnIfNil(self);
+        [self processLocalEcho:localEchoEvent];
+    }];
 }
 
 
 - (void)sendFile:(NSURL *)fileLocalURL mimeType:(NSString*)mimeType success:(void (^)(NSString *))success failure:(void (^)(NSError *))failure
 {
-    __block MXEvent *localEchoEvent = nil;
-    
-    [_room sendFile:fileLocalURL mimeType:mimeType localEcho:&localEchoEvent success:success failure:failure];
-    
-    if (localEchoEvent)
-    {
-        // Make the data source digest this fake local echo message
-        [self queueEventForProcessing:localEchoEvent withRoomState:self.roomState direction:MXTimelineDirectionForwards];
-        [self processQueuedEvents:nil];
-    }
+    // Wait for the messages in preparation, if any
+    MXRoom *room = _room;
+    MXWeakify(self);
+    [sendQueue send:^{
+        
+        __block MXEvent *localEchoEvent = nil;
+        [room sendFile:fileLocalURL mimeType:mimeType localEcho:&localEchoEvent success:success failure:failure];
+        
+        MXStrongifyAndReturnIfNil(self);
+        [self processLocalEcho:localEchoEvent];
+    }];
 }
 
 - (void)sendMessageWithContent:(NSDictionary *)msgContent success:(void (^)(NSString *))success failure:(void (^)(NSError *))failure
 {
-    __block MXEvent *localEchoEvent = nil;
-    
-    // Make the request to the homeserver
-    [_room sendMessageWithContent:msgContent localEcho:&localEchoEvent success:success failure:failure];
-    
-    if (localEchoEvent)
-    {
-        // Make the data source digest this fake local echo message
-        [self queueEventForProcessing:localEchoEvent withRoomState:self.roomState direction:MXTimelineDirectionForwards];
-        [self processQueuedEvents:nil];
-    }
+    // Wait for the messages in preparation, if any
+    MXRoom *room = _room;
+    MXWeakify(self);
+    [sendQueue send:^{
+        
+        __block MXEvent *localEchoEvent = nil;
+        
+        // Make the request to the homeserver
+        [room sendMessageWithContent:msgContent localEcho:&localEchoEvent success:success failure:failure];
+        
+        MXStrongifyAndReturnIfNil(self);
+        [self processLocalEcho:localEchoEvent];
+    }];
 }
 
 - (void)sendEventOfType:(MXEventTypeString)eventTypeString content:(NSDictionary<NSString*, id>*)msgContent success:(void (^)(NSString *eventId))success failure:(void (^)(NSError *error))failure
 {
-    __block MXEvent *localEchoEvent = nil;
-
-    // Make the request to the homeserver
-    [_room sendEventOfType:eventTypeString content:msgContent localEcho:&localEchoEvent success:success failure:failure];
-
-    if (localEchoEvent)
-    {
-        // Make the data source digest this fake local echo message
-        [self queueEventForProcessing:localEchoEvent withRoomState:self.roomState direction:MXTimelineDirectionForwards];
-        [self processQueuedEvents:nil];
-    }
+    // Wait for the messages in preparation, if any
+    MXRoom *room = _room;
+    MXWeakify(self);
+    [sendQueue send:^{
+        
+        __block MXEvent *localEchoEvent = nil;
+        
+        // Make the request to the homeserver
+        [room sendEventOfType:eventTypeString content:msgContent localEcho:&localEchoEvent success:success failure:failure];
+        
+        MXStrongifyAndReturnIfNil(self);
+        [self processLocalEcho:localEchoEvent];
+    }];
 }
 
 - (void)resendEventWithEventId:(NSString *)eventId success:(void (^)(NSString *))success failure:(void (^)(NSError *))failure
@@ -2138,6 +2239,11 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
             remainingEvents = [bubbleData removeEvent:eventId];
         }
         
+        // The summaries of the collapsable series are managed on the processing queue
+        dispatch_async(MXKRoomDataSource.processingQueue, ^{
+            [self invalidateSummaryOfCollapsableSeriesContainingBubble:bubbleData];
+        });
+        
         // If there is no more events in the bubble, remove it
         if (0 == remainingEvents)
         {
@@ -2286,6 +2392,167 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
     }
 }
 
++ (NSComparator)bubbleDateComparator
+{
+    // The bubbles without date come first
+    return ^NSComparisonResult(id<MXKRoomBubbleCellDataStoring> bubbleData1, id<MXKRoomBubbleCellDataStoring> bubbleData2) {
+        if (bubbleData1.date)
+        {
+            return bubbleData2.date ? [bubbleData1.date compare:bubbleData2.date] : NSOrderedDescending;
+        }
+        return bubbleData2.date ? NSOrderedAscending : NSOrderedSame;
+    };
+}
+
++ (NSUInteger)insertionIndexOfBubble:(id<MXKRoomBubbleCellDataStoring>)bubbleData inDateOrderedBubbles:(NSArray<id<MXKRoomBubbleCellDataStoring>>*)dateOrderedBubbles direction:(MXTimelineDirection)direction
+{
+    // Among the bubbles with the same date, a bubble added backwards is inserted before the others,
+    // a bubble added forwards after them, like a stable sort would do.
+    NSBinarySearchingOptions options = NSBinarySearchingInsertionIndex;
+    options |= (direction == MXTimelineDirectionBackwards) ? NSBinarySearchingFirstEqual : NSBinarySearchingLastEqual;
+    
+    return [dateOrderedBubbles indexOfObject:bubbleData
+                               inSortedRange:NSMakeRange(0, dateOrderedBubbles.count)
+                                     options:options
+                             usingComparator:[MXKRoomDataSource bubbleDateComparator]];
+}
+
++ (void)sortBubblesByDateIfNeeded:(NSMutableArray<id<MXKRoomBubbleCellDataStoring>>*)bubbles
+{
+    // The date of a bubble changes when its first component is removed, redacted or hidden.
+    // Check the order before relying on it, and fall back on a stable sort.
+    NSComparator comparator = [MXKRoomDataSource bubbleDateComparator];
+    for (NSUInteger index = 1; index < bubbles.count; index++)
+    {
+        if (comparator(bubbles[index - 1], bubbles[index]) == NSOrderedDescending)
+        {
+            [bubbles sortWithOptions:NSSortStable usingComparator:comparator];
+            break;
+        }
+    }
+}
+
++ (void)repositionBubble:(id<MXKRoomBubbleCellDataStoring>)bubbleData inDateOrderedBubbles:(NSMutableArray<id<MXKRoomBubbleCellDataStoring>>*)dateOrderedBubbles direction:(MXTimelineDirection)direction
+{
+    NSUInteger index = [dateOrderedBubbles indexOfObjectIdenticalTo:bubbleData];
+    if (index == NSNotFound)
+    {
+        return;
+    }
+    
+    // Move the bubble only if its date does not fit its neighbours anymore
+    NSComparator comparator = [MXKRoomDataSource bubbleDateComparator];
+    if ((index > 0 && comparator(dateOrderedBubbles[index - 1], bubbleData) == NSOrderedDescending)
+        || (index + 1 < dateOrderedBubbles.count && comparator(bubbleData, dateOrderedBubbles[index + 1]) == NSOrderedDescending))
+    {
+        [dateOrderedBubbles removeObjectAtIndex:index];
+        NSUInteger insertionIndex = [MXKRoomDataSource insertionIndexOfBubble:bubbleData inDateOrderedBubbles:dateOrderedBubbles direction:direction];
+        [dateOrderedBubbles insertObject:bubbleData atIndex:insertionIndex];
+    }
+}
+
+- (MXKCollapsedSeriesSummary*)summaryOfCollapsableSeries:(id<MXKRoomBubbleCellDataStoring>)seriesStartBubbleData
+{
+    if (!collapsedSeriesSummaries)
+    {
+        collapsedSeriesSummaries = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                                         valueOptions:NSPointerFunctionsStrongMemory];
+    }
+    
+    MXKCollapsedSeriesSummary *summary = [collapsedSeriesSummaries objectForKey:seriesStartBubbleData];
+    if (!summary)
+    {
+        // Aggregate the current events of the series
+        summary = [[MXKCollapsedSeriesSummary alloc] init];
+        id<MXKRoomBubbleCellDataStoring> nextBubbleData = seriesStartBubbleData;
+        do
+        {
+            for (MXEvent *event in nextBubbleData.events)
+            {
+                [summary appendEvent:event];
+            }
+        }
+        while ((nextBubbleData = nextBubbleData.nextCollapsableCellData));
+        
+        [collapsedSeriesSummaries setObject:summary forKey:seriesStartBubbleData];
+    }
+    
+    return summary;
+}
+
+- (void)addEvents:(NSArray<MXEvent*>*)events toSummaryOfCollapsableSeries:(id<MXKRoomBubbleCellDataStoring>)seriesStartBubbleData previousSeriesStart:(id<MXKRoomBubbleCellDataStoring>)previousSeriesStartBubbleData direction:(MXTimelineDirection)direction
+{
+    MXKCollapsedSeriesSummary *summary = [collapsedSeriesSummaries objectForKey:previousSeriesStartBubbleData];
+    if (summary)
+    {
+        if (direction == MXTimelineDirectionBackwards)
+        {
+            for (MXEvent *event in events.reverseObjectEnumerator)
+            {
+                [summary prependEvent:event];
+            }
+        }
+        else
+        {
+            for (MXEvent *event in events)
+            {
+                [summary appendEvent:event];
+            }
+        }
+        
+        if (previousSeriesStartBubbleData != seriesStartBubbleData)
+        {
+            [collapsedSeriesSummaries removeObjectForKey:previousSeriesStartBubbleData];
+            [collapsedSeriesSummaries setObject:summary forKey:seriesStartBubbleData];
+        }
+    }
+    else
+    {
+        // The series already contains the events, the summary built from its bubbles includes them
+        [self summaryOfCollapsableSeries:seriesStartBubbleData];
+    }
+}
+
+- (void)addEvent:(MXEvent*)event toCollapsableSeriesEndingWithBubble:(id<MXKRoomBubbleCellDataStoring>)bubbleData direction:(MXTimelineDirection)direction collapsingSeries:(NSMutableSet<id<MXKRoomBubbleCellDataStoring>>*)collapsingCellDataSeriess
+{
+    id<MXKRoomBubbleCellDataStoring> seriesStartBubbleData;
+    if (direction == MXTimelineDirectionBackwards && bubbleData == collapsableSeriesAtStart)
+    {
+        seriesStartBubbleData = collapsableSeriesAtStart;
+    }
+    else if (direction == MXTimelineDirectionForwards && collapsableSeriesAtEnd && bubbleData == collapsableSeriesAtEndTail)
+    {
+        seriesStartBubbleData = collapsableSeriesAtEnd;
+    }
+    
+    if (seriesStartBubbleData)
+    {
+        [self addEvents:@[event] toSummaryOfCollapsableSeries:seriesStartBubbleData previousSeriesStart:seriesStartBubbleData direction:direction];
+        [collapsingCellDataSeriess addObject:seriesStartBubbleData];
+    }
+}
+
+- (void)invalidateSummaryOfCollapsableSeriesContainingBubble:(id<MXKRoomBubbleCellDataStoring>)bubbleData
+{
+    // The summary will be built again from the current events of the series
+    id<MXKRoomBubbleCellDataStoring> seriesStartBubbleData = bubbleData;
+    while (seriesStartBubbleData.prevCollapsableCellData)
+    {
+        seriesStartBubbleData = seriesStartBubbleData.prevCollapsableCellData;
+    }
+    [collapsedSeriesSummaries removeObjectForKey:seriesStartBubbleData];
+}
+
+- (void)releaseSummaryOfClosedCollapsableSeries:(id<MXKRoomBubbleCellDataStoring>)seriesStartBubbleData collapsingSeries:(NSMutableSet<id<MXKRoomBubbleCellDataStoring>>*)collapsingCellDataSeriess
+{
+    // Keep the summary if the series is at the other border, or if its string has still to be built
+    if (seriesStartBubbleData != collapsableSeriesAtStart && seriesStartBubbleData != collapsableSeriesAtEnd
+        && ![collapsingCellDataSeriess containsObject:seriesStartBubbleData])
+    {
+        [collapsedSeriesSummaries removeObjectForKey:seriesStartBubbleData];
+    }
+}
+
 #pragma mark - Private methods
 
 - (void)replaceEvent:(MXEvent*)eventToReplace withEvent:(MXEvent*)event
@@ -2517,13 +2784,7 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
         
         @synchronized (bubbleData)
         {
-            [bubbleData updateEvent:event.eventId withEvent:event];
-        }
-        
-        // Inform the delegate
-        if (self.delegate && (self.secondaryRoom ? bubbles.count > 0 : YES))
-        {
-            [self.delegate dataSource:self didCellChange:nil];
+            [self updateSentStateOfEvent:event.eventId withEvent:event inBubble:bubbleData];
         }
     }
 }
@@ -2547,7 +2808,7 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                 [eventIdToBubbleMap removeObjectForKey:previousId];
 
                 // The bubble data must use the final event id too
-                [bubbleData updateEvent:previousId withEvent:event];
+                [self updateSentStateOfEvent:previousId withEvent:event inBubble:bubbleData];
             }
         }
         
@@ -2559,6 +2820,55 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
     }
 }
 
+- (void)updateSentStateOfEvent:(NSString*)eventId withEvent:(MXEvent*)event inBubble:(id<MXKRoomBubbleCellDataStoring>)bubbleData
+{
+    // Update only the attributes which depend on the event state when the cell data supports it
+    if ([bubbleData respondsToSelector:@selector(updateSentStateOfEvent:withEvent:)])
+    {
+        if (![bubbleData updateSentStateOfEvent:eventId withEvent:event])
+        {
+            sentStateChangesRequireReload = YES;
+        }
+    }
+    else
+    {
+        [bubbleData updateEvent:eventId withEvent:event];
+        sentStateChangesRequireReload = YES;
+    }
+    
+    // Coalesce the transitions received within a frame into a single notification
+    if (!sentStateChangedBubbles)
+    {
+        sentStateChangedBubbles = [NSMutableSet set];
+    }
+    BOOL isScheduled = (sentStateChangedBubbles.count > 0);
+    [sentStateChangedBubbles addObject:bubbleData];
+    
+    if (!isScheduled)
+    {
+        MXWeakify(self);
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(MXKROOMDATASOURCE_SENT_STATE_CHANGES_COALESCING_DELAY * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+            MXStrongifyAndReturnIfNil(self);
+            [self notifySentStateChanges];
+        });
+    }
+}
+
+- (void)notifySentStateChanges
+{
+    NSArray<id<MXKRoomBubbleCellDataStoring>> *changedBubbles = sentStateChangedBubbles.allObjects;
+    BOOL requireReload = sentStateChangesRequireReload;
+    
+    [sentStateChangedBubbles removeAllObjects];
+    sentStateChangesRequireReload = NO;
+    
+    // Inform the delegate
+    if (changedBubbles.count && self.delegate && (self.secondaryRoom ? bubbles.count > 0 : YES))
+    {
+        [self.delegate dataSource:self didCellChange:(requireReload ? nil : changedBubbles)];
+    }
+}
+
 - (void)eventDidDecrypt:(NSNotification *)notif
 {
     MXEvent *event = notif.object;
@@ -2777,7 +3087,7 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
     }
     
     // Check for undecryptable messages that were sent while the user was not in the room and hide them
-    if ([MXKAppSettings standardAppSettings].hidePreJoinedUndecryptableEvents
+    if ([MXKAppSettings standardAppSettings].snapshot.hidePreJoinedUndecryptableEvents
         && direction == MXTimelineDirectionBackwards)
     {
         [self checkForPreJoinUTDWithEvent:event roomState:roomState];
@@ -3012,6 +3322,12 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                 {
                     self->bubblesSnapshot = [self->bubbles mutableCopy];
                 }
+                
+                if (self.secondaryRoom)
+                {
+                    // The new bubbles are inserted by binary search, make sure the bubbles are still in date order
+                    [MXKRoomDataSource sortBubblesByDateIfNeeded:self->bubblesSnapshot];
+                }
 
                 NSMutableSet<id<MXKRoomBubbleCellDataStoring>> *collapsingCellDataSeriess = [NSMutableSet set];
 
@@ -3062,6 +3378,18 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                                 updatedBubbleDataHadNoDisplay = bubbleData.hasNoDisplay;
                                 eventManaged = [bubbleData addEvent:queuedEvent.event andRoomState:queuedEvent.state];
                             }
+                            
+                            if (eventManaged)
+                            {
+                                if (self.secondaryRoom)
+                                {
+                                    // The bubble date changes when an older event is merged into it
+                                    [MXKRoomDataSource repositionBubble:bubbleData inDateOrderedBubbles:self->bubblesSnapshot direction:queuedEvent.direction];
+                                }
+                                
+                                // The bubble may be an end of a collapsable series
+                                [self addEvent:queuedEvent.event toCollapsableSeriesEndingWithBubble:bubbleData direction:queuedEvent.direction collapsingSeries:collapsingCellDataSeriess];
+                            }
                         }
 
                         if (NO == eventManaged)
@@ -3095,6 +3423,9 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                                             self->collapsableSeriesAtStart.collapseState = nil;
                                             self->collapsableSeriesAtStart.collapsedAttributedTextMessage = nil;
                                             [collapsingCellDataSeriess removeObject:self->collapsableSeriesAtStart];
+                                            
+                                            // Move the series summary to its new header
+                                            [self addEvents:bubbleData.events toSummaryOfCollapsableSeries:bubbleData previousSeriesStart:self->collapsableSeriesAtStart direction:MXTimelineDirectionBackwards];
 
                                             // And keep a ref of data for the new start of the series
                                             self->collapsableSeriesAtStart = bubbleData;
@@ -3106,6 +3437,7 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                                             // This is a ending point for a new collapsable series of cells
                                             self->collapsableSeriesAtStart = bubbleData;
                                             self->collapsableSeriesAtStart.collapseState = queuedEvent.state;
+                                            [self summaryOfCollapsableSeries:self->collapsableSeriesAtStart];
                                             [collapsingCellDataSeriess addObject:self->collapsableSeriesAtStart];
                                         }
                                     }
@@ -3116,14 +3448,22 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                                         {
                                             // Put bubbleData at the series tail
                                             // Find the tail
-                                            id<MXKRoomBubbleCellDataStoring> tailBubbleData = self->collapsableSeriesAtEnd;
-                                            while (tailBubbleData.nextCollapsableCellData)
+                                            id<MXKRoomBubbleCellDataStoring> tailBubbleData = self->collapsableSeriesAtEndTail;
+                                            if (!tailBubbleData)
                                             {
-                                                tailBubbleData = tailBubbleData.nextCollapsableCellData;
+                                                tailBubbleData = self->collapsableSeriesAtEnd;
+                                                while (tailBubbleData.nextCollapsableCellData)
+                                                {
+                                                    tailBubbleData = tailBubbleData.nextCollapsableCellData;
+                                                }
                                             }
 
                                             tailBubbleData.nextCollapsableCellData = bubbleData;
                                             bubbleData.prevCollapsableCellData = tailBubbleData;
+                                            self->collapsableSeriesAtEndTail = bubbleData;
+                                            
+                                            // Update the series summary with the new events only
+                                            [self addEvents:bubbleData.events toSummaryOfCollapsableSeries:self->collapsableSeriesAtEnd previousSeriesStart:self->collapsableSeriesAtEnd direction:MXTimelineDirectionForwards];
 
                                             // The new cell must have the collapsed state as the series
                                             bubbleData.collapsed = tailBubbleData.collapsed;
@@ -3138,7 +3478,9 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                                         {
                                             // This is a starting point for a new collapsable series of cells
                                             self->collapsableSeriesAtEnd = bubbleData;
+                                            self->collapsableSeriesAtEndTail = bubbleData;
                                             self->collapsableSeriesAtEnd.collapseState = queuedEvent.state;
+                                            [self summaryOfCollapsableSeries:self->collapsableSeriesAtEnd];
                                             [collapsingCellDataSeriess addObject:self->collapsableSeriesAtEnd];
                                         }
                                     }
@@ -3150,12 +3492,17 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                                     if (queuedEvent.direction == MXTimelineDirectionBackwards && self->collapsableSeriesAtStart)
                                     {
                                         // This is the begin border of the series
+                                        id<MXKRoomBubbleCellDataStoring> closedSeries = self->collapsableSeriesAtStart;
                                         self->collapsableSeriesAtStart = nil;
+                                        [self releaseSummaryOfClosedCollapsableSeries:closedSeries collapsingSeries:collapsingCellDataSeriess];
                                     }
                                     else if (queuedEvent.direction == MXTimelineDirectionForwards && self->collapsableSeriesAtEnd)
                                     {
                                         // This is the end border of the series
+                                        id<MXKRoomBubbleCellDataStoring> closedSeries = self->collapsableSeriesAtEnd;
                                         self->collapsableSeriesAtEnd = nil;
+                                        self->collapsableSeriesAtEndTail = nil;
+                                        [self releaseSummaryOfClosedCollapsableSeries:closedSeries collapsingSeries:collapsingCellDataSeriess];
                                     }
                                 }
                             }
@@ -3217,7 +3564,13 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                                 }
 
                                 // Insert the new bubble data in first position
-                                [self->bubblesSnapshot insertObject:bubbleData atIndex:0];
+                                // or in date order among the bubbles of both rooms
+                                NSUInteger insertionIndex = 0;
+                                if (self.secondaryRoom)
+                                {
+                                    insertionIndex = [MXKRoomDataSource insertionIndexOfBubble:bubbleData inDateOrderedBubbles:self->bubblesSnapshot direction:MXTimelineDirectionBackwards];
+                                }
+                                [self->bubblesSnapshot insertObject:bubbleData atIndex:insertionIndex];
                                 
                                 addedHistoryCellCount++;
                             }
@@ -3270,7 +3623,13 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                                 }
 
                                 // Insert the new bubble in last position
-                                [self->bubblesSnapshot addObject:bubbleData];
+                                // or in date order among the bubbles of both rooms
+                                NSUInteger insertionIndex = self->bubblesSnapshot.count;
+                                if (self.secondaryRoom)
+                                {
+                                    insertionIndex = [MXKRoomDataSource insertionIndexOfBubble:bubbleData inDateOrderedBubbles:self->bubblesSnapshot direction:MXTimelineDirectionForwards];
+                                }
+                                [self->bubblesSnapshot insertObject:bubbleData atIndex:insertionIndex];
                                 
                                 addedLiveCellCount++;
                             }
@@ -3428,6 +3787,7 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                     if (tailBubbleData == self->bubbles.lastObject)
                     {
                         self->collapsableSeriesAtEnd = self->collapsableSeriesAtStart;
+                        self->collapsableSeriesAtEndTail = tailBubbleData;
                     }
                 }
                 else if (self->collapsableSeriesAtEnd)
@@ -3448,17 +3808,15 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                 // Compose (= compute collapsedAttributedTextMessage) of collapsable seriess
                 for (id<MXKRoomBubbleCellDataStoring> bubbleData in collapsingCellDataSeriess)
                 {
-                    // Get all events of the series
-                    NSMutableArray<MXEvent*> *events = [NSMutableArray array];
-                    id<MXKRoomBubbleCellDataStoring> nextBubbleData = bubbleData;
-                    do
+                    // Build the summary string for the series, once per batch, from its aggregates
+                    MXKCollapsedSeriesSummary *summary = [self summaryOfCollapsableSeries:bubbleData];
+                    bubbleData.collapsedAttributedTextMessage = [self.eventFormatter attributedStringFromCollapsedSeriesSummary:summary withRoomState:bubbleData.collapseState error:nil];
+                    
+                    // The series which are not at a border of self.bubbles will not be extended anymore
+                    if (bubbleData != self->collapsableSeriesAtStart && bubbleData != self->collapsableSeriesAtEnd)
                     {
-                        [events addObjectsFromArray:nextBubbleData.events];
+                        [self->collapsedSeriesSummaries removeObjectForKey:bubbleData];
                     }
-                    while ((nextBubbleData = nextBubbleData.nextCollapsableCellData));
-
-                    // Build the summary string for the series
-                    bubbleData.collapsedAttributedTextMessage = [self.eventFormatter attributedStringFromEvents:events withRoomState:bubbleData.collapseState error:nil];
 
                     // Release collapseState objects, even the one of collapsableSeriesAtStart.
                     // We do not need to keep its state because if an collapsable event comes before collapsableSeriesAtStart,
@@ -3485,40 +3843,15 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
                 {
                     if (self.serverSyncEventCount)
                     {
-                        self->_serverSyncEventCount -= serverSyncEventCount;
+                        // The count may have been reset while these events were processed
+                        self->_serverSyncEventCount = MAX(0, self.serverSyncEventCount - (NSInteger)serverSyncEventCount);
                         if (!self.serverSyncEventCount)
                         {
                             // Notify that sync process ends
                             [[NSNotificationCenter defaultCenter] postNotificationName:kMXKRoomDataSourceSyncStatusChanged object:self userInfo:nil];
                         }
                     }
-                    if (self.secondaryRoom) {
-                        [self->bubblesSnapshot sortWithOptions:NSSortStable
-                                               usingComparator:^NSComparisonResult(MXKRoomBubbleCellData * _Nonnull bubbleData1, MXKRoomBubbleCellData * _Nonnull bubbleData2) {
-                            if (bubbleData1.date)
-                            {
-                                if (bubbleData2.date)
-                                {
-                                    return [bubbleData1.date compare:bubbleData2.date];
-                                }
-                                else
-                                {
-                                    return NSOrderedDescending;
-                                }
-                            }
-                            else
-                            {
-                                if (bubbleData2.date)
-                                {
-                                    return NSOrderedAscending;
-                                }
-                                else
-                                {
-                                    return NSOrderedSame;
-                                }
-                            }
-                        }];
-                    }
+                    // Note: the bubbles of the secondary room have been inserted in date order during the processing
                     self->bubbles = self->bubblesSnapshot;
                     self->bubblesSnapshot = nil;
                     
@@ -4091,29 +4424,40 @@ typedef NS_ENUM (NSUInteger, MXKRoomDataSourceError) {
     MXEvent *event = [self eventWithEventId:eventId];
     
     NSString *sanitizedText = [self sanitizedMessageText:text];
-    NSString *formattedText = [self htmlMessageFromSanitizedText:sanitizedText];
-    
-    NSString *eventBody = event.content[@"body"];
-    NSString *eventFormattedBody = event.content[@"formatted_body"];
     
-    if (![sanitizedText isEqualToString:eventBody] && (!eventFormattedBody || ![formattedText isEqualToString:eventFormattedBody]))
-    {
-        [self.mxSession.aggregations replaceTextMessageEvent:event withTextMessage:sanitizedText formattedText:formattedText localEchoBlock:^(MXEvent * _Nonnull replaceEventLocalEcho) {
-
-            // Apply the local echo to the timeline
-            [self updateEventWithReplaceEvent:replaceEventLocalEcho];
-
-            // Integrate the replace local event into the timeline like when sending a message
-            // This also allows to manage read receipt on this replace event
-            [self queueEventForProcessing:replaceEventLocalEcho withRoomState:self.roomState direction:MXTimelineDirectionForwards];
-            [self processQueuedEvents:nil];
-
-        } success:success failure:failure];
-    }
-    else
-    {
-        failure(nil);
-    }
+    // Keep the session: the edit is sent even if the data source is released meanwhile
+    MXSession *mxSession = self.mxSession;
+    void (^sendWhenReady)(dispatch_block_t) = [sendQueue reserve];
+    MXWeakify(self);
+    [self htmlMessageFromSanitizedText:sanitizedText onComplete:^(NSString *formattedText) {
+        
+        sendWhenReady(^{
+            
+            NSString *eventBody = event.content[@"body"];
+            NSString *eventFormattedBody = event.content[@"formatted_body"];
+            
+            if (![sanitizedText isEqualToString:eventBody] && (!eventFormattedBody || ![formattedText isEqualToString:eventFormattedBody]))
+            {
+                [mxSession.aggregations replaceTextMessageEvent:event withTextMessage:sanitizedText formattedText:formattedText localEchoBlock:^(MXEvent * _Nonnull replaceEventLocalEcho) {
+                    
+                    MXStrongifyAndReturnIfNil(self);
+                    
+                    // Apply the local echo to the timeline
+                    [self updateEventWithReplaceEvent:replaceEventLocalEcho];
+                    
+                    // Integrate the replace local event into the timeline like when sending a message
+                    // This also allows to manage read receipt on this replace event
+                    [self queueEventForProcessing:replaceEventLocalEcho withRoomState:self.roomState direction:MXTimelineDirectionForwards];
+                    [self processQueuedEvents:nil];
+                    
+                } success:success failure:failure];
+            }
+            else
+            {
+                failure(nil);
+            }
+        });
+    }];
 }
 
 #pragma mark - Virtual Rooms
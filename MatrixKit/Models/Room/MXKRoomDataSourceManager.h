@@ -18,6 +18,13 @@
 
 #import "MXKRoomDataSource.h"
 
+/**
+ Posted when the first managed room data source starts processing events received during a server sync,
+ or when the last one has processed all of them (see `hasRoomDataSourcesProcessingServerSyncEvents`).
+ The notification object is the `MXKRoomDataSourceManager` instance.
+ */
+extern NSString *const kMXKRoomDataSourceManagerServerSyncProcessingDidChangeNotification;
+
 /**
  `MXKRoomDataSourceManagerReleasePolicy` defines how a `MXKRoomDataSource` instance must be released
  when [MXKRoomDataSourceManager closeRoomDataSourceWithRoomId:] is called.
@@ -37,8 +44,27 @@ typedef enum : NSUInteger {
      */
     MXKRoomDataSourceManagerReleasePolicyReleaseOnClose,
 
+    /**
+     Created `MXKRoomDataSource` instances are kept when they are closed, as long as the estimated memory
+     usage of all the closed instances stays under `memoryBudget`. Beyond this budget, the least recently
+     used instances are released first.
+     
+     Note: each kept instance still applies its own `maxBackgroundCachedBubblesCount` limit.
+     */
+    MXKRoomDataSourceManagerReleasePolicyMemoryBudget,
+
 } MXKRoomDataSourceManagerReleasePolicy;
 
+/**
+ Define the default memory budget (in bytes) used by `MXKRoomDataSourceManagerReleasePolicyMemoryBudget`.
+ */
+#define MXKROOMDATASOURCEMANAGER_DEFAULT_MEMORY_BUDGET (20 * 1024 * 1024)
+
+/**
+ Define the default number of messages loaded from the store when a room data source is prewarmed.
+ */
+#define MXKROOMDATASOURCEMANAGER_DEFAULT_PREWARM_PAGINATION_LIMIT 30
+
 
 /**
  `MXKRoomDataSourceManager` manages a pool of `MXKRoomDataSource` instances for a given Matrix session.
@@ -110,15 +136,72 @@ typedef enum : NSUInteger {
  */
 - (void)closeRoomDataSourceWithRoomId:(NSString*)roomId forceClose:(BOOL)forceRelease;
 
+/**
+ Prepare in background the room data sources of rooms that the user is likely to open soon
+ (the top rooms of the recents list, the room under the user's finger...).
+ 
+ The room data sources are created one after the other, and they are filled with the messages
+ available in the store (no homeserver request is made). The rooms which already have a room data source
+ are ignored.
+ 
+ @param roomIds the ids of the rooms to prewarm, ordered by priority.
+ */
+- (void)prewarmRoomDataSourcesWithRoomIds:(NSArray<NSString*>*)roomIds;
+
+/**
+ Cancel the pending prewarm requests. The prewarm in progress (if any) is completed.
+ */
+- (void)cancelPendingPrewarms;
+
+/**
+ The number of messages loaded from the store when a room data source is prewarmed.
+ Default is MXKROOMDATASOURCEMANAGER_DEFAULT_PREWARM_PAGINATION_LIMIT.
+ */
+@property (nonatomic) NSUInteger prewarmPaginationLimit;
+
+/**
+ The number of room data sources requested with creation which had been prewarmed.
+ */
+@property (nonatomic, readonly) NSUInteger prewarmHitCount;
+
+/**
+ The number of room data sources requested with creation which had not been prewarmed.
+ */
+@property (nonatomic, readonly) NSUInteger prewarmMissCount;
+
 /**
  The release policy to apply when `MXKRoomDataSource` instances are closed.
  Default is MXKRoomDataSourceManagerReleasePolicyNeverRelease.
  */
 @property (nonatomic) MXKRoomDataSourceManagerReleasePolicy releasePolicy;
 
+/**
+ The maximum estimated memory usage (in bytes) of the closed `MXKRoomDataSource` instances,
+ when the release policy is `MXKRoomDataSourceManagerReleasePolicyMemoryBudget`.
+ The room data sources which are currently used (with a delegate) are not counted in this budget.
+ Default is MXKROOMDATASOURCEMANAGER_DEFAULT_MEMORY_BUDGET.
+ */
+@property (nonatomic) NSUInteger memoryBudget;
+
+/**
+ The ids of the rooms whose data source is currently kept in memory,
+ ordered from the most recently used to the least recently used.
+ */
+@property (nonatomic, readonly) NSArray<NSString*> *residentRoomIds;
+
+/**
+ The estimated memory usage (in bytes) of all the room data sources kept in memory.
+ */
+@property (nonatomic, readonly) NSUInteger estimatedMemoryUsage;
+
 /**
  Tells whether a server sync is in progress in the matrix session.
  */
 @property (nonatomic, readonly) BOOL isServerSyncInProgress;
 
+/**
+ Tells whether some room data sources of the matrix session are still processing events received during a server sync.
+ */
+@property (nonatomic, readonly) BOOL hasRoomDataSourcesProcessingServerSyncEvents;
+
 @end
@@ -16,6 +16,8 @@
 
 #import "MXKRoomDataSourceManager.h"
 
+NSString *const kMXKRoomDataSourceManagerServerSyncProcessingDidChangeNotification = @"kMXKRoomDataSourceManagerServerSyncProcessingDidChangeNotification";
+
 @interface MXKRoomDataSourceManager()
 {
     MXSession *mxSession;
@@ -26,6 +28,32 @@
      */
     NSMutableDictionary *roomDataSources;
     
+    /**
+     The ids of the rooms handled in `roomDataSources`, ordered from the most recently used to the least recently used.
+     */
+    NSMutableArray<NSString*> *roomIdsByLastAccess;
+    
+    /**
+     The ids of the rooms waiting to be prewarmed, ordered by priority.
+     */
+    NSMutableArray<NSString*> *pendingPrewarmRoomIds;
+    
+    /**
+     The ids of the rooms whose data source has been prewarmed and has not been requested yet.
+     */
+    NSMutableSet<NSString*> *prewarmedRoomIds;
+    
+    /**
+     Tell whether a room data source is being prewarmed.
+     */
+    BOOL isPrewarming;
+    
+    /**
+     The room data sources of the session which have some pending server sync events (see `serverSyncEventCount`).
+     This set is updated on each `kMXKRoomDataSourceSyncStatusChanged` notification to avoid iterating all the data sources.
+     */
+    NSHashTable<MXKRoomDataSource*> *roomDataSourcesProcessingServerSyncEvents;
+    
     /**
      Observe UIApplicationDidReceiveMemoryWarningNotification to dispose of any resources that can be recreated.
      */
@@ -119,15 +147,29 @@ static Class _roomDataSourceClass;
     {
         mxSession = matrixSession;
         roomDataSources = [NSMutableDictionary dictionary];
+        roomIdsByLastAccess = [NSMutableArray array];
         _releasePolicy = MXKRoomDataSourceManagerReleasePolicyNeverRelease;
+        _memoryBudget = MXKROOMDATASOURCEMANAGER_DEFAULT_MEMORY_BUDGET;
+        pendingPrewarmRoomIds = [NSMutableArray array];
+        prewarmedRoomIds = [NSMutableSet set];
+        _prewarmPaginationLimit = MXKROOMDATASOURCEMANAGER_DEFAULT_PREWARM_PAGINATION_LIMIT;
+        roomDataSourcesProcessingServerSyncEvents = [NSHashTable weakObjectsHashTable];
         
         [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didMXSessionDidLeaveRoom:) name:kMXSessionDidLeaveRoomNotification object:nil];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didRoomDataSourceSyncStatusChange:) name:kMXKRoomDataSourceSyncStatusChanged object:nil];
         
         // Observe UIApplicationDidReceiveMemoryWarningNotification
         UIApplicationDidReceiveMemoryWarningNotificationObserver = [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationDidReceiveMemoryWarningNotification object:nil queue:[NSOperationQueue mainQueue] usingBlock:^(NSNotification *notif) {
             
             MXLogDebug(@"[MXKRoomDataSourceManager] %@: Received memory warning.", self);
             
+            if (self.releasePolicy == MXKRoomDataSourceManagerReleasePolicyMemoryBudget)
+            {
+                // Release the least recently used data sources until the half of the budget is reached.
+                [self releaseLeastRecentlyUsedRoomDataSourcesToFitMemoryBudget:self.memoryBudget / 2];
+                return;
+            }
+            
             // Reload all data sources (except the current used ones) to reduce memory usage.
             for (MXKRoomDataSource *roomDataSource in self->roomDataSources.allValues)
             {
@@ -145,10 +187,12 @@ static Class _roomDataSourceClass;
 - (void)dealloc
 {
     [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXSessionDidLeaveRoomNotification object:nil];
+    [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXKRoomDataSourceSyncStatusChanged object:nil];
 }
 
 - (void)destroy
 {
+    [self cancelPendingPrewarms];
     [self reset];
     
     if (UIApplicationDidReceiveMemoryWarningNotificationObserver)
@@ -168,16 +212,69 @@ static Class _roomDataSourceClass;
         return YES;
     }
     
-    // Check all data sources (events process is asynchronous, server sync may not be complete in data source).
+    // Check data sources (events process is asynchronous, server sync may not be complete in data source).
+    return self.hasRoomDataSourcesProcessingServerSyncEvents;
+}
+
+- (BOOL)hasRoomDataSourcesProcessingServerSyncEvents
+{
+    // Note: deallocated data sources are removed from the weak hash table with a delay, check `anyObject`.
+    return roomDataSourcesProcessingServerSyncEvents.anyObject != nil;
+}
+
+- (void)didRoomDataSourceSyncStatusChange:(NSNotification *)notif
+{
+    MXKRoomDataSource *roomDataSource = notif.object;
+    if (roomDataSource.mxSession != mxSession)
+    {
+        return;
+    }
+    
+    [self roomDataSource:roomDataSource isProcessingServerSyncEvents:(roomDataSource.serverSyncEventCount != 0)];
+}
+
+- (void)roomDataSource:(MXKRoomDataSource*)roomDataSource isProcessingServerSyncEvents:(BOOL)isProcessing
+{
+    BOOL wasProcessing = self.hasRoomDataSourcesProcessingServerSyncEvents;
+    
+    if (isProcessing)
+    {
+        [roomDataSourcesProcessingServerSyncEvents addObject:roomDataSource];
+    }
+    else
+    {
+        [roomDataSourcesProcessingServerSyncEvents removeObject:roomDataSource];
+    }
+    
+    if (wasProcessing != self.hasRoomDataSourcesProcessingServerSyncEvents)
+    {
+        [[NSNotificationCenter defaultCenter] postNotificationName:kMXKRoomDataSourceManagerServerSyncProcessingDidChangeNotification object:self userInfo:nil];
+    }
+}
+
+- (NSArray<NSString *> *)residentRoomIds
+{
+    return [roomIdsByLastAccess copy];
+}
+
+- (NSUInteger)estimatedMemoryUsage
+{
+    NSUInteger memoryUsage = 0;
     for (MXKRoomDataSource *roomDataSource in roomDataSources.allValues)
     {
-        if (roomDataSource.serverSyncEventCount)
-        {
-            return YES;
-        }
+        memoryUsage += roomDataSource.estimatedMemoryUsage;
     }
+    return memoryUsage;
+}
+
+- (void)setMemoryBudget:(NSUInteger)memoryBudget
+{
+    _memoryBudget = memoryBudget;
     
-    return NO;
+    if (_releasePolicy == MXKRoomDataSourceManagerReleasePolicyMemoryBudget)
+    {
+        [self releaseLeastRecentlyUsedRoomDataSourcesToFitMemoryBudget:_memoryBudget];
+    }
 }
 
 #pragma mark
@@ -198,15 +295,47 @@ static Class _roomDataSourceClass;
     // If not available yet, create the room data source
     MXKRoomDataSource *roomDataSource = roomDataSources[roomId];
 
+    if (create && roomId)
+    {
+        if (roomDataSource && [prewarmedRoomIds containsObject:roomId])
+        {
+            _prewarmHitCount++;
+        }
+        else if (!roomDataSource)
+        {
+            _prewarmMissCount++;
+            
+            // Do not prewarm it in parallel
+            [pendingPrewarmRoomIds removeObject:roomId];
+        }
+        [prewarmedRoomIds removeObject:roomId];
+    }
+
     if (!roomDataSource && create && roomId)
     {
         [_roomDataSourceClass loadRoomDataSourceWithRoomId:roomId andMatrixSession:mxSession onComplete:^(id roomDataSource) {
+            
+            // A prewarm, or another request, may have registered a data source for this room in the meantime
+            MXKRoomDataSource *registeredRoomDataSource = self->roomDataSources[roomId];
+            if (registeredRoomDataSource && registeredRoomDataSource != roomDataSource)
+            {
+                [roomDataSource destroy];
+                [self->prewarmedRoomIds removeObject:roomId];
+                [self touchRoomDataSourceWithRoomId:roomId];
+                onComplete(registeredRoomDataSource);
+                return;
+            }
+            
             [self addRoomDataSource:roomDataSource];
             onComplete(roomDataSource);
         }];
     }
     else
     {
+        if (roomDataSource)
+        {
+            [self touchRoomDataSourceWithRoomId:roomId];
+        }
         onComplete(roomDataSource);
     }
 }
@@ -214,6 +343,7 @@ static Class _roomDataSourceClass;
 - (void)addRoomDataSource:(MXKRoomDataSource *)roomDataSource
 {
     roomDataSources[roomDataSource.roomId] = roomDataSource;
+    [self touchRoomDataSourceWithRoomId:roomDataSource.roomId];
 }
 
 - (void)closeRoomDataSourceWithRoomId:(NSString*)roomId forceClose:(BOOL)forceRelease;
@@ -243,6 +373,9 @@ static Class _roomDataSourceClass;
             // Destroy and forget the instance
             [roomDataSource destroy];
             [roomDataSources removeObjectForKey:roomDataSource.roomId];
+            [self roomDataSource:roomDataSource isProcessingServerSyncEvents:NO];
+            [roomIdsByLastAccess removeObject:roomId];
+            [prewarmedRoomIds removeObject:roomId];
             break;
             
         case MXKRoomDataSourceManagerReleasePolicyNeverRelease:
@@ -254,11 +387,168 @@ static Class _roomDataSourceClass;
             [roomDataSource limitMemoryUsage:roomDataSource.maxBackgroundCachedBubblesCount];
             break;
             
+        case MXKRoomDataSourceManagerReleasePolicyMemoryBudget:
+            
+            // Keep the instance with its loaded data while the memory budget allows it
+            roomDataSource.delegate = nil;
+            
+            [self releaseLeastRecentlyUsedRoomDataSourcesToFitMemoryBudget:_memoryBudget];
+            break;
+            
         default:
             break;
     }
 }
 
+#pragma mark - Memory budget
+
+- (void)touchRoomDataSourceWithRoomId:(NSString*)roomId
+{
+    [roomIdsByLastAccess removeObject:roomId];
+    [roomIdsByLastAccess insertObject:roomId atIndex:0];
+}
+
+/**
+ Release the least recently used room data sources until the estimated memory usage
+ of the unused ones fits in the provided budget.
+ 
+ The room data sources with a delegate or with outgoing messages in progress are kept.
+ 
+ @param memoryBudget the budget in bytes.
+ */
+- (void)releaseLeastRecentlyUsedRoomDataSourcesToFitMemoryBudget:(NSUInteger)memoryBudget
+{
+    NSMutableDictionary<NSString*, NSNumber*> *memoryUsages = [NSMutableDictionary dictionary];
+    NSUInteger memoryUsage = 0;
+    
+    for (NSString *roomId in roomIdsByLastAccess)
+    {
+        MXKRoomDataSource *roomDataSource = roomDataSources[roomId];
+        if (!roomDataSource.delegate)
+        {
+            NSUInteger roomDataSourceMemoryUsage = roomDataSource.estimatedMemoryUsage;
+            memoryUsages[roomId] = @(roomDataSourceMemoryUsage);
+            memoryUsage += roomDataSourceMemoryUsage;
+        }
+    }
+    
+    if (memoryUsage <= memoryBudget)
+    {
+        return;
+    }
+    
+    NSArray<NSString*> *candidateRoomIds = roomIdsByLastAccess.reverseObjectEnumerator.allObjects;
+    for (NSString *roomId in candidateRoomIds)
+    {
+        if (memoryUsage <= memoryBudget)
+        {
+            break;
+        }
+        
+        MXKRoomDataSource *roomDataSource = roomDataSources[roomId];
+        if (!memoryUsages[roomId] || roomDataSource.hasOutgoingMessagesInProgress)
+        {
+            continue;
+        }
+        
+        MXLogDebug(@"[MXKRoomDataSourceManager] Release the room data source of %@ (%tu bytes) to fit the memory budget", roomId, memoryUsages[roomId].unsignedIntegerValue);
+        
+        memoryUsage -= memoryUsages[roomId].unsignedIntegerValue;
+        
+        [roomDataSource destroy];
+        [roomDataSources removeObjectForKey:roomId];
+        [self roomDataSource:roomDataSource isProcessingServerSyncEvents:NO];
+        [roomIdsByLastAccess removeObject:roomId];
+        [prewarmedRoomIds removeObject:roomId];
+    }
+    
+    MXLogDebug(@"[MXKRoomDataSourceManager] %tu resident room data sources, estimated memory usage of closed ones: %tu bytes", roomDataSources.count, memoryUsage);
+}
+
+#pragma mark - Prewarm
+
+- (void)prewarmRoomDataSourcesWithRoomIds:(NSArray<NSString *> *)roomIds
+{
+    for (NSString *roomId in roomIds)
+    {
+        if (!roomDataSources[roomId] && ![pendingPrewarmRoomIds containsObject:roomId])
+        {
+            [pendingPrewarmRoomIds addObject:roomId];
+        }
+    }
+    
+    [self prewarmNextRoomDataSource];
+}
+
+- (void)cancelPendingPrewarms
+{
+    [pendingPrewarmRoomIds removeAllObjects];
+}
+
+- (void)prewarmNextRoomDataSource
+{
+    // Prewarm one room at a time to not overload the processing queue shared by all the room data sources
+    if (isPrewarming || !pendingPrewarmRoomIds.count)
+    {
+        return;
+    }
+    
+    NSString *roomId = pendingPrewarmRoomIds.firstObject;
+    [pendingPrewarmRoomIds removeObjectAtIndex:0];
+    
+    if (roomDataSources[roomId] || ![mxSession roomWithRoomId:roomId])
+    {
+        [self prewarmNextRoomDataSource];
+        return;
+    }
+    
+    isPrewarming = YES;
+    
+    MXLogDebug(@"[MXKRoomDataSourceManager] Prewarm the room data source of %@", roomId);
+    
+    MXWeakify(self);
+    [_roomDataSourceClass loadRoomDataSourceWithRoomId:roomId andMatrixSession:mxSession onComplete:^(MXKRoomDataSource *roomDataSource) {
+        MXStrongifyAndReturnIfNil(self);
+        
+        // The room data source may have been created on demand in the meantime
+        if (self->roomDataSources[roomId])
+        {
+            [roomDataSource destroy];
+            [self didPrewarmRoomDataSource];
+            return;
+        }
+        
+        [self addRoomDataSource:roomDataSource];
+        [self->prewarmedRoomIds addObject:roomId];
+        
+        // Fill it with the messages available in the store
+        [roomDataSource paginate:self.prewarmPaginationLimit direction:MXTimelineDirectionBackwards onlyFromStore:YES success:^(NSUInteger addedCellNumber) {
+            
+            [self didPrewarmRoomDataSource];
+            
+        } failure:^(NSError *error) {
+            
+            MXLogDebug(@"[MXKRoomDataSourceManager] Failed to prewarm the room data source of %@", roomId);
+            [self didPrewarmRoomDataSource];
+            
+        }];
+    }];
+}
+
+- (void)didPrewarmRoomDataSource
+{
+    isPrewarming = NO;
+    
+    if (_releasePolicy == MXKRoomDataSourceManagerReleasePolicyMemoryBudget)
+    {
+        [self releaseLeastRecentlyUsedRoomDataSourcesToFitMemoryBudget:_memoryBudget];
+    }
+    
+    [self prewarmNextRoomDataSource];
+}
+
+#pragma mark -
+
 - (void)didMXSessionDidLeaveRoom:(NSNotification *)notif
 {
     if (mxSession == notif.object)
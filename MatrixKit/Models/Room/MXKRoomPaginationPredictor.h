@@ -0,0 +1,180 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+#import <MatrixSDK/MatrixSDK.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The default maximum number of messages requested by a pagination.
+ */
+#define MXKROOMPAGINATIONPREDICTOR_DEFAULT_MAXIMUM_LIMIT 150
+
+/**
+ The default estimation of a pagination duration (in seconds), before any measure.
+ */
+#define MXKROOMPAGINATIONPREDICTOR_DEFAULT_LOOK_AHEAD_DURATION 1.0
+
+/**
+ `MXKRoomPaginationPredictor` decides when a timeline must be paginated and how many messages must be requested,
+ from the scroll velocity and the average height of the displayed cells.
+ 
+ A pagination is started when the content ahead of the viewport will run out before a pagination can complete:
+ the distance the user will scroll during a pagination (measured on the previous ones) is added to the history buffer
+ (`threshold`). The request is sized to cover this distance and to refill the buffer.
+ 
+ The predictor also counts how often the user reaches the edge of the content while a pagination is in progress
+ (the loading indicator is then visible).
+ 
+ This class must be used on the main thread.
+ */
+@interface MXKRoomPaginationPredictor : NSObject
+
+/**
+ Create a predictor.
+ 
+ @param threshold the height of the history kept ahead of the viewport (in points).
+ @param minimumLimit the minimum number of messages requested by a pagination.
+ @return the newly created instance.
+ */
+- (instancetype)initWithThreshold:(CGFloat)threshold minimumLimit:(NSUInteger)minimumLimit;
+
+/**
+ The height of the history kept ahead of the viewport (in points).
+ */
+@property (nonatomic) CGFloat threshold;
+
+/**
+ The minimum number of messages requested by a pagination.
+ */
+@property (nonatomic) NSUInteger minimumLimit;
+
+/**
+ The maximum number of messages requested by a pagination.
+ Default is MXKROOMPAGINATIONPREDICTOR_DEFAULT_MAXIMUM_LIMIT.
+ */
+@property (nonatomic) NSUInteger maximumLimit;
+
+/**
+ The estimated duration of a pagination (in seconds). It is updated at the end of each pagination.
+ */
+@property (nonatomic, readonly) NSTimeInterval lookAheadDuration;
+
+/**
+ The current vertical scroll velocity (in points per second). It is negative when the user scrolls toward the top.
+ */
+@property (nonatomic, readonly) CGFloat velocity;
+
+/**
+ Tell whether a pagination is in progress (between `didStartPagination` and `didEndPagination`).
+ */
+@property (nonatomic, readonly) BOOL isPaginating;
+
+#pragma mark - Scroll tracking
+
+/**
+ Report the current vertical content offset, to update the scroll velocity.
+ 
+ @param contentOffset the vertical content offset.
+ @param timestamp the time of the offset (see `CACurrentMediaTime`).
+ */
+- (void)updateWithContentOffset:(CGFloat)contentOffset timestamp:(NSTimeInterval)timestamp;
+
+/**
+ Forget the current velocity (for example when the content is reloaded).
+ */
+- (void)resetVelocity;
+
+/**
+ Report a programmatic change of the content offset (for example to compensate the cells added at the top),
+ so that it is not taken for a scroll.
+ 
+ @param delta the offset change.
+ */
+- (void)didShiftContentOffsetBy:(CGFloat)delta;
+
+/**
+ The distance the user is expected to scroll toward the edge of a direction during a pagination.
+ 
+ @param direction the pagination direction (backwards for the top of the content).
+ @return the projected distance (in points).
+ */
+- (CGFloat)projectedDistanceInDirection:(MXTimelineDirection)direction;
+
+#pragma mark - Prediction
+
+/**
+ Tell whether a pagination must be started.
+ 
+ @param direction the pagination direction.
+ @param distanceToEdge the height of the content available between the viewport and the edge of this direction.
+ @return YES if the content will run out before a pagination can complete.
+ */
+- (BOOL)shouldPaginateInDirection:(MXTimelineDirection)direction distanceToEdge:(CGFloat)distanceToEdge;
+
+/**
+ Get the number of messages to request.
+ 
+ @param direction the pagination direction.
+ @param distanceToEdge the height of the content available between the viewport and the edge of this direction.
+ @param averageCellHeight the average height of the displayed cells (0 if unknown).
+ @return a number of messages between `minimumLimit` and `maximumLimit`.
+ */
+- (NSUInteger)paginationLimitInDirection:(MXTimelineDirection)direction distanceToEdge:(CGFloat)distanceToEdge averageCellHeight:(CGFloat)averageCellHeight;
+
+#pragma mark - Pagination tracking
+
+/**
+ Report the start of a pagination.
+ */
+- (void)didStartPagination;
+
+/**
+ Report the end of a pagination. Its duration is used to estimate the next ones.
+ */
+- (void)didEndPagination;
+
+/**
+ Report that the user has reached the edge of the content. It is counted only once per pagination in progress.
+ */
+- (void)didReachContentEdge;
+
+#pragma mark - Metrics
+
+/**
+ The number of paginations.
+ */
+@property (nonatomic, readonly) NSUInteger paginationCount;
+
+/**
+ The number of paginations during which the user has reached the loading indicator.
+ */
+@property (nonatomic, readonly) NSUInteger stallCount;
+
+/**
+ The ratio of paginations during which the user has reached the loading indicator (0 when there was no pagination).
+ */
+@property (nonatomic, readonly) double stallRate;
+
+/**
+ Reset the metrics.
+ */
+- (void)resetMetrics;
+
+@end
+
+NS_ASSUME_NONNULL_END
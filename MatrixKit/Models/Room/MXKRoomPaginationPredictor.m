@@ -0,0 +1,176 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXKRoomPaginationPredictor.h"
+
+/**
+ The scroll events older than this interval (in seconds) do not contribute to the velocity.
+ */
+static NSTimeInterval const kMXKRoomPaginationPredictorVelocityTimeout = 0.2;
+
+/**
+ The bounds of the estimated pagination duration (in seconds).
+ */
+static NSTimeInterval const kMXKRoomPaginationPredictorMinLookAheadDuration = 0.3;
+static NSTimeInterval const kMXKRoomPaginationPredictorMaxLookAheadDuration = 3.0;
+
+@interface MXKRoomPaginationPredictor ()
+{
+    /**
+     The last reported content offset and its time (0 when there is none).
+     */
+    CGFloat lastContentOffset;
+    NSTimeInterval lastTimestamp;
+    
+    /**
+     Tell whether the velocity has been measured since the last reset.
+     */
+    BOOL hasVelocity;
+    
+    /**
+     The start time of the pagination in progress.
+     */
+    NSTimeInterval paginationStartTimestamp;
+    
+    /**
+     Tell whether the user has reached the content edge during the pagination in progress.
+     */
+    BOOL hasReachedContentEdge;
+}
+
+@end
+
+@implementation MXKRoomPaginationPredictor
+
+- (instancetype)initWithThreshold:(CGFloat)threshold minimumLimit:(NSUInteger)minimumLimit
+{
+    self = [super init];
+    if (self)
+    {
+        _threshold = threshold;
+        _minimumLimit = minimumLimit;
+        _maximumLimit = MXKROOMPAGINATIONPREDICTOR_DEFAULT_MAXIMUM_LIMIT;
+        _lookAheadDuration = MXKROOMPAGINATIONPREDICTOR_DEFAULT_LOOK_AHEAD_DURATION;
+    }
+    return self;
+}
+
+#pragma mark - Scroll tracking
+
+- (void)updateWithContentOffset:(CGFloat)contentOffset timestamp:(NSTimeInterval)timestamp
+{
+    NSTimeInterval interval = timestamp - lastTimestamp;
+    
+    if (lastTimestamp && interval > 0)
+    {
+        CGFloat instantVelocity = (contentOffset - lastContentOffset) / interval;
+        
+        // Smooth the velocity, except for the first measure or after a pause
+        _velocity = (!hasVelocity || interval > kMXKRoomPaginationPredictorVelocityTimeout) ? instantVelocity : (_velocity + instantVelocity) / 2;
+        hasVelocity = YES;
+    }
+    
+    lastContentOffset = contentOffset;
+    lastTimestamp = timestamp;
+}
+
+- (void)resetVelocity
+{
+    _velocity = 0;
+    lastTimestamp = 0;
+    hasVelocity = NO;
+}
+
+- (void)didShiftContentOffsetBy:(CGFloat)delta
+{
+    lastContentOffset += delta;
+}
+
+- (CGFloat)projectedDistanceInDirection:(MXTimelineDirection)direction
+{
+    // The content offset decreases when the user scrolls toward the top (backwards)
+    CGFloat speedTowardEdge = (direction == MXTimelineDirectionBackwards) ? -_velocity : _velocity;
+    return MAX(0, speedTowardEdge) * _lookAheadDuration;
+}
+
+#pragma mark - Prediction
+
+- (BOOL)shouldPaginateInDirection:(MXTimelineDirection)direction distanceToEdge:(CGFloat)distanceToEdge
+{
+    return distanceToEdge < _threshold + [self projectedDistanceInDirection:direction];
+}
+
+- (NSUInteger)paginationLimitInDirection:(MXTimelineDirection)direction distanceToEdge:(CGFloat)distanceToEdge averageCellHeight:(CGFloat)averageCellHeight
+{
+    if (averageCellHeight <= 0)
+    {
+        return _minimumLimit;
+    }
+    
+    // Cover the distance scrolled during the pagination, and keep the history buffer ahead of the viewport after it
+    CGFloat missingHeight = [self projectedDistanceInDirection:direction] + 2 * _threshold - MAX(0, distanceToEdge);
+    NSUInteger limit = (NSUInteger)ceil(MAX(0, missingHeight) / averageCellHeight);
+    
+    return MIN(MAX(limit, _minimumLimit), MAX(_maximumLimit, _minimumLimit));
+}
+
+#pragma mark - Pagination tracking
+
+- (void)didStartPagination
+{
+    _isPaginating = YES;
+    _paginationCount++;
+    hasReachedContentEdge = NO;
+    paginationStartTimestamp = CACurrentMediaTime();
+}
+
+- (void)didEndPagination
+{
+    if (!_isPaginating)
+    {
+        return;
+    }
+    _isPaginating = NO;
+    
+    // Smooth the duration estimation
+    NSTimeInterval duration = CACurrentMediaTime() - paginationStartTimestamp;
+    _lookAheadDuration = (_lookAheadDuration + duration) / 2;
+    _lookAheadDuration = MIN(MAX(_lookAheadDuration, kMXKRoomPaginationPredictorMinLookAheadDuration), kMXKRoomPaginationPredictorMaxLookAheadDuration);
+}
+
+- (void)didReachContentEdge
+{
+    if (_isPaginating && !hasReachedContentEdge)
+    {
+        hasReachedContentEdge = YES;
+        _stallCount++;
+    }
+}
+
+#pragma mark - Metrics
+
+- (double)stallRate
+{
+    return _paginationCount ? (double)_stallCount / _paginationCount : 0;
+}
+
+- (void)resetMetrics
+{
+    _paginationCount = 0;
+    _stallCount = 0;
+}
+
+@end
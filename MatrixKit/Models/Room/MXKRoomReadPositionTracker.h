@@ -0,0 +1,92 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import <MatrixSDK/MatrixSDK.h>
+
+@class MXKRoomDataSource;
+
+/**
+ The default time interval during which the read position updates are coalesced.
+ */
+#define MXKROOMREADPOSITIONTRACKER_DEFAULT_COALESCING_INTERVAL 1.0
+
+/**
+ `MXKRoomReadPositionTracker` coalesces the read position updates of a room (read receipt and read marker).
+ 
+ The read position only moves forward: an event older than the last acknowledged one is ignored.
+ The latest event reported during the coalescing interval is acknowledged when the interval ends,
+ when `flush` is called, or when the application enters background.
+ 
+ This class must be used on the main thread.
+ */
+@interface MXKRoomReadPositionTracker : NSObject
+
+/**
+ The room data source of the room.
+ */
+@property (nonatomic, readonly, weak) MXKRoomDataSource *roomDataSource;
+
+/**
+ The time interval during which the updates are coalesced.
+ Default is MXKROOMREADPOSITIONTRACKER_DEFAULT_COALESCING_INTERVAL. Set 0 to acknowledge each update immediately.
+ */
+@property (nonatomic) NSTimeInterval coalescingInterval;
+
+/**
+ The event which will be acknowledged on the next flush, if any.
+ */
+@property (nonatomic, readonly) MXEvent *pendingEvent;
+
+/**
+ The number of acknowledgements sent to the homeserver.
+ */
+@property (nonatomic, readonly) NSUInteger sentUpdatesCount;
+
+/**
+ The number of updates which have been ignored (older or already acknowledged event)
+ or replaced by a more recent one before being sent.
+ */
+@property (nonatomic, readonly) NSUInteger suppressedUpdatesCount;
+
+/**
+ Create a tracker for the room of a room data source.
+ 
+ @param roomDataSource the room data source.
+ @return the newly created instance.
+ */
+- (instancetype)initWithRoomDataSource:(MXKRoomDataSource*)roomDataSource;
+
+/**
+ Report the event currently displayed at the bottom of the timeline.
+ 
+ @param event the event read by the user.
+ @param updateReadMarker tell whether the room read marker must be moved to this event too
+ (it is moved only if the event is posterior to the current read marker).
+ */
+- (void)updateWithEvent:(MXEvent*)event updateReadMarker:(BOOL)updateReadMarker;
+
+/**
+ Acknowledge now the pending event, if any.
+ */
+- (void)flush;
+
+/**
+ Flush the pending update and stop observing the application state.
+ */
+- (void)destroy;
+
+@end
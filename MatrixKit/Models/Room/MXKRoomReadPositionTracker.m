@@ -0,0 +1,169 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXKRoomReadPositionTracker.h"
+
+#import <UIKit/UIKit.h>
+
+#import "MXKRoomDataSource.h"
+
+@interface MXKRoomReadPositionTracker ()
+{
+    /**
+     Tell whether the read marker must be updated with the pending event.
+     */
+    BOOL pendingUpdateReadMarker;
+    
+    /**
+     The last acknowledged event.
+     */
+    MXEvent *lastAcknowledgedEvent;
+    
+    /**
+     The timer used to flush the pending event at the end of the coalescing interval.
+     */
+    NSTimer *flushTimer;
+    
+    /**
+     Observe UIApplicationDidEnterBackgroundNotification to flush the pending event.
+     */
+    id applicationDidEnterBackgroundObserver;
+}
+
+@end
+
+@implementation MXKRoomReadPositionTracker
+
+- (instancetype)initWithRoomDataSource:(MXKRoomDataSource *)roomDataSource
+{
+    self = [super init];
+    if (self)
+    {
+        _roomDataSource = roomDataSource;
+        _coalescingInterval = MXKROOMREADPOSITIONTRACKER_DEFAULT_COALESCING_INTERVAL;
+        
+        MXWeakify(self);
+        applicationDidEnterBackgroundObserver = [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationDidEnterBackgroundNotification object:nil queue:[NSOperationQueue mainQueue] usingBlock:^(NSNotification *notif) {
+            
+            MXStrongifyAndReturnIfNil(self);
+            [self flush];
+        }];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self destroy];
+}
+
+- (void)destroy
+{
+    [self flush];
+    
+    if (applicationDidEnterBackgroundObserver)
+    {
+        [[NSNotificationCenter defaultCenter] removeObserver:applicationDidEnterBackgroundObserver];
+        applicationDidEnterBackgroundObserver = nil;
+    }
+}
+
+- (void)updateWithEvent:(MXEvent *)event updateReadMarker:(BOOL)updateReadMarker
+{
+    if (!event.eventId)
+    {
+        return;
+    }
+    
+    // The read position only moves forward
+    MXEvent *latestEvent = _pendingEvent ?: lastAcknowledgedEvent;
+    if (latestEvent && ([latestEvent.eventId isEqualToString:event.eventId] || event.originServerTs < latestEvent.originServerTs))
+    {
+        // Keep a read marker update requested for the same event
+        if (_pendingEvent && [_pendingEvent.eventId isEqualToString:event.eventId])
+        {
+            pendingUpdateReadMarker |= updateReadMarker;
+        }
+        
+        _suppressedUpdatesCount++;
+        return;
+    }
+    
+    if (_pendingEvent)
+    {
+        // The pending update is replaced by this one
+        _suppressedUpdatesCount++;
+        updateReadMarker |= pendingUpdateReadMarker;
+    }
+    
+    _pendingEvent = event;
+    pendingUpdateReadMarker = updateReadMarker;
+    
+    if (_coalescingInterval <= 0)
+    {
+        [self flush];
+    }
+    else if (!flushTimer)
+    {
+        flushTimer = [NSTimer scheduledTimerWithTimeInterval:_coalescingInterval target:self selector:@selector(flushTimerFired:) userInfo:nil repeats:NO];
+    }
+}
+
+- (void)flush
+{
+    [flushTimer invalidate];
+    flushTimer = nil;
+    
+    MXEvent *event = _pendingEvent;
+    _pendingEvent = nil;
+    
+    MXKRoomDataSource *roomDataSource = _roomDataSource;
+    if (!event || !roomDataSource.room)
+    {
+        return;
+    }
+    
+    // Check whether the read marker must be updated.
+    BOOL updateReadMarker = pendingUpdateReadMarker;
+    NSString *readMarkerEventId = roomDataSource.room.accountData.readMarkerEventId;
+    if (updateReadMarker && readMarkerEventId)
+    {
+        MXEvent *currentReadMarkerEvent = [roomDataSource.mxSession.store eventWithEventId:readMarkerEventId inRoom:roomDataSource.roomId];
+        if (!currentReadMarkerEvent)
+        {
+            currentReadMarkerEvent = [roomDataSource eventWithEventId:readMarkerEventId];
+        }
+        
+        // Update the read marker only if the current event is available, and the new event is posterior to it.
+        updateReadMarker = (currentReadMarkerEvent && (currentReadMarkerEvent.originServerTs <= event.originServerTs));
+    }
+    
+    // Indicate to the homeserver that the user has read this event.
+    [roomDataSource.room acknowledgeEvent:event andUpdateReadMarker:updateReadMarker];
+    
+    lastAcknowledgedEvent = event;
+    _sentUpdatesCount++;
+}
+
+#pragma mark - Private methods
+
+- (void)flushTimerFired:(NSTimer*)timer
+{
+    flushTimer = nil;
+    [self flush];
+}
+
+@end
@@ -0,0 +1,60 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `MXKRoomSendQueue` keeps the order of the messages sent to a room while some of them are prepared in background
+ (Markdown conversion, image encoding).
+ 
+ A position is reserved when the message is sent. The message is handed to the room once it is prepared and all
+ the messages reserved before it have been handed to the room, so that the room receives them in the order of the calls.
+ 
+ This class must be used on the main thread.
+ */
+@interface MXKRoomSendQueue : NSObject
+
+/**
+ Reserve the position of the next message.
+ 
+ The returned block must be called once with the block which hands the message to the room, or with nil when
+ the message is not sent (for example its preparation failed). The block is run immediately when the queue
+ has no message in preparation before it.
+ 
+ The returned block retains the queue: the messages are sent even if the owner of the queue is released meanwhile.
+ 
+ @return the block to call once the message is prepared.
+ */
+- (void (^)(dispatch_block_t _Nullable sendBlock))reserve;
+
+/**
+ Hand a message to the room in the order of the calls.
+ It is the same as reserving a position and calling the returned block immediately.
+ 
+ @param sendBlock the block which hands the message to the room.
+ */
+- (void)send:(dispatch_block_t)sendBlock;
+
+/**
+ The number of messages reserved and not handed to the room yet.
+ */
+@property (nonatomic, readonly) NSUInteger pendingCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
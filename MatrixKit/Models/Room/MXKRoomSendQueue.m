@@ -0,0 +1,109 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXKRoomSendQueue.h"
+
+/**
+ A reserved position in the queue.
+ */
+@interface MXKRoomSendQueueItem : NSObject
+
+@property (nonatomic) BOOL isReady;
+@property (nonatomic, copy) dispatch_block_t sendBlock;
+
+@end
+
+@implementation MXKRoomSendQueueItem
+@end
+
+@interface MXKRoomSendQueue ()
+{
+    /**
+     The reserved positions, in the order of the calls.
+     */
+    NSMutableArray<MXKRoomSendQueueItem*> *items;
+    
+    /**
+     Tell whether the ready messages are being handed to the room.
+     */
+    BOOL isDraining;
+}
+
+@end
+
+@implementation MXKRoomSendQueue
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        items = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (NSUInteger)pendingCount
+{
+    return items.count;
+}
+
+- (void (^)(dispatch_block_t))reserve
+{
+    MXKRoomSendQueueItem *item = [MXKRoomSendQueueItem new];
+    [items addObject:item];
+    
+    return ^(dispatch_block_t sendBlock) {
+        
+        NSAssert(!item.isReady, @"[MXKRoomSendQueue] A reserved position must be completed once");
+        item.sendBlock = sendBlock;
+        item.isReady = YES;
+        
+        // The block retains the queue
+        [self drain];
+    };
+}
+
+- (void)send:(dispatch_block_t)sendBlock
+{
+    [self reserve](sendBlock);
+}
+
+#pragma mark - Private methods
+
+- (void)drain
+{
+    if (isDraining)
+    {
+        // A send block is sending another message, which is handed to the room after it
+        return;
+    }
+    
+    isDraining = YES;
+    while (items.firstObject.isReady)
+    {
+        MXKRoomSendQueueItem *item = items.firstObject;
+        [items removeObjectAtIndex:0];
+        
+        if (item.sendBlock)
+        {
+            item.sendBlock();
+        }
+    }
+    isDraining = NO;
+}
+
+@end
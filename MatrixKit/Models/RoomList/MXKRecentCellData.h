@@ -20,7 +20,15 @@
 
 /**
  `MXKRecentCellData` modelised the data for a `MXKRecentTableViewCell` cell.
+ 
+ A copy keeps the values of the displayed fields and their version, it can be updated with `updateWithRoomSummary:`
+ without modifying the original instance.
  */
-@interface MXKRecentCellData : MXKCellData <MXKRecentCellDataStoring>
+@interface MXKRecentCellData : MXKCellData <MXKRecentCellDataStoring, NSCopying>
+
+/**
+ The version of the displayed fields (see `updateWithRoomSummary:`).
+ */
+@property (nonatomic, readonly) NSUInteger version;
 
 @end
@@ -24,6 +24,21 @@
 
 #import "MXKSwiftHeader.h"
 
+@interface MXKRecentCellData ()
+{
+    // The values of the displayed fields at the last update, used to detect the changes
+    NSString *displayname;
+    NSString *avatarUrl;
+    NSString *lastMessageEventId;
+    NSString *lastMessageText;
+    uint64_t lastMessageTs;
+    NSUInteger localUnreadEventCount;
+    NSUInteger notificationCount;
+    NSUInteger highlightCount;
+}
+
+@end
+
 @implementation MXKRecentCellData
 @synthesize roomSummary, dataSource, lastEventDate;
 
@@ -35,10 +50,84 @@
     {
         roomSummary = theRoomSummary;
         dataSource = theDataSource;
+        
+        [self storeFieldValues];
     }
     return self;
 }
 
+- (id)copyWithZone:(NSZone *)zone
+{
+    MXKRecentCellData *cellData = [[[self class] allocWithZone:zone] initWithRoomSummary:roomSummary dataSource:dataSource];
+    
+    // Keep the previous values to detect the changes on the next update
+    cellData->displayname = displayname;
+    cellData->avatarUrl = avatarUrl;
+    cellData->lastMessageEventId = lastMessageEventId;
+    cellData->lastMessageText = lastMessageText;
+    cellData->lastMessageTs = lastMessageTs;
+    cellData->localUnreadEventCount = localUnreadEventCount;
+    cellData->notificationCount = notificationCount;
+    cellData->highlightCount = highlightCount;
+    cellData->_version = _version;
+    
+    return cellData;
+}
+
+- (MXKRecentCellDataChanges)updateWithRoomSummary:(id<MXRoomSummaryProtocol>)theRoomSummary
+{
+    roomSummary = theRoomSummary;
+    
+    MXKRecentCellDataChanges changes = MXKRecentCellDataChangesNone;
+    
+    NSString *newDisplayname = self.roomDisplayname;
+    if (newDisplayname != displayname && ![newDisplayname isEqualToString:displayname])
+    {
+        changes |= MXKRecentCellDataChangesDisplayname;
+    }
+    
+    NSString *newAvatarUrl = self.avatarUrl;
+    if (newAvatarUrl != avatarUrl && ![newAvatarUrl isEqualToString:avatarUrl])
+    {
+        changes |= MXKRecentCellDataChangesAvatar;
+    }
+    
+    MXRoomLastMessage *lastMessage = roomSummary.lastMessage;
+    if ((lastMessage.eventId != lastMessageEventId && ![lastMessage.eventId isEqualToString:lastMessageEventId])
+        || lastMessage.originServerTs != lastMessageTs
+        || (self.lastEventTextMessage != lastMessageText && ![self.lastEventTextMessage isEqualToString:lastMessageText]))
+    {
+        changes |= MXKRecentCellDataChangesLastMessage;
+    }
+    
+    if (roomSummary.localUnreadEventCount != localUnreadEventCount
+        || roomSummary.notificationCount != notificationCount
+        || roomSummary.highlightCount != highlightCount)
+    {
+        changes |= MXKRecentCellDataChangesUnreadCounts;
+    }
+    
+    if (changes != MXKRecentCellDataChangesNone)
+    {
+        [self storeFieldValues];
+        _version++;
+    }
+    
+    return changes;
+}
+
+- (void)storeFieldValues
+{
+    displayname = self.roomDisplayname;
+    avatarUrl = self.avatarUrl;
+    lastMessageEventId = roomSummary.lastMessage.eventId;
+    lastMessageText = self.lastEventTextMessage;
+    lastMessageTs = roomSummary.lastMessage.originServerTs;
+    localUnreadEventCount = roomSummary.localUnreadEventCount;
+    notificationCount = roomSummary.notificationCount;
+    highlightCount = roomSummary.highlightCount;
+}
+
 - (void)dealloc
 {
     roomSummary = nil;
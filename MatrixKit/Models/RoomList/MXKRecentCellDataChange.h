@@ -0,0 +1,82 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@protocol MXKRecentCellDataStoring;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The fields of a recent cell data which may change.
+ */
+typedef NS_OPTIONS(NSUInteger, MXKRecentCellDataChanges)
+{
+    MXKRecentCellDataChangesNone = 0,
+    /**
+     The room display name.
+     */
+    MXKRecentCellDataChangesDisplayname = 1 << 0,
+    /**
+     The room avatar.
+     */
+    MXKRecentCellDataChangesAvatar = 1 << 1,
+    /**
+     The last message (its text or its date).
+     */
+    MXKRecentCellDataChangesLastMessage = 1 << 2,
+    /**
+     The unread, notification or highlight counts.
+     */
+    MXKRecentCellDataChangesUnreadCounts = 1 << 3
+};
+
+/**
+ `MXKRecentCellDataChange` describes the update of a recent cell data.
+ 
+ The session recents data source reports an array of `MXKRecentCellDataChange` instances in `[MXKDataSourceDelegate dataSource:didCellChange:]`
+ when the recents order is unchanged. The updated cell data replace the previous instances of the same rooms: the rows which render
+ these rooms can be refreshed without reloading the whole table.
+ */
+@interface MXKRecentCellDataChange : NSObject
+
+/**
+ Create a change description.
+ 
+ @param cellData the updated cell data.
+ @param changes the changed fields.
+ @return the newly created instance.
+ */
+- (instancetype)initWithCellData:(id<MXKRecentCellDataStoring>)cellData changes:(MXKRecentCellDataChanges)changes;
+
+/**
+ The updated cell data, which replaces the previous instance of the room.
+ */
+@property (nonatomic, readonly) id<MXKRecentCellDataStoring> cellData;
+
+/**
+ The id of the room.
+ */
+@property (nonatomic, readonly, nullable) NSString *roomId;
+
+/**
+ The changed fields.
+ */
+@property (nonatomic, readonly) MXKRecentCellDataChanges changes;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -19,6 +19,7 @@
 #import <MatrixSDK/MatrixSDK.h>
 
 #import "MXKCellData.h"
+#import "MXKRecentCellDataChange.h"
 
 @class MXKDataSource;
 @class MXSpaceChildInfo;
@@ -72,4 +73,22 @@
  */
 @property (nonatomic, readonly) NSAttributedString *lastEventAttributedTextMessage;
 
+/**
+ The version of the displayed fields. It is incremented each time `updateWithRoomSummary:` detects a change.
+ */
+@property (nonatomic, readonly) NSUInteger version;
+
+/**
+ Update the displayed fields when the room summary has changed.
+ 
+ The cell data published by the data source are never modified: the data source calls this method on a copy
+ (see `NSCopying`) and replaces the previous instance with it when some fields have changed.
+
+ @param roomSummary the updated room summary.
+ @return the fields which have changed since the previous update. `MXKRecentCellDataChangesNone` when none
+ of the tracked fields has changed: the data source then reloads the whole list, as the change may concern
+ other rendered data.
+ */
+- (MXKRecentCellDataChanges)updateWithRoomSummary:(id<MXRoomSummaryProtocol>)roomSummary;
+
 @end
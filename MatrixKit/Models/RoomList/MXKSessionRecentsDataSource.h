@@ -30,6 +30,11 @@ extern NSString *const kMXKRecentCellIdentifier;
 
 /**
  The recents data source based on a unique matrix session.
+ 
+ On room summary changes, the cell data are not reallocated: an updated copy replaces the published instance
+ (see `[MXKRecentCellDataStoring updateWithRoomSummary:]`). When the recents order is unchanged, the `changes` parameter of
+ `[MXKDataSourceDelegate dataSource:didCellChange:]` is the array of the `MXKRecentCellDataChange` instances. It is nil when
+ the whole list must be reloaded, for example when the change concerns a field which is not tracked.
  */
 MXK_DEPRECATED_ATTRIBUTE_WITH_MSG("See MXSession.roomListDataManager")
 @interface MXKSessionRecentsDataSource : MXKDataSource {
@@ -59,6 +64,13 @@ MXK_DEPRECATED_ATTRIBUTE_WITH_MSG("See MXSession.roomListDataManager")
 
 @property (nonatomic, strong, nullable) MXSpace *currentSpace;
 
+/**
+ The number of top rooms whose room data source is prewarmed by the shared `MXKRoomDataSourceManager`
+ each time the recents list is sorted. 0 (the default) disables the prewarm.
+ @see `roomIdsToPrewarm:`.
+ */
+@property (nonatomic) NSUInteger prewarmedRoomsCount;
+
 
 #pragma mark - Life cycle
 
@@ -67,10 +79,27 @@ MXK_DEPRECATED_ATTRIBUTE_WITH_MSG("See MXSession.roomListDataManager")
  When patterns are not empty, the search result is stored in `filteredCellDataArray`,
  this array provides then data for the cells served by `MXKRecentsDataSource`.
  
+ The filtering runs in background (see `MXKSearchFilter`): the result is published on the main thread and the delegate
+ is then notified. A new search cancels the pending one.
+ 
+ Note for subclasses: this method used to filter synchronously. `filteredCellDataArray` is not updated yet when it returns:
+ read it from `[MXKDataSourceDelegate dataSource:didCellChange:]`. The data source refreshes an active search synchronously
+ when its cells are reloaded, and notifies the delegate only once.
+ 
  @param patternsList the list of patterns (`NSString` instances) to match with. Set nil to cancel search.
  */
 - (void)searchWithPatterns:(NSArray*)patternsList;
 
+/**
+ Get the ids of the rooms that the user is the most likely to open.
+ 
+ The rooms with unread messages come first, then the most recent ones.
+ 
+ @param count the maximum number of room ids to return.
+ @return the room ids ordered by priority.
+ */
+- (NSArray<NSString*>*)roomIdsToPrewarm:(NSUInteger)count;
+
 /**
  Get the data for the cell at the given index.
 
@@ -20,6 +20,7 @@
 @import MatrixSDK;
 
 #import "MXKRoomDataSourceManager.h"
+#import "MXKSearchFilter.h"
 
 #import "MXKSwiftHeader.h"
 
@@ -44,11 +45,31 @@ static NSTimeInterval const roomSummaryChangeThrottlerDelay = .5;
      */
     NSArray* searchPatternsList;
     
+    /**
+     The engine filtering the recents in background.
+     */
+    MXKSearchFilter *searchFilter;
+    
+    /**
+     Tell whether the recents have changed since they have been provided to the search filter.
+     */
+    BOOL searchFilterItemsAreOutdated;
+    
     /**
      Do not react on every summary change
      */
     MXThrottler *roomSummaryChangeThrottler;
     
+    /**
+     The room summaries changed since the last throttled processing.
+     */
+    NSMutableSet<MXRoomSummary*> *changedRoomSummaries;
+    
+    /**
+     Tell whether a change has been notified for a room summary which is not handled by this data source.
+     */
+    BOOL hasUnhandledRoomSummaryChange;
+    
     /**
      Last received suggested rooms per space ID
      */
@@ -90,6 +111,7 @@ static NSTimeInterval const roomSummaryChangeThrottlerDelay = .5;
         [self registerCellDataClass:MXKRecentCellData.class forCellIdentifier:kMXKRecentCellIdentifier];
         
         roomSummaryChangeThrottler = [[MXThrottler alloc] initWithMinimumDelay:roomSummaryChangeThrottlerDelay];
+        changedRoomSummaries = [NSMutableSet set];
         
         [[MXKAppSettings standardAppSettings] addObserver:self forKeyPath:@"showAllRoomsInHomeSpace" options:0 context:nil];
     }
@@ -99,7 +121,7 @@ static NSTimeInterval const roomSummaryChangeThrottlerDelay = .5;
 - (void)destroy
 {
     [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXRoomSummaryDidChangeNotification object:nil];
-    [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXKRoomDataSourceSyncStatusChanged object:nil];
+    [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXKRoomDataSourceManagerServerSyncProcessingDidChangeNotification object:nil];
     [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXSessionNewRoomNotification object:nil];
     [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXSessionDidLeaveRoomNotification object:nil];
     [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXSessionDirectRoomsDidChangeNotification object:nil];
@@ -110,6 +132,7 @@ static NSTimeInterval const roomSummaryChangeThrottlerDelay = .5;
     
     [roomSummaryChangeThrottler cancelAll];
     roomSummaryChangeThrottler = nil;
+    changedRoomSummaries = nil;
     
     cellDataArray = nil;
     internalCellDataArray = nil;
@@ -117,6 +140,8 @@ static NSTimeInterval const roomSummaryChangeThrottlerDelay = .5;
     lastSuggestedRooms = nil;
     
     searchPatternsList = nil;
+    [searchFilter cancel];
+    searchFilter = nil;
     
     [[MXKAppSettings standardAppSettings] removeObserver:self forKeyPath:@"showAllRoomsInHomeSpace" context:nil];
 
@@ -215,40 +240,94 @@ static NSTimeInterval const roomSummaryChangeThrottlerDelay = .5;
     return NO;
 }
 
+- (void)prepareSearchFilter
+{
+    if (!searchFilter)
+    {
+        searchFilter = [[MXKSearchFilter alloc] initWithSearchKeyBlock:^NSString *(id<MXKRecentCellDataStoring> cellData) {
+            return cellData.roomDisplayname;
+        }];
+        searchFilterItemsAreOutdated = YES;
+    }
+    
+    if (searchFilterItemsAreOutdated)
+    {
+        searchFilter.items = cellDataArray;
+        searchFilterItemsAreOutdated = NO;
+    }
+}
+
+// Refresh the current search result synchronously, the caller notifies the delegate once
+- (void)updateSearchResult
+{
+    [self prepareSearchFilter];
+    filteredCellDataArray = [NSMutableArray arrayWithArray:[searchFilter filteredItemsWithPatterns:searchPatternsList]];
+}
+
 - (void)searchWithPatterns:(NSArray*)patternsList
 {
     if (patternsList.count)
     {
         searchPatternsList = patternsList;
         
-        if (filteredCellDataArray)
-        {
-            [filteredCellDataArray removeAllObjects];
-        }
-        else
+        [self prepareSearchFilter];
+        
+        // Filter in background, the result replaces the current one at once
+        MXWeakify(self);
+        [searchFilter filterWithPatterns:patternsList completion:^(NSArray *filteredItems) {
+            MXStrongifyAndReturnIfNil(self);
+            
+            self->filteredCellDataArray = [NSMutableArray arrayWithArray:filteredItems];
+            [self.delegate dataSource:self didCellChange:nil];
+        }];
+        return;
+    }
+    
+    [searchFilter cancel];
+    filteredCellDataArray = nil;
+    searchPatternsList = nil;
+    
+    [self.delegate dataSource:self didCellChange:nil];
+}
+
+- (NSArray<NSString*>*)roomIdsToPrewarm:(NSUInteger)count
+{
+    NSMutableArray<NSString*> *roomIds = [NSMutableArray arrayWithCapacity:count];
+    NSMutableArray<NSString*> *readRoomIds = [NSMutableArray arrayWithCapacity:count];
+    
+    // cellDataArray is ordered by recency
+    for (id<MXKRecentCellDataStoring> cellData in cellDataArray)
+    {
+        NSString *roomId = cellData.roomSummary.roomId;
+        if (!roomId || cellData.isSuggestedRoom || cellData.roomSummary.membership != MXMembershipJoin)
         {
-            filteredCellDataArray = [NSMutableArray arrayWithCapacity:cellDataArray.count];
+            continue;
         }
         
-        for (id<MXKRecentCellDataStoring> cellData in cellDataArray)
+        if (cellData.hasUnread)
         {
-            for (NSString* pattern in patternsList)
+            [roomIds addObject:roomId];
+            if (roomIds.count == count)
             {
-                if (cellData.roomDisplayname && [cellData.roomDisplayname rangeOfString:pattern options:NSCaseInsensitiveSearch].location != NSNotFound)
-                {
-                    [filteredCellDataArray addObject:cellData];
-                    break;
-                }
+                break;
             }
         }
+        else if (readRoomIds.count < count)
+        {
+            [readRoomIds addObject:roomId];
+        }
     }
-    else
+    
+    for (NSString *roomId in readRoomIds)
     {
-        filteredCellDataArray = nil;
-        searchPatternsList = nil;
+        if (roomIds.count >= count)
+        {
+            break;
+        }
+        [roomIds addObject:roomId];
     }
     
-    [self.delegate dataSource:self didCellChange:nil];
+    return roomIds;
 }
 
 - (id<MXKRecentCellDataStoring>)cellDataAtIndex:(NSInteger)index
@@ -289,7 +368,7 @@ static NSTimeInterval const roomSummaryChangeThrottlerDelay = .5;
 - (void)loadData
 {
     [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXRoomSummaryDidChangeNotification object:nil];
-    [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXKRoomDataSourceSyncStatusChanged object:nil];
+    [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXKRoomDataSourceManagerServerSyncProcessingDidChangeNotification object:nil];
     [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXSessionNewRoomNotification object:nil];
     [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXSessionDidLeaveRoomNotification object:nil];
     [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXSessionDirectRoomsDidChangeNotification object:nil];
@@ -357,7 +436,8 @@ static NSTimeInterval const roomSummaryChangeThrottlerDelay = .5;
     // Listen to MXRoomSummary
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didRoomSummaryChanged:) name:kMXRoomSummaryDidChangeNotification object:nil];
 
-    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didMXSessionStateChange) name:kMXKRoomDataSourceSyncStatusChanged object:nil];
+    // Sort once when the room data sources have processed all the events of the server sync
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didMXSessionStateChange) name:kMXKRoomDataSourceManagerServerSyncProcessingDidChangeNotification object:roomDataSourceManager];
 }
 
 - (void)didDirectRoomsChange:(NSNotification *)notif
@@ -367,60 +447,112 @@ static NSTimeInterval const roomSummaryChangeThrottlerDelay = .5;
 }
 
 - (void)didRoomSummaryChanged:(NSNotification *)notif
-{    
+{
+    // Collect the changed summaries: the throttler only runs the last block
+    MXRoomSummary *roomSummary = notif.object;
+    if (roomSummary.mxSession == self.mxSession)
+    {
+        [changedRoomSummaries addObject:roomSummary];
+    }
+    else
+    {
+        hasUnhandledRoomSummaryChange = YES;
+    }
+    
+    MXWeakify(self);
     [roomSummaryChangeThrottler throttle:^{
-        [self didRoomSummaryChanged2:notif];
+        MXStrongifyAndReturnIfNil(self);
+        [self didRoomSummariesChange];
     }];
 }
 
-- (void)didRoomSummaryChanged2:(NSNotification *)notif
+- (void)didRoomSummariesChange
 {
-    MXRoomSummary *roomSummary = notif.object;
-    if (roomSummary.mxSession == self.mxSession && internalCellDataArray.count)
+    NSArray<MXRoomSummary*> *roomSummaries = changedRoomSummaries.allObjects;
+    [changedRoomSummaries removeAllObjects];
+    
+    BOOL reloadAll = hasUnhandledRoomSummaryChange;
+    hasUnhandledRoomSummaryChange = NO;
+    
+    if (!internalCellDataArray.count)
+    {
+        // Inform the delegate that all the room summaries have been updated.
+        [self.delegate dataSource:self didCellChange:nil];
+        return;
+    }
+    
+    NSMutableArray<MXKRecentCellDataChange*> *cellDataChanges = [NSMutableArray array];
+    BOOL needsSort = NO;
+    
+    for (MXRoomSummary *roomSummary in roomSummaries)
     {
         // Find the index of the related cell data
-        NSInteger index = NSNotFound;
-        for (index = 0; index < internalCellDataArray.count; index++)
+        NSUInteger index = [internalCellDataArray indexOfObjectPassingTest:^BOOL(id<MXKRecentCellDataStoring> theRoomData, NSUInteger idx, BOOL *stop) {
+            return theRoomData.roomSummary == roomSummary;
+        }];
+        
+        if (index == NSNotFound)
         {
-            id<MXKRecentCellDataStoring> theRoomData = [internalCellDataArray objectAtIndex:index];
-            if (theRoomData.roomSummary == roomSummary)
-            {
-                break;
-            }
+            MXLogDebug(@"[MXKSessionRecentsDataSource] didRoomSummariesChange: Cannot find the changed room summary for %@ (%@). It is probably not managed by this recents data source", roomSummary.roomId, roomSummary);
+            continue;
         }
         
-        if (index < internalCellDataArray.count)
+        if (roomSummary.hiddenFromUser)
         {
-            if (roomSummary.hiddenFromUser)
+            [internalCellDataArray removeObjectAtIndex:index];
+            needsSort = YES;
+            continue;
+        }
+        
+        id<MXKRecentCellDataStoring> cellData = internalCellDataArray[index];
+        if ([cellData respondsToSelector:@selector(updateWithRoomSummary:)] && [cellData conformsToProtocol:@protocol(NSCopying)])
+        {
+            // Update a copy to not modify the content of 'cellDataArray' (the copy is not a deep copy).
+            id<MXKRecentCellDataStoring> updatedCellData = [(id<NSCopying>)cellData copyWithZone:nil];
+            MXKRecentCellDataChanges changes = [updatedCellData updateWithRoomSummary:roomSummary];
+            if (changes != MXKRecentCellDataChangesNone)
             {
-                [internalCellDataArray removeObjectAtIndex:index];
+                [internalCellDataArray replaceObjectAtIndex:index withObject:updatedCellData];
+                [cellDataChanges addObject:[[MXKRecentCellDataChange alloc] initWithCellData:updatedCellData changes:changes]];
+                
+                // The order depends on the last message. The search result is made of the previous instances.
+                needsSort |= (changes & MXKRecentCellDataChangesLastMessage) || searchPatternsList;
             }
             else
             {
-                // Create a new instance to not modify the content of 'cellDataArray' (the copy is not a deep copy).
-                Class class = [self cellDataClassForCellIdentifier:kMXKRecentCellIdentifier];
-                id<MXKRecentCellDataStoring> cellData = [[class alloc] initWithRoomSummary:roomSummary dataSource:self];
-                if (cellData)
-                {
-                    [internalCellDataArray replaceObjectAtIndex:index withObject:cellData];
-                }
-            }
-            
-            // Report change except if sync is in progress
-            if (!roomDataSourceManager.isServerSyncInProgress)
-            {
-                [self sortCellDataAndNotifyChanges];
+                // The change concerns data which are not tracked (join rule, membership, encryption...)
+                reloadAll = YES;
             }
         }
         else
         {
-            MXLogDebug(@"[MXKSessionRecentsDataSource] didRoomLastMessageChanged: Cannot find the changed room summary for %@ (%@). It is probably not managed by this recents data source", roomSummary.roomId, roomSummary);
+            // Create a new instance to not modify the content of 'cellDataArray' (the copy is not a deep copy).
+            Class class = [self cellDataClassForCellIdentifier:kMXKRecentCellIdentifier];
+            cellData = [[class alloc] initWithRoomSummary:roomSummary dataSource:self];
+            if (cellData)
+            {
+                [internalCellDataArray replaceObjectAtIndex:index withObject:cellData];
+            }
+            needsSort = YES;
         }
     }
-    else
+    
+    // Report change except if sync is in progress, the cell data will be sorted at the end of the sync
+    if (roomDataSourceManager.isServerSyncInProgress)
     {
-        // Inform the delegate that all the room summaries have been updated.
-        [self.delegate dataSource:self didCellChange:nil];
+        return;
+    }
+    
+    if (needsSort || reloadAll)
+    {
+        [self sortCellDataAndNotifyChanges:(reloadAll ? nil : cellDataChanges)];
+    }
+    else if (cellDataChanges.count)
+    {
+        // Only the content of some cells has changed
+        cellDataArray = [internalCellDataArray copy];
+        searchFilterItemsAreOutdated = YES;
+        [self.delegate dataSource:self didCellChange:cellDataChanges];
     }
 }
 
@@ -482,6 +614,13 @@ static NSTimeInterval const roomSummaryChangeThrottlerDelay = .5;
 // Order cells
 - (void)sortCellDataAndNotifyChanges
 {
+    [self sortCellDataAndNotifyChanges:nil];
+}
+
+- (void)sortCellDataAndNotifyChanges:(NSArray<MXKRecentCellDataChange*>*)cellDataChanges
+{
+    NSArray *previousCellDataArray = cellDataArray;
+    
     // Order them by origin_server_ts
     [internalCellDataArray sortUsingComparator:^NSComparisonResult(id<MXKRecentCellDataStoring> cellData1, id<MXKRecentCellDataStoring> cellData2)
     {
@@ -490,11 +629,12 @@ static NSTimeInterval const roomSummaryChangeThrottlerDelay = .5;
     
     // Snapshot the cell data array
     cellDataArray = [internalCellDataArray copy];
+    searchFilterItemsAreOutdated = YES;
     
     // Update search result if any
     if (searchPatternsList)
     {
-        [self searchWithPatterns:searchPatternsList];
+        [self updateSearchResult];
     }
     
     // Update here data source state
@@ -507,8 +647,17 @@ static NSTimeInterval const roomSummaryChangeThrottlerDelay = .5;
         }
     }
     
-    // And inform the delegate about the update
-    [self.delegate dataSource:self didCellChange:nil];
+    // And inform the delegate about the update.
+    // Report only the cell data changes when the list is the same, in the same order.
+    BOOL isSameList = cellDataChanges.count && !searchPatternsList
+        && [[previousCellDataArray valueForKey:@"roomIdentifier"] isEqualToArray:[cellDataArray valueForKey:@"roomIdentifier"]];
+    [self.delegate dataSource:self didCellChange:(isSameList ? cellDataChanges : nil)];
+    
+    // Prepare the rooms that the user is likely to open
+    if (_prewarmedRoomsCount)
+    {
+        [roomDataSourceManager prewarmRoomDataSourcesWithRoomIds:[self roomIdsToPrewarm:_prewarmedRoomsCount]];
+    }
 }
 
 // Find the cell data that stores information about the given room id
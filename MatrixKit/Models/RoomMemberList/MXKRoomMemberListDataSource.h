@@ -74,6 +74,13 @@ extern NSString *const kMXKRoomMemberCellIdentifier;
  When patterns are not empty, the search result is stored in `filteredCellDataArray`,
  this array provides then data for the cells served by `MXKRoomMembersDataSource`.
  
+ The filtering runs in background (see `MXKSearchFilter`): the result is published on the main thread and the delegate
+ is then notified. A new search cancels the pending one.
+ 
+ Note for subclasses: this method used to filter synchronously. `filteredCellDataArray` is not updated yet when it returns:
+ read it from `[MXKDataSourceDelegate dataSource:didCellChange:]`. The data source refreshes an active search synchronously
+ when its cells are reloaded, and notifies the delegate only once.
+ 
  @param patternsList the list of patterns (`NSString` instances) to match with. Set nil to cancel search.
  */
 - (void)searchWithPatterns:(NSArray*)patternsList;
@@ -19,6 +19,7 @@
 @import MatrixSDK.MXCallManager;
 
 #import "MXKRoomMemberCellData.h"
+#import "MXKSearchFilter.h"
 
 
 #pragma mark - Constant definitions
@@ -46,6 +47,21 @@ NSString *const kMXKRoomMemberCellIdentifier = @"kMXKRoomMemberCellIdentifier";
      The typing notification listener in the room.
      */
     id typingNotifListener;
+    
+    /**
+     The current search patterns list.
+     */
+    NSArray* searchPatternsList;
+    
+    /**
+     The engine filtering the members in background.
+     */
+    MXKSearchFilter *searchFilter;
+    
+    /**
+     Tell whether the members have changed since they have been provided to the search filter.
+     */
+    BOOL searchFilterItemsAreOutdated;
 }
 
 @end
@@ -76,6 +92,10 @@ NSString *const kMXKRoomMemberCellIdentifier = @"kMXKRoomMemberCellIdentifier";
     cellDataArray = nil;
     filteredCellDataArray = nil;
     
+    [searchFilter cancel];
+    searchFilter = nil;
+    searchPatternsList = nil;
+    
     if (membersListener)
     {
         [self.mxSession removeListener:membersListener];
@@ -151,36 +171,56 @@ NSString *const kMXKRoomMemberCellIdentifier = @"kMXKRoomMemberCellIdentifier";
     }
 }
 
+- (void)prepareSearchFilter
+{
+    if (!searchFilter)
+    {
+        searchFilter = [[MXKSearchFilter alloc] initWithSearchKeyBlock:^NSString *(id<MXKRoomMemberCellDataStoring> cellData) {
+            return cellData.memberDisplayName;
+        }];
+        searchFilterItemsAreOutdated = YES;
+    }
+    
+    if (searchFilterItemsAreOutdated)
+    {
+        searchFilter.items = cellDataArray;
+        searchFilterItemsAreOutdated = NO;
+    }
+}
+
+// Refresh the current search result synchronously, the caller notifies the delegate once
+- (void)updateSearchResult
+{
+    [self prepareSearchFilter];
+    filteredCellDataArray = [NSMutableArray arrayWithArray:[searchFilter filteredItemsWithPatterns:searchPatternsList]];
+}
+
 - (void)searchWithPatterns:(NSArray*)patternsList
 {
     if (patternsList.count)
     {
-        if (filteredCellDataArray)
-        {
-            [filteredCellDataArray removeAllObjects];
-        }
-        else
-        {
-            filteredCellDataArray = [NSMutableArray arrayWithCapacity:cellDataArray.count];
-        }
+        searchPatternsList = patternsList;
         
-        for (id<MXKRoomMemberCellDataStoring> cellData in cellDataArray)
-        {
-            for (NSString* pattern in patternsList)
+        [self prepareSearchFilter];
+        
+        // Filter in background, the result replaces the current one at once
+        MXWeakify(self);
+        [searchFilter filterWithPatterns:patternsList completion:^(NSArray *filteredItems) {
+            MXStrongifyAndReturnIfNil(self);
+            
+            self->filteredCellDataArray = [NSMutableArray arrayWithArray:filteredItems];
+            if (self.delegate)
             {
-                if ([[cellData memberDisplayName] rangeOfString:pattern options:NSCaseInsensitiveSearch].location != NSNotFound)
-                {
-                    [filteredCellDataArray addObject:cellData];
-                    break;
-                }
+                [self.delegate dataSource:self didCellChange:nil];
             }
-        }
-    }
-    else
-    {
-        filteredCellDataArray = nil;
+        }];
+        return;
     }
     
+    [searchFilter cancel];
+    filteredCellDataArray = nil;
+    searchPatternsList = nil;
+    
     if (self.delegate)
     {
         [self.delegate dataSource:self didCellChange:nil];
@@ -214,7 +254,7 @@ NSString *const kMXKRoomMemberCellIdentifier = @"kMXKRoomMemberCellIdentifier";
 {
     NSArray* membersList = [mxRoomState.members membersWithoutConferenceUser];
     
-    if (!_settings.showLeftMembersInRoomMemberList)
+    if (!_settings.snapshot.showLeftMembersInRoomMemberList)
     {
         NSMutableArray* filteredMembers = [[NSMutableArray alloc] init];
         
@@ -251,6 +291,9 @@ NSString *const kMXKRoomMemberCellIdentifier = @"kMXKRoomMemberCellIdentifier";
 
 - (void)sortMembers
 {
+    // Read the settings once for the whole sort
+    BOOL sortRoomMembersUsingLastSeenTime = _settings.snapshot.sortRoomMembersUsingLastSeenTime;
+    
     NSArray *sortedMembers = [cellDataArray sortedArrayUsingComparator:^NSComparisonResult(id<MXKRoomMemberCellDataStoring> member1, id<MXKRoomMemberCellDataStoring> member2)
     {
         
@@ -280,7 +323,7 @@ NSString *const kMXKRoomMemberCellIdentifier = @"kMXKRoomMemberCellIdentifier";
             return NSOrderedAscending;
         }
         
-        if (self->_settings.sortRoomMembersUsingLastSeenTime)
+        if (sortRoomMembersUsingLastSeenTime)
         {
             // Get the users that correspond to these members
             MXUser *user1 = [self.mxSession userWithUserId:member1.roomMember.userId];
@@ -347,6 +390,13 @@ NSString *const kMXKRoomMemberCellIdentifier = @"kMXKRoomMemberCellIdentifier";
     }];
     
     cellDataArray = [NSMutableArray arrayWithArray:sortedMembers];
+    searchFilterItemsAreOutdated = YES;
+    
+    // Update the search result if any
+    if (searchPatternsList)
+    {
+        [self updateSearchResult];
+    }
 }
 
 - (void)listenMembersEvents
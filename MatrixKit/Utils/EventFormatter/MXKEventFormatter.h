@@ -22,6 +22,23 @@
 #import "MXKAppSettings.h"
 
 @protocol MarkdownToHTMLRendererProtocol;
+@class MXKCollapsedSeriesSummary;
+
+/**
+ The default maximum number of strings kept by the state events string cache.
+ */
+#define MXKEVENTFORMATTER_STRING_CACHE_COUNT_LIMIT 2000
+
+/**
+ The default format of the date strings (see `dateStringFromDate:withTime:`).
+ */
+#define MXKEVENTFORMATTER_DEFAULT_DATE_FORMAT @"MMM dd"
+
+/**
+ The maximum number of Markdown conversions kept by the formatter.
+ */
+#define MXKEVENTFORMATTER_MARKDOWN_CACHE_COUNT_LIMIT 50
+
 /**
  Formatting result codes.
  */
@@ -63,11 +80,13 @@ typedef enum : NSUInteger {
     
     /**
      The date formatter used to build date string without time information.
+     By default it is a private copy of a formatter of `MXKDateFormatterPool`: it may be customized.
      */
     NSDateFormatter *dateFormatter;
     
     /**
      The time formatter used to build time string without date information.
+     By default it is a private copy of a formatter of `MXKDateFormatterPool`: it may be customized.
      */
     NSDateFormatter *timeFormatter;
     
@@ -113,6 +132,9 @@ typedef enum : NSUInteger {
  Initialise the date and time formatters.
  This formatter could require to be updated after updating the device settings.
  e.g the time format switches from 24H format to AM/PM.
+
+ The formatters are copied from the shared `MXKDateFormatterPool`. This method is called again when the pool
+ is invalidated, because the locale or the time zone has changed.
  */
 - (void)initDateTimeFormatters;
 
@@ -207,6 +229,21 @@ typedef enum : NSUInteger {
  */
 - (NSAttributedString*)attributedStringFromEvents:(NSArray<MXEvent*>*)events withRoomState:(MXRoomState*)roomState error:(MXKEventFormatterError*)error;
 
+/**
+ Generate a displayable attributed string representating the summary of a collapsable series of events.
+ 
+ This method is called by the room data source each time a series is extended. The summary aggregates the changes
+ of the series as they are added: override this method to build the string from these aggregates instead of going
+ through all the events of the series. The default implementation describes the series with the counts of its changes.
+ It calls `attributedStringFromEvents:withRoomState:error:` with the events of the series when a subclass overrides it.
+
+ @param summary the summary of the series.
+ @param roomState the room state right before the first event in the series.
+ @param error the error code. In case of formatting error, the formatter may return non nil string as a proposal.
+ @return the attributed string.
+ */
+- (NSAttributedString*)attributedStringFromCollapsedSeriesSummary:(MXKCollapsedSeriesSummary*)summary withRoomState:(MXRoomState*)roomState error:(MXKEventFormatterError*)error;
+
 /**
  Render a random string into an attributed string with the font and the text color
  that correspond to the passed event.
@@ -239,16 +276,87 @@ typedef enum : NSUInteger {
  */
 - (NSAttributedString*)renderString:(NSString*)string withPrefix:(NSString*)prefix forEvent:(MXEvent*)event;
 
+/**
+ Get the text color applied by the formatter according to the event state (sent state, highlight, formatting error).
+
+ This color is the only attribute of the rendered strings which depends on the sent state of the event.
+
+ @param event the event.
+ @return the text color.
+ */
+- (UIColor*)textColorForEvent:(MXEvent*)event;
+
+#pragma mark - State events string cache
+
+/**
+ Tell whether the strings built for the membership, room name, room topic and power levels events are reused.
+ 
+ Replaying the room history formats many identical transitions (users joining, changing their avatar...).
+ The strings are cached with placeholders for the names, by event type and transition (the membership change and the
+ relation between the sender, the target and the current user, or the content for the other events), room kind,
+ redaction and language. The names of each event are resolved against the room state and substituted on use.
+ Default is YES.
+ */
+@property (nonatomic) BOOL stringCacheEnabled;
+
+/**
+ The maximum number of strings kept by the cache.
+ Default is MXKEVENTFORMATTER_STRING_CACHE_COUNT_LIMIT.
+ */
+@property (nonatomic) NSUInteger stringCacheCountLimit;
+
+/**
+ The number of cacheable events formatted from the cache, and the number of cacheable events formatted from scratch.
+ */
+@property (nonatomic, readonly) NSUInteger stringCacheHitCount;
+@property (nonatomic, readonly) NSUInteger stringCacheMissCount;
+
+/**
+ The ratio of the cacheable events formatted from the cache (0 when no cacheable event has been formatted).
+ */
+@property (nonatomic, readonly) double stringCacheHitRate;
+
+/**
+ Release the cached strings and reset the cache metrics.
+ Call it when the localized strings are customized (see `[NSBundle mxk_customizeLocalizedStringTableName:]`).
+ */
+- (void)resetStringCache;
+
 #pragma mark - Conversion tools
 
 /**
  Convert a Markdown string to HTML.
  
+ The strings without Markdown syntax are returned as is, without running the Markdown parser (see `isMarkdownFreeString:`).
+ The recent conversions are reused (edits and retries convert the same text again).
+ This method may be called on any thread.
+ 
  @param markdownString the string to convert.
  @return an HTML formatted string.
  */
 - (NSString*)htmlStringFromMarkdownString:(NSString*)markdownString;
 
+/**
+ Convert a Markdown string to HTML on a background queue.
+ 
+ The completion blocks are called on the main thread, in the order of the requests.
+ 
+ @param markdownString the string to convert.
+ @param onComplete the block called with the HTML formatted string.
+ */
+- (void)htmlStringFromMarkdownString:(NSString*)markdownString onComplete:(void (^)(NSString *htmlString))onComplete;
+
+/**
+ Tell whether a string is rendered as itself by the Markdown parser.
+ 
+ This quick check is conservative: the string must not contain any character which is significant for Markdown
+ or escaped in HTML, nor line break, nor leading or trailing whitespace, nor a list or heading marker at its beginning.
+ 
+ @param string the string to check.
+ @return YES if the string has no Markdown syntax.
+ */
++ (BOOL)isMarkdownFreeString:(NSString*)string;
+
 #pragma mark - Timestamp formatting
 
 /**
@@ -308,6 +416,13 @@ typedef enum : NSUInteger {
 */
 @property (nonatomic) NSString *defaultCSS;
 
+/**
+ Tell whether the 'renderHTMLString' method renders the simple HTML strings (bold, italic, code, links, line breaks, paragraphs)
+ without DTCoreText (see `MXKSimpleHTMLRenderer`). The other HTML strings are still rendered by DTCoreText.
+ Default is YES.
+ */
+@property (nonatomic) BOOL simpleHTMLRenderingEnabled;
+
 /**
  Default color used to display text content of event.
  Default is [UIColor blackColor].
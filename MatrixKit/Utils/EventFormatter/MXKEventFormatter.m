@@ -23,14 +23,179 @@
 
 #import "MXEvent+MatrixKit.h"
 #import "NSBundle+MatrixKit.h"
+#import "NSBundle+MXKLanguage.h"
 #import "MXKSwiftHeader.h"
 #import "MXKTools.h"
+#import "MXKTextAnalysis.h"
 #import "MXRoom+Sync.h"
 
 #import "MXKRoomNameStringLocalizer.h"
+#import "MXKSimpleHTMLRenderer.h"
+#import "MXKCollapsedSeriesSummary.h"
+#import "MXKDateFormatterPool.h"
 
 static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
 
+/**
+ The placeholders of the names in the cached strings, in the order of the names passed to `MXKEventFormatterStringFromTemplate`:
+ the sender display name, the sender id, the state key, the display name in the content and the one in the previous content.
+ */
+static const unichar kMXKEventFormatterFirstNameToken = 0xE000;
+static const NSUInteger kMXKEventFormatterNameTokenCount = 5;
+
+static inline NSString *MXKEventFormatterNameToken(NSUInteger index)
+{
+    unichar token = kMXKEventFormatterFirstNameToken + index;
+    return [NSString stringWithCharacters:&token length:1];
+}
+
+static NSCharacterSet *MXKEventFormatterNameTokenSet(void)
+{
+    static NSCharacterSet *tokenSet;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        tokenSet = [NSCharacterSet characterSetWithRange:NSMakeRange(kMXKEventFormatterFirstNameToken, kMXKEventFormatterNameTokenCount)];
+    });
+    return tokenSet;
+}
+
+/**
+ Tell whether a string, or a string in a JSON dictionary or array, contains a name placeholder.
+ Such a text cannot be inserted in a string built with placeholders.
+ */
+static BOOL MXKEventFormatterContainsNameToken(id object)
+{
+    if ([object isKindOfClass:NSString.class])
+    {
+        return [object rangeOfCharacterFromSet:MXKEventFormatterNameTokenSet()].location != NSNotFound;
+    }
+    if ([object isKindOfClass:NSDictionary.class])
+    {
+        for (id key in object)
+        {
+            if (MXKEventFormatterContainsNameToken(key) || MXKEventFormatterContainsNameToken(object[key]))
+            {
+                return YES;
+            }
+        }
+    }
+    else if ([object isKindOfClass:NSArray.class])
+    {
+        for (id item in object)
+        {
+            if (MXKEventFormatterContainsNameToken(item))
+            {
+                return YES;
+            }
+        }
+    }
+    return NO;
+}
+
+/**
+ Replace the name placeholders of a cached string with the names of an event.
+ */
+static NSString *MXKEventFormatterStringFromTemplate(NSString *template, NSArray<NSString*> *names)
+{
+    NSCharacterSet *tokenSet = MXKEventFormatterNameTokenSet();
+    
+    NSMutableString *string = [NSMutableString stringWithCapacity:template.length];
+    NSUInteger location = 0;
+    while (location < template.length)
+    {
+        NSRange tokenRange = [template rangeOfCharacterFromSet:tokenSet options:0 range:NSMakeRange(location, template.length - location)];
+        if (tokenRange.location == NSNotFound)
+        {
+            [string appendString:[template substringFromIndex:location]];
+            break;
+        }
+        
+        // Names are inserted in a single pass, a name containing a placeholder is kept as is
+        [string appendString:[template substringWithRange:NSMakeRange(location, tokenRange.location - location)]];
+        [string appendString:names[[template characterAtIndex:tokenRange.location] - kMXKEventFormatterFirstNameToken]];
+        location = NSMaxRange(tokenRange);
+    }
+    return string;
+}
+
+/**
+ The key of a string built for a state event: all the data which determine this string apart from the names.
+ */
+@interface MXKEventFormatterStringCacheKey : NSObject <NSCopying>
+{
+    NSString *type, *redactedInfo, *language;
+    NSDictionary *transition;
+    BOOL isEventSenderMyUser, isRoomDirect;
+    NSUInteger version;
+    NSUInteger keyHash;
+}
+
+- (instancetype)initWithEventType:(NSString*)type transition:(NSDictionary*)transition isEventSenderMyUser:(BOOL)isEventSenderMyUser isRoomDirect:(BOOL)isRoomDirect redactedInfo:(NSString*)redactedInfo version:(NSUInteger)version;
+
+@end
+
+static inline BOOL MXKEventFormatterEqualObjects(id object1, id object2)
+{
+    return object1 == object2 || [object1 isEqual:object2];
+}
+
+@implementation MXKEventFormatterStringCacheKey
+
+- (instancetype)initWithEventType:(NSString*)theType transition:(NSDictionary*)theTransition isEventSenderMyUser:(BOOL)theIsEventSenderMyUser isRoomDirect:(BOOL)theIsRoomDirect redactedInfo:(NSString*)theRedactedInfo version:(NSUInteger)theVersion
+{
+    self = [super init];
+    if (self)
+    {
+        type = theType;
+        transition = theTransition;
+        isEventSenderMyUser = theIsEventSenderMyUser;
+        isRoomDirect = theIsRoomDirect;
+        redactedInfo = theRedactedInfo;
+        version = theVersion;
+        language = [NSBundle mxk_language];
+        
+        // The transition dictionary is compared on match only
+        keyHash = type.hash ^ (transition.count << 8) ^ ([transition[@"membership"] hash] * 31) ^ ([transition[@"prev_membership"] hash] * 17) ^ version;
+        keyHash ^= (isEventSenderMyUser ? 1 : 0) ^ (isRoomDirect ? 2 : 0);
+    }
+    return self;
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    // Immutable
+    return self;
+}
+
+- (NSUInteger)hash
+{
+    return keyHash;
+}
+
+- (BOOL)isEqual:(id)object
+{
+    if (object == self)
+    {
+        return YES;
+    }
+    if (![object isKindOfClass:MXKEventFormatterStringCacheKey.class])
+    {
+        return NO;
+    }
+    
+    MXKEventFormatterStringCacheKey *key = object;
+    return keyHash == key->keyHash
+    && version == key->version
+    && isEventSenderMyUser == key->isEventSenderMyUser
+    && isRoomDirect == key->isRoomDirect
+    && MXKEventFormatterEqualObjects(type, key->type)
+    && MXKEventFormatterEqualObjects(redactedInfo, key->redactedInfo)
+    && MXKEventFormatterEqualObjects(language, key->language)
+    && MXKEventFormatterEqualObjects(transition, key->transition);
+}
+
+@end
+
 @interface MXKEventFormatter ()
 {
     /**
@@ -39,9 +204,48 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
     DTCSSStylesheet *dtCSS;
 
     /**
-     Links detector in strings.
+     The allowed HTML tags as a set, used by the simple HTML renderer.
      */
-    NSDataDetector *linkDetector;
+    NSSet<NSString*> *allowedHTMLTagsSet;
+
+    /**
+     The text attributes applied by DTCoreText for a given style (font, color and enclosing HTML tags).
+     They are used by the simple HTML renderer.
+     */
+    NSMutableDictionary<NSString*, NSDictionary*> *htmlStyleAttributesCache;
+
+    /**
+     The strings built for the state events with placeholders for the names (see `stringCacheEnabled`).
+     */
+    NSCache<MXKEventFormatterStringCacheKey*, NSString*> *stringCache;
+
+    /**
+     The version of the cached strings, incremented on reset so that a string built before the reset is not stored
+     with the new ones. It is part of the cache key.
+     */
+    NSUInteger stringCacheVersion;
+
+    /**
+     The recent Markdown conversions by Markdown string.
+     */
+    NSCache<NSString*, NSString*> *markdownCache;
+    
+    /**
+     The serial queue used to convert Markdown in background.
+     */
+    dispatch_queue_t markdownQueue;
+
+    /**
+     The shared formatter copied by `initDateTimeFormatters` into `dateFormatter`. Its day strings are cached by the pool,
+     they are used while `dateFormatter` keeps the same settings.
+     */
+    NSDateFormatter *defaultDateFormatter;
+
+    /**
+     The shared formatter copied by `initDateTimeFormatters` into `timeFormatter`. It is used while `timeFormatter`
+     keeps the same settings.
+     */
+    NSDateFormatter *defaultTimeFormatter;
 }
 @end
 
@@ -55,6 +259,7 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
         mxSession = matrixSession;
 
         [self initDateTimeFormatters];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(dateFormatterPoolDidInvalidate:) name:kMXKDateFormatterPoolDidInvalidateNotification object:nil];
 
         // Use the same list as matrix-react-sdk ( https://github.com/matrix-org/matrix-react-sdk/blob/24223ae2b69debb33fa22fcda5aeba6fa93c93eb/src/HtmlUtils.js#L25 )
         _allowedHTMLTags = @[
@@ -66,6 +271,13 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
                              @"nl", @"li", @"b", @"i", @"u", @"strong", @"em", @"strike", @"code", @"hr", @"br", @"div",
                              @"table", @"thead", @"caption", @"tbody", @"tr", @"th", @"td", @"pre"
                              ];
+        allowedHTMLTagsSet = [NSSet setWithArray:_allowedHTMLTags];
+        htmlStyleAttributesCache = [NSMutableDictionary dictionary];
+        _simpleHTMLRenderingEnabled = YES;
+
+        _stringCacheEnabled = YES;
+        stringCache = [[NSCache alloc] init];
+        self.stringCacheCountLimit = MXKEVENTFORMATTER_STRING_CACHE_COUNT_LIMIT;
 
         self.defaultCSS = @" \
             pre,code { \
@@ -107,26 +319,48 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
         defaultRoomSummaryUpdater.ignoreRedactedEvent = !_settings.showRedactionsInRoomHistory;
         defaultRoomSummaryUpdater.roomNameStringLocalizer = [MXKRoomNameStringLocalizer new];
 
-        linkDetector = [NSDataDetector dataDetectorWithTypes:NSTextCheckingTypeLink error:nil];
         
         _markdownToHTMLRenderer = [MarkdownToHTMLRendererHardBreaks new];
+        markdownCache = [[NSCache alloc] init];
+        markdownCache.countLimit = MXKEVENTFORMATTER_MARKDOWN_CACHE_COUNT_LIMIT;
+        markdownQueue = dispatch_queue_create("MXKEventFormatter.markdown", DISPATCH_QUEUE_SERIAL);
     }
     return self;
 }
 
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
 - (void)initDateTimeFormatters
 {
-    // Prepare internal date formatter
-    dateFormatter = [[NSDateFormatter alloc] init];
-    [dateFormatter setLocale:[[NSLocale alloc] initWithLocaleIdentifier:[[[NSBundle mainBundle] preferredLocalizations] objectAtIndex:0]]];
-    [dateFormatter setFormatterBehavior:NSDateFormatterBehavior10_4];
-    // Set default date format
-    [dateFormatter setDateFormat:@"MMM dd"];
-    
-    // Create a time formatter to get time string by considered the current system time formatting.
-    timeFormatter = [[NSDateFormatter alloc] init];
-    [timeFormatter setDateStyle:NSDateFormatterNoStyle];
-    [timeFormatter setTimeStyle:NSDateFormatterShortStyle];
+    MXKDateFormatterPool *dateFormatterPool = [MXKDateFormatterPool sharedPool];
+    
+    // Copy the shared formatters: the subclasses may customize them
+    defaultDateFormatter = [dateFormatterPool dateFormatterWithDateFormat:MXKEVENTFORMATTER_DEFAULT_DATE_FORMAT locale:[MXKDateFormatterPool applicationLocale]];
+    dateFormatter = [defaultDateFormatter copy];
+    
+    // Get a time formatter to get time string by considered the current system time formatting.
+    defaultTimeFormatter = [dateFormatterPool dateFormatterWithDateStyle:NSDateFormatterNoStyle timeStyle:NSDateFormatterShortStyle locale:nil];
+    timeFormatter = [defaultTimeFormatter copy];
+}
+
+- (void)dateFormatterPoolDidInvalidate:(NSNotification*)notification
+{
+    // The locale or the time zone has changed
+    if ([NSThread isMainThread])
+    {
+        [self initDateTimeFormatters];
+    }
+    else
+    {
+        MXWeakify(self);
+        dispatch_async(dispatch_get_main_queue(), ^{
+            MXStrongifyAndReturnIfNil(self);
+            [self initDateTimeFormatters];
+        });
+    }
 }
 
 #pragma mark - Event formatter settings
@@ -318,6 +552,9 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
     
     *error = MXKEventFormatterErrorNone;
     
+    // Read the settings once for the whole event
+    MXKAppSettingsSnapshot *settingsSnapshot = _settings.snapshot;
+    
     // Filter the events according to their type.
     if (_eventTypesFilterForMessages && ([_eventTypesFilterForMessages indexOfObject:event.type] == NSNotFound))
     {
@@ -333,7 +570,7 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
     if (isRedacted)
     {
         // Check whether redacted information is required
-        if (_settings.showRedactionsInRoomHistory)
+        if (settingsSnapshot.showRedactionsInRoomHistory)
         {
             MXLogDebug(@"[MXKEventFormatter] Redacted event %@ (%@)", event.description, event.redactedBecause);
             
@@ -381,6 +618,61 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
     NSString *senderDisplayName;
     senderDisplayName = roomState ? [self senderDisplayNameForEvent:event withRoomState:roomState] : event.sender;
     
+    // The names displayed for the sender and the target of a membership event
+    NSString *senderIdText = event.sender;
+    NSString *stateKeyText = event.stateKey;
+    NSString *contentDisplaynameText, *prevContentDisplaynameText;
+    MXJSONModelSetString(contentDisplaynameText, event.content[@"displayname"]);
+    MXJSONModelSetString(prevContentDisplaynameText, event.prevContent[@"displayname"]);
+    
+    // Reuse the string built for the same transition, only the names differ.
+    // The events whose text contains a placeholder character are formatted without the cache.
+    MXKEventFormatterStringCacheKey *stringCacheKey;
+    NSArray<NSString*> *stringCacheNames;
+    if (_stringCacheEnabled && [self isStringCacheableEvent:event]
+        && !MXKEventFormatterContainsNameToken(event.content) && !MXKEventFormatterContainsNameToken(redactedInfo))
+    {
+        NSUInteger version;
+        @synchronized(stringCache)
+        {
+            version = stringCacheVersion;
+        }
+        stringCacheKey = [[MXKEventFormatterStringCacheKey alloc] initWithEventType:event.type
+                                                                         transition:[self stringCacheTransitionOfEvent:event]
+                                                                isEventSenderMyUser:isEventSenderMyUser
+                                                                       isRoomDirect:isRoomDirect
+                                                                       redactedInfo:redactedInfo
+                                                                            version:version];
+        stringCacheNames = @[senderDisplayName ?: @"", senderIdText ?: @"", stateKeyText ?: @"", contentDisplaynameText ?: @"", prevContentDisplaynameText ?: @""];
+        
+        NSString *template = [stringCache objectForKey:stringCacheKey];
+        
+        @synchronized(stringCache)
+        {
+            if (template)
+            {
+                _stringCacheHitCount++;
+            }
+            else
+            {
+                _stringCacheMissCount++;
+            }
+        }
+        
+        if (template)
+        {
+            // Build the attributed string with the right font and color for the event
+            return [self renderString:MXKEventFormatterStringFromTemplate(template, stringCacheNames) forEvent:event];
+        }
+        
+        // Build the string with the placeholders of the names
+        senderDisplayName = MXKEventFormatterNameToken(0);
+        senderIdText = MXKEventFormatterNameToken(1);
+        stateKeyText = MXKEventFormatterNameToken(2);
+        contentDisplaynameText = MXKEventFormatterNameToken(3);
+        prevContentDisplaynameText = MXKEventFormatterNameToken(4);
+    }
+    
     switch (event.eventType)
     {
         case MXEventTypeRoomName:
@@ -536,11 +828,11 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
                         {
                             if (isEventSenderMyUser)
                             {
-                                displayText = [MatrixKitL10n noticeDisplayNameSetByYou:displayname];
+                                displayText = [MatrixKitL10n noticeDisplayNameSetByYou:contentDisplaynameText];
                             }
                             else
                             {
-                                displayText = [MatrixKitL10n noticeDisplayNameSet:event.sender :displayname];
+                                displayText = [MatrixKitL10n noticeDisplayNameSet:senderIdText :contentDisplaynameText];
                             }
                         }
                         else if (!displayname)
@@ -551,18 +843,18 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
                             }
                             else
                             {
-                                displayText = [MatrixKitL10n noticeDisplayNameRemoved:event.sender];
+                                displayText = [MatrixKitL10n noticeDisplayNameRemoved:senderIdText];
                             }
                         }
                         else
                         {
                             if (isEventSenderMyUser)
                             {
-                                displayText = [MatrixKitL10n noticeDisplayNameChangedFromByYou:prevDisplayname :displayname];
+                                displayText = [MatrixKitL10n noticeDisplayNameChangedFromByYou:prevContentDisplaynameText :contentDisplaynameText];
                             }
                             else
                             {
-                                displayText = [MatrixKitL10n noticeDisplayNameChangedFrom:event.sender :prevDisplayname :displayname];
+                                displayText = [MatrixKitL10n noticeDisplayNameChangedFrom:senderIdText :prevContentDisplaynameText :contentDisplaynameText];
                             }
                         }
                     }
@@ -608,7 +900,7 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
                 MXJSONModelSetString(membership, event.content[@"membership"]);
                 
                 // Prepare targeted member display name
-                NSString *targetDisplayName = event.stateKey;
+                NSString *targetDisplayName = stateKeyText;
                 
                 // Retrieve content displayname
                 NSString *contentDisplayname;
@@ -650,7 +942,7 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
                             {
                                 displayText = [MatrixKitL10n noticeRoomInviteByYou:targetDisplayName];
                             }
-                            else if ([targetDisplayName isEqualToString:mxSession.myUserId])
+                            else if ([event.stateKey isEqualToString:mxSession.myUserId])
                             {
                                 displayText = [MatrixKitL10n noticeRoomInviteYou:senderDisplayName];
                             }
@@ -658,7 +950,7 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
                             {
                                 if (contentDisplayname.length)
                                 {
-                                    targetDisplayName = contentDisplayname;
+                                    targetDisplayName = contentDisplaynameText;
                                 }
                                 
                                 displayText = [MatrixKitL10n noticeRoomInvite:senderDisplayName :targetDisplayName];
@@ -683,7 +975,7 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
                         {
                             if (contentDisplayname.length)
                             {
-                                targetDisplayName = contentDisplayname;
+                                targetDisplayName = contentDisplaynameText;
                             }
                             
                             displayText = [MatrixKitL10n noticeRoomJoin:targetDisplayName];
@@ -701,7 +993,7 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
                     // The targeted member display name (if any) is available in prevContent
                     if (prevContentDisplayname.length)
                     {
-                        targetDisplayName = prevContentDisplayname;
+                        targetDisplayName = prevContentDisplaynameText;
                     }
                     
                     if ([event.sender isEqualToString:event.stateKey])
@@ -789,7 +1081,7 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
                     // The targeted member display name (if any) is available in prevContent
                     if (prevContentDisplayname.length)
                     {
-                        targetDisplayName = prevContentDisplayname;
+                        targetDisplayName = prevContentDisplaynameText;
                     }
                     
                     if (isEventSenderMyUser)
@@ -1305,7 +1597,7 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
                         if (![self isSupportedAttachment:event])
                         {
                             MXLogDebug(@"[MXKEventFormatter] Warning: Unsupported attachment %@", event.description);
-                            if (_isForSubtitle || !_settings.showUnsupportedEventsInRoomHistory)
+                            if (_isForSubtitle || !settingsSnapshot.showUnsupportedEventsInRoomHistory)
                             {
                                 body = [MatrixKitL10n noticeInvalidAttachment];
                             }
@@ -1322,7 +1614,7 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
                         if (![self isSupportedAttachment:event])
                         {
                             MXLogDebug(@"[MXKEventFormatter] Warning: Unsupported attachment %@", event.description);
-                            if (_isForSubtitle || !_settings.showUnsupportedEventsInRoomHistory)
+                            if (_isForSubtitle || !settingsSnapshot.showUnsupportedEventsInRoomHistory)
                             {
                                 body = [MatrixKitL10n noticeInvalidAttachment];
                             }
@@ -1339,7 +1631,7 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
                         if (![self isSupportedAttachment:event])
                         {
                             MXLogDebug(@"[MXKEventFormatter] Warning: Unsupported attachment %@", event.description);
-                            if (_isForSubtitle || !_settings.showUnsupportedEventsInRoomHistory)
+                            if (_isForSubtitle || !settingsSnapshot.showUnsupportedEventsInRoomHistory)
                             {
                                 body = [MatrixKitL10n noticeInvalidAttachment];
                             }
@@ -1602,6 +1894,15 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
             break;
     }
 
+    if (stringCacheKey && displayText)
+    {
+        if (MXKEventFormatterErrorNone == *error)
+        {
+            [stringCache setObject:displayText forKey:stringCacheKey];
+        }
+        displayText = MXKEventFormatterStringFromTemplate(displayText, stringCacheNames);
+    }
+    
     if (!attributedDisplayText && displayText)
     {
         // Build the attributed string with the right font and color for the event
@@ -1611,7 +1912,7 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
     if (!attributedDisplayText)
     {
         MXLogDebug(@"[MXKEventFormatter] Warning: Unsupported event %@)", event.description);
-        if (_settings.showUnsupportedEventsInRoomHistory)
+        if (settingsSnapshot.showUnsupportedEventsInRoomHistory)
         {
             if (MXKEventFormatterErrorNone == *error)
             {
@@ -1661,6 +1962,64 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
     return nil;
 }
 
+- (NSAttributedString*)attributedStringFromCollapsedSeriesSummary:(MXKCollapsedSeriesSummary*)summary withRoomState:(MXRoomState*)roomState error:(MXKEventFormatterError*)error
+{
+    // Keep the summary of the subclasses which build it from the events
+    if ([self.class instanceMethodForSelector:@selector(attributedStringFromEvents:withRoomState:error:)]
+        != [MXKEventFormatter instanceMethodForSelector:@selector(attributedStringFromEvents:withRoomState:error:)])
+    {
+        return [self attributedStringFromEvents:summary.events withRoomState:roomState error:error];
+    }
+    
+    if (error)
+    {
+        *error = MXKEventFormatterErrorNone;
+    }
+    
+    // Describe the series from its aggregates, without going through its events
+    NSMutableArray<NSString*> *changes = [NSMutableArray array];
+    if (summary.joinCount)
+    {
+        [changes addObject:(summary.joinCount == 1) ? [MatrixKitL10n noticeCollapsedSeriesJoin] : [MatrixKitL10n noticeCollapsedSeriesJoins:@(summary.joinCount).stringValue]];
+    }
+    if (summary.leaveCount)
+    {
+        [changes addObject:(summary.leaveCount == 1) ? [MatrixKitL10n noticeCollapsedSeriesLeave] : [MatrixKitL10n noticeCollapsedSeriesLeaves:@(summary.leaveCount).stringValue]];
+    }
+    if (summary.kickCount)
+    {
+        [changes addObject:(summary.kickCount == 1) ? [MatrixKitL10n noticeCollapsedSeriesKick] : [MatrixKitL10n noticeCollapsedSeriesKicks:@(summary.kickCount).stringValue]];
+    }
+    if (summary.banCount)
+    {
+        [changes addObject:(summary.banCount == 1) ? [MatrixKitL10n noticeCollapsedSeriesBan] : [MatrixKitL10n noticeCollapsedSeriesBans:@(summary.banCount).stringValue]];
+    }
+    if (summary.inviteCount)
+    {
+        [changes addObject:(summary.inviteCount == 1) ? [MatrixKitL10n noticeCollapsedSeriesInvite] : [MatrixKitL10n noticeCollapsedSeriesInvites:@(summary.inviteCount).stringValue]];
+    }
+    if (summary.displaynameChangeCount)
+    {
+        [changes addObject:(summary.displaynameChangeCount == 1) ? [MatrixKitL10n noticeCollapsedSeriesDisplayNameChange] : [MatrixKitL10n noticeCollapsedSeriesDisplayNameChanges:@(summary.displaynameChangeCount).stringValue]];
+    }
+    if (summary.avatarChangeCount)
+    {
+        [changes addObject:(summary.avatarChangeCount == 1) ? [MatrixKitL10n noticeCollapsedSeriesAvatarChange] : [MatrixKitL10n noticeCollapsedSeriesAvatarChanges:@(summary.avatarChangeCount).stringValue]];
+    }
+    if (summary.otherEventCount)
+    {
+        [changes addObject:(summary.otherEventCount == 1) ? [MatrixKitL10n noticeCollapsedSeriesOtherEvent] : [MatrixKitL10n noticeCollapsedSeriesOtherEvents:@(summary.otherEventCount).stringValue]];
+    }
+    
+    if (!changes.count)
+    {
+        return nil;
+    }
+    
+    NSString *summaryString = [changes componentsJoinedByString:[MatrixKitL10n noticeCollapsedSeriesSeparator]];
+    return [self renderString:summaryString forEvent:summary.events.firstObject];
+}
+
 - (NSAttributedString*)renderString:(NSString*)string forEvent:(MXEvent*)event
 {
     // Sanity check
@@ -1678,10 +2037,11 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
     [str addAttribute:NSFontAttributeName value:[self fontForEvent:event] range:wholeString];
 
     // If enabled, make links clickable
-    if (!([[_settings httpLinkScheme] isEqualToString: @"http"] &&
-          [[_settings httpsLinkScheme] isEqualToString: @"https"]))
+    MXKAppSettingsSnapshot *settingsSnapshot = _settings.snapshot;
+    if (!settingsSnapshot.hasDefaultLinkSchemes)
     {
-        NSArray *matches = [linkDetector matchesInString:[str string] options:0 range:wholeString];
+        // Use the shared analysis of the string to not scan it again
+        NSArray *matches = [MXKTextAnalysis analysisOfString:string].linkMatches;
         for (NSTextCheckingResult *match in matches)
         {
             NSRange matchRange = [match range];
@@ -1692,11 +2052,11 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
             {
                 if ([url.scheme isEqualToString: @"http"])
                 {
-                    url.scheme = [_settings httpLinkScheme];
+                    url.scheme = settingsSnapshot.httpLinkScheme;
                 }
                 else if ([url.scheme isEqualToString: @"https"])
                 {
-                    url.scheme = [_settings httpsLinkScheme];
+                    url.scheme = settingsSnapshot.httpsLinkScheme;
                 }
 
                 if (url.URL)
@@ -1742,14 +2102,29 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
                               DTWillFlushBlockCallBack: sanitizeCallback
                               };
 
-    // Do not use the default HTML renderer of NSAttributedString because this method
-    // runs on the UI thread which we want to avoid because renderHTMLString is called
-    // most of the time from a background thread.
-    // Use DTCoreText HTML renderer instead.
-    // Using DTCoreText, which renders static string, helps to avoid code injection attacks
-    // that could happen with the default HTML renderer of NSAttributedString which is a
-    // webview.
-    NSAttributedString *str = [[NSAttributedString alloc] initWithHTMLData:[html dataUsingEncoding:NSUTF8StringEncoding] options:options documentAttributes:NULL];
+    NSAttributedString *str;
+    
+    // Most of the formatted bodies contain only a few basic tags. Render them in a single pass,
+    // the styles are still resolved by DTCoreText (once per style)
+    if (_simpleHTMLRenderingEnabled)
+    {
+        str = [MXKSimpleHTMLRenderer attributedStringFromHTMLString:html allowedTags:allowedHTMLTagsSet styleProvider:^NSDictionary *(NSArray<NSString *> *tagStack) {
+            MXStrongifyAndReturnValueIfNil(self, nil);
+            return [self htmlStyleAttributesForTagStack:tagStack withOptions:options];
+        }];
+    }
+    
+    if (!str)
+    {
+        // Do not use the default HTML renderer of NSAttributedString because this method
+        // runs on the UI thread which we want to avoid because renderHTMLString is called
+        // most of the time from a background thread.
+        // Use DTCoreText HTML renderer instead.
+        // Using DTCoreText, which renders static string, helps to avoid code injection attacks
+        // that could happen with the default HTML renderer of NSAttributedString which is a
+        // webview.
+        str = [[NSAttributedString alloc] initWithHTMLData:[html dataUsingEncoding:NSUTF8StringEncoding] options:options documentAttributes:NULL];
+    }
         
     // Apply additional treatments
     str = [self postRenderAttributedString:str];
@@ -1763,6 +2138,68 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
     return str;
 }
 
+/**
+ Get the text attributes applied by DTCoreText on a text enclosed in some HTML tags.
+
+ @discussion
+ The attributes are computed by rendering a sample HTML string with DTCoreText. They are cached
+ by font, text color and tags.
+
+ @param tagStack the enclosing HTML tags, from the outermost one.
+ @param options the DTCoreText options used to render the event.
+ @return the text attributes (without link).
+ */
+- (NSDictionary<NSAttributedStringKey, id>*)htmlStyleAttributesForTagStack:(NSArray<NSString*>*)tagStack withOptions:(NSDictionary*)options
+{
+    NSString *cacheKey = [NSString stringWithFormat:@"%@|%@|%@|%@", options[DTDefaultFontName], options[DTDefaultFontSize], options[DTDefaultTextColor], [tagStack componentsJoinedByString:@">"]];
+    
+    NSDictionary *attributes;
+    @synchronized(htmlStyleAttributesCache)
+    {
+        attributes = htmlStyleAttributesCache[cacheKey];
+    }
+    
+    if (!attributes)
+    {
+        // Render a sample text enclosed in the tags
+        NSMutableString *html = [NSMutableString string];
+        for (NSString *tag in tagStack)
+        {
+            if ([tag isEqualToString:@"a"])
+            {
+                [html appendString:@"<a href=\"https://matrix.org\">"];
+            }
+            else
+            {
+                [html appendFormat:@"<%@>", tag];
+            }
+        }
+        [html appendString:@"x"];
+        for (NSString *tag in tagStack.reverseObjectEnumerator)
+        {
+            [html appendFormat:@"</%@>", tag];
+        }
+        
+        NSAttributedString *sample = [[NSAttributedString alloc] initWithHTMLData:[html dataUsingEncoding:NSUTF8StringEncoding] options:options documentAttributes:NULL];
+        if (!sample.length)
+        {
+            return nil;
+        }
+        
+        // Remove the attributes specific to the sample link
+        NSMutableDictionary *sampleAttributes = [NSMutableDictionary dictionaryWithDictionary:[sample attributesAtIndex:0 effectiveRange:nil]];
+        [sampleAttributes removeObjectsForKeys:@[NSLinkAttributeName, DTLinkAttribute, DTGUIDAttribute, DTAnchorAttribute]];
+        attributes = sampleAttributes;
+        
+        @synchronized(htmlStyleAttributesCache)
+        {
+            htmlStyleAttributesCache[cacheKey] = attributes;
+        }
+    }
+    
+    return attributes;
+}
+
 /**
  Special treatment for "In reply to" message.
 
@@ -1921,6 +2358,18 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
     _defaultCSS = [NSString stringWithFormat:@"%@%@", [MXKTools cssToMarkBlockquotes], defaultCSS];
 
     dtCSS = [[DTCSSStylesheet alloc] initWithStyleBlock:_defaultCSS];
+    
+    // The styles may have changed
+    @synchronized(htmlStyleAttributesCache)
+    {
+        [htmlStyleAttributesCache removeAllObjects];
+    }
+}
+
+- (void)setAllowedHTMLTags:(NSArray<NSString *> *)allowedHTMLTags
+{
+    _allowedHTMLTags = allowedHTMLTags;
+    allowedHTMLTagsSet = [NSSet setWithArray:allowedHTMLTags];
 }
 
 #pragma mark - MXRoomSummaryUpdating
@@ -2025,12 +2474,6 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
 
 #pragma mark - Conversion private methods
 
-/**
- Get the text color to use according to the event state.
- 
- @param event the event.
- @return the text color.
- */
 - (UIColor*)textColorForEvent:(MXEvent*)event
 {
     // Select the text color
@@ -2119,11 +2562,12 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
         NSString *message;
         MXJSONModelSetString(message, event.content[@"body"]);
 
-        if (_emojiOnlyTextFont && [MXKTools isEmojiOnlyString:message])
+        MXKTextAnalysis *analysis = message ? [MXKTextAnalysis analysisOfString:message] : nil;
+        if (_emojiOnlyTextFont && analysis.isEmojiOnly)
         {
             font = _emojiOnlyTextFont;
         }
-        else if (_singleEmojiTextFont && [MXKTools isSingleEmojiString:message])
+        else if (_singleEmojiTextFont && analysis.isSingleEmoji)
         {
             font = _singleEmojiTextFont;
         }
@@ -2131,11 +2575,218 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
     return font;
 }
 
+#pragma mark - State events string cache
+
+- (void)setStringCacheCountLimit:(NSUInteger)stringCacheCountLimit
+{
+    _stringCacheCountLimit = stringCacheCountLimit;
+    stringCache.countLimit = stringCacheCountLimit;
+}
+
+- (double)stringCacheHitRate
+{
+    @synchronized(stringCache)
+    {
+        NSUInteger lookupCount = _stringCacheHitCount + _stringCacheMissCount;
+        return lookupCount ? (double)_stringCacheHitCount / lookupCount : 0;
+    }
+}
+
+- (void)resetStringCache
+{
+    @synchronized(stringCache)
+    {
+        stringCacheVersion++;
+        _stringCacheHitCount = 0;
+        _stringCacheMissCount = 0;
+    }
+    
+    [stringCache removeAllObjects];
+}
+
+- (BOOL)isStringCacheableEvent:(MXEvent*)event
+{
+    switch (event.eventType)
+    {
+        case MXEventTypeRoomMember:
+        case MXEventTypeRoomName:
+        case MXEventTypeRoomTopic:
+        case MXEventTypeRoomPowerLevels:
+            return YES;
+        default:
+            return NO;
+    }
+}
+
+/**
+ The data of a cacheable event which determine its string apart from the names.
+ 
+ The content of the room name, room topic and power levels events does not contain names. For a membership event,
+ only the membership change, the kind of profile change and the relation between the sender, the target and the
+ current user matter: the user ids and the display names are placeholders in the cached string.
+ */
+- (NSDictionary*)stringCacheTransitionOfEvent:(MXEvent*)event
+{
+    if (event.eventType != MXEventTypeRoomMember)
+    {
+        return event.content ?: @{};
+    }
+    
+    NSString *membership, *prevMembership, *displayname, *prevDisplayname, *avatar, *prevAvatar;
+    MXJSONModelSetString(membership, event.content[@"membership"]);
+    MXJSONModelSetString(prevMembership, event.prevContent[@"membership"]);
+    MXJSONModelSetString(displayname, event.content[@"displayname"]);
+    MXJSONModelSetString(prevDisplayname, event.prevContent[@"displayname"]);
+    MXJSONModelSetString(avatar, event.content[@"avatar_url"]);
+    MXJSONModelSetString(prevAvatar, event.prevContent[@"avatar_url"]);
+    
+    NSMutableDictionary *transition = [NSMutableDictionary dictionary];
+    transition[@"membership"] = membership;
+    transition[@"prev_membership"] = prevMembership;
+    transition[@"reason"] = event.content[@"reason"];
+    if (event.content[@"third_party_invite"])
+    {
+        transition[@"third_party_invite"] = event.content[@"third_party_invite"][@"display_name"] ?: NSNull.null;
+    }
+    transition[@"is_profile_change"] = @(event.isUserProfileChange);
+    transition[@"is_target_my_user"] = @([event.stateKey isEqualToString:mxSession.myUserId]);
+    transition[@"is_sender_target"] = @([event.sender isEqualToString:event.stateKey]);
+    transition[@"is_conference_user"] = @([MXCallManager isConferenceUser:event.stateKey]);
+    transition[@"has_displayname"] = @(displayname.length != 0);
+    transition[@"has_prev_displayname"] = @(prevDisplayname.length != 0);
+    transition[@"is_displayname_changed"] = @((displayname.length || prevDisplayname.length) && ![displayname isEqualToString:prevDisplayname]);
+    transition[@"is_avatar_changed"] = @((avatar.length || prevAvatar.length) && ![avatar isEqualToString:prevAvatar]);
+    return transition;
+}
+
 #pragma mark - Conversion tools
 
+- (void)setMarkdownToHTMLRenderer:(id<MarkdownToHTMLRendererProtocol>)markdownToHTMLRenderer
+{
+    @synchronized (self)
+    {
+        _markdownToHTMLRenderer = markdownToHTMLRenderer;
+        
+        // The cached conversions come from the previous renderer. The conversions in progress
+        // with the previous renderer end up in the previous cache.
+        markdownCache = [[NSCache alloc] init];
+        markdownCache.countLimit = MXKEVENTFORMATTER_MARKDOWN_CACHE_COUNT_LIMIT;
+    }
+}
+
 - (NSString *)htmlStringFromMarkdownString:(NSString *)markdownString
 {
-    NSString *htmlString = [_markdownToHTMLRenderer renderToHTMLWithMarkdown:markdownString];
+    id<MarkdownToHTMLRendererProtocol> renderer;
+    NSCache<NSString*, NSString*> *cache;
+    @synchronized (self)
+    {
+        renderer = _markdownToHTMLRenderer;
+        cache = markdownCache;
+    }
+    
+    return [self htmlStringFromMarkdownString:markdownString withRenderer:renderer cache:cache];
+}
+
+- (void)htmlStringFromMarkdownString:(NSString *)markdownString onComplete:(void (^)(NSString *))onComplete
+{
+    // Take the renderer of the request, it may be replaced before the conversion
+    NSString *string = [markdownString copy];
+    id<MarkdownToHTMLRendererProtocol> renderer;
+    NSCache<NSString*, NSString*> *cache;
+    @synchronized (self)
+    {
+        renderer = _markdownToHTMLRenderer;
+        cache = markdownCache;
+    }
+    
+    // Use the serial queue even for the strings without Markdown, to complete the requests in order
+    dispatch_async(markdownQueue, ^{
+        
+        NSString *htmlString = [self htmlStringFromMarkdownString:string withRenderer:renderer cache:cache];
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            onComplete(htmlString);
+        });
+    });
+}
+
++ (BOOL)isMarkdownFreeString:(NSString *)string
+{
+    static NSCharacterSet *markdownCharacterSet;
+    static NSCharacterSet *whitespaceCharacterSet;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        // The Markdown syntax, the characters escaped in HTML and the line breaks
+        NSMutableCharacterSet *characterSet = [NSMutableCharacterSet characterSetWithCharactersInString:@"\\`*_[]!<>&\"~#"];
+        [characterSet formUnionWithCharacterSet:[NSCharacterSet newlineCharacterSet]];
+        markdownCharacterSet = characterSet;
+        
+        whitespaceCharacterSet = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+    });
+    
+    NSUInteger length = string.length;
+    if (!length)
+    {
+        return YES;
+    }
+    
+    // The leading and trailing whitespaces are trimmed, the indented lines are code blocks
+    if ([whitespaceCharacterSet characterIsMember:[string characterAtIndex:0]]
+        || [whitespaceCharacterSet characterIsMember:[string characterAtIndex:length - 1]])
+    {
+        return NO;
+    }
+    
+    if ([string rangeOfCharacterFromSet:markdownCharacterSet].location != NSNotFound)
+    {
+        return NO;
+    }
+    
+    // Check the block markers: bullet list, thematic break, setext heading or ordered list ("1." or "1)")
+    unichar firstCharacter = [string characterAtIndex:0];
+    if (firstCharacter == '-' || firstCharacter == '+' || firstCharacter == '=')
+    {
+        return NO;
+    }
+    
+    NSUInteger index = 0;
+    while (index < length && [string characterAtIndex:index] >= '0' && [string characterAtIndex:index] <= '9')
+    {
+        index++;
+    }
+    if (index && index < length && ([string characterAtIndex:index] == '.' || [string characterAtIndex:index] == ')'))
+    {
+        return NO;
+    }
+    
+    return YES;
+}
+
+- (NSString *)htmlStringFromMarkdownString:(NSString *)markdownString withRenderer:(id<MarkdownToHTMLRendererProtocol>)renderer cache:(NSCache<NSString*, NSString*> *)cache
+{
+    if ([MXKEventFormatter isMarkdownFreeString:markdownString])
+    {
+        // The parser would return the same string
+        return markdownString;
+    }
+    
+    NSString *htmlString = [cache objectForKey:markdownString];
+    if (!htmlString)
+    {
+        htmlString = [self renderHTMLStringFromMarkdownString:markdownString withRenderer:renderer];
+        if (htmlString)
+        {
+            // Do not key the cache with a string which may be mutated
+            [cache setObject:htmlString forKey:[markdownString copy]];
+        }
+    }
+    
+    return htmlString;
+}
+
+- (NSString *)renderHTMLStringFromMarkdownString:(NSString *)markdownString withRenderer:(id<MarkdownToHTMLRendererProtocol>)renderer
+{
+    NSString *htmlString = [renderer renderToHTMLWithMarkdown:markdownString];
 
     // Strip off the trailing newline, if it exists.
     if ([htmlString hasSuffix:@"\n"])
@@ -2166,7 +2817,12 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
 {
     // Get first date string without time (if a date format is defined, else only time string is returned)
     NSString *dateString = nil;
-    if (dateFormatter.dateFormat)
+    if ([self formatter:dateFormatter hasSettingsOf:defaultDateFormatter])
+    {
+        // The string only depends on the day, reuse it
+        dateString = [[MXKDateFormatterPool sharedPool] dayStringFromDate:date withDayFormatter:defaultDateFormatter];
+    }
+    else if (dateFormatter.dateFormat)
     {
         dateString = [dateFormatter stringFromDate:date];
     }
@@ -2188,6 +2844,18 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
     return dateString;
 }
 
+// Tell whether a formatter still formats like the shared formatter it has been copied from
+- (BOOL)formatter:(NSDateFormatter*)formatter hasSettingsOf:(NSDateFormatter*)sharedFormatter
+{
+    return sharedFormatter
+        && [formatter.dateFormat isEqualToString:sharedFormatter.dateFormat]
+        && [formatter.locale isEqual:sharedFormatter.locale]
+        && [formatter.timeZone isEqual:sharedFormatter.timeZone]
+        && [formatter.calendar isEqual:sharedFormatter.calendar]
+        && [formatter.AMSymbol isEqualToString:sharedFormatter.AMSymbol]
+        && [formatter.PMSymbol isEqualToString:sharedFormatter.PMSymbol];
+}
+
 - (NSString*)dateStringFromTimestamp:(uint64_t)timestamp withTime:(BOOL)time
 {
     NSDate *date = [NSDate dateWithTimeIntervalSince1970:timestamp / 1000];
@@ -2207,7 +2875,9 @@ static NSString *const kHTMLATagRegexPattern = @"<a href=\"(.*?)\">([^<]*)</a>";
 
 - (NSString*)timeStringFromDate:(NSDate *)date
 {
-    NSString *timeString = [timeFormatter stringFromDate:date];
+    // Use the shared formatter until the subclass customizes its copy
+    NSDateFormatter *formatter = [self formatter:timeFormatter hasSettingsOf:defaultTimeFormatter] ? defaultTimeFormatter : timeFormatter;
+    NSString *timeString = [formatter stringFromDate:date];
     
     return timeString.lowercaseString;
 }
@@ -0,0 +1,60 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Block returning the text attributes to apply to a text contained in the provided HTML tags.
+
+ @param tagStack the names of the enclosing tags (lowercase), from the outermost one. Empty for a top level text.
+ @return the text attributes without link. nil if the tags cannot be rendered.
+ */
+typedef NSDictionary<NSAttributedStringKey, id> * _Nullable (^MXKSimpleHTMLRendererStyleProvider)(NSArray<NSString*> *tagStack);
+
+/**
+ `MXKSimpleHTMLRenderer` renders in a single pass the small subset of HTML that is used by
+ most Matrix formatted bodies: `b`, `strong`, `i`, `em`, `u`, `del`, `strike`, `code`, `a`, `br`, `p` and `mx-reply`.
+
+ The tags styling is not computed here: it is provided by the caller for each stack of tags (see `MXKSimpleHTMLRendererStyleProvider`).
+ The output follows the DTCoreText conventions for white spaces, paragraphs (new line) and line breaks (U+2028),
+ so that it can be post-processed like a DTCoreText output.
+
+ The renderer gives up (and returns nil) as soon as the HTML contains something else: the caller must then use a full HTML renderer.
+ */
+@interface MXKSimpleHTMLRenderer : NSObject
+
+/**
+ The HTML tags supported by this renderer.
+ */
+@property (class, nonatomic, readonly) NSSet<NSString*> *supportedTags;
+
+/**
+ Render an HTML string.
+
+ @param htmlString the HTML string to render.
+ @param allowedTags the tags allowed in the output. An HTML string containing a tag which is not allowed is not rendered.
+ @param styleProvider the block providing the text attributes.
+ @return the attributed string, or nil if the HTML string contains constructs that are not supported.
+ */
++ (nullable NSAttributedString*)attributedStringFromHTMLString:(NSString*)htmlString
+                                                   allowedTags:(NSSet<NSString*>*)allowedTags
+                                                 styleProvider:(MXKSimpleHTMLRendererStyleProvider)styleProvider;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,590 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXKSimpleHTMLRenderer.h"
+
+#import <UIKit/UIKit.h>
+
+// The line separator used by DTCoreText for <br>
+static NSString *const kMXKSimpleHTMLRendererLineBreak = @"\u2028";
+
+// The max depth of nested tags
+#define MXKSIMPLEHTMLRENDERER_MAX_TAG_DEPTH 16
+
+@interface MXKSimpleHTMLRenderer ()
+{
+    /**
+     The characters of the HTML string.
+     */
+    unichar *characters;
+    NSUInteger length;
+    NSUInteger index;
+
+    NSSet<NSString*> *allowedTags;
+    MXKSimpleHTMLRendererStyleProvider styleProvider;
+
+    /**
+     The names of the open tags, and the link of each of them (NSNull when none).
+     */
+    NSMutableArray<NSString*> *tagStack;
+    NSMutableArray *linkStack;
+
+    /**
+     The text attributes by tag stack.
+     */
+    NSMutableDictionary<NSString*, NSDictionary*> *attributesByTagStack;
+
+    NSMutableAttributedString *output;
+
+    /**
+     The length of the output when the current paragraph has been opened.
+     */
+    NSUInteger paragraphStart;
+}
+
+@end
+
+@implementation MXKSimpleHTMLRenderer
+
++ (NSSet<NSString *> *)supportedTags
+{
+    static NSSet<NSString*> *supportedTags;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        supportedTags = [NSSet setWithArray:@[@"b", @"strong", @"i", @"em", @"u", @"del", @"strike", @"code", @"a", @"br", @"p", @"mx-reply"]];
+    });
+    return supportedTags;
+}
+
++ (NSAttributedString *)attributedStringFromHTMLString:(NSString *)htmlString allowedTags:(NSSet<NSString *> *)allowedTags styleProvider:(MXKSimpleHTMLRendererStyleProvider)styleProvider
+{
+    MXKSimpleHTMLRenderer *renderer = [[MXKSimpleHTMLRenderer alloc] initWithAllowedTags:allowedTags styleProvider:styleProvider];
+    return [renderer render:htmlString];
+}
+
+- (instancetype)initWithAllowedTags:(NSSet<NSString *> *)theAllowedTags styleProvider:(MXKSimpleHTMLRendererStyleProvider)theStyleProvider
+{
+    self = [super init];
+    if (self)
+    {
+        allowedTags = theAllowedTags;
+        styleProvider = theStyleProvider;
+        tagStack = [NSMutableArray array];
+        linkStack = [NSMutableArray array];
+        attributesByTagStack = [NSMutableDictionary dictionary];
+        output = [[NSMutableAttributedString alloc] init];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (characters)
+    {
+        free(characters);
+    }
+}
+
+#pragma mark - Parsing
+
+- (NSAttributedString*)render:(NSString*)htmlString
+{
+    length = htmlString.length;
+    if (!length)
+    {
+        return nil;
+    }
+
+    characters = malloc(length * sizeof(unichar));
+    [htmlString getCharacters:characters range:NSMakeRange(0, length)];
+
+    index = 0;
+    while (index < length)
+    {
+        BOOL success;
+        if (characters[index] == '<')
+        {
+            success = [self parseTag];
+        }
+        else
+        {
+            success = [self parseText];
+        }
+
+        if (!success)
+        {
+            return nil;
+        }
+    }
+
+    // Unclosed tags are not supported
+    if (tagStack.count)
+    {
+        return nil;
+    }
+
+    return output;
+}
+
+- (BOOL)parseText
+{
+    NSMutableString *text = [NSMutableString string];
+
+    NSUInteger chunkStart = index;
+    while (index < length && characters[index] != '<')
+    {
+        if (characters[index] == '&')
+        {
+            CFStringAppendCharacters((__bridge CFMutableStringRef)text, characters + chunkStart, index - chunkStart);
+
+            NSString *decoded = [self parseEntity];
+            if (!decoded)
+            {
+                return NO;
+            }
+            [text appendString:decoded];
+            chunkStart = index;
+        }
+        else
+        {
+            index++;
+        }
+    }
+    CFStringAppendCharacters((__bridge CFMutableStringRef)text, characters + chunkStart, index - chunkStart);
+
+    return [self appendText:text];
+}
+
+/**
+ Parse an HTML tag starting at the current index.
+
+ @return NO if the tag is not supported.
+ */
+- (BOOL)parseTag
+{
+    // Skip '<'
+    index++;
+    if (index >= length)
+    {
+        return NO;
+    }
+
+    BOOL isClosingTag = NO;
+    if (characters[index] == '/')
+    {
+        isClosingTag = YES;
+        index++;
+    }
+
+    NSString *tagName = [self parseName];
+    if (!tagName.length || ![MXKSimpleHTMLRenderer.supportedTags containsObject:tagName] || ![allowedTags containsObject:tagName])
+    {
+        // Comments, doctypes, unsupported tags or a plain '<' character
+        return NO;
+    }
+
+    NSString *href;
+    BOOL isSelfClosing = NO;
+
+    // Parse attributes
+    while (YES)
+    {
+        [self skipWhitespaces];
+        if (index >= length)
+        {
+            return NO;
+        }
+
+        unichar c = characters[index];
+        if (c == '>')
+        {
+            index++;
+            break;
+        }
+        else if (c == '/' && index + 1 < length && characters[index + 1] == '>')
+        {
+            isSelfClosing = YES;
+            index += 2;
+            break;
+        }
+
+        NSString *attributeName = [self parseName];
+        if (!attributeName.length || isClosingTag)
+        {
+            return NO;
+        }
+
+        NSString *value = @"";
+        [self skipWhitespaces];
+        if (index < length && characters[index] == '=')
+        {
+            index++;
+            [self skipWhitespaces];
+            value = [self parseAttributeValue];
+            if (!value)
+            {
+                return NO;
+            }
+        }
+
+        // Only the link of <a> tags is supported. Other attributes may change the rendering.
+        if ([tagName isEqualToString:@"a"] && [attributeName isEqualToString:@"href"])
+        {
+            href = value;
+        }
+        else
+        {
+            return NO;
+        }
+    }
+
+    if ([tagName isEqualToString:@"br"])
+    {
+        if (isClosingTag)
+        {
+            return NO;
+        }
+        return [self appendLineBreak];
+    }
+    else if (isSelfClosing)
+    {
+        return NO;
+    }
+    else if (isClosingTag)
+    {
+        return [self closeTag:tagName];
+    }
+    else
+    {
+        return [self openTag:tagName href:href];
+    }
+}
+
+- (NSString*)parseName
+{
+    NSUInteger start = index;
+    while (index < length)
+    {
+        unichar c = characters[index];
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-')
+        {
+            index++;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (index == start)
+    {
+        return nil;
+    }
+
+    return [[NSString stringWithCharacters:characters + start length:index - start] lowercaseString];
+}
+
+- (NSString*)parseAttributeValue
+{
+    if (index >= length)
+    {
+        return nil;
+    }
+
+    unichar quote = characters[index];
+    if (quote != '"' && quote != '\'')
+    {
+        // Unquoted values are not supported
+        return nil;
+    }
+    index++;
+
+    NSMutableString *value = [NSMutableString string];
+    NSUInteger chunkStart = index;
+    while (index < length && characters[index] != quote)
+    {
+        if (characters[index] == '&')
+        {
+            CFStringAppendCharacters((__bridge CFMutableStringRef)value, characters + chunkStart, index - chunkStart);
+
+            NSString *decoded = [self parseEntity];
+            if (!decoded)
+            {
+                return nil;
+            }
+            [value appendString:decoded];
+            chunkStart = index;
+        }
+        else
+        {
+            index++;
+        }
+    }
+    CFStringAppendCharacters((__bridge CFMutableStringRef)value, characters + chunkStart, MIN(index, length) - chunkStart);
+
+    if (index >= length)
+    {
+        return nil;
+    }
+
+    // Skip the closing quote
+    index++;
+
+    return value;
+}
+
+/**
+ Decode the HTML entity starting at the current index.
+
+ @return the decoded string. nil if the entity is not supported.
+ */
+- (NSString*)parseEntity
+{
+    NSUInteger start = index + 1;
+    NSUInteger end = start;
+    while (end < length && end - start < 10 && characters[end] != ';')
+    {
+        end++;
+    }
+
+    if (end >= length || characters[end] != ';' || end == start)
+    {
+        return nil;
+    }
+
+    NSString *entity = [NSString stringWithCharacters:characters + start length:end - start];
+    index = end + 1;
+
+    static NSDictionary<NSString*, NSString*> *namedEntities;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        namedEntities = @{
+                          @"amp": @"&",
+                          @"lt": @"<",
+                          @"gt": @">",
+                          @"quot": @"\"",
+                          @"apos": @"'",
+                          @"nbsp": @"\u00A0"
+                          };
+    });
+
+    NSString *decoded = namedEntities[entity];
+    if (decoded)
+    {
+        return decoded;
+    }
+
+    if ([entity hasPrefix:@"#"])
+    {
+        unsigned int codePoint = 0;
+        NSScanner *scanner;
+        BOOL scanned;
+
+        if ([entity hasPrefix:@"#x"] || [entity hasPrefix:@"#X"])
+        {
+            scanner = [NSScanner scannerWithString:[entity substringFromIndex:2]];
+            scanned = [scanner scanHexInt:&codePoint];
+        }
+        else
+        {
+            int decimal = 0;
+            scanner = [NSScanner scannerWithString:[entity substringFromIndex:1]];
+            scanned = [scanner scanInt:&decimal] && decimal >= 0;
+            codePoint = decimal;
+        }
+
+        if (scanned && scanner.isAtEnd && codePoint > 0 && codePoint <= 0x10FFFF && (codePoint < 0xD800 || codePoint > 0xDFFF))
+        {
+            UTF32Char utf32 = NSSwapHostIntToLittle(codePoint);
+            return [[NSString alloc] initWithBytes:&utf32 length:sizeof(utf32) encoding:NSUTF32LittleEndianStringEncoding];
+        }
+    }
+
+    return nil;
+}
+
+- (void)skipWhitespaces
+{
+    while (index < length && [self isWhitespace:characters[index]])
+    {
+        index++;
+    }
+}
+
+- (BOOL)isWhitespace:(unichar)c
+{
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f');
+}
+
+#pragma mark - Output
+
+- (BOOL)openTag:(NSString*)tagName href:(NSString*)href
+{
+    if (tagStack.count >= MXKSIMPLEHTMLRENDERER_MAX_TAG_DEPTH)
+    {
+        return NO;
+    }
+
+    if ([tagName isEqualToString:@"p"])
+    {
+        // Paragraphs are supported only at the top level
+        if (tagStack.count)
+        {
+            return NO;
+        }
+
+        // Start a new paragraph
+        if (output.length && ![self outputEndsWithString:@"\n"])
+        {
+            [self appendString:@"\n" withTagStack:tagStack];
+        }
+        paragraphStart = output.length;
+    }
+
+    id link = NSNull.null;
+    if (href)
+    {
+        link = [NSURL URLWithString:href];
+        if (!link)
+        {
+            return NO;
+        }
+    }
+
+    [tagStack addObject:tagName];
+    [linkStack addObject:link];
+
+    return YES;
+}
+
+- (BOOL)closeTag:(NSString*)tagName
+{
+    if (![tagStack.lastObject isEqualToString:tagName])
+    {
+        // Misnested tags are not supported
+        return NO;
+    }
+
+    if ([tagName isEqualToString:@"p"])
+    {
+        // Empty paragraphs and trailing spaces are not supported
+        if (output.length == paragraphStart || [self outputEndsWithString:@" "])
+        {
+            return NO;
+        }
+
+        [self appendString:@"\n" withTagStack:tagStack];
+    }
+
+    [tagStack removeLastObject];
+    [linkStack removeLastObject];
+
+    return YES;
+}
+
+- (BOOL)appendLineBreak
+{
+    if ([self outputEndsWithString:@" "])
+    {
+        return NO;
+    }
+
+    return [self appendString:kMXKSimpleHTMLRendererLineBreak withTagStack:tagStack];
+}
+
+- (BOOL)appendText:(NSString*)text
+{
+    NSUInteger textLength = text.length;
+    unichar *normalizedCharacters = malloc(textLength * sizeof(unichar));
+    NSUInteger normalizedLength = 0;
+
+    // Does the output already end with a white space or a line start?
+    BOOL previousIsWhitespace = (!output.length || [self outputEndsWithString:@" "] || [self outputEndsWithString:@"\n"] || [self outputEndsWithString:kMXKSimpleHTMLRendererLineBreak]);
+
+    BOOL isInCode = [tagStack containsObject:@"code"];
+
+    for (NSUInteger i = 0; i < textLength; i++)
+    {
+        unichar c = [text characterAtIndex:i];
+        if ([self isWhitespace:c])
+        {
+            if (isInCode && (c != ' ' || previousIsWhitespace))
+            {
+                // White spaces may be preserved in code, let the full renderer handle them
+                free(normalizedCharacters);
+                return NO;
+            }
+
+            // Collapse white spaces
+            if (!previousIsWhitespace)
+            {
+                normalizedCharacters[normalizedLength++] = ' ';
+                previousIsWhitespace = YES;
+            }
+        }
+        else
+        {
+            normalizedCharacters[normalizedLength++] = c;
+            previousIsWhitespace = NO;
+        }
+    }
+
+    NSString *normalizedText = [[NSString alloc] initWithCharactersNoCopy:normalizedCharacters length:normalizedLength freeWhenDone:YES];
+    if (!normalizedText.length)
+    {
+        return YES;
+    }
+
+    return [self appendString:normalizedText withTagStack:tagStack];
+}
+
+- (BOOL)appendString:(NSString*)string withTagStack:(NSArray<NSString*>*)stack
+{
+    NSString *key = [stack componentsJoinedByString:@">"];
+    NSDictionary *attributes = attributesByTagStack[key];
+    if (!attributes)
+    {
+        attributes = styleProvider(stack);
+        if (!attributes)
+        {
+            return NO;
+        }
+        attributesByTagStack[key] = attributes;
+    }
+
+    // Apply the innermost link
+    for (id link in linkStack.reverseObjectEnumerator)
+    {
+        if (link != NSNull.null)
+        {
+            NSMutableDictionary *linkAttributes = [NSMutableDictionary dictionaryWithDictionary:attributes];
+            linkAttributes[NSLinkAttributeName] = link;
+            attributes = linkAttributes;
+            break;
+        }
+    }
+
+    [output appendAttributedString:[[NSAttributedString alloc] initWithString:string attributes:attributes]];
+
+    return YES;
+}
+
+- (BOOL)outputEndsWithString:(NSString*)string
+{
+    return [output.string hasSuffix:string];
+}
+
+@end
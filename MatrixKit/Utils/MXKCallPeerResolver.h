@@ -0,0 +1,86 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+
+#import <Foundation/Foundation.h>
+#import <MatrixSDK/MatrixSDK.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `MXKCallPeerResolver` finds the user on the other side of a call, and keeps it for the call.
+
+ - for an incoming call, the peer is the caller.
+ - for an outgoing 1:1 call, the peer is the direct chat user of the room when he has joined it. Otherwise the joined members
+ of the room are enumerated once to find the member who is not the caller.
+ - for a conference call, there is no peer: the room information is used instead.
+
+ The resolved peer is reused until a membership event of the room may change it (see `handleRoomEvent:`).
+ This class must be used on the main thread.
+ */
+@interface MXKCallPeerResolver : NSObject
+
+/**
+ Create a resolver.
+
+ @param call the call.
+ @return the newly created instance.
+ */
+- (instancetype)initWithCall:(MXCall*)call;
+
+/**
+ The call.
+ */
+@property (nonatomic, readonly) MXCall *call;
+
+/**
+ The resolved peer, nil if it has not been resolved yet or if the call has no peer.
+ It is the user of the session (see `[MXSession getOrCreateUser:]`) whatever the way it has been found.
+ */
+@property (nonatomic, readonly, nullable) MXUser *peer;
+
+/**
+ Tell whether the peer has been resolved.
+ */
+@property (nonatomic, readonly) BOOL isResolved;
+
+/**
+ Get the peer of the call.
+
+ The block is called synchronously when the peer is already resolved.
+
+ @param completion the block called with the peer (nil if the call has no peer).
+ */
+- (void)resolvePeer:(void (^)(MXUser * _Nullable peer))completion;
+
+/**
+ Take into account a live event of the call room.
+
+ Only the membership events of the peer, or the joins when no peer has been found, reset the resolved peer.
+
+ @param event the event.
+ @return YES if the peer must be resolved again.
+ */
+- (BOOL)handleRoomEvent:(MXEvent*)event;
+
+/**
+ Reset the resolved peer, for example when the room history has been flushed.
+ */
+- (void)reset;
+
+@end
+
+NS_ASSUME_NONNULL_END
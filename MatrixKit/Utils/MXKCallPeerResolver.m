@@ -0,0 +1,186 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+
+#import "MXKCallPeerResolver.h"
+
+@interface MXKCallPeerResolver ()
+{
+    /**
+     The blocks waiting for the pending resolution.
+     */
+    NSMutableArray<void (^)(MXUser *peer)> *pendingCompletions;
+
+    /**
+     Incremented on each reset, to ignore the resolution in progress.
+     */
+    NSUInteger generation;
+}
+
+@end
+
+@implementation MXKCallPeerResolver
+
+- (instancetype)initWithCall:(MXCall *)call
+{
+    self = [super init];
+    if (self)
+    {
+        _call = call;
+        pendingCompletions = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)resolvePeer:(void (^)(MXUser *))completion
+{
+    if (_isResolved)
+    {
+        completion(_peer);
+        return;
+    }
+
+    if (_call.isIncoming)
+    {
+        [self didResolvePeer:[_call.room.mxSession getOrCreateUser:_call.callerId]];
+        completion(_peer);
+        return;
+    }
+
+    if (_call.isConferenceCall || !_call.room)
+    {
+        // The room information will be used to display information about the call
+        [self didResolvePeer:nil];
+        completion(_peer);
+        return;
+    }
+
+    [pendingCompletions addObject:completion];
+    if (pendingCompletions.count > 1)
+    {
+        // A resolution is already in progress
+        return;
+    }
+
+    MXRoom *room = _call.room;
+    NSString *callerId = _call.callerId;
+    NSUInteger resolutionGeneration = generation;
+
+    MXWeakify(self);
+    [room state:^(MXRoomState *roomState) {
+        MXStrongifyAndReturnIfNil(self);
+
+        if (resolutionGeneration != self->generation)
+        {
+            // Reset in the meantime, the new resolution will complete the blocks
+            return;
+        }
+
+        NSString *peerId;
+
+        // Ask the room summary first: the peer of a direct chat is known without enumerating the members
+        NSString *directUserId = room.directUserId;
+        if (directUserId && ![directUserId isEqualToString:callerId]
+            && [roomState.members memberWithUserId:directUserId].membership == MXMembershipJoin)
+        {
+            peerId = directUserId;
+        }
+        else
+        {
+            // Find the other joined member
+            for (MXRoomMember *member in roomState.members.joinedMembers)
+            {
+                if (![member.userId isEqualToString:callerId])
+                {
+                    peerId = member.userId;
+                    break;
+                }
+            }
+        }
+
+        // The peer is always the user of the session, as for an incoming call
+        MXUser *peer = peerId ? [room.mxSession getOrCreateUser:peerId] : nil;
+        [self didResolvePeer:peer];
+
+        NSArray<void (^)(MXUser *peer)> *completions = self->pendingCompletions;
+        self->pendingCompletions = [NSMutableArray array];
+        for (void (^pendingCompletion)(MXUser *peer) in completions)
+        {
+            pendingCompletion(peer);
+        }
+    }];
+}
+
+- (BOOL)handleRoomEvent:(MXEvent *)event
+{
+    // Only the membership of the room may change the peer
+    if (!_isResolved || event.eventType != MXEventTypeRoomMember || _call.isIncoming || _call.isConferenceCall)
+    {
+        return NO;
+    }
+
+    NSString *userId = event.stateKey;
+    if (!userId || [userId isEqualToString:_call.callerId])
+    {
+        return NO;
+    }
+
+    NSString *membership;
+    MXJSONModelSetString(membership, event.content[@"membership"]);
+
+    BOOL peerChanged;
+    if (_peer)
+    {
+        // The peer left the room or updated its profile
+        peerChanged = [userId isEqualToString:_peer.userId];
+    }
+    else
+    {
+        // A peer may have joined
+        peerChanged = [membership isEqualToString:@"join"];
+    }
+
+    if (peerChanged)
+    {
+        [self reset];
+    }
+    return peerChanged;
+}
+
+- (void)reset
+{
+    generation++;
+    _isResolved = NO;
+    _peer = nil;
+
+    // Restart the pending resolution, if any
+    NSArray<void (^)(MXUser *peer)> *completions = pendingCompletions;
+    pendingCompletions = [NSMutableArray array];
+    for (void (^completion)(MXUser *peer) in completions)
+    {
+        [self resolvePeer:completion];
+    }
+}
+
+#pragma mark - Private methods
+
+- (void)didResolvePeer:(MXUser*)peer
+{
+    _peer = peer;
+    _isResolved = YES;
+}
+
+@end
@@ -0,0 +1,106 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Posted when the formatters of the pool have been released, because the current locale or the system time zone has changed.
+ The holders of formatter copies should get new ones. The notification object is the pool.
+ */
+extern NSString *const kMXKDateFormatterPoolDidInvalidateNotification;
+
+/**
+ `MXKDateFormatterPool` shares the date formatters of the process.
+
+ Creating a `NSDateFormatter` is expensive: the formatters are created once by locale, time zone and format,
+ and reused by all their users. The vended formatters may be used from any thread but they MUST NOT be modified:
+ use a copy to customize a formatter.
+
+ The pool also caches the strings which only depend on the day of a date (see `dayStringFromDate:withDayFormatter:`
+ and `relativeDayStringFromDate:`).
+
+ Everything is released when the current locale or the system time zone changes (see `kMXKDateFormatterPoolDidInvalidateNotification`).
+ The cached day strings are also released when the current day changes.
+ */
+@interface MXKDateFormatterPool : NSObject
+
+/**
+ The shared pool.
+ */
++ (instancetype)sharedPool;
+
+/**
+ The locale of the application: the one of its preferred localization.
+ */
++ (NSLocale*)applicationLocale;
+
+/**
+ Get a formatter with a fixed date format.
+
+ @param dateFormat the date format.
+ @param locale the locale of the formatter. nil for the current locale.
+ @return a shared formatter.
+ */
+- (NSDateFormatter*)dateFormatterWithDateFormat:(NSString*)dateFormat locale:(nullable NSLocale*)locale;
+
+/**
+ Get a formatter with a date format localized from a template (see `[NSDateFormatter dateFormatFromTemplate:options:locale:]`).
+
+ @param dateTemplate the template, for example @"EEEE" for the weekday.
+ @param locale the locale of the formatter. nil for the current locale.
+ @return a shared formatter.
+ */
+- (NSDateFormatter*)dateFormatterWithTemplate:(NSString*)dateTemplate locale:(nullable NSLocale*)locale;
+
+/**
+ Get a formatter with date and time styles.
+
+ @param dateStyle the date style.
+ @param timeStyle the time style.
+ @param locale the locale of the formatter. nil for the current locale.
+ @return a shared formatter.
+ */
+- (NSDateFormatter*)dateFormatterWithDateStyle:(NSDateFormatterStyle)dateStyle timeStyle:(NSDateFormatterStyle)timeStyle locale:(nullable NSLocale*)locale;
+
+/**
+ Format a date with a formatter which displays the day only, the string is cached for the day.
+
+ @param date the date.
+ @param dayFormatter a formatter without time field.
+ @return the formatted date.
+ */
+- (NSString*)dayStringFromDate:(NSDate*)date withDayFormatter:(NSDateFormatter*)dayFormatter;
+
+/**
+ Get the day of a date relatively to the current day, the string is cached for the day.
+
+ @param date the date.
+ @return "Today" or "Yesterday" (localized in the application locale), the weekday for the other days of the last week,
+ the medium style date else.
+ */
+- (NSString*)relativeDayStringFromDate:(NSDate*)date;
+
+/**
+ Release all the formatters and the cached strings, and post `kMXKDateFormatterPoolDidInvalidateNotification`.
+ */
+- (void)invalidate;
+
+@end
+
+NS_ASSUME_NONNULL_END
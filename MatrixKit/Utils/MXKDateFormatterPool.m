@@ -0,0 +1,250 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+
+#import "MXKDateFormatterPool.h"
+
+#import <UIKit/UIKit.h>
+
+NSString *const kMXKDateFormatterPoolDidInvalidateNotification = @"kMXKDateFormatterPoolDidInvalidateNotification";
+
+@interface MXKDateFormatterPool ()
+{
+    /**
+     The formatters by locale, time zone and format.
+     */
+    NSMutableDictionary<NSString*, NSDateFormatter*> *formatters;
+
+    /**
+     The day strings by day formatter, then by day.
+     */
+    NSMapTable<NSDateFormatter*, NSMutableDictionary<NSNumber*, NSString*>*> *dayStrings;
+
+    /**
+     The relative day strings by day, and the day they are relative to.
+     */
+    NSMutableDictionary<NSNumber*, NSString*> *relativeDayStrings;
+    NSInteger relativeDayStringsCurrentDay;
+}
+
+@end
+
+@implementation MXKDateFormatterPool
+
++ (instancetype)sharedPool
+{
+    static MXKDateFormatterPool *sharedPool = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedPool = [[MXKDateFormatterPool alloc] init];
+    });
+    return sharedPool;
+}
+
++ (NSLocale *)applicationLocale
+{
+    return [[NSLocale alloc] initWithLocaleIdentifier:[NSBundle mainBundle].preferredLocalizations.firstObject];
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        formatters = [NSMutableDictionary dictionary];
+        dayStrings = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality
+                                           valueOptions:NSPointerFunctionsStrongMemory];
+        relativeDayStrings = [NSMutableDictionary dictionary];
+
+        NSNotificationCenter *notificationCenter = [NSNotificationCenter defaultCenter];
+        [notificationCenter addObserver:self selector:@selector(invalidate) name:NSCurrentLocaleDidChangeNotification object:nil];
+        [notificationCenter addObserver:self selector:@selector(systemTimeZoneDidChange:) name:NSSystemTimeZoneDidChangeNotification object:nil];
+        [notificationCenter addObserver:self selector:@selector(releaseDayStrings) name:NSCalendarDayChangedNotification object:nil];
+        [notificationCenter addObserver:self selector:@selector(releaseDayStrings) name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+#pragma mark - Formatters
+
+- (NSDateFormatter *)dateFormatterWithDateFormat:(NSString *)dateFormat locale:(NSLocale *)locale
+{
+    return [self formatterWithKey:[NSString stringWithFormat:@"format:%@", dateFormat] locale:locale configuration:^(NSDateFormatter *formatter) {
+        formatter.dateFormat = dateFormat;
+    }];
+}
+
+- (NSDateFormatter *)dateFormatterWithTemplate:(NSString *)dateTemplate locale:(NSLocale *)locale
+{
+    return [self formatterWithKey:[NSString stringWithFormat:@"template:%@", dateTemplate] locale:locale configuration:^(NSDateFormatter *formatter) {
+        formatter.dateFormat = [NSDateFormatter dateFormatFromTemplate:dateTemplate options:0 locale:formatter.locale];
+    }];
+}
+
+- (NSDateFormatter *)dateFormatterWithDateStyle:(NSDateFormatterStyle)dateStyle timeStyle:(NSDateFormatterStyle)timeStyle locale:(NSLocale *)locale
+{
+    return [self formatterWithKey:[NSString stringWithFormat:@"style:%tu:%tu", dateStyle, timeStyle] locale:locale configuration:^(NSDateFormatter *formatter) {
+        formatter.dateStyle = dateStyle;
+        formatter.timeStyle = timeStyle;
+    }];
+}
+
+#pragma mark - Day strings
+
+- (NSString *)dayStringFromDate:(NSDate *)date withDayFormatter:(NSDateFormatter *)dayFormatter
+{
+    NSNumber *day = @([self dayOfDate:date inTimeZone:dayFormatter.timeZone]);
+
+    @synchronized(self)
+    {
+        NSMutableDictionary<NSNumber*, NSString*> *strings = [dayStrings objectForKey:dayFormatter];
+        NSString *dayString = strings[day];
+        if (dayString)
+        {
+            return dayString;
+        }
+
+        dayString = [dayFormatter stringFromDate:date];
+        if (dayString)
+        {
+            if (!strings)
+            {
+                strings = [NSMutableDictionary dictionary];
+                [dayStrings setObject:strings forKey:dayFormatter];
+            }
+            strings[day] = dayString;
+        }
+        return dayString;
+    }
+}
+
+- (NSString *)relativeDayStringFromDate:(NSDate *)date
+{
+    NSTimeZone *timeZone = [NSTimeZone localTimeZone];
+    NSInteger day = [self dayOfDate:date inTimeZone:timeZone];
+    NSInteger currentDay = [self dayOfDate:[NSDate date] inTimeZone:timeZone];
+
+    @synchronized(self)
+    {
+        if (currentDay != relativeDayStringsCurrentDay)
+        {
+            // The strings are relative to the previous day
+            [relativeDayStrings removeAllObjects];
+            relativeDayStringsCurrentDay = currentDay;
+        }
+
+        NSString *relativeDayString = relativeDayStrings[@(day)];
+        if (relativeDayString)
+        {
+            return relativeDayString;
+        }
+
+        NSLocale *locale = [MXKDateFormatterPool applicationLocale];
+        NSInteger elapsedDays = currentDay - day;
+        if (elapsedDays == 0 || elapsedDays == 1)
+        {
+            // "Today", "Yesterday"
+            NSDateFormatter *formatter = [self formatterWithKey:@"relative" locale:locale configuration:^(NSDateFormatter *formatter) {
+                formatter.dateStyle = NSDateFormatterMediumStyle;
+                formatter.timeStyle = NSDateFormatterNoStyle;
+                formatter.doesRelativeDateFormatting = YES;
+            }];
+            relativeDayString = [formatter stringFromDate:date];
+        }
+        else if (elapsedDays > 1 && elapsedDays < 7)
+        {
+            relativeDayString = [[self dateFormatterWithTemplate:@"EEEE" locale:locale] stringFromDate:date];
+        }
+        else
+        {
+            relativeDayString = [[self dateFormatterWithDateStyle:NSDateFormatterMediumStyle timeStyle:NSDateFormatterNoStyle locale:locale] stringFromDate:date];
+        }
+
+        if (relativeDayString)
+        {
+            relativeDayStrings[@(day)] = relativeDayString;
+        }
+        return relativeDayString;
+    }
+}
+
+#pragma mark - Invalidation
+
+- (void)invalidate
+{
+    @synchronized(self)
+    {
+        [formatters removeAllObjects];
+        [dayStrings removeAllObjects];
+        [relativeDayStrings removeAllObjects];
+    }
+    
+    [[NSNotificationCenter defaultCenter] postNotificationName:kMXKDateFormatterPoolDidInvalidateNotification object:self];
+}
+
+- (void)systemTimeZoneDidChange:(NSNotification*)notification
+{
+    [NSTimeZone resetSystemTimeZone];
+    [self invalidate];
+}
+
+- (void)releaseDayStrings
+{
+    // Keep the formatters, they are expensive to create
+    @synchronized(self)
+    {
+        [dayStrings removeAllObjects];
+        [relativeDayStrings removeAllObjects];
+    }
+}
+
+#pragma mark - Private methods
+
+- (NSDateFormatter*)formatterWithKey:(NSString*)formatKey locale:(NSLocale*)locale configuration:(void (^)(NSDateFormatter *formatter))configuration
+{
+    locale = locale ?: [NSLocale currentLocale];
+    NSTimeZone *timeZone = [NSTimeZone localTimeZone];
+    NSString *key = [NSString stringWithFormat:@"%@|%@|%@", locale.localeIdentifier, timeZone.name, formatKey];
+
+    @synchronized(self)
+    {
+        NSDateFormatter *formatter = formatters[key];
+        if (!formatter)
+        {
+            formatter = [[NSDateFormatter alloc] init];
+            formatter.locale = locale;
+            formatter.timeZone = timeZone;
+            configuration(formatter);
+
+            formatters[key] = formatter;
+        }
+        return formatter;
+    }
+}
+
+- (NSInteger)dayOfDate:(NSDate*)date inTimeZone:(NSTimeZone*)timeZone
+{
+    // The number of days since 1970 in this time zone
+    NSTimeInterval localTimeInterval = date.timeIntervalSince1970 + [timeZone secondsFromGMTForDate:date];
+    return (NSInteger)floor(localTimeInterval / 86400);
+}
+
+@end
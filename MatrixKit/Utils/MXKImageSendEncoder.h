@@ -0,0 +1,89 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <UIKit/UIKit.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The compression quality of the JPEG images sent by the app.
+ */
+#define MXKIMAGESENDENCODER_JPEG_COMPRESSION_QUALITY 0.9
+
+/**
+ The size in which the thumbnail of a sent image must fit (this thumbnail is uploaded in the encrypted rooms).
+ */
+#define MXKIMAGESENDENCODER_THUMBNAIL_MAX_SIZE CGSizeMake(800, 600)
+
+/**
+ `MXKImageSendEncoder` prepares the images to send in a room.
+
+ The work is done on a shared background queue, in the requests order, and the results are provided on the main thread.
+
+ The orientation of an image is written as EXIF metadata in the JPEG data instead of redrawing the full bitmap upright.
+ The full size bitmap is decoded only once, to encode the image: the thumbnail is created with ImageIO from the encoded data,
+ which is read at a reduced size.
+ */
+@interface MXKImageSendEncoder : NSObject
+
+/**
+ Encode an image in JPEG in background.
+
+ @param image the image to send.
+ @param withThumbnail YES to create a thumbnail (it is nil when the image fits in MXKIMAGESENDENCODER_THUMBNAIL_MAX_SIZE).
+ @param completion the block called on the main thread with the JPEG data (nil on failure), the displayed size of the image
+                   and the thumbnail.
+ */
++ (void)encodeImage:(UIImage*)image
+      withThumbnail:(BOOL)withThumbnail
+         completion:(void (^)(NSData * _Nullable imageData, CGSize imageSize, UIImage * _Nullable thumbnail))completion;
+
+/**
+ Read the size of an encoded image and create its thumbnail in background. The data is sent as is.
+
+ @param imageData the encoded image to send.
+ @param withThumbnail YES to create a thumbnail (it is nil when the image fits in MXKIMAGESENDENCODER_THUMBNAIL_MAX_SIZE).
+ @param completion the block called on the main thread with the displayed size of the image (CGSizeZero if the data
+                   cannot be read) and the thumbnail.
+ */
++ (void)prepareImageData:(NSData*)imageData
+           withThumbnail:(BOOL)withThumbnail
+              completion:(void (^)(CGSize imageSize, UIImage * _Nullable thumbnail))completion;
+
+#pragma mark - Synchronous encoding
+
+/**
+ Encode an image in JPEG, its orientation is written as EXIF metadata. This method may be called on any thread.
+
+ @param image the image.
+ @param compressionQuality the JPEG compression quality (0.0 to 1.0).
+ @return the JPEG data, nil on failure.
+ */
++ (nullable NSData*)jpegDataWithImage:(UIImage*)image compressionQuality:(CGFloat)compressionQuality;
+
+/**
+ Create the upright thumbnail of an encoded image, without decoding the full size image. This method may be called on any thread.
+
+ @param imageData the encoded image.
+ @param maxSize the size in which the thumbnail must fit.
+ @param imageSize if not NULL, set to the displayed size of the image (CGSizeZero if the data cannot be read).
+ @return the thumbnail, nil if the image already fits in `maxSize` or cannot be read.
+ */
++ (nullable UIImage*)thumbnailWithImageData:(NSData*)imageData maxSize:(CGSize)maxSize imageSize:(nullable CGSize*)imageSize;
+
+@end
+
+NS_ASSUME_NONNULL_END
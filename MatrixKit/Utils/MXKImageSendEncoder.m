@@ -0,0 +1,237 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXKImageSendEncoder.h"
+
+#import <ImageIO/ImageIO.h>
+#import <MobileCoreServices/MobileCoreServices.h>
+
+#import <MatrixSDK/MatrixSDK.h>
+
+@implementation MXKImageSendEncoder
+
++ (dispatch_queue_t)encodingQueue
+{
+    static dispatch_queue_t encodingQueue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        // The queue is serial to keep the order of the sent images
+        encodingQueue = dispatch_queue_create("MXKImageSendEncoder", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_USER_INITIATED, 0));
+    });
+    return encodingQueue;
+}
+
++ (void)encodeImage:(UIImage *)image withThumbnail:(BOOL)withThumbnail completion:(void (^)(NSData *, CGSize, UIImage *))completion
+{
+    dispatch_async([self encodingQueue], ^{
+        
+        NSData *imageData;
+        UIImage *thumbnail;
+        
+        @autoreleasepool
+        {
+            imageData = [self jpegDataWithImage:image compressionQuality:MXKIMAGESENDENCODER_JPEG_COMPRESSION_QUALITY];
+            if (imageData && withThumbnail)
+            {
+                thumbnail = [self thumbnailWithImageData:imageData maxSize:MXKIMAGESENDENCODER_THUMBNAIL_MAX_SIZE imageSize:NULL];
+            }
+        }
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(imageData, image.size, thumbnail);
+        });
+    });
+}
+
++ (void)prepareImageData:(NSData *)imageData withThumbnail:(BOOL)withThumbnail completion:(void (^)(CGSize, UIImage *))completion
+{
+    dispatch_async([self encodingQueue], ^{
+        
+        CGSize imageSize = CGSizeZero;
+        UIImage *thumbnail;
+        
+        @autoreleasepool
+        {
+            if (withThumbnail)
+            {
+                thumbnail = [self thumbnailWithImageData:imageData maxSize:MXKIMAGESENDENCODER_THUMBNAIL_MAX_SIZE imageSize:&imageSize];
+            }
+            else
+            {
+                imageSize = [self imageSizeWithImageData:imageData];
+            }
+        }
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(imageSize, thumbnail);
+        });
+    });
+}
+
+#pragma mark - Synchronous encoding
+
++ (NSData *)jpegDataWithImage:(UIImage *)image compressionQuality:(CGFloat)compressionQuality
+{
+    CGImageRef cgImage = image.CGImage;
+    if (!cgImage)
+    {
+        // The image is not backed by a bitmap (CIImage)
+        return UIImageJPEGRepresentation(image, compressionQuality);
+    }
+    
+    NSMutableData *data = [NSMutableData data];
+    CGImageDestinationRef destination = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)data, kUTTypeJPEG, 1, NULL);
+    if (!destination)
+    {
+        return nil;
+    }
+    
+    // Keep the pixels as they are, the viewers apply the EXIF orientation
+    NSDictionary *properties = @{
+                                 (NSString*)kCGImageDestinationLossyCompressionQuality: @(compressionQuality),
+                                 (NSString*)kCGImagePropertyOrientation: @([self exifOrientationWithImageOrientation:image.imageOrientation])
+                                 };
+    CGImageDestinationAddImage(destination, cgImage, (__bridge CFDictionaryRef)properties);
+    BOOL success = CGImageDestinationFinalize(destination);
+    CFRelease(destination);
+    
+    if (!success)
+    {
+        MXLogDebug(@"[MXKImageSendEncoder] jpegDataWithImage: Failed to encode the image");
+        return nil;
+    }
+    return data;
+}
+
++ (UIImage *)thumbnailWithImageData:(NSData *)imageData maxSize:(CGSize)maxSize imageSize:(CGSize *)imageSize
+{
+    if (imageSize)
+    {
+        *imageSize = CGSizeZero;
+    }
+    
+    NSDictionary *sourceOptions = @{(NSString*)kCGImageSourceShouldCache: @NO};
+    CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)imageData, (__bridge CFDictionaryRef)sourceOptions);
+    if (!source)
+    {
+        return nil;
+    }
+    
+    CGSize size = [self imageSizeWithImageSource:source];
+    if (imageSize)
+    {
+        *imageSize = size;
+    }
+    
+    UIImage *thumbnail;
+    CGSize thumbnailSize = [self size:size fittingInSize:maxSize];
+    if (size.width && size.height && !CGSizeEqualToSize(thumbnailSize, size))
+    {
+        // Let ImageIO read the image at a reduced size, and apply the EXIF orientation
+        NSDictionary *thumbnailOptions = @{
+                                           (NSString*)kCGImageSourceCreateThumbnailFromImageAlways: @YES,
+                                           (NSString*)kCGImageSourceCreateThumbnailWithTransform: @YES,
+                                           (NSString*)kCGImageSourceShouldCacheImmediately: @YES,
+                                           (NSString*)kCGImageSourceThumbnailMaxPixelSize: @(MAX(thumbnailSize.width, thumbnailSize.height))
+                                           };
+        CGImageRef cgImage = CGImageSourceCreateThumbnailAtIndex(source, 0, (__bridge CFDictionaryRef)thumbnailOptions);
+        if (cgImage)
+        {
+            thumbnail = [UIImage imageWithCGImage:cgImage];
+            CGImageRelease(cgImage);
+        }
+    }
+    
+    CFRelease(source);
+    return thumbnail;
+}
+
+#pragma mark - Private methods
+
++ (CGSize)imageSizeWithImageData:(NSData*)imageData
+{
+    NSDictionary *sourceOptions = @{(NSString*)kCGImageSourceShouldCache: @NO};
+    CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)imageData, (__bridge CFDictionaryRef)sourceOptions);
+    if (!source)
+    {
+        return CGSizeZero;
+    }
+    
+    CGSize size = [self imageSizeWithImageSource:source];
+    CFRelease(source);
+    return size;
+}
+
++ (CGSize)imageSizeWithImageSource:(CGImageSourceRef)source
+{
+    // Read the size in the image properties, without decoding the image
+    NSDictionary *properties = (__bridge_transfer NSDictionary*)CGImageSourceCopyPropertiesAtIndex(source, 0, NULL);
+    CGFloat width = [properties[(NSString*)kCGImagePropertyPixelWidth] doubleValue];
+    CGFloat height = [properties[(NSString*)kCGImagePropertyPixelHeight] doubleValue];
+    
+    // The EXIF orientations 5 to 8 swap the width and the height
+    NSUInteger orientation = [properties[(NSString*)kCGImagePropertyOrientation] unsignedIntegerValue];
+    if (orientation >= kCGImagePropertyOrientationLeftMirrored)
+    {
+        return CGSizeMake(height, width);
+    }
+    return CGSizeMake(width, height);
+}
+
++ (CGSize)size:(CGSize)size fittingInSize:(CGSize)maxSize
+{
+    // Same computation as [MXKTools reduceImage:toFitInSize:]
+    CGFloat width = size.width;
+    CGFloat height = size.height;
+    
+    if (width > maxSize.width)
+    {
+        height = floor((height * maxSize.width) / width / 2) * 2;
+        width = maxSize.width;
+    }
+    if (height > maxSize.height)
+    {
+        width = floor((width * maxSize.height) / height / 2) * 2;
+        height = maxSize.height;
+    }
+    
+    return CGSizeMake(width, height);
+}
+
++ (CGImagePropertyOrientation)exifOrientationWithImageOrientation:(UIImageOrientation)imageOrientation
+{
+    switch (imageOrientation)
+    {
+        case UIImageOrientationDown:
+            return kCGImagePropertyOrientationDown;
+        case UIImageOrientationLeft:
+            return kCGImagePropertyOrientationLeft;
+        case UIImageOrientationRight:
+            return kCGImagePropertyOrientationRight;
+        case UIImageOrientationUpMirrored:
+            return kCGImagePropertyOrientationUpMirrored;
+        case UIImageOrientationDownMirrored:
+            return kCGImagePropertyOrientationDownMirrored;
+        case UIImageOrientationLeftMirrored:
+            return kCGImagePropertyOrientationLeftMirrored;
+        case UIImageOrientationRightMirrored:
+            return kCGImagePropertyOrientationRightMirrored;
+        default:
+            return kCGImagePropertyOrientationUp;
+    }
+}
+
+@end
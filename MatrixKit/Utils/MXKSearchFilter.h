@@ -0,0 +1,83 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ `MXKSearchFilter` filters a list of items (cell data for example) by matching their search key with patterns.
+ 
+ The matching is case, diacritic and width insensitive: the keys are folded once in background and the folded keys
+ are kept while the items are refreshed. The filtering runs on a background queue. A new request cancels the pending one,
+ and when all the patterns of the new request extend the previous ones, only the previous result is scanned.
+ 
+ The results are published on the main thread, in the items order. This class must be used on the main thread.
+ */
+@interface MXKSearchFilter : NSObject
+
+/**
+ Create a filter.
+ 
+ @param searchKeyBlock the block returning the string to match for an item. It is called on the main thread by `setItems:`.
+ @return the newly created instance.
+ */
+- (instancetype)initWithSearchKeyBlock:(NSString* _Nullable (^)(id item))searchKeyBlock NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ The items to filter. Setting new items does not update the current result: a new filtering must be requested.
+ */
+@property (nonatomic, copy) NSArray *items;
+
+/**
+ Filter the items.
+ 
+ An item is kept when its search key contains one of the patterns.
+ 
+ @param patterns the patterns to match with.
+ @param completion the block called on the main thread with the kept items. It is not called if the request is cancelled
+                   or superseded by a new one.
+ */
+- (void)filterWithPatterns:(NSArray<NSString*>*)patterns completion:(void (^)(NSArray *filteredItems))completion;
+
+/**
+ Filter the items synchronously.
+ 
+ The pending request is cancelled. Use it when the result must be available at once, for example to refresh
+ a search result after an update of the items, before notifying this update.
+ 
+ @param patterns the patterns to match with.
+ @return the kept items.
+ */
+- (NSArray*)filteredItemsWithPatterns:(NSArray<NSString*>*)patterns;
+
+/**
+ Cancel the pending filtering request, if any.
+ */
+- (void)cancel;
+
+/**
+ Fold a string for the matching (case, diacritic and width insensitive).
+ 
+ @param string the string to fold.
+ @return the folded string.
+ */
++ (NSString*)foldedString:(NSString*)string;
+
+@end
+
+NS_ASSUME_NONNULL_END
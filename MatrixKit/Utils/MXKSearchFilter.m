@@ -0,0 +1,300 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXKSearchFilter.h"
+
+#import <MatrixSDK/MatrixSDK.h>
+
+/**
+ The number of items scanned between two cancellation checks.
+ */
+static NSUInteger const kMXKSearchFilterCancellationCheckInterval = 256;
+
+@interface MXKSearchFilter ()
+{
+    NSString* (^searchKeyBlock)(id item);
+    
+    /**
+     The search keys of the items, and their version (incremented each time the items are set).
+     */
+    NSArray *searchKeys;
+    NSUInteger itemsVersion;
+    
+    /**
+     The number of filtering requests. Only the result of the last request is published.
+     */
+    NSUInteger requestCount;
+    
+    NSOperationQueue *operationQueue;
+    NSOperation *currentOperation;
+    
+    // The following ivars are only used on the operation queue.
+    
+    /**
+     The folded keys by search key, kept across the items changes.
+     */
+    NSDictionary<NSString*, NSString*> *foldedKeysBySearchKey;
+    
+    /**
+     The folded keys of the items of the `foldedKeysItemsVersion` version.
+     */
+    NSArray<NSString*> *foldedKeys;
+    NSUInteger foldedKeysItemsVersion;
+    
+    /**
+     The last computed result, used to narrow the next request.
+     */
+    NSArray<NSString*> *lastFoldedPatterns;
+    NSIndexSet *lastResultIndexes;
+    NSUInteger lastResultItemsVersion;
+}
+
+@end
+
+@implementation MXKSearchFilter
+
+- (instancetype)initWithSearchKeyBlock:(NSString * _Nullable (^)(id))theSearchKeyBlock
+{
+    self = [super init];
+    if (self)
+    {
+        searchKeyBlock = theSearchKeyBlock;
+        _items = @[];
+        searchKeys = @[];
+        
+        operationQueue = [[NSOperationQueue alloc] init];
+        operationQueue.name = @"MXKSearchFilter";
+        operationQueue.maxConcurrentOperationCount = 1;
+        operationQueue.qualityOfService = NSQualityOfServiceUserInitiated;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [currentOperation cancel];
+}
+
+- (void)setItems:(NSArray *)items
+{
+    _items = items ? [items copy] : @[];
+    
+    // Read the search keys here, the items may not be thread safe
+    NSMutableArray *keys = [NSMutableArray arrayWithCapacity:_items.count];
+    for (id item in _items)
+    {
+        [keys addObject:searchKeyBlock(item) ?: @""];
+    }
+    searchKeys = keys;
+    itemsVersion++;
+}
+
+- (void)filterWithPatterns:(NSArray<NSString *> *)patterns completion:(void (^)(NSArray *))completion
+{
+    [self cancel];
+    
+    NSUInteger request = requestCount;
+    NSUInteger version = itemsVersion;
+    NSArray *items = _items;
+    NSArray *keys = searchKeys;
+    NSArray<NSString*> *foldedPatterns = [self foldedPatterns:patterns];
+    
+    NSBlockOperation *operation = [[NSBlockOperation alloc] init];
+    
+    MXWeakify(self);
+    MXWeakify(operation);
+    [operation addExecutionBlock:^{
+        
+        MXStrongifyAndReturnIfNil(self);
+        MXStrongifyAndReturnIfNil(operation);
+        
+        NSIndexSet *resultIndexes = [self indexesOfKeys:keys itemsVersion:version matchingFoldedPatterns:foldedPatterns operation:operation];
+        if (!resultIndexes)
+        {
+            // Cancelled
+            return;
+        }
+        
+        NSArray *filteredItems = [items objectsAtIndexes:resultIndexes];
+        
+        MXWeakify(self);
+        dispatch_async(dispatch_get_main_queue(), ^{
+            
+            MXStrongifyAndReturnIfNil(self);
+            if (self->requestCount == request)
+            {
+                self->currentOperation = nil;
+                completion(filteredItems);
+            }
+        });
+    }];
+    
+    currentOperation = operation;
+    [operationQueue addOperation:operation];
+}
+
+- (NSArray *)filteredItemsWithPatterns:(NSArray<NSString *> *)patterns
+{
+    [self cancel];
+    
+    NSUInteger version = itemsVersion;
+    NSArray *items = _items;
+    NSArray *keys = searchKeys;
+    NSArray<NSString*> *foldedPatterns = [self foldedPatterns:patterns];
+    
+    // Run on the operation queue, which owns the folded keys, and wait for the result
+    __block NSIndexSet *resultIndexes;
+    NSBlockOperation *operation = [[NSBlockOperation alloc] init];
+    
+    MXWeakify(operation);
+    [operation addExecutionBlock:^{
+        MXStrongifyAndReturnIfNil(operation);
+        resultIndexes = [self indexesOfKeys:keys itemsVersion:version matchingFoldedPatterns:foldedPatterns operation:operation];
+    }];
+    [operationQueue addOperations:@[operation] waitUntilFinished:YES];
+    
+    return resultIndexes ? [items objectsAtIndexes:resultIndexes] : @[];
+}
+
+- (void)cancel
+{
+    requestCount++;
+    
+    [currentOperation cancel];
+    currentOperation = nil;
+}
+
++ (NSString *)foldedString:(NSString *)string
+{
+    return [string stringByFoldingWithOptions:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch | NSWidthInsensitiveSearch locale:nil];
+}
+
+#pragma mark - Private methods
+
+- (NSArray<NSString*>*)foldedPatterns:(NSArray<NSString*>*)patterns
+{
+    NSMutableArray<NSString*> *foldedPatterns = [NSMutableArray arrayWithCapacity:patterns.count];
+    for (NSString *pattern in patterns)
+    {
+        [foldedPatterns addObject:[MXKSearchFilter foldedString:pattern]];
+    }
+    return foldedPatterns;
+}
+
+// Called on the operation queue
+- (NSIndexSet*)indexesOfKeys:(NSArray<NSString*>*)keys
+                itemsVersion:(NSUInteger)version
+      matchingFoldedPatterns:(NSArray<NSString*>*)foldedPatterns
+                   operation:(NSOperation*)operation
+{
+    NSArray<NSString*> *itemFoldedKeys = [self foldedKeysOfKeys:keys itemsVersion:version];
+    
+    // Narrow the previous result when the patterns have been extended
+    NSIndexSet *candidateIndexes;
+    if (lastFoldedPatterns && lastResultItemsVersion == version && [self foldedPatterns:foldedPatterns extendFoldedPatterns:lastFoldedPatterns])
+    {
+        candidateIndexes = lastResultIndexes;
+    }
+    else
+    {
+        candidateIndexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, itemFoldedKeys.count)];
+    }
+    
+    NSMutableIndexSet *resultIndexes = [NSMutableIndexSet indexSet];
+    __block NSUInteger scannedCount = 0;
+    __block BOOL isCancelled = NO;
+    
+    [candidateIndexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        
+        if (++scannedCount % kMXKSearchFilterCancellationCheckInterval == 0 && operation.isCancelled)
+        {
+            isCancelled = YES;
+            *stop = YES;
+            return;
+        }
+        
+        NSString *foldedKey = itemFoldedKeys[index];
+        for (NSString *foldedPattern in foldedPatterns)
+        {
+            if ([foldedKey rangeOfString:foldedPattern options:NSLiteralSearch].location != NSNotFound)
+            {
+                [resultIndexes addIndex:index];
+                break;
+            }
+        }
+    }];
+    
+    if (isCancelled)
+    {
+        return nil;
+    }
+    
+    lastFoldedPatterns = foldedPatterns;
+    lastResultIndexes = resultIndexes;
+    lastResultItemsVersion = version;
+    
+    return resultIndexes;
+}
+
+// Called on the operation queue
+- (NSArray<NSString*>*)foldedKeysOfKeys:(NSArray<NSString*>*)keys itemsVersion:(NSUInteger)version
+{
+    if (foldedKeys && foldedKeysItemsVersion == version)
+    {
+        return foldedKeys;
+    }
+    
+    // Fold only the new keys, and forget the keys which are not used anymore
+    NSMutableDictionary<NSString*, NSString*> *newFoldedKeysBySearchKey = [NSMutableDictionary dictionaryWithCapacity:keys.count];
+    NSMutableArray<NSString*> *newFoldedKeys = [NSMutableArray arrayWithCapacity:keys.count];
+    for (NSString *key in keys)
+    {
+        NSString *foldedKey = newFoldedKeysBySearchKey[key] ?: foldedKeysBySearchKey[key] ?: [MXKSearchFilter foldedString:key];
+        newFoldedKeysBySearchKey[key] = foldedKey;
+        [newFoldedKeys addObject:foldedKey];
+    }
+    
+    foldedKeysBySearchKey = newFoldedKeysBySearchKey;
+    foldedKeys = newFoldedKeys;
+    foldedKeysItemsVersion = version;
+    
+    return foldedKeys;
+}
+
+// Tell whether each new pattern contains one of the previous patterns: the new result is then a subset of the previous one
+- (BOOL)foldedPatterns:(NSArray<NSString*>*)foldedPatterns extendFoldedPatterns:(NSArray<NSString*>*)previousFoldedPatterns
+{
+    for (NSString *foldedPattern in foldedPatterns)
+    {
+        BOOL isExtended = NO;
+        for (NSString *previousFoldedPattern in previousFoldedPatterns)
+        {
+            if (previousFoldedPattern.length && [foldedPattern rangeOfString:previousFoldedPattern options:NSLiteralSearch].location != NSNotFound)
+            {
+                isExtended = YES;
+                break;
+            }
+        }
+        
+        if (!isExtended)
+        {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+@end
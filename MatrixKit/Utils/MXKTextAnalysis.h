@@ -0,0 +1,97 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The max number of analyses kept in memory by `analysisOfString:`.
+ */
+#define MXKTEXTANALYSIS_CACHE_COUNT_LIMIT 200
+
+/**
+ `MXKTextAnalysis` gathers the result of the text scans done on a message text: links, Matrix ids, emojis...
+ 
+ Each scan is done lazily, only once per string, and the analyses are shared: the event formatter,
+ the link creation and the bubble component link detection use the same analysis for a given text.
+ 
+ This class is thread safe.
+ */
+@interface MXKTextAnalysis : NSObject
+
+/**
+ Get the analysis of a string.
+ The analyses of the recently analysed strings are cached.
+
+ @param string the string to analyse.
+ @return the analysis.
+ */
++ (instancetype)analysisOfString:(NSString*)string NS_SWIFT_NAME(analysis(of:));
+
+- (instancetype)initWithString:(NSString*)string NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ The analysed string.
+ */
+@property (nonatomic, readonly) NSString *string;
+
+/**
+ The links detected by a `NSDataDetector` (NSTextCheckingTypeLink).
+ */
+@property (nonatomic, readonly) NSArray<NSTextCheckingResult*> *linkMatches;
+
+/**
+ The ranges matching an http(s) URL. They are used to not create Matrix id links inside URLs.
+ */
+@property (nonatomic, readonly) NSArray<NSTextCheckingResult*> *httpLinkMatches;
+
+/**
+ Get the Matrix ids of a given type found in the string.
+
+ @param matrixIdType one of the MXKTOOLS_XXX_BITWISE values (see MXKTools.h).
+ @return the matches.
+ */
+- (NSArray<NSTextCheckingResult*>*)matrixIdMatchesOfType:(NSInteger)matrixIdType;
+
+/**
+ Tell whether the string contains only emojis.
+ */
+@property (nonatomic, readonly) BOOL isEmojiOnly;
+
+/**
+ Tell whether the string contains one emoji and only one.
+ */
+@property (nonatomic, readonly) BOOL isSingleEmoji;
+
+/**
+ The first http(s) URL of the string, ignoring the hosts defined in `MXKAppSettings.firstURLDetectionIgnoredHosts`.
+ This is the URL that can be previewed.
+ */
+@property (nonatomic, readonly, nullable) NSURL *firstWebURL;
+
+/**
+ Get the first http(s) URL of the string.
+
+ @param ignoredHosts the hosts to ignore.
+ @return the URL if any.
+ */
+- (nullable NSURL*)firstWebURLIgnoringHosts:(NSArray<NSString*>*)ignoredHosts;
+
+@end
+
+NS_ASSUME_NONNULL_END
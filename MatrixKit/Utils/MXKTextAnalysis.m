@@ -0,0 +1,191 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "MXKTextAnalysis.h"
+
+@import MatrixSDK;
+
+#import "MXKTools.h"
+#import "MXKAppSettings.h"
+
+#pragma mark - MXKTextAnalysis static private members
+// The detectors and regexes are immutable, they are shared by all analyses.
+static NSDataDetector *linkDetector;
+static NSRegularExpression *httpLinksRegex;
+static NSDictionary<NSNumber*, NSRegularExpression*> *matrixIdRegexes;
+static NSCache<NSString*, MXKTextAnalysis*> *analysesCache;
+
+@interface MXKTextAnalysis ()
+{
+    NSArray<NSTextCheckingResult*> *linkMatches;
+    NSArray<NSTextCheckingResult*> *httpLinkMatches;
+    NSMutableDictionary<NSNumber*, NSArray<NSTextCheckingResult*>*> *matrixIdMatches;
+    NSNumber *isEmojiOnly;
+    NSNumber *isSingleEmoji;
+}
+
+@end
+
+@implementation MXKTextAnalysis
+
++ (void)initialize
+{
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        
+        linkDetector = [NSDataDetector dataDetectorWithTypes:NSTextCheckingTypeLink error:nil];
+        httpLinksRegex = [NSRegularExpression regularExpressionWithPattern:@"(?i)\\b(https?://.*)\\b" options:NSRegularExpressionCaseInsensitive error:nil];
+        
+        matrixIdRegexes = @{
+                            @(MXKTOOLS_USER_IDENTIFIER_BITWISE): [NSRegularExpression regularExpressionWithPattern:kMXToolsRegexStringForMatrixUserIdentifier options:NSRegularExpressionCaseInsensitive error:nil],
+                            @(MXKTOOLS_ROOM_IDENTIFIER_BITWISE): [NSRegularExpression regularExpressionWithPattern:kMXToolsRegexStringForMatrixRoomIdentifier options:NSRegularExpressionCaseInsensitive error:nil],
+                            @(MXKTOOLS_ROOM_ALIAS_BITWISE): [NSRegularExpression regularExpressionWithPattern:kMXToolsRegexStringForMatrixRoomAlias options:NSRegularExpressionCaseInsensitive error:nil],
+                            @(MXKTOOLS_EVENT_IDENTIFIER_BITWISE): [NSRegularExpression regularExpressionWithPattern:kMXToolsRegexStringForMatrixEventIdentifier options:NSRegularExpressionCaseInsensitive error:nil],
+                            @(MXKTOOLS_GROUP_IDENTIFIER_BITWISE): [NSRegularExpression regularExpressionWithPattern:kMXToolsRegexStringForMatrixGroupIdentifier options:NSRegularExpressionCaseInsensitive error:nil]
+                            };
+        
+        analysesCache = [[NSCache alloc] init];
+        analysesCache.countLimit = MXKTEXTANALYSIS_CACHE_COUNT_LIMIT;
+    });
+}
+
++ (instancetype)analysisOfString:(NSString *)string
+{
+    MXKTextAnalysis *analysis = [analysesCache objectForKey:string];
+    if (!analysis)
+    {
+        analysis = [[MXKTextAnalysis alloc] initWithString:string];
+        
+        // NSCache does not copy its keys: use the immutable copy of the analysis, the string may be the backing store of a mutable string
+        [analysesCache setObject:analysis forKey:analysis.string];
+    }
+    return analysis;
+}
+
+- (instancetype)initWithString:(NSString *)string
+{
+    self = [super init];
+    if (self)
+    {
+        _string = [string copy] ?: @"";
+        matrixIdMatches = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (NSArray<NSTextCheckingResult *> *)linkMatches
+{
+    @synchronized(self)
+    {
+        if (!linkMatches)
+        {
+            linkMatches = [linkDetector matchesInString:_string options:0 range:NSMakeRange(0, _string.length)];
+        }
+        return linkMatches;
+    }
+}
+
+- (NSArray<NSTextCheckingResult *> *)httpLinkMatches
+{
+    @synchronized(self)
+    {
+        if (!httpLinkMatches)
+        {
+            httpLinkMatches = [httpLinksRegex matchesInString:_string options:0 range:NSMakeRange(0, _string.length)];
+        }
+        return httpLinkMatches;
+    }
+}
+
+- (NSArray<NSTextCheckingResult *> *)matrixIdMatchesOfType:(NSInteger)matrixIdType
+{
+    NSRegularExpression *regex = matrixIdRegexes[@(matrixIdType)];
+    if (!regex)
+    {
+        return @[];
+    }
+    
+    @synchronized(self)
+    {
+        NSArray<NSTextCheckingResult*> *matches = matrixIdMatches[@(matrixIdType)];
+        if (!matches)
+        {
+            matches = [regex matchesInString:_string options:0 range:NSMakeRange(0, _string.length)];
+            matrixIdMatches[@(matrixIdType)] = matches;
+        }
+        return matches;
+    }
+}
+
+- (BOOL)isEmojiOnly
+{
+    @synchronized(self)
+    {
+        if (!isEmojiOnly)
+        {
+            isEmojiOnly = @([MXKTools isEmojiOnlyString:_string]);
+        }
+        return isEmojiOnly.boolValue;
+    }
+}
+
+- (BOOL)isSingleEmoji
+{
+    @synchronized(self)
+    {
+        if (!isSingleEmoji)
+        {
+            isSingleEmoji = @([MXKTools isSingleEmojiString:_string]);
+        }
+        return isSingleEmoji.boolValue;
+    }
+}
+
+- (NSURL *)firstWebURL
+{
+    return [self firstWebURLIgnoringHosts:MXKAppSettings.standardAppSettings.snapshot.firstURLDetectionIgnoredHosts];
+}
+
+- (NSURL *)firstWebURLIgnoringHosts:(NSArray<NSString *> *)ignoredHosts
+{
+    // Consider all the urls found in the string to ensure
+    // detection of a valid link if there are invalid links preceding it
+    for (NSTextCheckingResult *match in self.linkMatches)
+    {
+        // Check if the match is a valid url
+        NSURL *url = [NSURL URLWithString:[_string substringWithRange:match.range]];
+        
+        // Ensure the match is a web link
+        NSString *scheme = url.scheme.lowercaseString;
+        if (![scheme isEqualToString:@"https"] && ![scheme isEqualToString:@"http"])
+        {
+            continue;
+        }
+        
+        // Discard any links to ignored hosts
+        NSString *host = url.host.lowercaseString;
+        if (!host || [ignoredHosts containsObject:host])
+        {
+            continue;
+        }
+        
+        return url;
+    }
+    
+    return nil;
+}
+
+@end
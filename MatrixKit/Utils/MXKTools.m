@@ -28,6 +28,7 @@
 #import <MatrixSDK/MXTools.h>
 #import "MXKSwiftHeader.h"
 #import "MXKAnalyticsConstants.h"
+#import "MXKTextAnalysis.h"
 
 #pragma mark - Constants definitions
 
@@ -38,14 +39,6 @@
 NSString *const kMXKToolsBlockquoteMarkAttribute = @"kMXKToolsBlockquoteMarkAttribute";
 
 #pragma mark - MXKTools static private members
-// The regex used to find matrix ids.
-static NSRegularExpression *userIdRegex;
-static NSRegularExpression *roomIdRegex;
-static NSRegularExpression *roomAliasRegex;
-static NSRegularExpression *eventIdRegex;
-static NSRegularExpression *groupIdRegex;
-// A regex to find http URLs.
-static NSRegularExpression *httpLinksRegex;
 // A regex to find all HTML tags
 static NSRegularExpression *htmlTagsRegex;
 
@@ -56,13 +49,6 @@ static NSRegularExpression *htmlTagsRegex;
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
         
-        userIdRegex = [NSRegularExpression regularExpressionWithPattern:kMXToolsRegexStringForMatrixUserIdentifier options:NSRegularExpressionCaseInsensitive error:nil];
-        roomIdRegex = [NSRegularExpression regularExpressionWithPattern:kMXToolsRegexStringForMatrixRoomIdentifier options:NSRegularExpressionCaseInsensitive error:nil];
-        roomAliasRegex = [NSRegularExpression regularExpressionWithPattern:kMXToolsRegexStringForMatrixRoomAlias options:NSRegularExpressionCaseInsensitive error:nil];
-        eventIdRegex = [NSRegularExpression regularExpressionWithPattern:kMXToolsRegexStringForMatrixEventIdentifier options:NSRegularExpressionCaseInsensitive error:nil];
-        groupIdRegex = [NSRegularExpression regularExpressionWithPattern:kMXToolsRegexStringForMatrixGroupIdentifier options:NSRegularExpressionCaseInsensitive error:nil];
-        
-        httpLinksRegex = [NSRegularExpression regularExpressionWithPattern:@"(?i)\\b(https?://.*)\\b" options:NSRegularExpressionCaseInsensitive error:nil];
         htmlTagsRegex  = [NSRegularExpression regularExpressionWithPattern:@"<(\\w+)[^>]*>" options:NSRegularExpressionCaseInsensitive error:nil];        
     });
 }
@@ -530,6 +516,10 @@ static NSRegularExpression *htmlTagsRegex;
 {
     // Create the image source
     CGImageSourceRef imageSource = CGImageSourceCreateWithData((__bridge CFDataRef)imageData, NULL);
+    if (!imageSource)
+    {
+        return nil;
+    }
 
     // Take the max dimension of size to fit in
     CGFloat maxPixelSize = fmax(size.width, size.height);
@@ -543,11 +533,15 @@ static NSRegularExpression *htmlTagsRegex;
 
     // Generate the thumbnail
     CGImageRef resizedImageRef = CGImageSourceCreateThumbnailAtIndex(imageSource, 0, options);
+    CFRelease(imageSource);
+    if (!resizedImageRef)
+    {
+        return nil;
+    }
 
     UIImage *resizedImage = [[UIImage alloc] initWithCGImage:resizedImageRef];
 
     CGImageRelease(resizedImageRef);
-    CFRelease(imageSource);
 
     return resizedImage;
 }
@@ -1025,46 +1019,31 @@ manualChangeMessageForVideo:(NSString*)manualChangeMessageForVideo
     
     NSMutableAttributedString *postRenderAttributedString;
     
-    // If enabled, make user id clickable
-    if (enabledMatrixIdsBitMask & MXKTOOLS_USER_IDENTIFIER_BITWISE)
-    {
-        [MXKTools createLinksInAttributedString:attributedString matchingRegex:userIdRegex withWorkingAttributedString:&postRenderAttributedString];
-    }
-    
-    // If enabled, make room id clickable
-    if (enabledMatrixIdsBitMask & MXKTOOLS_ROOM_IDENTIFIER_BITWISE)
-    {
-        [MXKTools createLinksInAttributedString:attributedString matchingRegex:roomIdRegex withWorkingAttributedString:&postRenderAttributedString];
-    }
-    
-    // If enabled, make room alias clickable
-    if (enabledMatrixIdsBitMask & MXKTOOLS_ROOM_ALIAS_BITWISE)
-    {
-        [MXKTools createLinksInAttributedString:attributedString matchingRegex:roomAliasRegex withWorkingAttributedString:&postRenderAttributedString];
-    }
-    
-    // If enabled, make event id clickable
-    if (enabledMatrixIdsBitMask & MXKTOOLS_EVENT_IDENTIFIER_BITWISE)
-    {
-        [MXKTools createLinksInAttributedString:attributedString matchingRegex:eventIdRegex withWorkingAttributedString:&postRenderAttributedString];
-    }
+    // Use the shared analysis of the string to not scan it again
+    MXKTextAnalysis *analysis = [MXKTextAnalysis analysisOfString:attributedString.string];
     
-    // If enabled, make group id clickable
-    if (enabledMatrixIdsBitMask & MXKTOOLS_GROUP_IDENTIFIER_BITWISE)
+    // Make clickable the enabled matrix ids: user ids, room ids, room aliases, event ids, group ids
+    NSArray<NSNumber*> *matrixIdTypes = @[@(MXKTOOLS_USER_IDENTIFIER_BITWISE),
+                                          @(MXKTOOLS_ROOM_IDENTIFIER_BITWISE),
+                                          @(MXKTOOLS_ROOM_ALIAS_BITWISE),
+                                          @(MXKTOOLS_EVENT_IDENTIFIER_BITWISE),
+                                          @(MXKTOOLS_GROUP_IDENTIFIER_BITWISE)];
+    for (NSNumber *matrixIdType in matrixIdTypes)
     {
-        [MXKTools createLinksInAttributedString:attributedString matchingRegex:groupIdRegex withWorkingAttributedString:&postRenderAttributedString];
+        if (enabledMatrixIdsBitMask & matrixIdType.integerValue)
+        {
+            [MXKTools createLinksInAttributedString:attributedString forMatches:[analysis matrixIdMatchesOfType:matrixIdType.integerValue] withAnalysis:analysis workingAttributedString:&postRenderAttributedString];
+        }
     }
     
     return postRenderAttributedString ? postRenderAttributedString : attributedString;
 }
 
-+ (void)createLinksInAttributedString:(NSAttributedString*)attributedString matchingRegex:(NSRegularExpression*)regex withWorkingAttributedString:(NSMutableAttributedString* __autoreleasing *)mutableAttributedString
++ (void)createLinksInAttributedString:(NSAttributedString*)attributedString forMatches:(NSArray<NSTextCheckingResult*>*)matches withAnalysis:(MXKTextAnalysis*)analysis workingAttributedString:(NSMutableAttributedString* __autoreleasing *)mutableAttributedString
 {
-    __block NSArray *linkMatches;
-    
-    // Enumerate each string matching the regex
-    [regex enumerateMatchesInString:attributedString.string options:0 range:NSMakeRange(0, attributedString.length) usingBlock:^(NSTextCheckingResult *match, NSMatchingFlags flags, BOOL *stop) {
-        
+    // Consider each string matching the regex
+    for (NSTextCheckingResult *match in matches)
+    {
         // Do not create a link if there is already one on the found match
         __block BOOL hasAlreadyLink = NO;
         [attributedString enumerateAttributesInRange:match.range options:0 usingBlock:^(NSDictionary<NSString *,id> * _Nonnull attrs, NSRange range, BOOL * _Nonnull stop) {
@@ -1081,18 +1060,12 @@ manualChangeMessageForVideo:(NSString*)manualChangeMessageForVideo
         // So, do not break it now by adding a link on a subset of this http link.
         if (!hasAlreadyLink)
         {
-            if (!linkMatches)
-            {
-                // Search for the links in the string only once
-                // Do not use NSDataDetector with NSTextCheckingTypeLink because is not able to
-                // manage URLs with 2 hashes like "https://matrix.to/#/#matrix:matrix.org"
-                // Such URL is not valid but web browsers can open them and users C+P them...
-                // NSDataDetector does not support it but UITextView and UIDataDetectorTypeLink
-                // detect them when they are displayed. So let the UI create the link at display.
-                linkMatches = [httpLinksRegex matchesInString:attributedString.string options:0 range:NSMakeRange(0, attributedString.length)];
-            }
-            
-            for (NSTextCheckingResult *linkMatch in linkMatches)
+            // Note: The http links are not detected with NSDataDetector with NSTextCheckingTypeLink because it is not able to
+            // manage URLs with 2 hashes like "https://matrix.to/#/#matrix:matrix.org"
+            // Such URL is not valid but web browsers can open them and users C+P them...
+            // NSDataDetector does not support it but UITextView and UIDataDetectorTypeLink
+            // detect them when they are displayed. So let the UI create the link at display.
+            for (NSTextCheckingResult *linkMatch in analysis.httpLinkMatches)
             {
                 // If the match is fully in the link, skip it
                 if (NSIntersectionRange(match.range, linkMatch.range).length == match.range.length)
@@ -1118,7 +1091,7 @@ manualChangeMessageForVideo:(NSString*)manualChangeMessageForVideo
             link = [link stringByAddingPercentEscapesUsingEncoding:NSUTF8StringEncoding];
             [*mutableAttributedString addAttribute:NSLinkAttributeName value:link range:match.range];
         }
-    }];
+    }
 }
 
 #pragma mark - HTML processing - blockquote display handling
@@ -17,13 +17,126 @@
 import UIKit
 import AVFoundation
 
+/// MXKVideoThumbnailRequest is a pending thumbnail request of MXKVideoThumbnailGenerator.
+@objcMembers
+public class MXKVideoThumbnailRequest: NSObject {
+    
+    // MARK: - Properties
+    
+    /// The key of the thumbnail in the generator caches.
+    fileprivate let key: String
+    
+    fileprivate var completion: ((UIImage?) -> Void)?
+    
+    fileprivate weak var generator: MXKVideoThumbnailGenerator?
+    
+    /// Tell whether the request has been cancelled.
+    public fileprivate(set) var isCancelled = false
+    
+    // MARK: - Setup
+    
+    fileprivate init(key: String, generator: MXKVideoThumbnailGenerator, completion: @escaping (UIImage?) -> Void) {
+        self.key = key
+        self.generator = generator
+        self.completion = completion
+        super.init()
+    }
+    
+    // MARK: - Public
+    
+    /// Cancel the request: its completion will not be called.
+    /// The thumbnail generation is stopped if no other request is waiting for it.
+    /// Must be called on the main thread.
+    public func cancel() {
+        generator?.cancel(self)
+    }
+}
+
 /// MXKVideoThumbnailGenerator is a utility class to generate a thumbnail image from a video file.
+///
+/// The thumbnails are cached in memory and on disk, by file identity (path, size and modification date) and maximum size,
+/// so that the same video is decoded only once. The asynchronous requests for the same thumbnail share the same generation.
+/// The disk cache lives in the Caches directory and keeps the most recently used thumbnails within a size limit.
 @objcMembers
 public class MXKVideoThumbnailGenerator: NSObject {
     
+    // MARK: - Constants
+    
+    private enum Constants {
+        static let maxConcurrentGenerationCount = 2
+        static let memoryCacheCountLimit = 50
+        static let cacheFolderName = "MXKVideoThumbnails"
+        static let diskCacheSizeLimit: UInt64 = 20 * 1024 * 1024
+        static let jpegCompressionQuality: CGFloat = 0.9
+    }
+    
     public static let shared = MXKVideoThumbnailGenerator()
     
-    // MARK - Public
+    // MARK: - Properties
+    
+    // MARK: Private
+    
+    private let cacheFolderURL: URL?
+    private let diskCacheSizeLimit: UInt64
+    /// Serialize the writes and the trimming of the disk cache.
+    private let diskCacheLock = NSLock()
+    private let memoryCache = NSCache<NSString, UIImage>()
+    private let generationQueue: OperationQueue
+    
+    /// The pending generations and their requests by thumbnail key. Only accessed on the main thread.
+    private var pendingGenerations: [String: (operation: Operation, requests: [MXKVideoThumbnailRequest])] = [:]
+    
+    private let generationCountLock = NSLock()
+    private var _generationCount: UInt = 0
+    
+    // MARK: Public
+    
+    /// The number of thumbnails successfully generated from a video (and not from a cache).
+    public var generationCount: UInt {
+        generationCountLock.lock()
+        defer { generationCountLock.unlock() }
+        return _generationCount
+    }
+    
+    // MARK: - Setup
+    
+    /// Create a generator which caches its thumbnails in the Caches directory of the app.
+    public convenience override init() {
+        let cacheFolderURL = FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask).first?.appendingPathComponent(Constants.cacheFolderName, isDirectory: true)
+        self.init(cacheFolderURL: cacheFolderURL)
+    }
+    
+    /// Create a generator with the default disk cache size limit.
+    ///
+    /// - Parameter cacheFolderURL: The folder where the thumbnails are stored, nil to keep them in memory only.
+    public convenience init(cacheFolderURL: URL?) {
+        self.init(cacheFolderURL: cacheFolderURL, diskCacheSizeLimit: Constants.diskCacheSizeLimit)
+    }
+    
+    /// Create a generator.
+    ///
+    /// - Parameters:
+    ///   - cacheFolderURL: The folder where the thumbnails are stored, nil to keep them in memory only.
+    ///   - diskCacheSizeLimit: The maximum size in bytes of the stored thumbnails. The least recently used ones are removed first.
+    public init(cacheFolderURL: URL?, diskCacheSizeLimit: UInt64) {
+        self.cacheFolderURL = cacheFolderURL
+        self.diskCacheSizeLimit = diskCacheSizeLimit
+        
+        memoryCache.countLimit = Constants.memoryCacheCountLimit
+        
+        generationQueue = OperationQueue()
+        generationQueue.name = "MXKVideoThumbnailGenerator"
+        generationQueue.maxConcurrentOperationCount = Constants.maxConcurrentGenerationCount
+        generationQueue.qualityOfService = .userInitiated
+        
+        super.init()
+        
+        if let cacheFolderURL = cacheFolderURL {
+            try? FileManager.default.createDirectory(at: cacheFolderURL, withIntermediateDirectories: true, attributes: nil)
+        }
+    }
+    
+    // MARK: - Public
     
     /// Generate thumbnail image from a video URL.
     /// Note: Do not make `maximumSize` optional with default nil value for Objective-C compatibility.
@@ -34,7 +147,7 @@ public class MXKVideoThumbnailGenerator: NSObject {
     /// - Returns: Thumbnail image or nil.
     public func generateThumbnail(from url: URL, with maximumSize: CGSize) -> UIImage? {
         let finalSize: CGSize? = maximumSize != .zero ? maximumSize : nil
-        return self.generateThumbnail(from: url, with: finalSize)
+        return self.cachedOrGeneratedThumbnail(from: url, with: finalSize)
     }    
     
     /// Generate thumbnail image from a video URL.
@@ -42,10 +155,91 @@ public class MXKVideoThumbnailGenerator: NSObject {
     /// - Parameter url: Video URL.
     /// - Returns: Thumbnail image or nil.
     public func generateThumbnail(from url: URL) -> UIImage? {
-        return generateThumbnail(from: url, with: nil)
+        return cachedOrGeneratedThumbnail(from: url, with: nil)
+    }
+    
+    /// Generate thumbnail image from a video URL in background.
+    /// Must be called on the main thread.
+    ///
+    /// - Parameters:
+    ///   - url: Video URL.
+    ///   - maximumSize: Maximum dimension for generated thumbnail image, `.zero` to keep video dimension.
+    ///   - completion: A closure called on the main thread with the thumbnail image or nil.
+    ///     It is called immediately when the thumbnail is in the memory cache.
+    /// - Returns: The request, which may be cancelled.
+    @discardableResult
+    public func generateThumbnail(from url: URL, with maximumSize: CGSize, completion: @escaping (UIImage?) -> Void) -> MXKVideoThumbnailRequest {
+        let finalSize: CGSize? = maximumSize != .zero ? maximumSize : nil
+        let key = self.thumbnailKey(for: url, with: finalSize)
+        let request = MXKVideoThumbnailRequest(key: key, generator: self, completion: completion)
+        
+        if let image = memoryCache.object(forKey: key as NSString) {
+            request.completion = nil
+            completion(image)
+            return request
+        }
+        
+        // Share the pending generation of the same thumbnail
+        if var pendingGeneration = pendingGenerations[key] {
+            pendingGeneration.requests.append(request)
+            pendingGenerations[key] = pendingGeneration
+            return request
+        }
+        
+        let operation = BlockOperation()
+        operation.addExecutionBlock { [weak self, weak operation] in
+            guard let self = self, let operation = operation, !operation.isCancelled else {
+                return
+            }
+            
+            let image = self.diskCachedThumbnail(for: key) ?? self.generateAndStoreThumbnail(from: url, with: finalSize, key: key)
+            
+            DispatchQueue.main.async {
+                self.didGenerateThumbnail(image, for: key, operation: operation)
+            }
+        }
+        
+        pendingGenerations[key] = (operation: operation, requests: [request])
+        generationQueue.addOperation(operation)
+        
+        return request
+    }
+    
+    /// Release the cached thumbnails, in memory and on disk.
+    /// MatrixKit calls it on the shared generator when an account is logged out or its cache is cleared.
+    public func clearCache() {
+        memoryCache.removeAllObjects()
+        
+        guard let cacheFolderURL = self.cacheFolderURL else {
+            return
+        }
+        diskCacheLock.lock()
+        defer { diskCacheLock.unlock() }
+        try? FileManager.default.removeItem(at: cacheFolderURL)
+        try? FileManager.default.createDirectory(at: cacheFolderURL, withIntermediateDirectories: true, attributes: nil)
     }
     
-    // MARK - Private
+    // MARK: - Private
+    
+    /// Get a thumbnail image from the caches, or generate it.
+    ///
+    /// - Parameters:
+    ///   - url: Video URL.
+    ///   - maximumSize: Maximum dimension for generated thumbnail image or nil to keep video dimension.
+    /// - Returns: Thumbnail image or nil.
+    private func cachedOrGeneratedThumbnail(from url: URL, with maximumSize: CGSize?) -> UIImage? {
+        let key = self.thumbnailKey(for: url, with: maximumSize)
+        
+        if let image = memoryCache.object(forKey: key as NSString) {
+            return image
+        }
+        
+        let image = self.diskCachedThumbnail(for: key) ?? self.generateAndStoreThumbnail(from: url, with: maximumSize, key: key)
+        if let image = image {
+            memoryCache.setObject(image, forKey: key as NSString)
+        }
+        return image
+    }
     
     /// Generate thumbnail image from a video URL.
     ///
@@ -73,4 +267,131 @@ public class MXKVideoThumbnailGenerator: NSObject {
         
         return thumbnailImage
     }
+    
+    private func generateAndStoreThumbnail(from url: URL, with maximumSize: CGSize?, key: String) -> UIImage? {
+        guard let image = self.generateThumbnail(from: url, with: maximumSize) else {
+            return nil
+        }
+        
+        generationCountLock.lock()
+        _generationCount += 1
+        generationCountLock.unlock()
+        
+        if let fileURL = self.cacheFileURL(for: key), let data = image.jpegData(compressionQuality: Constants.jpegCompressionQuality) {
+            diskCacheLock.lock()
+            defer { diskCacheLock.unlock() }
+            
+            if (try? data.write(to: fileURL, options: [.atomic, .completeFileProtectionUntilFirstUserAuthentication])) != nil {
+                self.trimDiskCache(keeping: fileURL)
+            }
+        }
+        return image
+    }
+    
+    private func diskCachedThumbnail(for key: String) -> UIImage? {
+        guard let fileURL = self.cacheFileURL(for: key), let data = try? Data(contentsOf: fileURL) else {
+            return nil
+        }
+        
+        // Mark the thumbnail as recently used
+        try? FileManager.default.setAttributes([.modificationDate: Date()], ofItemAtPath: fileURL.path)
+        return UIImage(data: data)
+    }
+    
+    /// Remove the least recently used thumbnails until the disk cache fits in its size limit.
+    /// Must be called with `diskCacheLock` locked.
+    ///
+    /// - Parameter keptFileURL: The thumbnail which has just been stored, it is never removed.
+    private func trimDiskCache(keeping keptFileURL: URL) {
+        guard let cacheFolderURL = self.cacheFolderURL else {
+            return
+        }
+        
+        let resourceKeys: [URLResourceKey] = [.contentModificationDateKey, .fileSizeKey]
+        guard let fileURLs = try? FileManager.default.contentsOfDirectory(at: cacheFolderURL, includingPropertiesForKeys: resourceKeys, options: .skipsHiddenFiles) else {
+            return
+        }
+        
+        var files = fileURLs.compactMap { fileURL -> (url: URL, date: Date, size: UInt64)? in
+            guard let values = try? fileURL.resourceValues(forKeys: Set(resourceKeys)) else {
+                return nil
+            }
+            return (url: fileURL, date: values.contentModificationDate ?? .distantPast, size: UInt64(values.fileSize ?? 0))
+        }
+        
+        var totalSize = files.reduce(0) { $0 + $1.size }
+        guard totalSize > diskCacheSizeLimit else {
+            return
+        }
+        
+        files.sort { $0.date < $1.date }
+        for file in files where totalSize > diskCacheSizeLimit && file.url.lastPathComponent != keptFileURL.lastPathComponent {
+            if (try? FileManager.default.removeItem(at: file.url)) != nil {
+                totalSize -= file.size
+            }
+        }
+    }
+    
+    private func didGenerateThumbnail(_ image: UIImage?, for key: String, operation: Operation) {
+        if let image = image {
+            memoryCache.setObject(image, forKey: key as NSString)
+        }
+        
+        // Ignore the generations whose requests have all been cancelled
+        guard let pendingGeneration = pendingGenerations[key], pendingGeneration.operation === operation else {
+            return
+        }
+        pendingGenerations[key] = nil
+        
+        for request in pendingGeneration.requests {
+            let completion = request.completion
+            request.completion = nil
+            completion?(image)
+        }
+    }
+    
+    fileprivate func cancel(_ request: MXKVideoThumbnailRequest) {
+        guard !request.isCancelled else {
+            return
+        }
+        request.isCancelled = true
+        request.completion = nil
+        
+        guard var pendingGeneration = pendingGenerations[request.key] else {
+            return
+        }
+        pendingGeneration.requests.removeAll { $0 === request }
+        
+        if pendingGeneration.requests.isEmpty {
+            // Nobody waits for this thumbnail anymore
+            pendingGeneration.operation.cancel()
+            pendingGenerations[request.key] = nil
+        } else {
+            pendingGenerations[request.key] = pendingGeneration
+        }
+    }
+    
+    /// Build the cache key of a thumbnail: the file identity and the maximum size.
+    private func thumbnailKey(for url: URL, with maximumSize: CGSize?) -> String {
+        var identity = url.absoluteString
+        
+        if url.isFileURL, let attributes = try? FileManager.default.attributesOfItem(atPath: url.path) {
+            // A modified file gets another key
+            let fileSize = (attributes[.size] as? NSNumber)?.uint64Value ?? 0
+            let modificationDate = (attributes[.modificationDate] as? Date)?.timeIntervalSince1970 ?? 0
+            identity += "|\(fileSize)|\(modificationDate)"
+        }
+        
+        if let maximumSize = maximumSize {
+            identity += "|\(Int(maximumSize.width))x\(Int(maximumSize.height))"
+        }
+        return identity
+    }
+    
+    private func cacheFileURL(for key: String) -> URL? {
+        guard let cacheFolderURL = self.cacheFolderURL, let hash = (key.data(using: .utf8) as NSData?)?.mx_MD5() else {
+            return nil
+        }
+        return cacheFolderURL.appendingPathComponent(hash).appendingPathExtension("jpg")
+    }
 }
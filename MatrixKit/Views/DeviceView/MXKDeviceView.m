@@ -21,6 +21,7 @@
 #import "NSBundle+MatrixKit.h"
 
 #import "MXKConstants.h"
+#import "MXKDateFormatterPool.h"
 
 #import "MXKSwiftHeader.h"
 
@@ -181,11 +182,9 @@ static NSAttributedString *verticalWhitespace = nil;
             
             NSDate *lastSeenDate = [NSDate dateWithTimeIntervalSince1970:device.lastSeenTs/1000];
             
-            NSDateFormatter *dateFormatter = [[NSDateFormatter alloc] init];
-            [dateFormatter setLocale:[[NSLocale alloc] initWithLocaleIdentifier:[[[NSBundle mainBundle] preferredLocalizations] objectAtIndex:0]]];
-            [dateFormatter setDateStyle:NSDateFormatterShortStyle];
-            [dateFormatter setTimeStyle:NSDateFormatterShortStyle];
-            [dateFormatter setFormatterBehavior:NSDateFormatterBehavior10_4];
+            NSDateFormatter *dateFormatter = [[MXKDateFormatterPool sharedPool] dateFormatterWithDateStyle:NSDateFormatterShortStyle
+                                                                                                timeStyle:NSDateFormatterShortStyle
+                                                                                                   locale:[MXKDateFormatterPool applicationLocale]];
             
             NSString *lastSeen = [MatrixKitL10n deviceDetailsLastSeenFormat:device.lastSeenIp :[dateFormatter stringFromDate:lastSeenDate]];
             
@@ -79,6 +79,14 @@ andImageOrientation:(UIImageOrientation)orientation
  */
 - (void)setAttachment:(MXKAttachment *)attachment;
 
+/**
+ * Display an image attachment which has been already decoded (see `MXKAttachmentPrefetcher`).
+ * The full res image is not loaded.
+ * @param attachment The attachment
+ * @param image The decoded image of the attachment
+ */
+- (void)setAttachment:(MXKAttachment *)attachment withDecodedImage:(UIImage *)image;
+
 /**
  * Load an attachment into the image viewer and display its thumbnail, if it has one.
  * This method must be used to display encrypted attachments
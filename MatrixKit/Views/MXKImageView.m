@@ -728,6 +728,25 @@ andImageOrientation:(UIImageOrientation)orientation
     }
 }
 
+- (void)setAttachment:(MXKAttachment *)attachment withDecodedImage:(UIImage *)image
+{
+    // Remove any pending observers
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    
+    // The orientation has been applied during decoding
+    imageOrientation = UIImageOrientationUp;
+    
+    mediaFolder = attachment.eventRoomId;
+    mxcURI = attachment.contentURL;
+    mimeType = attachment.contentInfo[@"mimetype"];
+    
+    // Ignore the potential pending load of the previous attachment
+    currentAttachment = attachment;
+    
+    self.image = image;
+    [self stopActivityIndicator];
+}
+
 - (void)setAttachmentThumb:(MXKAttachment *)attachment
 {
     // Remove any pending observers
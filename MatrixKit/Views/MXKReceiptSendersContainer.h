@@ -20,6 +20,11 @@
 
 #import "MXKView.h"
 
+/**
+ The memory budget (in bytes) of the receipt stacks rendered by all the containers.
+ */
+#define MXKRECEIPTSENDERSCONTAINER_RENDERED_STACKS_COST_LIMIT (4 * 1024 * 1024)
+
 typedef NS_ENUM(NSInteger, ReadReceiptsAlignment)
 {
     /**
@@ -37,6 +42,11 @@ typedef NS_ENUM(NSInteger, ReadReceiptsAlignment)
  `MXKReceiptSendersContainer` is a view dedicated to display receipt senders by using their avatars.
  
  This container handles automatically the number of visible avatars. A label is added when avatars are not all visible (see 'moreLabel' property).
+ 
+ The avatars are not displayed with one image view per member: the stack is rendered into a single bitmap, displayed by a layer
+ reused across refreshes. The rendered stacks are shared by all the containers, so identical receipt stacks (same avatars, size
+ and alignment) are rendered only once. A stack is cached only when all its avatars are available. The placeholder of a member
+ without avatar is expected to depend only on its user id and display name.
  */
 @interface MXKReceiptSendersContainer : MXKView
 
@@ -75,6 +85,11 @@ typedef NS_ENUM(NSInteger, ReadReceiptsAlignment)
  */
 @property (nonatomic, readonly) NSArray <UIImage *> *placeholders;
 
+/**
+ The media manager used to download the matrix user's avatar.
+ */
+@property (nonatomic) MXMediaManager *mediaManager;
+
 /**
  Initializes an `MXKReceiptSendersContainer` object with a frame and a media manager.
  
@@ -17,15 +17,43 @@
 
 #import "MXKReceiptSendersContainer.h"
 
-#import "MXKImageView.h"
-
 static UIColor* kMoreLabelDefaultcolor;
 
+/**
+ The receipt stacks rendered by all the containers, by stack key.
+ */
+static NSCache<NSString*, UIImage*> *renderedStacks;
+
 @interface MXKReceiptSendersContainer ()
+{
+    /**
+     The layer displaying the rendered stack of avatars. It is reused across refreshes.
+     */
+    CALayer *stackLayer;
+    
+    /**
+     The label reused to display the number of hidden avatars.
+     */
+    UILabel *reusableMoreLabel;
+    
+    /**
+     The alignment of the current receipt senders.
+     */
+    ReadReceiptsAlignment currentAlignment;
+    
+    /**
+     The identifiers of the avatar downloads the current stack is waiting for.
+     */
+    NSMutableSet<NSString*> *pendingDownloadIds;
+    
+    /**
+     Tell whether one of the pending avatars has been downloaded.
+     */
+    BOOL hasDownloadedAvatar;
+}
 
 @property (nonatomic, readwrite) NSArray <MXRoomMember *> *roomMembers;
 @property (nonatomic, readwrite) NSArray <UIImage *> *placeholders;
-@property (nonatomic) MXMediaManager *mediaManager;
 
 @end
 
@@ -37,6 +65,9 @@ static UIColor* kMoreLabelDefaultcolor;
     if (self == [MXKReceiptSendersContainer class])
     {
         kMoreLabelDefaultcolor = [UIColor blackColor];
+        
+        renderedStacks = [[NSCache alloc] init];
+        renderedStacks.totalCostLimit = MXKRECEIPTSENDERSCONTAINER_RENDERED_STACKS_COST_LIMIT;
     }
 }
 
@@ -50,6 +81,15 @@ static UIColor* kMoreLabelDefaultcolor;
         _avatarMargin = 2.0;
         _moreLabel = nil;
         _moreLabelTextColor = kMoreLabelDefaultcolor;
+        
+        stackLayer = [CALayer layer];
+        stackLayer.contentsScale = UIScreen.mainScreen.scale;
+        stackLayer.contentsGravity = kCAGravityResize;
+        // The content is replaced on each refresh, do not animate it
+        stackLayer.actions = @{@"contents": [NSNull null], @"bounds": [NSNull null], @"position": [NSNull null]};
+        [self.layer addSublayer:stackLayer];
+        
+        pendingDownloadIds = [NSMutableSet set];
     }
     return self;
 }
@@ -59,17 +99,12 @@ static UIColor* kMoreLabelDefaultcolor;
     // Store the room members and placeholders for showing in the details view controller
     self.roomMembers = roomMembers;
     self.placeholders = placeHolders;
+    currentAlignment = alignment;
     
-    // Remove all previous content
-    for (UIView* view in self.subviews)
-    {
-        [view removeFromSuperview];
-    }
-    if (_moreLabel)
-    {
-        [_moreLabel removeFromSuperview];
-        _moreLabel = nil;
-    }
+    // Stop waiting for the avatars of the previous stack
+    [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXMediaLoaderStateDidChangeNotification object:nil];
+    [pendingDownloadIds removeAllObjects];
+    hasDownloadedAvatar = NO;
     
     CGRect globalFrame = self.frame;
     CGFloat side = globalFrame.size.height;
@@ -80,46 +115,26 @@ static UIColor* kMoreLabelDefaultcolor;
     maxDisplayableItems = MIN(maxDisplayableItems, _maxDisplayedAvatars);
     count = MIN(roomMembers.count, maxDisplayableItems);
     
-    int index;
-    
     CGFloat xOff = 0;
     
-    if (alignment == ReadReceiptAlignmentRight)
+    // Display the avatars stack
+    if (count && side > 0)
     {
-        xOff = globalFrame.size.width - (side + _avatarMargin);
-    }
-    
-    for (index = 0; index < count; index++)
-    {
-        MXRoomMember *roomMember = [roomMembers objectAtIndex:index];
-        UIImage *preview = index < placeHolders.count ? placeHolders[index] : nil;
+        CGFloat stackWidth = count * side + (count - 1) * _avatarMargin;
+        CGFloat stackX = (alignment == ReadReceiptAlignmentRight) ? globalFrame.size.width - count * (side + _avatarMargin) : 0;
         
-        MXKImageView *imageView = [[MXKImageView alloc] initWithFrame:CGRectMake(xOff, 0, side, side)];
-        imageView.defaultBackgroundColor = [UIColor clearColor];
-        imageView.autoresizingMask = UIViewAutoresizingNone;
+        stackLayer.frame = CGRectMake(stackX, 0, stackWidth, side);
+        stackLayer.contents = (id)[self stackImageWithRoomMembers:roomMembers placeholders:placeHolders count:count side:side alignment:alignment].CGImage;
+        stackLayer.hidden = NO;
         
-        if (alignment == ReadReceiptAlignmentRight)
-        {
-            xOff -= side + _avatarMargin;
-        }
-        else
-        {
-            xOff += side + _avatarMargin;
-        }
-        
-        [self addSubview:imageView];
-        imageView.enableInMemoryCache = YES;
-        
-        [imageView setImageURI:roomMember.avatarUrl
-                      withType:nil
-           andImageOrientation:UIImageOrientationUp
-                 toFitViewSize:CGSizeMake(side, side)
-                    withMethod:MXThumbnailingMethodCrop
-                  previewImage:preview
-                  mediaManager:_mediaManager];
+        xOff = (alignment == ReadReceiptAlignmentRight) ? stackX - (side + _avatarMargin) : count * (side + _avatarMargin);
+    }
+    else
+    {
+        stackLayer.contents = nil;
+        stackLayer.hidden = YES;
         
-        [imageView.layer setCornerRadius:imageView.frame.size.width / 2];
-        imageView.clipsToBounds = YES;
+        xOff = (alignment == ReadReceiptAlignmentRight) ? globalFrame.size.width - (side + _avatarMargin) : 0;
     }
     
     // Check whether there are more than expected read receipts
@@ -133,11 +148,17 @@ static UIColor* kMoreLabelDefaultcolor;
             xOff -= (defaultMoreLabelWidth - side);
         }
         
-        _moreLabel = [[UILabel alloc] initWithFrame:CGRectMake(xOff, 0, defaultMoreLabelWidth, side)];
+        if (!reusableMoreLabel)
+        {
+            reusableMoreLabel = [[UILabel alloc] init];
+            reusableMoreLabel.font = [UIFont systemFontOfSize:11];
+            reusableMoreLabel.adjustsFontSizeToFitWidth = YES;
+            reusableMoreLabel.minimumScaleFactor = 0.6;
+        }
+        
+        _moreLabel = reusableMoreLabel;
+        _moreLabel.frame = CGRectMake(xOff, 0, defaultMoreLabelWidth, side);
         _moreLabel.text = [NSString stringWithFormat:(alignment == ReadReceiptAlignmentRight) ? @"%tu+" : @"+%tu", roomMembers.count - maxDisplayableItems];
-        _moreLabel.font = [UIFont systemFontOfSize:11];
-        _moreLabel.adjustsFontSizeToFitWidth = YES;
-        _moreLabel.minimumScaleFactor = 0.6;
         
         // In case of right alignment, adjust the horizontal position according to the actual label width
         if (alignment == ReadReceiptAlignmentRight)
@@ -152,12 +173,22 @@ static UIColor* kMoreLabelDefaultcolor;
         }
         
         _moreLabel.textColor = self.moreLabelTextColor ?: kMoreLabelDefaultcolor;
-        [self addSubview:_moreLabel];
+        if (_moreLabel.superview != self)
+        {
+            [self addSubview:_moreLabel];
+        }
+    }
+    else if (_moreLabel)
+    {
+        [_moreLabel removeFromSuperview];
+        _moreLabel = nil;
     }
 }
 
 - (void)dealloc
 {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    
     NSArray* subviews = self.subviews;
     for (UIView* view in subviews)
     {
@@ -171,4 +202,174 @@ static UIColor* kMoreLabelDefaultcolor;
     }
 }
 
+#pragma mark - Stack rendering
+
+- (UIImage*)stackImageWithRoomMembers:(NSArray<MXRoomMember*>*)roomMembers
+                         placeholders:(NSArray<UIImage*>*)placeHolders
+                                count:(NSUInteger)count
+                                 side:(CGFloat)side
+                            alignment:(ReadReceiptsAlignment)alignment
+{
+    CGSize avatarSize = CGSizeMake(side, side);
+    
+    // Build the stack key. A stack is cached only once all its avatars are available: the placeholders are drawn
+    // only for the members without avatar, they are identified by these members (user id and display name).
+    NSMutableString *stackKey = [NSMutableString stringWithFormat:@"%.1f|%.1f|%tu", side, _avatarMargin, alignment];
+    for (NSUInteger index = 0; index < count; index++)
+    {
+        MXRoomMember *roomMember = roomMembers[index];
+        if (roomMember.avatarUrl)
+        {
+            [stackKey appendFormat:@"|%@", roomMember.avatarUrl];
+        }
+        else
+        {
+            BOOL hasPreview = index < placeHolders.count && [placeHolders[index] isKindOfClass:UIImage.class];
+            [stackKey appendFormat:@"|%@|%@|%d", roomMember.userId, roomMember.displayname ?: @"", hasPreview];
+        }
+    }
+    
+    UIImage *stackImage = [renderedStacks objectForKey:stackKey];
+    if (stackImage)
+    {
+        return stackImage;
+    }
+    
+    // Retrieve the avatars from the media cache
+    NSMutableArray *avatars = [NSMutableArray arrayWithCapacity:count];
+    BOOL isComplete = YES;
+    for (NSUInteger index = 0; index < count; index++)
+    {
+        UIImage *preview = index < placeHolders.count ? placeHolders[index] : nil;
+        UIImage *avatar = [self avatarWithContentURI:roomMembers[index].avatarUrl size:avatarSize];
+        if (!avatar && roomMembers[index].avatarUrl)
+        {
+            // The stack will be rendered again once this avatar is downloaded
+            isComplete = NO;
+        }
+        [avatars addObject:avatar ?: preview ?: [NSNull null]];
+    }
+    
+    // Render the circular avatars once, instead of clipping each of them at each frame
+    CGFloat margin = _avatarMargin;
+    UIGraphicsImageRendererFormat *format = [UIGraphicsImageRendererFormat preferredFormat];
+    format.opaque = NO;
+    UIGraphicsImageRenderer *renderer = [[UIGraphicsImageRenderer alloc] initWithSize:CGSizeMake(count * side + (count - 1) * margin, side) format:format];
+    stackImage = [renderer imageWithActions:^(UIGraphicsImageRendererContext *rendererContext) {
+        
+        for (NSUInteger index = 0; index < count; index++)
+        {
+            if (![avatars[index] isKindOfClass:UIImage.class])
+            {
+                continue;
+            }
+            
+            // The latest receipt is displayed on the alignment side
+            NSUInteger position = (alignment == ReadReceiptAlignmentRight) ? count - 1 - index : index;
+            CGRect avatarRect = CGRectMake(position * (side + margin), 0, side, side);
+            
+            CGContextSaveGState(rendererContext.CGContext);
+            [[UIBezierPath bezierPathWithOvalInRect:avatarRect] addClip];
+            [self drawAvatar:avatars[index] inRect:avatarRect];
+            CGContextRestoreGState(rendererContext.CGContext);
+        }
+    }];
+    
+    if (isComplete)
+    {
+        NSUInteger cost = CGImageGetBytesPerRow(stackImage.CGImage) * CGImageGetHeight(stackImage.CGImage);
+        [renderedStacks setObject:stackImage forKey:stackKey cost:cost];
+    }
+    
+    return stackImage;
+}
+
+- (void)drawAvatar:(UIImage*)avatar inRect:(CGRect)rect
+{
+    // Fill the rect by keeping the aspect ratio (like UIViewContentModeScaleAspectFill)
+    CGSize imageSize = avatar.size;
+    if (!imageSize.width || !imageSize.height)
+    {
+        return;
+    }
+    
+    CGFloat ratio = MAX(rect.size.width / imageSize.width, rect.size.height / imageSize.height);
+    CGSize drawSize = CGSizeMake(imageSize.width * ratio, imageSize.height * ratio);
+    [avatar drawInRect:CGRectMake(CGRectGetMidX(rect) - drawSize.width / 2, CGRectGetMidY(rect) - drawSize.height / 2, drawSize.width, drawSize.height)];
+}
+
+- (UIImage*)avatarWithContentURI:(NSString*)mxContentURI size:(CGSize)size
+{
+    if (!mxContentURI)
+    {
+        return nil;
+    }
+    
+    // Use the same thumbnail as the one displayed by the sender avatar of the bubble cells (no mime type)
+    NSString *cacheFilePath = [MXMediaManager thumbnailCachePathForMatrixContentURI:mxContentURI
+                                                                           andType:nil
+                                                                          inFolder:nil
+                                                                     toFitViewSize:size
+                                                                        withMethod:MXThumbnailingMethodCrop];
+    UIImage *avatar = [MXMediaManager loadThroughCacheWithFilePath:cacheFilePath];
+    if (avatar)
+    {
+        return avatar;
+    }
+    
+    // Check whether the avatar download is in progress
+    NSString *downloadId = [MXMediaManager thumbnailDownloadIdForMatrixContentURI:mxContentURI
+                                                                         inFolder:nil
+                                                                    toFitViewSize:size
+                                                                       withMethod:MXThumbnailingMethodCrop];
+    MXMediaLoader *loader = [MXMediaManager existingDownloaderWithIdentifier:downloadId];
+    if (!loader && _mediaManager)
+    {
+        loader = [_mediaManager downloadThumbnailFromMatrixContentURI:mxContentURI
+                                                             withType:nil
+                                                             inFolder:nil
+                                                        toFitViewSize:size
+                                                           withMethod:MXThumbnailingMethodCrop
+                                                              success:nil
+                                                              failure:nil];
+    }
+    
+    if (loader && ![pendingDownloadIds containsObject:downloadId])
+    {
+        [pendingDownloadIds addObject:downloadId];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(onMediaLoaderStateDidChange:) name:kMXMediaLoaderStateDidChangeNotification object:loader];
+    }
+    
+    return nil;
+}
+
+- (void)onMediaLoaderStateDidChange:(NSNotification *)notif
+{
+    MXMediaLoader *loader = (MXMediaLoader*)notif.object;
+    switch (loader.state) {
+        case MXMediaLoaderStateDownloadCompleted:
+        case MXMediaLoaderStateDownloadFailed:
+        case MXMediaLoaderStateCancelled:
+        {
+            [[NSNotificationCenter defaultCenter] removeObserver:self name:kMXMediaLoaderStateDidChangeNotification object:loader];
+            
+            if (loader.downloadId && [pendingDownloadIds containsObject:loader.downloadId])
+            {
+                [pendingDownloadIds removeObject:loader.downloadId];
+                hasDownloadedAvatar |= (loader.state == MXMediaLoaderStateDownloadCompleted);
+                
+                // Render the stack again once, when all the pending avatars are handled.
+                // Do not retry the failed downloads forever.
+                if (!pendingDownloadIds.count && hasDownloadedAvatar)
+                {
+                    [self refreshReceiptSenders:_roomMembers withPlaceHolders:_placeholders andAlignment:currentAlignment];
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
 @end
@@ -59,6 +59,9 @@ static BOOL _disableLongPressGestureOnEvent;
 {
     // The list of UIViews used to fix the display of side borders for HTML blockquotes
     NSMutableArray<UIView*> *htmlBlockquoteSideBorderViews;
+    
+    // The receipt senders containers removed from the bubble info container, reused on next render
+    NSMutableArray<MXKReceiptSendersContainer*> *reusableReceiptSendersContainers;
 }
 
 @property (nonatomic, weak) UIView *messageTextBackgroundView;
@@ -271,70 +274,38 @@ static BOOL _disableLongPressGestureOnEvent;
 
  @discussion
  `NSAttributedString` and `UITextView` classes do not support it natively. This
- method add an `UIView` to the `UITextView` that implements this border.
-
- @param canRetry YES if the method can retry later if the UI is not yet ready.
+ method add an `UIView` to the `UITextView` for each border precomputed by the bubble data
+ (see `htmlBlockquoteBorderRects`).
  */
-- (void)fixHTMLBlockQuoteRendering:(BOOL)canRetry
+- (void)renderHTMLBlockquoteBorders
 {
-    if (self.messageTextView && htmlBlockquoteSideBorderViews.count == 0)
+    [self removeHTMLBlockquoteBorders];
+    
+    NSArray<NSValue*> *borderRects = bubbleData.htmlBlockquoteBorderRects;
+    if (self.messageTextView && borderRects.count)
     {
-        __weak typeof(self) weakSelf = self;
-        dispatch_async(dispatch_get_main_queue(), ^{
+        htmlBlockquoteSideBorderViews = [NSMutableArray arrayWithCapacity:borderRects.count];
+        
+        for (NSValue *borderRect in borderRects)
+        {
+            UIView *sideBorderView = [[UIView alloc] initWithFrame:borderRect.CGRectValue];
+            sideBorderView.backgroundColor = bubbleData.eventFormatter.htmlBlockquoteBorderColor;
+            [sideBorderView setTranslatesAutoresizingMaskIntoConstraints:NO];
+            
+            [self.messageTextView addSubview:sideBorderView];
+            [htmlBlockquoteSideBorderViews addObject:sideBorderView];
+        }
+    }
+}
 
-            if (weakSelf)
-            {
-                typeof(self) self = weakSelf;
-                [MXKTools enumerateMarkedBlockquotesInAttributedString:self.messageTextView.attributedText
-                                                            usingBlock:^(NSRange range, BOOL *stop)
-                 {
-                     // Compute the UITextRange of the blockquote
-                     UITextPosition *beginning = self.messageTextView.beginningOfDocument;
-                     UITextPosition *start = [self.messageTextView positionFromPosition:beginning offset:range.location];
-                     UITextPosition *end = [self.messageTextView positionFromPosition:start offset:range.length];
-                     UITextRange *textRange = [self.messageTextView textRangeFromPosition:start toPosition:end];
-
-                     // Get the rect area of this blockquote within the cell
-                     // There can be several rects in case of multilines. Hence, the merge
-                     NSArray<UITextSelectionRect*> *array = [self.messageTextView selectionRectsForRange:textRange];
-                     CGRect textRect = CGRectNull;
-                     for (UITextSelectionRect *rect in array)
-                     {
-                         if (rect.rect.size.width)
-                         {
-                             textRect = CGRectUnion(textRect, rect.rect);
-                         }
-                     }
-
-                     if (!CGRectIsNull(textRect))
-                     {
-                         // Add a left border with a height that covers all the blockquote block height
-                         // TODO: Manage RTL language
-                         UIView *sideBorderView = [[UIView alloc] initWithFrame:CGRectMake(5, textRect.origin.y, 4, textRect.size.height)];
-                         sideBorderView.backgroundColor = self.bubbleData.eventFormatter.htmlBlockquoteBorderColor;
-                         [sideBorderView setTranslatesAutoresizingMaskIntoConstraints:NO];
-                         
-                         [self.messageTextView addSubview:sideBorderView];
-
-                         if (!self->htmlBlockquoteSideBorderViews)
-                         {
-                             self->htmlBlockquoteSideBorderViews = [NSMutableArray array];
-                         }
-
-                         [self->htmlBlockquoteSideBorderViews addObject:sideBorderView];
-                     }
-                     else if (canRetry)
-                     {
-                         // Have not found rect area that corresponds to the blockquote
-                         // Try again later when the UI is more ready. Try it only once
-                         dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.3 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
-                             [self fixHTMLBlockQuoteRendering:NO];
-                         });
-                     }
-                 }];
-            }
-        });
+- (void)removeHTMLBlockquoteBorders
+{
+    for (UIView *sideBorder in htmlBlockquoteSideBorderViews)
+    {
+        [sideBorder removeFromSuperview];
     }
+    [htmlBlockquoteSideBorderViews removeAllObjects];
+    htmlBlockquoteSideBorderViews = nil;
 }
 
 - (void)dealloc
@@ -574,10 +545,8 @@ static BOOL _disableLongPressGestureOnEvent;
             {
                 self.messageTextView.attributedText = newText;
 
-                if (bubbleData.displayFix & MXKRoomBubbleComponentDisplayFixHtmlBlockquote)
-                {
-                    [self fixHTMLBlockQuoteRendering:YES];
-                }
+                // Draw the blockquote borders computed with the content size
+                [self renderHTMLBlockquoteBorders];
             }
             
             // Update msgTextView width constraint to align correctly the text
@@ -602,11 +571,7 @@ static BOOL _disableLongPressGestureOnEvent;
                 // ensure that older subviews are removed
                 // They should be (they are removed when the is not anymore used).
                 // But, it seems that is not always true.
-                NSArray* views = [self.bubbleInfoContainer subviews];
-                for(UIView* view in views)
-                {
-                    [view removeFromSuperview];
-                }
+                [self removeBubbleInfoContainerSubviews];
                 
                 for (MXKRoomBubbleComponent *component in bubbleData.bubbleComponents)
                 {
@@ -700,7 +665,18 @@ static BOOL _disableLongPressGestureOnEvent;
                             
                             if (roomMembers.count)
                             {
-                                MXKReceiptSendersContainer* avatarsContainer = [[MXKReceiptSendersContainer alloc] initWithFrame:CGRectMake(0, component.position.y + timeLabelOffset, self.bubbleInfoContainer.frame.size.width , 15) andMediaManager:bubbleData.mxSession.mediaManager];
+                                CGRect avatarsContainerFrame = CGRectMake(0, component.position.y + timeLabelOffset, self.bubbleInfoContainer.frame.size.width , 15);
+                                MXKReceiptSendersContainer* avatarsContainer = reusableReceiptSendersContainers.lastObject;
+                                if (avatarsContainer)
+                                {
+                                    [reusableReceiptSendersContainers removeLastObject];
+                                    avatarsContainer.frame = avatarsContainerFrame;
+                                    avatarsContainer.mediaManager = bubbleData.mxSession.mediaManager;
+                                }
+                                else
+                                {
+                                    avatarsContainer = [[MXKReceiptSendersContainer alloc] initWithFrame:avatarsContainerFrame andMediaManager:bubbleData.mxSession.mediaManager];
+                                }
                                 
                                 [avatarsContainer refreshReceiptSenders:roomMembers withPlaceHolders:placeholders andAlignment:self.readReceiptsAlignment];
                                 
@@ -956,12 +932,7 @@ static BOOL _disableLongPressGestureOnEvent;
 {
     bubbleData = nil;
 
-    for (UIView *sideBorder in htmlBlockquoteSideBorderViews)
-    {
-        [sideBorder removeFromSuperview];
-    }
-    [htmlBlockquoteSideBorderViews removeAllObjects];
-    htmlBlockquoteSideBorderViews = nil;
+    [self removeHTMLBlockquoteBorders];
 
     if (_attachmentWebView)
     {
@@ -995,12 +966,7 @@ static BOOL _disableLongPressGestureOnEvent;
     // Remove potential dateTime (or unsent) label(s)
     if (self.bubbleInfoContainer && self.bubbleInfoContainer.subviews.count > 0)
     {
-        NSArray* subviews = self.bubbleInfoContainer.subviews;
-             
-        for (UIView *view in subviews)
-        {
-            [view removeFromSuperview];
-        }
+        [self removeBubbleInfoContainerSubviews];
     }
     self.bubbleInfoContainer.hidden = YES;
     
@@ -1130,6 +1096,26 @@ static BOOL _disableLongPressGestureOnEvent;
     [self resetAttachmentViewBottomConstraintConstant];
 }
 
+- (void)removeBubbleInfoContainerSubviews
+{
+    if (!reusableReceiptSendersContainers)
+    {
+        reusableReceiptSendersContainers = [NSMutableArray array];
+    }
+    
+    NSArray* subviews = self.bubbleInfoContainer.subviews;
+    for (UIView *view in subviews)
+    {
+        [view removeFromSuperview];
+        
+        // Keep the receipt senders containers for the next render
+        if ([view isKindOfClass:MXKReceiptSendersContainer.class])
+        {
+            [reusableReceiptSendersContainers addObject:(MXKReceiptSendersContainer*)view];
+        }
+    }
+}
+
 #pragma mark - Attachment progress handling
 
 - (void)updateProgressUI:(NSDictionary*)statisticsDict
@@ -28,6 +28,7 @@
 #import "MXKImageView.h"
 
 #import "MXKTools.h"
+#import "MXKImageSendEncoder.h"
 
 #import "NSBundle+MatrixKit.h"
 #import "MXKConstants.h"
@@ -1093,9 +1094,16 @@ NSString* MXKFileSizes_description(MXKFileSizes sizes)
             }
             else
             {
-                // Suggest compression before sending image
-                NSData *imageData = UIImageJPEGRepresentation(selectedImage, 0.9);
-                [self sendSelectedImage:imageData withMimeType:nil andCompressionMode:MXKRoomInputToolbarCompressionModePrompt isPhotoLibraryAsset:NO];
+                // Suggest compression before sending image.
+                // Encode the camera image in background, its orientation is kept in EXIF metadata.
+                __weak typeof(self) weakSelf = self;
+                [MXKImageSendEncoder encodeImage:selectedImage withThumbnail:NO completion:^(NSData *imageData, CGSize imageSize, UIImage *thumbnail) {
+                    if (weakSelf && imageData)
+                    {
+                        typeof(self) self = weakSelf;
+                        [self sendSelectedImage:imageData withMimeType:nil andCompressionMode:MXKRoomInputToolbarCompressionModePrompt isPhotoLibraryAsset:NO];
+                    }
+                }];
             }
         }
     }
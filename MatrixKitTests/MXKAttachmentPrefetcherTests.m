@@ -0,0 +1,165 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "MatrixKit.h"
+
+@interface MXKAttachmentPrefetcherTests : XCTestCase
+{
+    /**
+     The media files written in the media cache for the tests.
+     */
+    NSMutableArray<NSString*> *fixtureFilePaths;
+}
+
+@end
+
+@implementation MXKAttachmentPrefetcherTests
+
+- (void)setUp
+{
+    [super setUp];
+    fixtureFilePaths = [NSMutableArray array];
+}
+
+- (void)tearDown
+{
+    for (NSString *filePath in fixtureFilePaths)
+    {
+        [[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
+    }
+    [super tearDown];
+}
+
+- (NSData*)pngDataWithSize:(CGSize)size
+{
+    UIGraphicsImageRendererFormat *format = [UIGraphicsImageRendererFormat defaultFormat];
+    format.scale = 1;
+    UIGraphicsImageRenderer *renderer = [[UIGraphicsImageRenderer alloc] initWithSize:size format:format];
+    return [renderer PNGDataWithActions:^(UIGraphicsImageRendererContext *context) {
+        [[UIColor redColor] setFill];
+        [context fillRect:CGRectMake(0, 0, size.width, size.height)];
+    }];
+}
+
+/**
+ Build an image attachment whose media is already in the media cache, so that the tests never reach a homeserver.
+ */
+- (MXKAttachment*)imageAttachmentWithEventId:(NSString*)eventId
+{
+    MXEvent *event = [MXEvent modelFromJSON:@{
+                                              @"event_id": eventId,
+                                              @"room_id": @"!aRoomId:matrix.org",
+                                              @"sender": @"@alice:matrix.org",
+                                              @"type": kMXEventTypeStringRoomMessage,
+                                              @"origin_server_ts": @(1000),
+                                              @"content": @{
+                                                      @"msgtype": kMXMessageTypeImage,
+                                                      @"body": @"image.png",
+                                                      @"url": [NSString stringWithFormat:@"mxc://localhost/%@", [eventId substringFromIndex:1]],
+                                                      @"info": @{@"mimetype": @"image/png"}
+                                                      }
+                                              }];
+    MXMediaManager *mediaManager = [[MXMediaManager alloc] initWithHomeServer:@"http://localhost"];
+    MXKAttachment *attachment = [[MXKAttachment alloc] initWithEvent:event andMediaManager:mediaManager];
+    
+    [[NSFileManager defaultManager] createDirectoryAtPath:attachment.cacheFilePath.stringByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:nil];
+    [[self pngDataWithSize:CGSizeMake(400, 300)] writeToFile:attachment.cacheFilePath atomically:YES];
+    [fixtureFilePaths addObject:attachment.cacheFilePath];
+    
+    return attachment;
+}
+
+- (void)testDecodedImageFitsMaxPixelSize
+{
+    NSData *data = [self pngDataWithSize:CGSizeMake(400, 300)];
+
+    UIImage *image = [MXKAttachmentPrefetcher decodedImageWithData:data maxPixelSize:100];
+    XCTAssertNotNil(image);
+    XCTAssertEqual(CGImageGetWidth(image.CGImage), 100);
+    XCTAssertEqual(CGImageGetHeight(image.CGImage), 75);
+
+    // A smaller image is not upscaled
+    image = [MXKAttachmentPrefetcher decodedImageWithData:data maxPixelSize:1000];
+    XCTAssertEqual(CGImageGetWidth(image.CGImage), 400);
+
+    XCTAssertNil([MXKAttachmentPrefetcher decodedImageWithData:[@"not an image" dataUsingEncoding:NSUTF8StringEncoding] maxPixelSize:100]);
+}
+
+- (void)testMetrics
+{
+    MXKAttachmentPrefetcher *prefetcher = [[MXKAttachmentPrefetcher alloc] initWithMaxPixelSize:100];
+    MXKAttachment *attachment = [self imageAttachmentWithEventId:@"$anEventId"];
+    XCTAssertNotNil(attachment);
+
+    XCTAssertEqual(prefetcher.hitRate, 0);
+    XCTAssertNil([prefetcher decodedImageForAttachment:attachment]);
+    XCTAssertEqual(prefetcher.missCount, 1);
+    XCTAssertEqual(prefetcher.hitCount, 0);
+    XCTAssertEqual(prefetcher.hitRate, 0);
+
+    [prefetcher resetMetrics];
+    XCTAssertEqual(prefetcher.missCount, 0);
+}
+
+- (void)testOnlyTheDisplayLookupsAreCounted
+{
+    MXKAttachmentPrefetcher *prefetcher = [[MXKAttachmentPrefetcher alloc] initWithMaxPixelSize:100];
+    prefetcher.prefetchCount = 1;
+    NSArray<MXKAttachment*> *attachments = @[[self imageAttachmentWithEventId:@"$event0"], [self imageAttachmentWithEventId:@"$event1"]];
+    
+    [prefetcher prefetchAttachments:attachments aroundIndex:0];
+    
+    // Wait for the decoding of the next attachment
+    NSPredicate *isDecoded = [NSPredicate predicateWithBlock:^BOOL(MXKAttachmentPrefetcher *prefetcher, NSDictionary *bindings) {
+        return [prefetcher existingDecodedImageForAttachment:attachments[1]] != nil;
+    }];
+    [self waitForExpectations:@[[[XCTNSPredicateExpectation alloc] initWithPredicate:isDecoded object:prefetcher]] timeout:10];
+    XCTAssertEqual(prefetcher.hitCount + prefetcher.missCount, 0);
+    
+    // The display of the attachment is counted
+    XCTAssertNotNil([prefetcher decodedImageForAttachment:attachments[1]]);
+    XCTAssertEqual(prefetcher.hitCount, 1);
+    XCTAssertEqual(prefetcher.missCount, 0);
+    
+    [prefetcher destroy];
+}
+
+- (void)testCancellationOnDirectionChange
+{
+    MXKAttachmentPrefetcher *prefetcher = [[MXKAttachmentPrefetcher alloc] initWithMaxPixelSize:100];
+    prefetcher.prefetchCount = 1;
+
+    NSMutableArray<MXKAttachment*> *attachments = [NSMutableArray array];
+    for (NSUInteger index = 0; index < 5; index++)
+    {
+        [attachments addObject:[self imageAttachmentWithEventId:[NSString stringWithFormat:@"$event%tu", index]]];
+    }
+
+    // Both sides are prefetched at first, then only the swipe direction
+    [prefetcher prefetchAttachments:attachments aroundIndex:2];
+    [prefetcher prefetchAttachments:attachments aroundIndex:3];
+    XCTAssertEqual(prefetcher.cancelledCount, 1, @"The prefetch of the item 1 must be cancelled");
+
+    // Swipe back
+    [prefetcher prefetchAttachments:attachments aroundIndex:2];
+    XCTAssertEqual(prefetcher.cancelledCount, 3, @"The prefetches of the items 3 and 4 must be cancelled");
+
+    [prefetcher destroy];
+}
+
+@end
@@ -0,0 +1,244 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+
+#import <XCTest/XCTest.h>
+
+#import "MatrixKit.h"
+
+/**
+ Room members built from a list of joined members.
+ */
+@interface MXKCallPeerResolverFakeRoomMembers : MXRoomMembers
+
+@property (nonatomic) NSArray<MXRoomMember*> *fakeJoinedMembers;
+
+@end
+
+@implementation MXKCallPeerResolverFakeRoomMembers
+
+- (NSArray<MXRoomMember *> *)joinedMembers
+{
+    return _fakeJoinedMembers;
+}
+
+- (MXRoomMember *)memberWithUserId:(NSString *)userId
+{
+    for (MXRoomMember *member in _fakeJoinedMembers)
+    {
+        if ([member.userId isEqualToString:userId])
+        {
+            return member;
+        }
+    }
+    return nil;
+}
+
+@end
+
+@interface MXKCallPeerResolverFakeRoomState : MXRoomState
+
+@property (nonatomic) MXKCallPeerResolverFakeRoomMembers *fakeMembers;
+
+@end
+
+@implementation MXKCallPeerResolverFakeRoomState
+
+- (MXRoomMembers *)members
+{
+    return _fakeMembers;
+}
+
+@end
+
+/**
+ A room which returns its state synchronously.
+ */
+@interface MXKCallPeerResolverFakeRoom : MXRoom
+
+@property (nonatomic) MXKCallPeerResolverFakeRoomState *fakeState;
+@property (nonatomic) NSString *fakeDirectUserId;
+@property (nonatomic) NSUInteger stateRequestCount;
+
+@end
+
+@implementation MXKCallPeerResolverFakeRoom
+
+- (void)state:(void (^)(MXRoomState *))onComplete
+{
+    _stateRequestCount++;
+    onComplete(_fakeState);
+}
+
+- (NSString *)directUserId
+{
+    return _fakeDirectUserId;
+}
+
+@end
+
+@interface MXKCallPeerResolverFakeCall : MXCall
+
+@property (nonatomic) MXKCallPeerResolverFakeRoom *fakeRoom;
+@property (nonatomic) NSString *fakeCallerId;
+@property (nonatomic) BOOL fakeIsIncoming;
+
+@end
+
+@implementation MXKCallPeerResolverFakeCall
+
+- (MXRoom *)room
+{
+    return _fakeRoom;
+}
+
+- (NSString *)callerId
+{
+    return _fakeCallerId;
+}
+
+- (BOOL)isIncoming
+{
+    return _fakeIsIncoming;
+}
+
+- (BOOL)isConferenceCall
+{
+    return NO;
+}
+
+@end
+
+@interface MXKCallPeerResolverTests : XCTestCase
+{
+    MXSession *session;
+    MXKCallPeerResolverFakeRoom *room;
+    MXKCallPeerResolverFakeCall *call;
+}
+
+@end
+
+@implementation MXKCallPeerResolverTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    MXCredentials *credentials = [[MXCredentials alloc] initWithHomeServer:@"https://matrix.org" userId:@"@alice:matrix.org" accessToken:@"token"];
+    MXRestClient *restClient = [[MXRestClient alloc] initWithCredentials:credentials andOnUnrecognizedCertificateBlock:nil];
+    session = [[MXSession alloc] initWithMatrixRestClient:restClient];
+
+    room = [[MXKCallPeerResolverFakeRoom alloc] initWithRoomId:@"!room:matrix.org" andMatrixSession:session];
+    room.fakeState = [[MXKCallPeerResolverFakeRoomState alloc] initWithRoomId:room.roomId andMatrixSession:session andDirection:YES];
+    room.fakeState.fakeMembers = [[MXKCallPeerResolverFakeRoomMembers alloc] initWithRoomState:room.fakeState andMatrixSession:session];
+    room.fakeState.fakeMembers.fakeJoinedMembers = @[[self joinedMemberWithUserId:@"@alice:matrix.org" displayname:@"Alice"],
+                                                     [self joinedMemberWithUserId:@"@bob:matrix.org" displayname:@"Bob"]];
+
+    call = [[MXKCallPeerResolverFakeCall alloc] initWithRoomId:room.roomId andCallManager:nil];
+    call.fakeRoom = room;
+    call.fakeCallerId = @"@alice:matrix.org";
+}
+
+- (void)tearDown
+{
+    call = nil;
+    room = nil;
+    session = nil;
+
+    [super tearDown];
+}
+
+- (MXEvent*)memberEventWithUserId:(NSString*)userId displayname:(NSString*)displayname membership:(NSString*)membership
+{
+    return [MXEvent modelFromJSON:@{
+        @"event_id": [NSString stringWithFormat:@"$%@", [[NSUUID UUID] UUIDString]],
+        @"room_id": @"!room:matrix.org",
+        @"type": kMXEventTypeStringRoomMember,
+        @"sender": userId,
+        @"state_key": userId,
+        @"origin_server_ts": @((uint64_t)([[NSDate date] timeIntervalSince1970] * 1000)),
+        @"content": @{@"membership": membership, @"displayname": displayname}
+    }];
+}
+
+- (MXRoomMember*)joinedMemberWithUserId:(NSString*)userId displayname:(NSString*)displayname
+{
+    return [[MXRoomMember alloc] initWithMXEvent:[self memberEventWithUserId:userId displayname:displayname membership:kMXMembershipStringJoin]];
+}
+
+- (MXUser*)resolvePeerWithResolver:(MXKCallPeerResolver*)resolver
+{
+    __block MXUser *resolvedPeer;
+    __block BOOL completed = NO;
+    [resolver resolvePeer:^(MXUser *peer) {
+        resolvedPeer = peer;
+        completed = YES;
+    }];
+    XCTAssertTrue(completed);
+    return resolvedPeer;
+}
+
+- (void)testIncomingCallPeerIsTheCaller
+{
+    call.fakeIsIncoming = YES;
+    call.fakeCallerId = @"@bob:matrix.org";
+    MXKCallPeerResolver *resolver = [[MXKCallPeerResolver alloc] initWithCall:call];
+
+    MXUser *peer = [self resolvePeerWithResolver:resolver];
+    XCTAssertEqual(peer, [session getOrCreateUser:@"@bob:matrix.org"]);
+    XCTAssertEqual(room.stateRequestCount, 0);
+}
+
+- (void)testDirectChatPeerIsTheUserOfTheSession
+{
+    room.fakeDirectUserId = @"@bob:matrix.org";
+    MXKCallPeerResolver *resolver = [[MXKCallPeerResolver alloc] initWithCall:call];
+
+    MXUser *peer = [self resolvePeerWithResolver:resolver];
+    XCTAssertEqual(peer, [session getOrCreateUser:@"@bob:matrix.org"]);
+    XCTAssertTrue(resolver.isResolved);
+}
+
+- (void)testJoinedMemberPeerIsTheUserOfTheSession
+{
+    // Without direct chat user, the peer is found in the joined members. It must have the same type as the other peers.
+    MXKCallPeerResolver *resolver = [[MXKCallPeerResolver alloc] initWithCall:call];
+
+    MXUser *peer = [self resolvePeerWithResolver:resolver];
+    XCTAssertTrue([peer isKindOfClass:MXUser.class]);
+    XCTAssertEqual(peer, [session getOrCreateUser:@"@bob:matrix.org"]);
+}
+
+- (void)testPeerIsResolvedOnce
+{
+    MXKCallPeerResolver *resolver = [[MXKCallPeerResolver alloc] initWithCall:call];
+    MXUser *peer = [self resolvePeerWithResolver:resolver];
+
+    // Another member event does not concern the peer
+    XCTAssertFalse([resolver handleRoomEvent:[self memberEventWithUserId:@"@carol:matrix.org" displayname:@"Carol" membership:kMXMembershipStringJoin]]);
+    XCTAssertEqual([self resolvePeerWithResolver:resolver], peer);
+    XCTAssertEqual(room.stateRequestCount, 1);
+
+    // The peer leaving the room does
+    room.fakeState.fakeMembers.fakeJoinedMembers = @[[self joinedMemberWithUserId:@"@alice:matrix.org" displayname:@"Alice"],
+                                                     [self joinedMemberWithUserId:@"@carol:matrix.org" displayname:@"Carol"]];
+    XCTAssertTrue([resolver handleRoomEvent:[self memberEventWithUserId:@"@bob:matrix.org" displayname:@"Bob" membership:kMXMembershipStringLeave]]);
+    XCTAssertFalse(resolver.isResolved);
+    XCTAssertEqual([self resolvePeerWithResolver:resolver], [session getOrCreateUser:@"@carol:matrix.org"]);
+    XCTAssertEqual(room.stateRequestCount, 2);
+}
+
+@end
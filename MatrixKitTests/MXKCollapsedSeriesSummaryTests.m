@@ -0,0 +1,131 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+
+#import <XCTest/XCTest.h>
+
+#import "MatrixKit.h"
+
+@interface MXKCollapsedSeriesSummaryTests : XCTestCase
+
+@end
+
+@implementation MXKCollapsedSeriesSummaryTests
+
+- (MXEvent*)membershipEventWithSender:(NSString*)sender stateKey:(NSString*)stateKey content:(NSDictionary*)content prevContent:(NSDictionary*)prevContent
+{
+    NSMutableDictionary *JSON = [NSMutableDictionary dictionaryWithDictionary:@{
+                                                                               @"type": kMXEventTypeStringRoomMember,
+                                                                               @"event_id": [NSString stringWithFormat:@"$%@", [[NSUUID UUID] UUIDString]],
+                                                                               @"room_id": @"!room:matrix.org",
+                                                                               @"sender": sender,
+                                                                               @"state_key": stateKey,
+                                                                               @"origin_server_ts": @(1616488993287),
+                                                                               @"content": content
+                                                                               }];
+    if (prevContent)
+    {
+        JSON[@"prev_content"] = prevContent;
+    }
+    return [MXEvent modelFromJSON:JSON];
+}
+
+- (void)testAppendedEventsAreAggregated
+{
+    MXKCollapsedSeriesSummary *summary = [[MXKCollapsedSeriesSummary alloc] init];
+    
+    [summary appendEvent:[self membershipEventWithSender:@"@alice:matrix.org" stateKey:@"@alice:matrix.org" content:@{@"membership": @"join", @"displayname": @"Alice"} prevContent:nil]];
+    [summary appendEvent:[self membershipEventWithSender:@"@bob:matrix.org" stateKey:@"@bob:matrix.org" content:@{@"membership": @"join", @"displayname": @"Bob"} prevContent:nil]];
+    [summary appendEvent:[self membershipEventWithSender:@"@alice:matrix.org" stateKey:@"@alice:matrix.org" content:@{@"membership": @"join", @"displayname": @"Alicia"} prevContent:@{@"membership": @"join", @"displayname": @"Alice"}]];
+    [summary appendEvent:[self membershipEventWithSender:@"@alice:matrix.org" stateKey:@"@bob:matrix.org" content:@{@"membership": @"leave"} prevContent:@{@"membership": @"join", @"displayname": @"Bob"}]];
+    
+    XCTAssertEqual(summary.events.count, 4);
+    XCTAssertEqual(summary.joinCount, 2);
+    XCTAssertEqual(summary.displaynameChangeCount, 1);
+    XCTAssertEqual(summary.kickCount, 1);
+    XCTAssertEqual(summary.leaveCount, 0);
+    XCTAssertEqual(summary.otherEventCount, 0);
+    
+    XCTAssertEqual(summary.memberChanges.count, 2);
+    XCTAssertEqualObjects(summary.memberChanges.firstObject.userId, @"@alice:matrix.org");
+    
+    MXKCollapsedSeriesMemberChanges *alice = [summary memberChangesForUserId:@"@alice:matrix.org"];
+    XCTAssertEqual(alice.joinCount, 1);
+    XCTAssertEqual(alice.displaynameChangeCount, 1);
+    XCTAssertEqualObjects(alice.previousDisplayname, @"Alice");
+    XCTAssertEqualObjects(alice.displayname, @"Alicia");
+    
+    XCTAssertEqual([summary memberChangesForUserId:@"@bob:matrix.org"].kickCount, 1);
+}
+
+- (void)testPrependedEventsKeepTheSeriesOrder
+{
+    MXKCollapsedSeriesSummary *summary = [[MXKCollapsedSeriesSummary alloc] init];
+    
+    MXEvent *rename = [self membershipEventWithSender:@"@alice:matrix.org" stateKey:@"@alice:matrix.org" content:@{@"membership": @"join", @"displayname": @"Alicia"} prevContent:@{@"membership": @"join", @"displayname": @"Alice"}];
+    MXEvent *join = [self membershipEventWithSender:@"@alice:matrix.org" stateKey:@"@alice:matrix.org" content:@{@"membership": @"join", @"displayname": @"Alice"} prevContent:@{@"membership": @"invite", @"displayname": @"Ali"}];
+    
+    // Back pagination: the most recent event comes first
+    [summary prependEvent:rename];
+    [summary prependEvent:join];
+    
+    XCTAssertEqualObjects(summary.events, (@[join, rename]));
+    XCTAssertEqual(summary.joinCount, 1);
+    XCTAssertEqual(summary.displaynameChangeCount, 1);
+    
+    MXKCollapsedSeriesMemberChanges *alice = [summary memberChangesForUserId:@"@alice:matrix.org"];
+    XCTAssertEqualObjects(alice.previousDisplayname, @"Ali");
+    XCTAssertEqualObjects(alice.displayname, @"Alicia");
+}
+
+- (void)testSummaryStringIsBuiltFromTheAggregates
+{
+    MXKCollapsedSeriesSummary *summary = [[MXKCollapsedSeriesSummary alloc] init];
+    
+    [summary appendEvent:[self membershipEventWithSender:@"@alice:matrix.org" stateKey:@"@alice:matrix.org" content:@{@"membership": @"join"} prevContent:nil]];
+    [summary appendEvent:[self membershipEventWithSender:@"@bob:matrix.org" stateKey:@"@bob:matrix.org" content:@{@"membership": @"join"} prevContent:nil]];
+    [summary appendEvent:[self membershipEventWithSender:@"@bob:matrix.org" stateKey:@"@bob:matrix.org" content:@{@"membership": @"leave"} prevContent:@{@"membership": @"join"}]];
+    
+    MXKEventFormatter *eventFormatter = [[MXKEventFormatter alloc] initWithMatrixSession:nil];
+    MXKEventFormatterError error;
+    NSAttributedString *summaryString = [eventFormatter attributedStringFromCollapsedSeriesSummary:summary withRoomState:nil error:&error];
+    
+    XCTAssertEqual(error, MXKEventFormatterErrorNone);
+    XCTAssertEqualObjects(summaryString.string, @"2 joins, 1 leave");
+}
+
+- (void)testLargeSeriesAggregation
+{
+    NSMutableArray<MXEvent*> *events = [NSMutableArray array];
+    for (NSUInteger index = 0; index < 5000; index++)
+    {
+        NSString *userId = [NSString stringWithFormat:@"@user%tu:matrix.org", index % 500];
+        [events addObject:[self membershipEventWithSender:userId stateKey:userId content:@{@"membership": (index % 2) ? @"leave" : @"join"} prevContent:nil]];
+    }
+    
+    [self measureBlock:^{
+        MXKCollapsedSeriesSummary *summary = [[MXKCollapsedSeriesSummary alloc] init];
+        for (MXEvent *event in events)
+        {
+            [summary appendEvent:event];
+        }
+        XCTAssertEqual(summary.joinCount, 2500);
+        XCTAssertEqual(summary.leaveCount, 2500);
+        XCTAssertEqual(summary.memberChanges.count, 500);
+    }];
+}
+
+@end
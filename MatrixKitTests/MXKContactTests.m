@@ -0,0 +1,157 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "MatrixKit.h"
+#import "XCTestCase+MXKTests.h"
+
+/**
+ The number of contacts of the contacts cache benchmarks.
+ */
+#define MXKCONTACTTESTS_BENCHMARK_CONTACTS_COUNT 10000
+
+@interface MXKContactTests : XCTestCase
+
+@end
+
+@implementation MXKContactTests
+
+- (MXKContact*)contactWithThumbnail:(UIImage*)thumbnail
+{
+    return [[MXKContact alloc] initContactWithDisplayName:@"Alice" emails:nil phoneNumbers:nil andThumbnail:thumbnail];
+}
+
+- (NSData*)archivedObject:(id<NSCoding>)object
+{
+    // Archive like MXKContactManager does for its cache
+    NSMutableData *data = [NSMutableData data];
+    NSKeyedArchiver *encoder = [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
+    [encoder encodeObject:object forKey:@"object"];
+    [encoder finishEncoding];
+    return data;
+}
+
+- (id)unarchivedObjectWithData:(NSData*)data
+{
+    NSKeyedUnarchiver *decoder = [[NSKeyedUnarchiver alloc] initForReadingWithData:data];
+    id object = [decoder decodeObjectForKey:@"object"];
+    [decoder finishDecoding];
+    return object;
+}
+
+- (NSData*)archivedThumbnailDataOfContact:(MXKContact*)contact
+{
+    NSMutableData *data = [NSMutableData data];
+    NSKeyedArchiver *encoder = [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
+    [contact encodeWithCoder:encoder];
+    [encoder finishEncoding];
+    
+    NSKeyedUnarchiver *decoder = [[NSKeyedUnarchiver alloc] initForReadingWithData:data];
+    NSData *thumbnailData = [decoder decodeObjectForKey:@"contactThumbnail"];
+    [decoder finishDecoding];
+    return thumbnailData;
+}
+
+#pragma mark - Thumbnail archiving
+
+- (void)testThumbnailBytesArePassedThrough
+{
+    MXKContact *contact = [self contactWithThumbnail:[self mxk_imageWithPixelSize:CGSizeMake(96, 96) orientation:UIImageOrientationUp]];
+    NSData *thumbnailData = [self archivedThumbnailDataOfContact:contact];
+    XCTAssertNotNil(thumbnailData);
+    
+    // The next archivings must write the same bytes, without compressing the image again
+    XCTAssertEqualObjects([self archivedThumbnailDataOfContact:contact], thumbnailData);
+    
+    MXKContact *cachedContact = [self unarchivedObjectWithData:[self archivedObject:contact]];
+    XCTAssertEqualObjects([self archivedThumbnailDataOfContact:cachedContact], thumbnailData);
+    
+    // Displaying the thumbnail must not change the archived bytes
+    XCTAssertNotNil([cachedContact thumbnailWithPreferedSize:CGSizeMake(40, 40)]);
+    XCTAssertEqualObjects([self archivedThumbnailDataOfContact:cachedContact], thumbnailData);
+}
+
+- (void)testThumbnailIsDecodedAtDisplaySize
+{
+    MXKContact *contact = [self contactWithThumbnail:[self mxk_imageWithPixelSize:CGSizeMake(512, 512) orientation:UIImageOrientationUp]];
+    MXKContact *cachedContact = [self unarchivedObjectWithData:[self archivedObject:contact]];
+    
+    UIImage *thumbnail = [cachedContact thumbnailWithPreferedSize:CGSizeMake(40, 40)];
+    XCTAssertNotNil(thumbnail);
+    
+    CGFloat maxPixelSize = 40 * [UIScreen mainScreen].scale;
+    XCTAssertLessThanOrEqual(CGImageGetWidth(thumbnail.CGImage), maxPixelSize);
+    XCTAssertLessThanOrEqual(CGImageGetHeight(thumbnail.CGImage), maxPixelSize);
+    
+    // The loaded thumbnail is returned for a smaller size
+    XCTAssertEqual([cachedContact thumbnailWithPreferedSize:CGSizeMake(20, 20)], thumbnail);
+    
+    // It is decoded again for a larger size
+    UIImage *largerThumbnail = [cachedContact thumbnailWithPreferedSize:CGSizeMake(128, 128)];
+    XCTAssertGreaterThan(CGImageGetWidth(largerThumbnail.CGImage), CGImageGetWidth(thumbnail.CGImage));
+}
+
+- (void)testThumbnailIsNotLostBeforeLayout
+{
+    MXKContact *contact = [self contactWithThumbnail:[self mxk_imageWithPixelSize:CGSizeMake(96, 96) orientation:UIImageOrientationUp]];
+    MXKContact *cachedContact = [self unarchivedObjectWithData:[self archivedObject:contact]];
+    
+    // A view which is not laid out yet requests a zero size
+    XCTAssertNil([cachedContact thumbnailWithPreferedSize:CGSizeZero]);
+    XCTAssertNotNil([cachedContact thumbnailWithPreferedSize:CGSizeMake(40, 40)]);
+}
+
+#pragma mark - Benchmarks
+
+- (NSDictionary<NSString*, MXKContact*>*)benchmarkContactsCache
+{
+    // Use a distinct image per contact to not benefit from any caching
+    NSMutableDictionary<NSString*, MXKContact*> *contactsByContactID = [NSMutableDictionary dictionary];
+    for (NSUInteger index = 0; index < MXKCONTACTTESTS_BENCHMARK_CONTACTS_COUNT; index++)
+    {
+        @autoreleasepool
+        {
+            CGFloat side = 64 + (index % 64);
+            MXKContact *contact = [self contactWithThumbnail:[self mxk_imageWithPixelSize:CGSizeMake(side, side) orientation:UIImageOrientationUp]];
+            contactsByContactID[contact.contactID] = contact;
+        }
+    }
+    
+    // Load them like the contacts read from the cache at startup
+    return [self unarchivedObjectWithData:[self archivedObject:contactsByContactID]];
+}
+
+- (void)testContactsCacheSavePerformance
+{
+    NSDictionary<NSString*, MXKContact*> *contactsByContactID = [self benchmarkContactsCache];
+    
+    [self mxk_measureClockAndMemoryOfBlock:^{
+        [self archivedObject:contactsByContactID];
+    }];
+}
+
+- (void)testContactsCacheLoadPerformance
+{
+    NSData *cacheData = [self archivedObject:[self benchmarkContactsCache]];
+    
+    [self mxk_measureClockAndMemoryOfBlock:^{
+        NSDictionary<NSString*, MXKContact*> *contactsByContactID = [self unarchivedObjectWithData:cacheData];
+        XCTAssertEqual(contactsByContactID.count, MXKCONTACTTESTS_BENCHMARK_CONTACTS_COUNT);
+    }];
+}
+
+@end
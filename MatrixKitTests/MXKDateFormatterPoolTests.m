@@ -0,0 +1,233 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+
+#import <XCTest/XCTest.h>
+
+#import "MatrixKit.h"
+
+/**
+ An event formatter which customizes its date formatter, like the applications do.
+ */
+@interface MXKCustomDateEventFormatter : MXKEventFormatter
+
+@property (nonatomic, readonly) NSDateFormatter *customizedDateFormatter;
+@property (nonatomic, readonly) NSDateFormatter *customizedTimeFormatter;
+
+@end
+
+@implementation MXKCustomDateEventFormatter
+
+- (void)initDateTimeFormatters
+{
+    [super initDateTimeFormatters];
+    dateFormatter.dateFormat = @"yyyy-MM-dd";
+    timeFormatter.dateFormat = @"HH:mm";
+}
+
+- (NSDateFormatter *)customizedDateFormatter
+{
+    return dateFormatter;
+}
+
+- (NSDateFormatter *)customizedTimeFormatter
+{
+    return timeFormatter;
+}
+
+@end
+
+@interface MXKDateFormatterPoolTests : XCTestCase
+{
+    MXKDateFormatterPool *pool;
+    NSLocale *locale;
+}
+
+@end
+
+@implementation MXKDateFormatterPoolTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+    pool = [[MXKDateFormatterPool alloc] init];
+    locale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US"];
+}
+
+- (void)tearDown
+{
+    pool = nil;
+    
+    [super tearDown];
+}
+
+- (void)testFormattersAreShared
+{
+    NSDateFormatter *formatter = [pool dateFormatterWithDateFormat:@"MMM dd" locale:locale];
+    
+    XCTAssertEqual([pool dateFormatterWithDateFormat:@"MMM dd" locale:locale], formatter);
+    XCTAssertEqualObjects(formatter.dateFormat, @"MMM dd");
+    XCTAssertEqualObjects(formatter.locale.localeIdentifier, @"en_US");
+    
+    // Another format or locale gets another formatter
+    XCTAssertNotEqual([pool dateFormatterWithDateFormat:@"MMM d" locale:locale], formatter);
+    XCTAssertNotEqual([pool dateFormatterWithDateFormat:@"MMM dd" locale:[[NSLocale alloc] initWithLocaleIdentifier:@"fr_FR"]], formatter);
+    
+    NSDateFormatter *styleFormatter = [pool dateFormatterWithDateStyle:NSDateFormatterShortStyle timeStyle:NSDateFormatterShortStyle locale:locale];
+    XCTAssertEqual([pool dateFormatterWithDateStyle:NSDateFormatterShortStyle timeStyle:NSDateFormatterShortStyle locale:locale], styleFormatter);
+    XCTAssertNotEqual([pool dateFormatterWithDateStyle:NSDateFormatterNoStyle timeStyle:NSDateFormatterShortStyle locale:locale], styleFormatter);
+}
+
+- (void)testInvalidate
+{
+    NSDateFormatter *formatter = [pool dateFormatterWithTemplate:@"EEEE" locale:locale];
+    
+    [[NSNotificationCenter defaultCenter] postNotificationName:NSCurrentLocaleDidChangeNotification object:nil];
+    
+    NSDateFormatter *newFormatter = [pool dateFormatterWithTemplate:@"EEEE" locale:locale];
+    XCTAssertNotEqual(newFormatter, formatter);
+    XCTAssertEqualObjects(newFormatter.dateFormat, formatter.dateFormat);
+}
+
+- (void)testDayStrings
+{
+    NSDateFormatter *formatter = [pool dateFormatterWithDateFormat:@"MMM dd" locale:locale];
+    NSDate *date = [NSDate dateWithTimeIntervalSince1970:1600000000];
+    
+    // The cached strings must match the formatter output for all the times of a day
+    for (NSTimeInterval offset = 0; offset < 2 * 86400; offset += 1800)
+    {
+        NSDate *otherDate = [date dateByAddingTimeInterval:offset];
+        XCTAssertEqualObjects([pool dayStringFromDate:otherDate withDayFormatter:formatter], [formatter stringFromDate:otherDate]);
+    }
+}
+
+- (void)testRelativeDayStrings
+{
+    NSDate *now = [NSDate date];
+    NSCalendar *calendar = [NSCalendar currentCalendar];
+    
+    NSDateFormatter *relativeFormatter = [[NSDateFormatter alloc] init];
+    relativeFormatter.locale = [MXKDateFormatterPool applicationLocale];
+    relativeFormatter.dateStyle = NSDateFormatterMediumStyle;
+    relativeFormatter.doesRelativeDateFormatting = YES;
+    
+    XCTAssertEqualObjects([pool relativeDayStringFromDate:now], [relativeFormatter stringFromDate:now]);
+    
+    NSDate *yesterday = [calendar dateByAddingUnit:NSCalendarUnitDay value:-1 toDate:now options:0];
+    XCTAssertEqualObjects([pool relativeDayStringFromDate:yesterday], [relativeFormatter stringFromDate:yesterday]);
+    
+    NSDate *lastWeek = [calendar dateByAddingUnit:NSCalendarUnitDay value:-3 toDate:now options:0];
+    NSDateFormatter *weekdayFormatter = [[NSDateFormatter alloc] init];
+    weekdayFormatter.locale = [MXKDateFormatterPool applicationLocale];
+    weekdayFormatter.dateFormat = [NSDateFormatter dateFormatFromTemplate:@"EEEE" options:0 locale:weekdayFormatter.locale];
+    XCTAssertEqualObjects([pool relativeDayStringFromDate:lastWeek], [weekdayFormatter stringFromDate:lastWeek]);
+}
+
+- (void)testEventFormatterDateStrings
+{
+    MXKEventFormatter *eventFormatter = [[MXKEventFormatter alloc] initWithMatrixSession:nil];
+    NSDate *date = [NSDate dateWithTimeIntervalSince1970:1600000000];
+    
+    NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+    formatter.locale = [MXKDateFormatterPool applicationLocale];
+    formatter.dateFormat = MXKEVENTFORMATTER_DEFAULT_DATE_FORMAT;
+    
+    XCTAssertEqualObjects([eventFormatter dateStringFromDate:date withTime:NO], [formatter stringFromDate:date]);
+    XCTAssertEqualObjects([eventFormatter dateStringFromDate:[date dateByAddingTimeInterval:60] withTime:NO], [formatter stringFromDate:date]);
+}
+
+- (void)testEventFormatterCustomizationIsPrivate
+{
+    MXKCustomDateEventFormatter *customFormatter = [[MXKCustomDateEventFormatter alloc] initWithMatrixSession:nil];
+    MXKEventFormatter *eventFormatter = [[MXKEventFormatter alloc] initWithMatrixSession:nil];
+    NSDate *date = [NSDate dateWithTimeIntervalSince1970:1600000000];
+    
+    NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+    formatter.locale = [MXKDateFormatterPool applicationLocale];
+    formatter.dateFormat = MXKEVENTFORMATTER_DEFAULT_DATE_FORMAT;
+    
+    // The expected strings depend on the time zone of the formatters
+    NSDateFormatter *customDateFormatter = [[NSDateFormatter alloc] init];
+    customDateFormatter.locale = customFormatter.customizedDateFormatter.locale;
+    customDateFormatter.timeZone = customFormatter.customizedDateFormatter.timeZone;
+    customDateFormatter.dateFormat = @"yyyy-MM-dd";
+    
+    NSDateFormatter *customTimeFormatter = [[NSDateFormatter alloc] init];
+    customTimeFormatter.locale = customFormatter.customizedTimeFormatter.locale;
+    customTimeFormatter.timeZone = customFormatter.customizedTimeFormatter.timeZone;
+    customTimeFormatter.dateFormat = @"HH:mm";
+    
+    NSDateFormatter *timeFormatter = [[NSDateFormatter alloc] init];
+    timeFormatter.dateStyle = NSDateFormatterNoStyle;
+    timeFormatter.timeStyle = NSDateFormatterShortStyle;
+    
+    // The customization of a formatter does not alter the shared formatters, nor the cached day strings
+    XCTAssertEqualObjects([customFormatter dateStringFromDate:date withTime:NO], [customDateFormatter stringFromDate:date]);
+    XCTAssertEqualObjects([customFormatter timeStringFromDate:date], [customTimeFormatter stringFromDate:date]);
+    XCTAssertEqualObjects([eventFormatter dateStringFromDate:date withTime:NO], [formatter stringFromDate:date]);
+    XCTAssertEqualObjects([eventFormatter timeStringFromDate:date], [timeFormatter stringFromDate:date].lowercaseString);
+    XCTAssertEqualObjects([MXKDateFormatterPool.sharedPool dateFormatterWithDateFormat:MXKEVENTFORMATTER_DEFAULT_DATE_FORMAT locale:[MXKDateFormatterPool applicationLocale]].dateFormat, MXKEVENTFORMATTER_DEFAULT_DATE_FORMAT);
+    XCTAssertEqualObjects([MXKDateFormatterPool.sharedPool dateFormatterWithDateStyle:NSDateFormatterNoStyle timeStyle:NSDateFormatterShortStyle locale:nil].dateFormat, timeFormatter.dateFormat);
+}
+
+- (void)testEventFormatterFollowsInvalidation
+{
+    MXKCustomDateEventFormatter *customFormatter = [[MXKCustomDateEventFormatter alloc] initWithMatrixSession:nil];
+    NSDateFormatter *previousFormatter = customFormatter.customizedDateFormatter;
+    
+    [[MXKDateFormatterPool sharedPool] invalidate];
+    
+    // The formatters are initialised again, with the customization
+    XCTAssertNotEqual(customFormatter.customizedDateFormatter, previousFormatter);
+    XCTAssertEqualObjects(customFormatter.customizedDateFormatter.dateFormat, @"yyyy-MM-dd");
+    XCTAssertEqualObjects(customFormatter.customizedTimeFormatter.dateFormat, @"HH:mm");
+}
+
+#pragma mark - Performance
+
+- (void)testPooledDateStringsPerformance
+{
+    MXKEventFormatter *eventFormatter = [[MXKEventFormatter alloc] initWithMatrixSession:nil];
+    NSDate *date = [NSDate dateWithTimeIntervalSince1970:1600000000];
+    
+    // A timeline of 1000 events, one per minute
+    [self measureBlock:^{
+        for (NSUInteger index = 0; index < 1000; index++)
+        {
+            [eventFormatter dateStringFromDate:[date dateByAddingTimeInterval:index * 60] withTime:NO];
+        }
+    }];
+}
+
+- (void)testAllocatedDateStringsPerformance
+{
+    NSDate *date = [NSDate dateWithTimeIntervalSince1970:1600000000];
+    
+    // The same timeline with a formatter per string, as the views used to do
+    [self measureBlock:^{
+        for (NSUInteger index = 0; index < 1000; index++)
+        {
+            NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+            formatter.locale = [MXKDateFormatterPool applicationLocale];
+            formatter.dateFormat = MXKEVENTFORMATTER_DEFAULT_DATE_FORMAT;
+            [formatter stringFromDate:[date dateByAddingTimeInterval:index * 60]];
+        }
+    }];
+}
+
+@end
@@ -19,9 +19,29 @@
 
 #import "MatrixKit.h"
 #import "MXKEventFormatter+Tests.h"
+#import "MXKSwiftHeader.h"
 
 @import DTCoreText;
 
+/**
+ A Markdown renderer which counts its conversions.
+ */
+@interface MXKCountingMarkdownRenderer : NSObject <MarkdownToHTMLRendererProtocol>
+
+@property (nonatomic) NSUInteger renderCount;
+
+@end
+
+@implementation MXKCountingMarkdownRenderer
+
+- (NSString *)renderToHTMLWithMarkdown:(NSString *)markdown
+{
+    self.renderCount++;
+    return [[MarkdownToHTMLRendererHardBreaks new] renderToHTMLWithMarkdown:markdown];
+}
+
+@end
+
 @interface MXEventFormatterTests : XCTestCase
 {
     MXKEventFormatter *eventFormatter;
@@ -350,6 +370,442 @@
     XCTAssert(!openParagraphExists && !closeParagraphExists, "The html must not contain any opening or closing paragraph tags.");
 }
 
+- (NSArray<NSString*>*)markdownFreeCorpus
+{
+    return @[
+        @"Hello",
+        @"See you tomorrow at 10:30, ok?",
+        @"It costs 5 euros (or 6 dollars).",
+        @"2021 was a long year",
+        @"https://matrix.org/docs/spec",
+        @"Ça marche 👍",
+        @"@alice:matrix.org can you check it?"
+        ];
+}
+
+- (NSArray<NSString*>*)markdownCorpus
+{
+    return @[
+        @"**bold** text",
+        @"some _emphasis_",
+        @"`code`",
+        @"[a link](https://matrix.org)",
+        @"a < b & c",
+        @"Line One.\nLine Two.",
+        @"# Title",
+        @"- item",
+        @"1. first",
+        @"3) third",
+        @"    indented code",
+        @"trailing space "
+        ];
+}
+
+- (void)testMarkdownFreeStrings
+{
+    id<MarkdownToHTMLRendererProtocol> renderer = [MarkdownToHTMLRendererHardBreaks new];
+    
+    for (NSString *string in self.markdownFreeCorpus)
+    {
+        XCTAssertTrue([MXKEventFormatter isMarkdownFreeString:string], @"%@", string);
+        
+        // The parser would have rendered the same paragraph
+        NSString *html = [renderer renderToHTMLWithMarkdown:string];
+        XCTAssertEqualObjects(html, ([NSString stringWithFormat:@"<p>%@</p>\n", string]));
+        XCTAssertEqualObjects([eventFormatter htmlStringFromMarkdownString:string], string);
+    }
+    
+    for (NSString *string in self.markdownCorpus)
+    {
+        XCTAssertFalse([MXKEventFormatter isMarkdownFreeString:string], @"%@", string);
+        XCTAssertNotEqualObjects([eventFormatter htmlStringFromMarkdownString:string], string);
+    }
+}
+
+- (void)testMarkdownConversionIsMemoized
+{
+    MXKCountingMarkdownRenderer *renderer = [MXKCountingMarkdownRenderer new];
+    eventFormatter.markdownToHTMLRenderer = renderer;
+    
+    NSString *html = [eventFormatter htmlStringFromMarkdownString:@"**bold**"];
+    XCTAssertEqualObjects(html, @"<strong>bold</strong>");
+    XCTAssertEqualObjects([eventFormatter htmlStringFromMarkdownString:@"**bold**"], html);
+    XCTAssertEqual(renderer.renderCount, 1);
+    
+    // The strings without Markdown do not reach the parser
+    [eventFormatter htmlStringFromMarkdownString:@"Hello"];
+    XCTAssertEqual(renderer.renderCount, 1);
+    
+    // A new renderer does not reuse the previous conversions
+    MXKCountingMarkdownRenderer *otherRenderer = [MXKCountingMarkdownRenderer new];
+    eventFormatter.markdownToHTMLRenderer = otherRenderer;
+    [eventFormatter htmlStringFromMarkdownString:@"**bold**"];
+    XCTAssertEqual(otherRenderer.renderCount, 1);
+}
+
+- (void)testMarkdownConversionOfMutableString
+{
+    MXKCountingMarkdownRenderer *renderer = [MXKCountingMarkdownRenderer new];
+    eventFormatter.markdownToHTMLRenderer = renderer;
+    
+    NSMutableString *string = [NSMutableString stringWithString:@"**bold**"];
+    [eventFormatter htmlStringFromMarkdownString:string];
+    [string setString:@"**other**"];
+    
+    // The cached conversion is still found with the original text
+    XCTAssertEqualObjects([eventFormatter htmlStringFromMarkdownString:@"**bold**"], @"<strong>bold</strong>");
+    XCTAssertEqual(renderer.renderCount, 1);
+}
+
+- (void)testMarkdownConversionInBackgroundUsesTheRendererOfTheRequest
+{
+    MXKCountingMarkdownRenderer *renderer = [MXKCountingMarkdownRenderer new];
+    eventFormatter.markdownToHTMLRenderer = renderer;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Conversion"];
+    
+    [eventFormatter htmlStringFromMarkdownString:@"**bold**" onComplete:^(NSString *htmlString) {
+        [expectation fulfill];
+    }];
+    
+    // Replace the renderer while the conversion is pending
+    MXKCountingMarkdownRenderer *otherRenderer = [MXKCountingMarkdownRenderer new];
+    eventFormatter.markdownToHTMLRenderer = otherRenderer;
+    
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    XCTAssertEqual(renderer.renderCount, 1);
+    
+    // The conversion of the previous renderer is not reused
+    [eventFormatter htmlStringFromMarkdownString:@"**bold**"];
+    XCTAssertEqual(otherRenderer.renderCount, 1);
+}
+
+- (void)testMarkdownConversionInBackground
+{
+    NSArray<NSString*> *strings = @[@"**first**", @"second", @"_third_"];
+    NSMutableArray<NSString*> *htmlStrings = [NSMutableArray array];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Conversions"];
+    
+    for (NSString *string in strings)
+    {
+        [eventFormatter htmlStringFromMarkdownString:string onComplete:^(NSString *htmlString) {
+            
+            XCTAssertTrue([NSThread isMainThread]);
+            [htmlStrings addObject:htmlString];
+            
+            if (htmlStrings.count == strings.count)
+            {
+                [expectation fulfill];
+            }
+        }];
+    }
+    
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    
+    // The completions are called in the order of the requests
+    XCTAssertEqualObjects(htmlStrings, (@[@"<strong>first</strong>", @"second", @"<em>third</em>"]));
+}
+
+- (void)testMarkdownConversionPerformance
+{
+    // A composer corpus: mostly plain messages, some Markdown
+    NSMutableArray<NSString*> *corpus = [NSMutableArray array];
+    for (NSUInteger index = 0; index < 100; index++)
+    {
+        [corpus addObjectsFromArray:self.markdownFreeCorpus];
+        [corpus addObjectsFromArray:[self.markdownCorpus subarrayWithRange:NSMakeRange(0, 3)]];
+    }
+    
+    __block NSUInteger counter = 0;
+    [self measureBlock:^{
+        
+        // Make the strings unique, so that the conversions are not memoized
+        for (NSString *string in corpus)
+        {
+            [self->eventFormatter htmlStringFromMarkdownString:[NSString stringWithFormat:@"%@ %tu", string, counter++]];
+        }
+    }];
+}
+
+#pragma mark - Simple HTML rendering
+
+- (NSArray<NSString*>*)simpleHTMLCorpus
+{
+    return @[
+        @"Hello <b>world</b>!",
+        @"<strong>Bold</strong>, <em>italic</em> and <i><b>both</b></i>",
+        @"Some <code>inline code</code> in a sentence",
+        @"<u>underlined</u> <del>deleted</del> <strike>striked</strike>",
+        @"This text contains a <a href=\"https://www.matrix.org/\">link</a>.",
+        @"<a href=\"https://matrix.to/#/@alice:matrix.org\">Alice</a>: hi",
+        @"Line One.<br />Line Two.<br>Line Three.",
+        @"<p>First paragraph</p>\n<p>Second <b>paragraph</b></p>",
+        @"Tom &amp; Jerry &lt;3 &quot;cheese&quot; &#x1F600; &#39;",
+        @"  Spaces\n\n  are   collapsed  ",
+        @"<b>Nested <a href=\"https://matrix.org\">link <i>in</i> bold</a></b> text"
+    ];
+}
+
+- (void)testSimpleHTMLRenderingEquivalence
+{
+    for (NSString *html in [self simpleHTMLCorpus])
+    {
+        // Given the rendering of DTCoreText
+        eventFormatter.simpleHTMLRenderingEnabled = NO;
+        NSAttributedString *expected = [eventFormatter renderHTMLString:html forEvent:anEvent withRoomState:nil];
+        
+        // When rendering with the simple HTML renderer
+        eventFormatter.simpleHTMLRenderingEnabled = YES;
+        NSAttributedString *actual = [eventFormatter renderHTMLString:html forEvent:anEvent withRoomState:nil];
+        
+        // Then the text and the main attributes must be the same
+        XCTAssertEqualObjects(actual.string, expected.string, @"Unexpected text for %@", html);
+        if (![actual.string isEqualToString:expected.string])
+        {
+            continue;
+        }
+        
+        for (NSUInteger index = 0; index < expected.length; index++)
+        {
+            NSDictionary *expectedAttributes = [expected attributesAtIndex:index effectiveRange:nil];
+            NSDictionary *actualAttributes = [actual attributesAtIndex:index effectiveRange:nil];
+            
+            for (NSAttributedStringKey key in @[NSFontAttributeName, NSForegroundColorAttributeName, NSBackgroundColorAttributeName, NSLinkAttributeName, NSUnderlineStyleAttributeName, NSStrikethroughStyleAttributeName])
+            {
+                XCTAssertEqualObjects(actualAttributes[key], expectedAttributes[key], @"Unexpected %@ at %tu for %@", key, index, html);
+            }
+        }
+    }
+}
+
+- (void)testSimpleHTMLRendererFallback
+{
+    NSSet<NSString*> *allowedTags = [NSSet setWithArray:eventFormatter.allowedHTMLTags];
+    NSDictionary* (^styleProvider)(NSArray<NSString*> *) = ^NSDictionary *(NSArray<NSString *> *tagStack) {
+        return @{};
+    };
+    
+    // Supported HTML strings are rendered
+    XCTAssertNotNil([MXKSimpleHTMLRenderer attributedStringFromHTMLString:@"<b>bold</b>" allowedTags:allowedTags styleProvider:styleProvider]);
+    
+    // Others are not: unsupported tags, attributes, entities, misnested tags, white spaces in code, not allowed tags
+    NSArray<NSString*> *unsupportedHTMLStrings = @[
+        @"<h1>Header</h1>",
+        @"<mx-reply><blockquote>quote</blockquote></mx-reply>reply",
+        @"<p style=\"color: red\">red</p>",
+        @"&hellip;",
+        @"<b><i>misnested</b></i>",
+        @"<b>unclosed",
+        @"<code>a\nb</code>",
+        @"<!-- comment -->"
+    ];
+    for (NSString *html in unsupportedHTMLStrings)
+    {
+        XCTAssertNil([MXKSimpleHTMLRenderer attributedStringFromHTMLString:html allowedTags:allowedTags styleProvider:styleProvider], @"%@ must not be rendered", html);
+    }
+    
+    XCTAssertNil([MXKSimpleHTMLRenderer attributedStringFromHTMLString:@"<b>bold</b>" allowedTags:[NSSet setWithObject:@"i"] styleProvider:styleProvider]);
+}
+
+- (void)testSimpleHTMLRenderingPerformance
+{
+    NSArray<NSString*> *corpus = [self simpleHTMLCorpus];
+    
+    // Warm up the styles cache
+    for (NSString *html in corpus)
+    {
+        [eventFormatter renderHTMLString:html forEvent:anEvent withRoomState:nil];
+    }
+    
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 20; i++)
+        {
+            for (NSString *html in corpus)
+            {
+                [self->eventFormatter renderHTMLString:html forEvent:self->anEvent withRoomState:nil];
+            }
+        }
+    }];
+}
+
+- (void)testDTCoreTextHTMLRenderingPerformance
+{
+    NSArray<NSString*> *corpus = [self simpleHTMLCorpus];
+    eventFormatter.simpleHTMLRenderingEnabled = NO;
+    
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 20; i++)
+        {
+            for (NSString *html in corpus)
+            {
+                [self->eventFormatter renderHTMLString:html forEvent:self->anEvent withRoomState:nil];
+            }
+        }
+    }];
+}
+
+#pragma mark - State events string cache
+
+- (MXEvent*)membershipEventWithSender:(NSString*)sender content:(NSDictionary*)content prevContent:(NSDictionary*)prevContent
+{
+    MXEvent *event = [[MXEvent alloc] init];
+    event.roomId = @"aRoomId";
+    event.eventId = [NSString stringWithFormat:@"$%@", [[NSUUID UUID] UUIDString]];
+    event.sender = sender;
+    event.stateKey = sender;
+    event.wireType = kMXEventTypeStringRoomMember;
+    event.originServerTs = (uint64_t) ([[NSDate date] timeIntervalSince1970] * 1000);
+    event.wireContent = content;
+    event.prevContent = prevContent;
+    return event;
+}
+
+- (NSArray<MXEvent*>*)stateHeavyTimeline
+{
+    // 200 users joining, changing their avatar, leaving and joining again 5 times
+    NSMutableArray<MXEvent*> *events = [NSMutableArray array];
+    for (NSUInteger round = 0; round < 5; round++)
+    {
+        for (NSUInteger index = 0; index < 200; index++)
+        {
+            NSString *userId = [NSString stringWithFormat:@"@user%tu:matrix.org", index];
+            NSString *displayname = [NSString stringWithFormat:@"User %tu", index];
+            NSDictionary *joined = @{@"membership": @"join", @"displayname": displayname};
+            NSDictionary *joinedWithAvatar = @{@"membership": @"join", @"displayname": displayname, @"avatar_url": @"mxc://matrix.org/avatar"};
+            
+            [events addObject:[self membershipEventWithSender:userId content:joined prevContent:@{@"membership": @"leave"}]];
+            [events addObject:[self membershipEventWithSender:userId content:joinedWithAvatar prevContent:joined]];
+            [events addObject:[self membershipEventWithSender:userId content:@{@"membership": @"leave"} prevContent:joinedWithAvatar]];
+        }
+    }
+    return events;
+}
+
+- (void)testStringCacheReusesIdenticalTransitions
+{
+    MXKEventFormatter *uncachedFormatter = [[MXKEventFormatter alloc] initWithMatrixSession:nil];
+    uncachedFormatter.stringCacheEnabled = NO;
+    
+    MXKEventFormatterError error;
+    NSDictionary *content = @{@"membership": @"join", @"displayname": @"Alice"};
+    MXEvent *join = [self membershipEventWithSender:@"@alice:matrix.org" content:content prevContent:nil];
+    MXEvent *rejoin = [self membershipEventWithSender:@"@alice:matrix.org" content:content prevContent:nil];
+    MXEvent *otherJoin = [self membershipEventWithSender:@"@bob:matrix.org" content:@{@"membership": @"join", @"displayname": @"Bob"} prevContent:nil];
+    
+    NSString *joinString = [eventFormatter attributedStringFromEvent:join withRoomState:nil error:&error].string;
+    XCTAssertEqual(eventFormatter.stringCacheMissCount, 1);
+    
+    // The same transition is formatted from the cache
+    NSString *rejoinString = [eventFormatter attributedStringFromEvent:rejoin withRoomState:nil error:&error].string;
+    XCTAssertEqual(error, MXKEventFormatterErrorNone);
+    XCTAssertEqual(eventFormatter.stringCacheHitCount, 1);
+    XCTAssertEqualObjects(rejoinString, joinString);
+    XCTAssertEqualObjects(rejoinString, [uncachedFormatter attributedStringFromEvent:rejoin withRoomState:nil error:&error].string);
+    
+    // So is the same transition of another user, with the name of this user
+    NSString *otherJoinString = [eventFormatter attributedStringFromEvent:otherJoin withRoomState:nil error:&error].string;
+    XCTAssertEqual(eventFormatter.stringCacheHitCount, 2);
+    XCTAssertEqualObjects(otherJoinString, [uncachedFormatter attributedStringFromEvent:otherJoin withRoomState:nil error:&error].string);
+    XCTAssertTrue([otherJoinString containsString:@"Bob"]);
+    XCTAssertFalse([otherJoinString containsString:@"Alice"]);
+    
+    // Another transition is not
+    MXEvent *leave = [self membershipEventWithSender:@"@bob:matrix.org" content:@{@"membership": @"leave"} prevContent:@{@"membership": @"join", @"displayname": @"Bob"}];
+    NSString *leaveString = [eventFormatter attributedStringFromEvent:leave withRoomState:nil error:&error].string;
+    XCTAssertEqual(eventFormatter.stringCacheMissCount, 2);
+    XCTAssertEqualObjects(leaveString, [uncachedFormatter attributedStringFromEvent:leave withRoomState:nil error:&error].string);
+    
+    [eventFormatter resetStringCache];
+    XCTAssertEqual(eventFormatter.stringCacheHitRate, 0);
+    [eventFormatter attributedStringFromEvent:rejoin withRoomState:nil error:&error];
+    XCTAssertEqual(eventFormatter.stringCacheMissCount, 1);
+}
+
+- (void)testStringCacheSubstitutesTheNamesOfEachEvent
+{
+    MXKEventFormatter *uncachedFormatter = [[MXKEventFormatter alloc] initWithMatrixSession:nil];
+    uncachedFormatter.stringCacheEnabled = NO;
+    
+    // Display name changes contain the user id and both display names
+    NSArray<MXEvent*> *events = @[
+        [self membershipEventWithSender:@"@alice:matrix.org" content:@{@"membership": @"join", @"displayname": @"Alice Cooper"} prevContent:@{@"membership": @"join", @"displayname": @"Alice"}],
+        [self membershipEventWithSender:@"@bob:matrix.org" content:@{@"membership": @"join", @"displayname": @"Bobby"} prevContent:@{@"membership": @"join", @"displayname": @"Bob"}],
+        [self membershipEventWithSender:@"@carol:matrix.org" content:@{@"membership": @"join", @"displayname": @"\uE001"} prevContent:@{@"membership": @"join", @"displayname": @"Carol"}]
+    ];
+    
+    MXKEventFormatterError error;
+    for (MXEvent *event in events)
+    {
+        NSString *string = [eventFormatter attributedStringFromEvent:event withRoomState:nil error:&error].string;
+        XCTAssertEqual(error, MXKEventFormatterErrorNone);
+        XCTAssertEqualObjects(string, [uncachedFormatter attributedStringFromEvent:event withRoomState:nil error:&error].string);
+    }
+    XCTAssertEqual(eventFormatter.stringCacheMissCount, 1);
+    XCTAssertEqual(eventFormatter.stringCacheHitCount, 2);
+}
+
+- (void)testStringCacheKeepsTheTextOfTheContent
+{
+    MXKEventFormatter *uncachedFormatter = [[MXKEventFormatter alloc] initWithMatrixSession:nil];
+    uncachedFormatter.stringCacheEnabled = NO;
+    MXKEventFormatterError error;
+    
+    // A topic made of placeholder characters is not replaced by names
+    MXEvent *topic = [[MXEvent alloc] init];
+    topic.roomId = @"aRoomId";
+    topic.eventId = @"$topic";
+    topic.sender = @"@alice:matrix.org";
+    topic.stateKey = @"";
+    topic.wireType = kMXEventTypeStringRoomTopic;
+    topic.wireContent = @{@"topic": @"\uE000\uE001"};
+    
+    NSString *topicString = [eventFormatter attributedStringFromEvent:topic withRoomState:nil error:&error].string;
+    XCTAssertEqual(error, MXKEventFormatterErrorNone);
+    XCTAssertTrue([topicString containsString:@"\uE000\uE001"]);
+    XCTAssertEqualObjects(topicString, [uncachedFormatter attributedStringFromEvent:topic withRoomState:nil error:&error].string);
+    
+    // So is a kick reason
+    MXEvent *kick = [self membershipEventWithSender:@"@alice:matrix.org" content:@{@"membership": @"leave", @"reason": @"\uE002"} prevContent:@{@"membership": @"join", @"displayname": @"Bob"}];
+    kick.stateKey = @"@bob:matrix.org";
+    NSString *kickString = [eventFormatter attributedStringFromEvent:kick withRoomState:nil error:&error].string;
+    XCTAssertTrue([kickString containsString:@"\uE002"]);
+    XCTAssertEqualObjects(kickString, [uncachedFormatter attributedStringFromEvent:kick withRoomState:nil error:&error].string);
+    
+    // These events do not use the cache
+    XCTAssertEqual(eventFormatter.stringCacheHitCount + eventFormatter.stringCacheMissCount, 0);
+}
+
+- (void)testStringCachePerformance
+{
+    NSArray<MXEvent*> *events = [self stateHeavyTimeline];
+    
+    [self measureBlock:^{
+        [self->eventFormatter resetStringCache];
+        
+        MXKEventFormatterError error;
+        for (MXEvent *event in events)
+        {
+            [self->eventFormatter attributedStringFromEvent:event withRoomState:nil error:&error];
+        }
+        
+        // Only the first join, avatar change and leave are formatted from scratch
+        XCTAssertEqual(self->eventFormatter.stringCacheMissCount, 3);
+    }];
+}
+
+- (void)testStringCacheDisabledPerformance
+{
+    NSArray<MXEvent*> *events = [self stateHeavyTimeline];
+    eventFormatter.stringCacheEnabled = NO;
+    
+    [self measureBlock:^{
+        MXKEventFormatterError error;
+        for (MXEvent *event in events)
+        {
+            [self->eventFormatter attributedStringFromEvent:event withRoomState:nil error:&error];
+        }
+    }];
+}
+
 #pragma mark - Links
 
 - (void)testRoomAliasLink
@@ -391,6 +847,76 @@
     XCTAssertEqual(ranges, 1, @"There should be no link in this case. We let the UI manage the link");
 }
 
+- (void)testTextAnalysis
+{
+    NSString *s = @"Ask @alice:matrix.org in #matrix:matrix.org, see https://matrix.to/#/#matrix:matrix.org or https://matrix.org/docs";
+    
+    // The analysis of a string is shared
+    MXKTextAnalysis *analysis = [MXKTextAnalysis analysisOfString:s];
+    XCTAssertEqual([MXKTextAnalysis analysisOfString:[s mutableCopy]], analysis);
+    
+    // The first web URL ignores the provided hosts
+    XCTAssertEqualObjects([analysis firstWebURLIgnoringHosts:@[@"matrix.to"]], [NSURL URLWithString:@"https://matrix.org/docs"]);
+    
+    // Matrix ids are found
+    XCTAssertEqual([analysis matrixIdMatchesOfType:MXKTOOLS_USER_IDENTIFIER_BITWISE].count, 1);
+    XCTAssertGreaterThanOrEqual([analysis matrixIdMatchesOfType:MXKTOOLS_ROOM_ALIAS_BITWISE].count, 1);
+    XCTAssertFalse(analysis.isEmojiOnly);
+    XCTAssertTrue([MXKTextAnalysis analysisOfString:@"🎉"].isSingleEmoji);
+}
+
+- (void)testTextAnalysisOfMutableString
+{
+    NSMutableString *string = [NSMutableString stringWithString:@"Hello @bob:matrix.org, how are you?"];
+    MXKTextAnalysis *analysis = [MXKTextAnalysis analysisOfString:string];
+    
+    // Editing the analysed string must not change the cached entry
+    [string setString:@"Hello 🎉"];
+    MXKTextAnalysis *newAnalysis = [MXKTextAnalysis analysisOfString:string];
+    XCTAssertNotEqual(newAnalysis, analysis);
+    XCTAssertEqualObjects(newAnalysis.string, @"Hello 🎉");
+    XCTAssertEqual([MXKTextAnalysis analysisOfString:@"Hello @bob:matrix.org, how are you?"], analysis);
+}
+
+- (void)testSettingsSnapshotLinkSchemes
+{
+    MXKAppSettings *settings = [MXKAppSettings new];
+    eventFormatter.settings = settings;
+
+    // The snapshot is kept while the settings do not change
+    MXKAppSettingsSnapshot *snapshot = settings.snapshot;
+    XCTAssertEqual(settings.snapshot, snapshot);
+    XCTAssertTrue(snapshot.hasDefaultLinkSchemes);
+
+    // A new version is published on change
+    settings.httpsLinkScheme = @"googlechromes";
+    MXKAppSettingsSnapshot *newSnapshot = settings.snapshot;
+    XCTAssertNotEqualObjects(newSnapshot, snapshot);
+    XCTAssertGreaterThan(newSnapshot.version, snapshot.version);
+    XCTAssertFalse(newSnapshot.hasDefaultLinkSchemes);
+    XCTAssertTrue(snapshot.hasDefaultLinkSchemes, @"A snapshot must be immutable");
+
+    // Setting the same value keeps the version
+    settings.httpsLinkScheme = @"googlechromes";
+    XCTAssertEqual(settings.snapshot, newSnapshot);
+
+    NSAttributedString *as = [eventFormatter renderString:@"See https://matrix.org" forEvent:anEvent];
+    NSURL *link = [as attribute:NSLinkAttributeName atIndex:as.length - 1 effectiveRange:nil];
+    XCTAssertEqualObjects(link.scheme, @"googlechromes");
+}
+
+- (void)testSettingsSnapshotIsKeptOnUnrelatedUserDefaultsChange
+{
+    MXKAppSettings *settings = [MXKAppSettings standardAppSettings];
+    MXKAppSettingsSnapshot *snapshot = settings.snapshot;
+
+    [[NSUserDefaults standardUserDefaults] setObject:[[NSUUID UUID] UUIDString] forKey:@"MXKEventFormatterTestsUnrelatedKey"];
+    [[NSNotificationCenter defaultCenter] postNotificationName:NSUserDefaultsDidChangeNotification object:[NSUserDefaults standardUserDefaults]];
+    XCTAssertEqual(settings.snapshot, snapshot);
+
+    [[NSUserDefaults standardUserDefaults] removeObjectForKey:@"MXKEventFormatterTestsUnrelatedKey"];
+}
+
 #pragma mark - Event sender/target info
 
 - (void)testUserDisplayNameFromEventContent {
@@ -0,0 +1,119 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+#import <ImageIO/ImageIO.h>
+
+#import "MatrixKit.h"
+#import "XCTestCase+MXKTests.h"
+
+@interface MXKImageSendEncoderTests : XCTestCase
+
+@end
+
+@implementation MXKImageSendEncoderTests
+
+- (NSDictionary*)propertiesOfImageData:(NSData*)imageData
+{
+    CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)imageData, NULL);
+    XCTAssert(source);
+    NSDictionary *properties = (__bridge_transfer NSDictionary*)CGImageSourceCopyPropertiesAtIndex(source, 0, NULL);
+    CFRelease(source);
+    return properties;
+}
+
+#pragma mark - Encoding
+
+- (void)testOrientationIsWrittenAsExif
+{
+    UIImage *image = [self mxk_imageWithPixelSize:CGSizeMake(1600, 900) orientation:UIImageOrientationRight];
+    
+    NSData *imageData = [MXKImageSendEncoder jpegDataWithImage:image compressionQuality:MXKIMAGESENDENCODER_JPEG_COMPRESSION_QUALITY];
+    XCTAssertNotNil(imageData);
+    
+    // The pixels are not redrawn
+    NSDictionary *properties = [self propertiesOfImageData:imageData];
+    XCTAssertEqual([properties[(NSString*)kCGImagePropertyPixelWidth] integerValue], 1600);
+    XCTAssertEqual([properties[(NSString*)kCGImagePropertyPixelHeight] integerValue], 900);
+    XCTAssertEqual([properties[(NSString*)kCGImagePropertyOrientation] integerValue], kCGImagePropertyOrientationRight);
+    
+    // The thumbnail and the displayed size are upright
+    CGSize imageSize;
+    UIImage *thumbnail = [MXKImageSendEncoder thumbnailWithImageData:imageData maxSize:MXKIMAGESENDENCODER_THUMBNAIL_MAX_SIZE imageSize:&imageSize];
+    XCTAssertTrue(CGSizeEqualToSize(imageSize, image.size));
+    XCTAssertNotNil(thumbnail);
+    XCTAssertEqual(thumbnail.imageOrientation, UIImageOrientationUp);
+    XCTAssertLessThan(CGImageGetWidth(thumbnail.CGImage), CGImageGetHeight(thumbnail.CGImage));
+    XCTAssertLessThanOrEqual(CGImageGetHeight(thumbnail.CGImage), 600);
+}
+
+- (void)testNoThumbnailForSmallImages
+{
+    UIImage *image = [self mxk_imageWithPixelSize:CGSizeMake(640, 480) orientation:UIImageOrientationUp];
+    NSData *imageData = [MXKImageSendEncoder jpegDataWithImage:image compressionQuality:MXKIMAGESENDENCODER_JPEG_COMPRESSION_QUALITY];
+    
+    CGSize imageSize;
+    XCTAssertNil([MXKImageSendEncoder thumbnailWithImageData:imageData maxSize:MXKIMAGESENDENCODER_THUMBNAIL_MAX_SIZE imageSize:&imageSize]);
+    XCTAssertTrue(CGSizeEqualToSize(imageSize, CGSizeMake(640, 480)));
+}
+
+- (void)testEncodeImageInBackground
+{
+    UIImage *image = [self mxk_imageWithPixelSize:CGSizeMake(2000, 1500) orientation:UIImageOrientationDown];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"encoding"];
+    
+    [MXKImageSendEncoder encodeImage:image withThumbnail:YES completion:^(NSData *imageData, CGSize imageSize, UIImage *thumbnail) {
+        XCTAssertTrue([NSThread isMainThread]);
+        XCTAssertNotNil(imageData);
+        XCTAssertTrue(CGSizeEqualToSize(imageSize, CGSizeMake(2000, 1500)));
+        XCTAssertEqual(CGImageGetWidth(thumbnail.CGImage), 800);
+        [expectation fulfill];
+    }];
+    
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+#pragma mark - Benchmarks
+
+- (void)measure12MPImageSending:(void (^)(UIImage *image))sendingBlock
+{
+    // A 12 MP camera picture taken in portrait
+    UIImage *image = [self mxk_imageWithPixelSize:CGSizeMake(4032, 3024) orientation:UIImageOrientationRight];
+    
+    [self mxk_measureClockAndMemoryOfBlock:^{
+        sendingBlock(image);
+    }];
+}
+
+- (void)test12MPImageEncodingPerformance
+{
+    [self measure12MPImageSending:^(UIImage *image) {
+        NSData *imageData = [MXKImageSendEncoder jpegDataWithImage:image compressionQuality:MXKIMAGESENDENCODER_JPEG_COMPRESSION_QUALITY];
+        [MXKImageSendEncoder thumbnailWithImageData:imageData maxSize:MXKIMAGESENDENCODER_THUMBNAIL_MAX_SIZE imageSize:NULL];
+    }];
+}
+
+- (void)test12MPImageRedrawEncodingPerformance
+{
+    // The previous pipeline: the bitmap is redrawn upright, then the thumbnail is drawn from it
+    [self measure12MPImageSending:^(UIImage *image) {
+        UIImage *uprightImage = [MXKTools forceImageOrientationUp:image];
+        UIImageJPEGRepresentation(uprightImage, MXKIMAGESENDENCODER_JPEG_COMPRESSION_QUALITY);
+        [MXKTools reduceImage:uprightImage toFitInSize:MXKIMAGESENDENCODER_THUMBNAIL_MAX_SIZE];
+    }];
+}
+
+@end
@@ -0,0 +1,274 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+
+#import <XCTest/XCTest.h>
+
+#import "MatrixKit.h"
+
+@interface MXKRoomAttachmentsTimelineFakeOperation : MXHTTPOperation
+
+@property (nonatomic) BOOL isCancelled;
+
+@end
+
+@implementation MXKRoomAttachmentsTimelineFakeOperation
+
+- (void)cancel
+{
+    _isCancelled = YES;
+}
+
+@end
+
+/**
+ A rest client which keeps the blocks of the requests, so that the tests complete them.
+ */
+@interface MXKRoomAttachmentsTimelineFakeRestClient : MXRestClient
+
+@property (nonatomic) NSUInteger contextRequestCount;
+@property (nonatomic, copy) void (^contextSuccess)(MXEventContext *eventContext);
+
+@property (nonatomic) NSMutableArray<NSString*> *messagesFromTokens;
+@property (nonatomic, copy) void (^messagesSuccess)(MXPaginationResponse *paginatedResponse);
+@property (nonatomic, copy) void (^messagesFailure)(NSError *error);
+
+@property (nonatomic) MXKRoomAttachmentsTimelineFakeOperation *lastOperation;
+
+@end
+
+@implementation MXKRoomAttachmentsTimelineFakeRestClient
+
+- (MXHTTPOperation *)contextOfEvent:(NSString *)eventId inRoom:(NSString *)roomId limit:(NSUInteger)limit filter:(MXRoomEventFilter *)filter success:(void (^)(MXEventContext *))success failure:(void (^)(NSError *))failure
+{
+    _contextRequestCount++;
+    _contextSuccess = success;
+    _lastOperation = [[MXKRoomAttachmentsTimelineFakeOperation alloc] init];
+    return _lastOperation;
+}
+
+- (MXHTTPOperation *)messagesForRoom:(NSString *)roomId from:(NSString *)from direction:(MXTimelineDirection)direction limit:(NSUInteger)limit filter:(MXRoomEventFilter *)roomEventFilter success:(void (^)(MXPaginationResponse *))success failure:(void (^)(NSError *))failure
+{
+    [_messagesFromTokens addObject:from];
+    _messagesSuccess = success;
+    _messagesFailure = failure;
+    _lastOperation = [[MXKRoomAttachmentsTimelineFakeOperation alloc] init];
+    return _lastOperation;
+}
+
+@end
+
+@interface MXKRoomAttachmentsTimelineTests : XCTestCase
+{
+    MXKRoomAttachmentsTimelineFakeRestClient *restClient;
+    MXSession *session;
+    MXKRoomAttachmentsTimeline *timeline;
+}
+
+@end
+
+@implementation MXKRoomAttachmentsTimelineTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+    MXCredentials *credentials = [[MXCredentials alloc] initWithHomeServer:@"https://matrix.org" userId:@"@alice:matrix.org" accessToken:@"token"];
+    restClient = [[MXKRoomAttachmentsTimelineFakeRestClient alloc] initWithCredentials:credentials andOnUnrecognizedCertificateBlock:nil];
+    restClient.messagesFromTokens = [NSMutableArray array];
+    session = [[MXSession alloc] initWithMatrixRestClient:restClient];
+    
+    timeline = [[MXKRoomAttachmentsTimeline alloc] initWithRoomId:@"!room:matrix.org" andMatrixSession:session];
+    [timeline updateRecentAttachments:@[[[MXKAttachment alloc] initWithEvent:[self eventWithId:@"$recent" msgtype:kMXMessageTypeImage] andMediaManager:session.mediaManager]]];
+}
+
+- (void)tearDown
+{
+    [timeline destroy];
+    timeline = nil;
+    session = nil;
+    restClient = nil;
+    
+    [super tearDown];
+}
+
+- (MXEvent*)eventWithId:(NSString*)eventId msgtype:(NSString*)msgtype
+{
+    return [MXEvent modelFromJSON:[self eventJSONWithId:eventId msgtype:msgtype]];
+}
+
+- (NSDictionary*)eventJSONWithId:(NSString*)eventId msgtype:(NSString*)msgtype
+{
+    return @{
+        @"event_id": eventId,
+        @"room_id": @"!room:matrix.org",
+        @"sender": @"@bob:matrix.org",
+        @"type": kMXEventTypeStringRoomMessage,
+        @"origin_server_ts": @(1000),
+        @"content": @{
+            @"msgtype": msgtype,
+            @"body": eventId,
+            @"url": [NSString stringWithFormat:@"mxc://matrix.org/%@", [eventId substringFromIndex:1]],
+            @"info": @{@"mimetype": [msgtype isEqualToString:kMXMessageTypeImage] ? @"image/png" : @"application/pdf"}
+        }
+    };
+}
+
+- (void)completeContextRequestWithStart:(NSString*)start
+{
+    NSMutableDictionary *JSON = [NSMutableDictionary dictionaryWithDictionary:@{
+        @"event": [self eventJSONWithId:@"$recent" msgtype:kMXMessageTypeImage],
+        @"events_before": @[],
+        @"events_after": @[],
+        @"state": @[]
+    }];
+    JSON[@"start"] = start;
+    restClient.contextSuccess([MXEventContext modelFromJSON:JSON]);
+}
+
+/**
+ Complete the pending messages request.
+
+ @param chunk the events of the page, from the most recent one.
+ */
+- (void)completeMessagesRequestWithChunk:(NSArray<NSDictionary*>*)chunk start:(NSString*)start end:(NSString*)end
+{
+    NSMutableDictionary *JSON = [NSMutableDictionary dictionaryWithDictionary:@{@"chunk": chunk, @"start": start}];
+    JSON[@"end"] = end;
+    restClient.messagesSuccess([MXPaginationResponse modelFromJSON:JSON]);
+}
+
+- (void)testPagesWithoutAttachmentAreSkipped
+{
+    __block NSArray<MXKAttachment*> *addedAttachments;
+    [timeline paginateBackwards:^(NSArray<MXKAttachment *> *attachments) {
+        addedAttachments = attachments;
+    } failure:^(NSError *error) {
+        XCTFail(@"The pagination must not fail");
+    }];
+    XCTAssertTrue(timeline.isPaginating);
+    XCTAssertEqual(restClient.contextRequestCount, 1);
+    
+    [self completeContextRequestWithStart:@"t0"];
+    
+    // A page with a file only: the next page is requested
+    [self completeMessagesRequestWithChunk:@[[self eventJSONWithId:@"$file" msgtype:kMXMessageTypeFile]] start:@"t0" end:@"t1"];
+    XCTAssertNil(addedAttachments);
+    XCTAssertTrue(timeline.isPaginating);
+    XCTAssertEqualObjects(restClient.messagesFromTokens, (@[@"t0", @"t1"]));
+    
+    [self completeMessagesRequestWithChunk:@[[self eventJSONWithId:@"$image2" msgtype:kMXMessageTypeImage],
+                                             [self eventJSONWithId:@"$file2" msgtype:kMXMessageTypeFile],
+                                             [self eventJSONWithId:@"$image1" msgtype:kMXMessageTypeImage]] start:@"t1" end:@"t2"];
+    XCTAssertEqualObjects([addedAttachments valueForKey:@"eventId"], (@[@"$image1", @"$image2"]));
+    XCTAssertEqualObjects([timeline.attachments valueForKey:@"eventId"], (@[@"$image1", @"$image2", @"$recent"]));
+    XCTAssertFalse(timeline.isPaginating);
+    XCTAssertTrue(timeline.canPaginateBackwards);
+    
+    // The next pagination goes on from the last token
+    [timeline paginateBackwards:^(NSArray<MXKAttachment *> *attachments) {} failure:nil];
+    XCTAssertEqual(restClient.contextRequestCount, 1);
+    XCTAssertEqualObjects(restClient.messagesFromTokens.lastObject, @"t2");
+}
+
+- (void)testStartOfTheHistory
+{
+    __block NSArray<MXKAttachment*> *addedAttachments;
+    [timeline paginateBackwards:^(NSArray<MXKAttachment *> *attachments) {
+        addedAttachments = attachments;
+    } failure:nil];
+    [self completeContextRequestWithStart:@"t0"];
+    
+    // The last page of the history has no end token. The pagination stops even without attachment.
+    [self completeMessagesRequestWithChunk:@[[self eventJSONWithId:@"$file" msgtype:kMXMessageTypeFile]] start:@"t0" end:nil];
+    XCTAssertEqualObjects(addedAttachments, @[]);
+    XCTAssertFalse(timeline.isPaginating);
+    XCTAssertFalse(timeline.canPaginateBackwards);
+    XCTAssertEqual(restClient.messagesFromTokens.count, 1);
+    
+    // No more request is made
+    __block BOOL completed = NO;
+    [timeline paginateBackwards:^(NSArray<MXKAttachment *> *attachments) {
+        XCTAssertEqual(attachments.count, 0);
+        completed = YES;
+    } failure:nil];
+    XCTAssertTrue(completed);
+    XCTAssertEqual(restClient.contextRequestCount, 1);
+    XCTAssertEqual(restClient.messagesFromTokens.count, 1);
+}
+
+- (void)testStartOfTheHistoryBeforeTheOldestAttachment
+{
+    __block NSArray<MXKAttachment*> *addedAttachments;
+    [timeline paginateBackwards:^(NSArray<MXKAttachment *> *attachments) {
+        addedAttachments = attachments;
+    } failure:nil];
+    
+    // The oldest attachment is the first event of the room
+    [self completeContextRequestWithStart:nil];
+    XCTAssertEqualObjects(addedAttachments, @[]);
+    XCTAssertFalse(timeline.canPaginateBackwards);
+    XCTAssertEqual(restClient.messagesFromTokens.count, 0);
+}
+
+- (void)testRequestDuringPaginationIsIgnored
+{
+    __block NSUInteger successCount = 0;
+    [timeline paginateBackwards:^(NSArray<MXKAttachment *> *attachments) {
+        successCount++;
+    } failure:nil];
+    
+    [timeline paginateBackwards:^(NSArray<MXKAttachment *> *attachments) {
+        XCTFail(@"The ignored request must not complete");
+    } failure:^(NSError *error) {
+        XCTFail(@"The ignored request must not fail");
+    }];
+    XCTAssertEqual(restClient.contextRequestCount, 1);
+    
+    [self completeContextRequestWithStart:@"t0"];
+    [timeline paginateBackwards:^(NSArray<MXKAttachment *> *attachments) {
+        XCTFail(@"The ignored request must not complete");
+    } failure:^(NSError *error) {
+        XCTFail(@"The ignored request must not fail");
+    }];
+    XCTAssertEqual(restClient.messagesFromTokens.count, 1);
+    
+    [self completeMessagesRequestWithChunk:@[[self eventJSONWithId:@"$image" msgtype:kMXMessageTypeImage]] start:@"t0" end:@"t1"];
+    XCTAssertEqual(successCount, 1);
+}
+
+- (void)testDestroyDuringPagination
+{
+    [timeline paginateBackwards:^(NSArray<MXKAttachment *> *attachments) {
+        XCTFail(@"A destroyed timeline must not complete");
+    } failure:^(NSError *error) {
+        XCTFail(@"A destroyed timeline must not fail");
+    }];
+    [self completeContextRequestWithStart:@"t0"];
+    MXKRoomAttachmentsTimelineFakeOperation *operation = restClient.lastOperation;
+    
+    [timeline destroy];
+    XCTAssertTrue(operation.isCancelled);
+    XCTAssertFalse(timeline.isPaginating);
+    XCTAssertFalse(timeline.canPaginateBackwards);
+    XCTAssertEqual(timeline.attachments.count, 0);
+    
+    // A response received after the cancellation is ignored
+    [self completeMessagesRequestWithChunk:@[[self eventJSONWithId:@"$image" msgtype:kMXMessageTypeImage]] start:@"t0" end:@"t1"];
+    XCTAssertEqual(timeline.attachments.count, 0);
+}
+
+@end
@@ -21,7 +21,13 @@
 - (NSArray<id<MXKRoomBubbleCellDataStoring>> *)getBubbles;
 - (void)replaceBubbles:(NSArray<id<MXKRoomBubbleCellDataStoring>> *)newBubbles;
 
+- (void)setRoom:(MXRoom*)room;
+
 - (void)queueEventForProcessing:(MXEvent*)event withRoomState:(MXRoomState*)roomState direction:(MXTimelineDirection)direction;
 - (void)processQueuedEvents:(void (^)(NSUInteger addedHistoryCellNb, NSUInteger addedLiveCellNb))onComplete;
 
++ (NSUInteger)insertionIndexOfBubble:(id<MXKRoomBubbleCellDataStoring>)bubbleData inDateOrderedBubbles:(NSArray<id<MXKRoomBubbleCellDataStoring>>*)dateOrderedBubbles direction:(MXTimelineDirection)direction;
++ (void)sortBubblesByDateIfNeeded:(NSMutableArray<id<MXKRoomBubbleCellDataStoring>>*)bubbles;
++ (void)repositionBubble:(id<MXKRoomBubbleCellDataStoring>)bubbleData inDateOrderedBubbles:(NSMutableArray<id<MXKRoomBubbleCellDataStoring>>*)dateOrderedBubbles direction:(MXTimelineDirection)direction;
+
 @end
@@ -0,0 +1,171 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+
+#import <XCTest/XCTest.h>
+
+#import "MatrixKit.h"
+#import "MXKRoomDataSource+Tests.h"
+
+/**
+ A bubble reduced to what the insertion in date order needs.
+ */
+@interface MXKRoomDataSourceFakeBubble : NSObject
+
+@property (nonatomic) NSString *name;
+@property (nonatomic) NSDate *date;
+
+@end
+
+@implementation MXKRoomDataSourceFakeBubble
+
++ (instancetype)bubbleWithName:(NSString*)name timestamp:(NSTimeInterval)timestamp
+{
+    MXKRoomDataSourceFakeBubble *bubble = [[MXKRoomDataSourceFakeBubble alloc] init];
+    bubble.name = name;
+    bubble.date = timestamp ? [NSDate dateWithTimeIntervalSince1970:timestamp] : nil;
+    return bubble;
+}
+
+@end
+
+@interface MXKRoomDataSourceBubbleOrderTests : XCTestCase
+
+@end
+
+@implementation MXKRoomDataSourceBubbleOrderTests
+
+- (void)insertBubble:(MXKRoomDataSourceFakeBubble*)bubble inBubbles:(NSMutableArray*)bubbles direction:(MXTimelineDirection)direction
+{
+    NSUInteger index = [MXKRoomDataSource insertionIndexOfBubble:(id)bubble inDateOrderedBubbles:bubbles direction:direction];
+    [bubbles insertObject:bubble atIndex:index];
+}
+
+- (NSArray<NSString*>*)namesOfBubbles:(NSArray<MXKRoomDataSourceFakeBubble*>*)bubbles
+{
+    return [bubbles valueForKey:@"name"];
+}
+
+- (void)testInterleavedRoomsAreInDateOrder
+{
+    NSMutableArray *bubbles = [NSMutableArray array];
+    
+    // The events of the primary room are processed before the ones of the secondary room
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"primary1" timestamp:10] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"primary2" timestamp:30] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"primary3" timestamp:50] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"secondary1" timestamp:20] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"secondary2" timestamp:40] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"secondary3" timestamp:60] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    
+    // Back pagination
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"secondary0" timestamp:5] inBubbles:bubbles direction:MXTimelineDirectionBackwards];
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"primary0" timestamp:8] inBubbles:bubbles direction:MXTimelineDirectionBackwards];
+    
+    XCTAssertEqualObjects([self namesOfBubbles:bubbles], (@[@"secondary0", @"primary0", @"primary1", @"secondary1", @"primary2", @"secondary2", @"primary3", @"secondary3"]));
+}
+
+- (void)testEqualTimestampsKeepTheInsertionOrder
+{
+    NSMutableArray *bubbles = [NSMutableArray array];
+    
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"a" timestamp:10] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"b" timestamp:10] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"c" timestamp:20] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"d" timestamp:10] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    
+    // A bubble added backwards goes before the bubbles with the same date
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"e" timestamp:10] inBubbles:bubbles direction:MXTimelineDirectionBackwards];
+    
+    XCTAssertEqualObjects([self namesOfBubbles:bubbles], (@[@"e", @"a", @"b", @"d", @"c"]));
+}
+
+- (void)testBubblesWithoutDateComeFirst
+{
+    NSMutableArray *bubbles = [NSMutableArray array];
+    
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"dated" timestamp:10] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"undated1" timestamp:0] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"undated2" timestamp:0] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    
+    XCTAssertEqualObjects([self namesOfBubbles:bubbles], (@[@"undated1", @"undated2", @"dated"]));
+}
+
+- (void)testInsertionMatchesStableSort
+{
+    NSMutableArray *bubbles = [NSMutableArray array];
+    NSMutableArray *sequence = [NSMutableArray array];
+    
+    srand48(42);
+    for (NSUInteger index = 0; index < 1000; index++)
+    {
+        MXTimelineDirection direction = (drand48() < 0.3) ? MXTimelineDirectionBackwards : MXTimelineDirectionForwards;
+        MXKRoomDataSourceFakeBubble *bubble = [MXKRoomDataSourceFakeBubble bubbleWithName:@(index).stringValue timestamp:1 + lrand48() % 50];
+        
+        [self insertBubble:bubble inBubbles:bubbles direction:direction];
+        
+        // The previous implementation: prepend or append, then sort
+        if (direction == MXTimelineDirectionBackwards)
+        {
+            [sequence insertObject:bubble atIndex:0];
+        }
+        else
+        {
+            [sequence addObject:bubble];
+        }
+    }
+    
+    [sequence sortWithOptions:NSSortStable usingComparator:^NSComparisonResult(MXKRoomDataSourceFakeBubble *bubble1, MXKRoomDataSourceFakeBubble *bubble2) {
+        return [bubble1.date compare:bubble2.date];
+    }];
+    
+    XCTAssertEqualObjects(bubbles, sequence);
+}
+
+- (void)testMergedBubbleIsRepositioned
+{
+    MXKRoomDataSourceFakeBubble *primary = [MXKRoomDataSourceFakeBubble bubbleWithName:@"primary" timestamp:30];
+    NSMutableArray *bubbles = [NSMutableArray array];
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"secondary" timestamp:20] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    [self insertBubble:primary inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    
+    // An older event is merged into the primary bubble
+    primary.date = [NSDate dateWithTimeIntervalSince1970:10];
+    [MXKRoomDataSource repositionBubble:(id)primary inDateOrderedBubbles:bubbles direction:MXTimelineDirectionBackwards];
+    
+    XCTAssertEqualObjects([self namesOfBubbles:bubbles], (@[@"primary", @"secondary"]));
+    
+    // The next insertions still find their place
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"live" timestamp:15] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    XCTAssertEqualObjects([self namesOfBubbles:bubbles], (@[@"primary", @"live", @"secondary"]));
+}
+
+- (void)testBubblesAreSortedAgainWhenADateChanged
+{
+    MXKRoomDataSourceFakeBubble *first = [MXKRoomDataSourceFakeBubble bubbleWithName:@"first" timestamp:10];
+    NSMutableArray *bubbles = [NSMutableArray array];
+    [self insertBubble:first inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"second" timestamp:20] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    [self insertBubble:[MXKRoomDataSourceFakeBubble bubbleWithName:@"third" timestamp:30] inBubbles:bubbles direction:MXTimelineDirectionForwards];
+    
+    // The first component of the first bubble has been redacted
+    first.date = [NSDate dateWithTimeIntervalSince1970:25];
+    [MXKRoomDataSource sortBubblesByDateIfNeeded:bubbles];
+    
+    XCTAssertEqualObjects([self namesOfBubbles:bubbles], (@[@"second", @"first", @"third"]));
+}
+
+@end
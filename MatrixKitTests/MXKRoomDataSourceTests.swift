@@ -57,6 +57,63 @@ class MXKRoomDataSourceTests: XCTestCase {
         dataSource.verifyCollapsedEvents(2)
     }
 
+    // MARK: - Read position tests
+
+    func testReadPositionUpdatesAreCoalesced() throws {
+        let dataSource = try ReadPositionMXKRoomDataSource.make()
+        let tracker = try XCTUnwrap(MXKRoomReadPositionTracker(roomDataSource: dataSource))
+        tracker.coalescingInterval = 60
+
+        let events = try (1...3).map { try ReadPositionMXKRoomDataSource.event(at: $0) }
+        events.forEach { tracker.update(with: $0, updateReadMarker: false) }
+        XCTAssertTrue(dataSource.fakeRoom.acknowledgedEvents.isEmpty)
+        XCTAssertEqual(tracker.pendingEvent?.eventId, events[2].eventId)
+
+        // Only the latest event is acknowledged
+        tracker.flush()
+        XCTAssertEqual(dataSource.fakeRoom.acknowledgedEvents.map { $0.eventId }, [events[2].eventId])
+        XCTAssertEqual(tracker.sentUpdatesCount, 1)
+        XCTAssertEqual(tracker.suppressedUpdatesCount, 2)
+
+        tracker.destroy()
+    }
+
+    func testReadPositionOnlyMovesForward() throws {
+        let dataSource = try ReadPositionMXKRoomDataSource.make()
+        let tracker = try XCTUnwrap(MXKRoomReadPositionTracker(roomDataSource: dataSource))
+        tracker.coalescingInterval = 0
+
+        let latestEvent = try ReadPositionMXKRoomDataSource.event(at: 2)
+        tracker.update(with: latestEvent, updateReadMarker: true)
+        XCTAssertEqual(dataSource.fakeRoom.acknowledgedEvents.count, 1)
+        XCTAssertEqual(dataSource.fakeRoom.readMarkerUpdates, [true])
+
+        // Scrolling back up reports older events, and the same event again
+        tracker.update(with: try ReadPositionMXKRoomDataSource.event(at: 1), updateReadMarker: true)
+        tracker.update(with: latestEvent, updateReadMarker: true)
+        tracker.flush()
+        XCTAssertEqual(dataSource.fakeRoom.acknowledgedEvents.count, 1)
+        XCTAssertEqual(tracker.suppressedUpdatesCount, 2)
+
+        tracker.update(with: try ReadPositionMXKRoomDataSource.event(at: 3), updateReadMarker: false)
+        XCTAssertEqual(dataSource.fakeRoom.acknowledgedEvents.count, 2)
+        XCTAssertEqual(dataSource.fakeRoom.readMarkerUpdates, [true, false])
+
+        tracker.destroy()
+    }
+
+    func testReadMarkerUpdateIsKeptWhenCoalesced() throws {
+        let dataSource = try ReadPositionMXKRoomDataSource.make()
+        let tracker = try XCTUnwrap(MXKRoomReadPositionTracker(roomDataSource: dataSource))
+        tracker.coalescingInterval = 60
+
+        tracker.update(with: try ReadPositionMXKRoomDataSource.event(at: 1), updateReadMarker: true)
+        tracker.update(with: try ReadPositionMXKRoomDataSource.event(at: 2), updateReadMarker: false)
+        tracker.destroy()
+
+        XCTAssertEqual(dataSource.fakeRoom.readMarkerUpdates, [true])
+    }
+
     private func awaitEventProcessing(for dataSource: MXKRoomDataSource) {
         let e = expectation(description: "The wai-ai-ting is the hardest part")
         dataSource.processQueuedEvents { _, _ in
@@ -129,6 +186,46 @@ private final class FakeMXKRoomDataSource: MXKRoomDataSource {
 
 }
 
+private final class ReadPositionMXKRoomDataSource: MXKRoomDataSource {
+
+    private static let roomId = "!foofoofoofoofoofoo:matrix.org"
+
+    let fakeRoom = AcknowledgingRoom(roomId: ReadPositionMXKRoomDataSource.roomId, andMatrixSession: nil)!
+
+    class func make() throws -> ReadPositionMXKRoomDataSource {
+        try XCTUnwrap(ReadPositionMXKRoomDataSource(roomId: roomId, andMatrixSession: nil))
+    }
+
+    class func event(at index: Int) throws -> MXEvent {
+        let json: [AnyHashable: Any] = [
+            "sender": "@alice:matrix.org",
+            "content": ["msgtype": "m.text", "body": "Message \(index)"],
+            "origin_server_ts": 1616488993287 + index * 1000,
+            "room_id": roomId,
+            "event_id": "$event\(index)",
+            "type": "m.room.message"
+        ]
+        return try XCTUnwrap(MXEvent(fromJSON: json))
+    }
+
+    override var room: MXRoom! {
+        fakeRoom
+    }
+
+}
+
+private final class AcknowledgingRoom: MXRoom {
+
+    private(set) var acknowledgedEvents: [MXEvent] = []
+    private(set) var readMarkerUpdates: [Bool] = []
+
+    override func acknowledgeEvent(_ event: MXEvent!, andUpdateReadMarker updateReadMarker: Bool) {
+        acknowledgedEvents.append(event)
+        readMarkerUpdates.append(updateReadMarker)
+    }
+
+}
+
 private final class CollapsibleBubbleCellData: MXKRoomBubbleCellData {
 
     override init() {
@@ -0,0 +1,102 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "MatrixKit.h"
+
+@interface MXKRoomPaginationPredictorTests : XCTestCase
+{
+    MXKRoomPaginationPredictor *predictor;
+}
+
+@end
+
+@implementation MXKRoomPaginationPredictorTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+    predictor = [[MXKRoomPaginationPredictor alloc] initWithThreshold:300 minimumLimit:30];
+}
+
+- (void)testNoPredictionWithoutScroll
+{
+    XCTAssertEqual(predictor.velocity, 0);
+    XCTAssertFalse([predictor shouldPaginateInDirection:MXTimelineDirectionBackwards distanceToEdge:500]);
+    XCTAssertTrue([predictor shouldPaginateInDirection:MXTimelineDirectionBackwards distanceToEdge:200]);
+    XCTAssertEqual([predictor paginationLimitInDirection:MXTimelineDirectionBackwards distanceToEdge:200 averageCellHeight:50], 30);
+}
+
+- (void)testFastScrollTriggersEarlyAndLargerPagination
+{
+    // Scroll toward the top at 3000 points per second
+    [predictor updateWithContentOffset:10000 timestamp:1.0];
+    [predictor updateWithContentOffset:9950 timestamp:1.0 + 1.0/60];
+    [predictor updateWithContentOffset:9900 timestamp:1.0 + 2.0/60];
+    XCTAssertEqualWithAccuracy(predictor.velocity, -3000, 1);
+    
+    // With the default look ahead duration (1s), 3000 points will be scrolled during the pagination
+    XCTAssertEqualWithAccuracy([predictor projectedDistanceInDirection:MXTimelineDirectionBackwards], 3000, 1);
+    XCTAssertEqual([predictor projectedDistanceInDirection:MXTimelineDirectionForwards], 0);
+    
+    XCTAssertTrue([predictor shouldPaginateInDirection:MXTimelineDirectionBackwards distanceToEdge:3000]);
+    XCTAssertFalse([predictor shouldPaginateInDirection:MXTimelineDirectionForwards distanceToEdge:3000]);
+    
+    // 3000 + 2 * 300 - 1000 = 2600 points are missing, i.e. 52 cells of 50 points
+    XCTAssertEqual([predictor paginationLimitInDirection:MXTimelineDirectionBackwards distanceToEdge:1000 averageCellHeight:50], 52);
+    
+    // The limit is bounded
+    predictor.maximumLimit = 40;
+    XCTAssertEqual([predictor paginationLimitInDirection:MXTimelineDirectionBackwards distanceToEdge:1000 averageCellHeight:50], 40);
+}
+
+- (void)testContentOffsetShiftIsNotAScroll
+{
+    [predictor updateWithContentOffset:1000 timestamp:1.0];
+    [predictor updateWithContentOffset:990 timestamp:1.0 + 1.0/60];
+    CGFloat velocity = predictor.velocity;
+    
+    // Cells of 2000 points have been added at the top
+    [predictor didShiftContentOffsetBy:2000];
+    [predictor updateWithContentOffset:2980 timestamp:1.0 + 2.0/60];
+    
+    XCTAssertEqualWithAccuracy(predictor.velocity, velocity, 1);
+}
+
+- (void)testStallMetrics
+{
+    [predictor didStartPagination];
+    [predictor didReachContentEdge];
+    [predictor didReachContentEdge];
+    [predictor didEndPagination];
+    
+    [predictor didStartPagination];
+    [predictor didEndPagination];
+    
+    // Out of any pagination
+    [predictor didReachContentEdge];
+    
+    XCTAssertEqual(predictor.paginationCount, 2);
+    XCTAssertEqual(predictor.stallCount, 1);
+    XCTAssertEqualWithAccuracy(predictor.stallRate, 0.5, 0.001);
+    
+    [predictor resetMetrics];
+    XCTAssertEqual(predictor.stallRate, 0);
+}
+
+@end
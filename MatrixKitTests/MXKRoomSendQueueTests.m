@@ -0,0 +1,130 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "MatrixKit.h"
+#import "MXKRoomSendQueue.h"
+#import "MXKRoomDataSource+Tests.h"
+#import "XCTestCase+MXKTests.h"
+
+/**
+ A room which records the messages it is asked to send.
+ */
+@interface MXKRoomSendQueueFakeRoom : MXRoom
+
+@property (nonatomic) NSMutableArray<NSString*> *sentMessages;
+@property (nonatomic, copy) void (^onSend)(void);
+
+@end
+
+@implementation MXKRoomSendQueueFakeRoom
+
+- (MXHTTPOperation *)sendTextMessage:(NSString *)text formattedText:(NSString *)formattedText localEcho:(MXEvent *__autoreleasing *)localEcho success:(void (^)(NSString *))success failure:(void (^)(NSError *))failure
+{
+    [_sentMessages addObject:text];
+    _onSend();
+    return nil;
+}
+
+- (MXHTTPOperation *)sendImage:(NSData *)imageData withImageSize:(CGSize)imageSize mimeType:(NSString *)mimetype andThumbnail:(UIImage *)thumbnail localEcho:(MXEvent *__autoreleasing *)localEcho success:(void (^)(NSString *))success failure:(void (^)(NSError *))failure
+{
+    [_sentMessages addObject:@"image"];
+    _onSend();
+    return nil;
+}
+
+@end
+
+@interface MXKRoomSendQueueTests : XCTestCase
+
+@end
+
+@implementation MXKRoomSendQueueTests
+
+- (void)testMessagesAreSentInReservationOrder
+{
+    MXKRoomSendQueue *queue = [[MXKRoomSendQueue alloc] init];
+    NSMutableArray<NSNumber*> *sent = [NSMutableArray array];
+    
+    void (^first)(dispatch_block_t) = [queue reserve];
+    void (^second)(dispatch_block_t) = [queue reserve];
+    
+    // A message sent without preparation waits for the reserved ones
+    [queue send:^{
+        [sent addObject:@3];
+    }];
+    
+    second(^{
+        [sent addObject:@2];
+    });
+    XCTAssertEqual(sent.count, 0);
+    XCTAssertEqual(queue.pendingCount, 3);
+    
+    first(^{
+        [sent addObject:@1];
+    });
+    XCTAssertEqualObjects(sent, (@[@1, @2, @3]));
+    XCTAssertEqual(queue.pendingCount, 0);
+    
+    // Without message in preparation, a message is sent immediately
+    [queue send:^{
+        [sent addObject:@4];
+    }];
+    XCTAssertEqualObjects(sent.lastObject, @4);
+}
+
+- (void)testSkippedMessageReleasesItsPosition
+{
+    MXKRoomSendQueue *queue = [[MXKRoomSendQueue alloc] init];
+    __block BOOL sent = NO;
+    
+    void (^failed)(dispatch_block_t) = [queue reserve];
+    [queue send:^{
+        sent = YES;
+    }];
+    XCTAssertFalse(sent);
+    
+    failed(nil);
+    XCTAssertTrue(sent);
+}
+
+- (void)testTextSentAfterAnImageIsSentAfterIt
+{
+    MXKRoomDataSource *dataSource = [[MXKRoomDataSource alloc] initWithRoomId:@"!room:matrix.org" andMatrixSession:nil];
+    dataSource.eventFormatter = [[MXKEventFormatter alloc] initWithMatrixSession:nil];
+    
+    MXKRoomSendQueueFakeRoom *room = [[MXKRoomSendQueueFakeRoom alloc] initWithRoomId:@"!room:matrix.org" andMatrixSession:nil];
+    room.sentMessages = [NSMutableArray array];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"sending"];
+    expectation.expectedFulfillmentCount = 2;
+    room.onSend = ^{
+        [expectation fulfill];
+    };
+    [dataSource setRoom:room];
+    
+    // The image encoding takes longer than the Markdown conversion of the caption
+    UIImage *image = [self mxk_imageWithPixelSize:CGSizeMake(4032, 3024) orientation:UIImageOrientationRight];
+    [dataSource sendImage:image success:nil failure:nil];
+    [dataSource sendTextMessage:@"A caption" success:nil failure:nil];
+    
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+    XCTAssertEqualObjects(room.sentMessages, (@[@"image", @"A caption"]));
+    
+    [dataSource destroy];
+}
+
+@end
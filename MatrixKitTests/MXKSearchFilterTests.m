@@ -0,0 +1,111 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "MatrixKit.h"
+
+@interface MXKSearchFilterTests : XCTestCase
+{
+    MXKSearchFilter *searchFilter;
+}
+
+@end
+
+@implementation MXKSearchFilterTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+    searchFilter = [[MXKSearchFilter alloc] initWithSearchKeyBlock:^NSString *(NSString *item) {
+        return item;
+    }];
+    searchFilter.items = @[@"Alice", @"Bob", @"Zoë", @"ALINE", @"Marc-André"];
+}
+
+- (void)tearDown
+{
+    [searchFilter cancel];
+    searchFilter = nil;
+    
+    [super tearDown];
+}
+
+- (NSArray*)filterWithPatterns:(NSArray<NSString*>*)patterns
+{
+    __block NSArray *result;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"filter"];
+    [searchFilter filterWithPatterns:patterns completion:^(NSArray *filteredItems) {
+        XCTAssertTrue(NSThread.isMainThread);
+        result = filteredItems;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    return result;
+}
+
+- (void)testFilterIsCaseAndDiacriticInsensitive
+{
+    XCTAssertEqualObjects([self filterWithPatterns:@[@"ali"]], (@[@"Alice", @"ALINE"]));
+    XCTAssertEqualObjects([self filterWithPatterns:@[@"zoe"]], (@[@"Zoë"]));
+    XCTAssertEqualObjects([self filterWithPatterns:@[@"ANDRÉ", @"bo"]], (@[@"Bob", @"Marc-André"]));
+    XCTAssertEqualObjects([self filterWithPatterns:@[@"nobody"]], (@[]));
+}
+
+- (void)testFilterNarrowsExtendedPatterns
+{
+    XCTAssertEqualObjects([self filterWithPatterns:@[@"al"]], (@[@"Alice", @"ALINE"]));
+    XCTAssertEqualObjects([self filterWithPatterns:@[@"alic"]], (@[@"Alice"]));
+    
+    // A shorter pattern must scan all the items again
+    XCTAssertEqualObjects([self filterWithPatterns:@[@"a"]], (@[@"Alice", @"ALINE", @"Marc-André"]));
+}
+
+- (void)testFilterUsesNewItems
+{
+    XCTAssertEqualObjects([self filterWithPatterns:@[@"al"]], (@[@"Alice", @"ALINE"]));
+    
+    searchFilter.items = @[@"Alfred", @"Bob"];
+    XCTAssertEqualObjects([self filterWithPatterns:@[@"alf"]], (@[@"Alfred"]));
+}
+
+- (void)testSupersededRequestIsNotPublished
+{
+    __block BOOL isFirstRequestPublished = NO;
+    [searchFilter filterWithPatterns:@[@"b"] completion:^(NSArray *filteredItems) {
+        isFirstRequestPublished = YES;
+    }];
+    
+    XCTAssertEqualObjects([self filterWithPatterns:@[@"zo"]], (@[@"Zoë"]));
+    XCTAssertFalse(isFirstRequestPublished);
+}
+
+- (void)testSynchronousFilterCancelsPendingRequest
+{
+    __block BOOL isPendingRequestPublished = NO;
+    [searchFilter filterWithPatterns:@[@"b"] completion:^(NSArray *filteredItems) {
+        isPendingRequestPublished = YES;
+    }];
+    
+    XCTAssertEqualObjects([searchFilter filteredItemsWithPatterns:@[@"ali"]], (@[@"Alice", @"ALINE"]));
+    
+    // Let the main queue run the pending completions, if any
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    XCTAssertFalse(isPendingRequestPublished);
+}
+
+@end
@@ -0,0 +1,204 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+
+#import <XCTest/XCTest.h>
+
+#import "MatrixKit.h"
+
+/**
+ A session which counts the group summary requests, and lets the test complete them.
+ */
+@interface MXKSessionGroupsDataSourceFakeSession : MXSession
+
+@property (nonatomic) NSArray<MXGroup*> *fakeGroups;
+@property (nonatomic) NSUInteger requestCount;
+@property (nonatomic) NSMutableArray<void (^)(void)> *pendingRequests;
+
+@end
+
+@implementation MXKSessionGroupsDataSourceFakeSession
+
+- (NSArray<MXGroup *> *)groups
+{
+    return _fakeGroups;
+}
+
+- (MXSessionState)state
+{
+    return MXSessionStateRunning;
+}
+
+- (MXHTTPOperation *)updateGroupSummary:(MXGroup *)group success:(void (^)(void))success failure:(void (^)(NSError *))failure
+{
+    _requestCount++;
+    [_pendingRequests addObject:success ?: ^{}];
+    return nil;
+}
+
+- (void)completeRequests
+{
+    // Complete the pending requests, including the ones started by the completion of the others
+    while (_pendingRequests.count)
+    {
+        void (^request)(void) = _pendingRequests.firstObject;
+        [_pendingRequests removeObjectAtIndex:0];
+        request();
+    }
+}
+
+@end
+
+@interface MXKSessionGroupsDataSourceTests : XCTestCase
+{
+    MXKSessionGroupsDataSourceFakeSession *session;
+    MXKSessionGroupsDataSource *dataSource;
+}
+
+@end
+
+@implementation MXKSessionGroupsDataSourceTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+    MXCredentials *credentials = [[MXCredentials alloc] initWithHomeServer:@"https://matrix.org" userId:@"@alice:matrix.org" accessToken:@"token"];
+    MXRestClient *restClient = [[MXRestClient alloc] initWithCredentials:credentials andOnUnrecognizedCertificateBlock:nil];
+    session = [[MXKSessionGroupsDataSourceFakeSession alloc] initWithMatrixRestClient:restClient];
+    session.pendingRequests = [NSMutableArray array];
+    
+    NSMutableArray<MXGroup*> *groups = [NSMutableArray array];
+    for (NSUInteger index = 0; index < 10; index++)
+    {
+        MXGroup *group = [[MXGroup alloc] initWithGroupId:[NSString stringWithFormat:@"+group%tu:matrix.org", index]];
+        group.membership = MXMembershipJoin;
+        [groups addObject:group];
+    }
+    session.fakeGroups = groups;
+    
+    dataSource = [[MXKSessionGroupsDataSource alloc] initWithMatrixSession:session];
+}
+
+- (void)tearDown
+{
+    [dataSource destroy];
+    dataSource = nil;
+    session = nil;
+    
+    [super tearDown];
+}
+
+- (void)testSummaryRequestsAreBounded
+{
+    dataSource.maxConcurrentSummaryRefreshes = 3;
+    [dataSource finalizeInitialization];
+    
+    // Only 3 requests are started for the 10 groups
+    XCTAssertEqual(session.requestCount, 3);
+    XCTAssertEqual(session.pendingRequests.count, 3);
+    
+    // The next ones are started when the previous ones are done
+    [session completeRequests];
+    XCTAssertEqual(session.requestCount, 10);
+}
+
+- (void)testUpToDateSummariesAreSkipped
+{
+    [dataSource finalizeInitialization];
+    [session completeRequests];
+    XCTAssertEqual(session.requestCount, 10);
+    
+    // The summaries have just been refreshed
+    __block BOOL completed = NO;
+    [dataSource refreshGroupsSummary:^{
+        completed = YES;
+    }];
+    XCTAssertTrue(completed);
+    XCTAssertEqual(session.requestCount, 10);
+    
+    // They are refreshed again once they are stale
+    dataSource.summaryStalenessInterval = 0;
+    completed = NO;
+    [dataSource refreshGroupsSummary:^{
+        completed = YES;
+    }];
+    XCTAssertFalse(completed);
+    [session completeRequests];
+    XCTAssertTrue(completed);
+    XCTAssertEqual(session.requestCount, 20);
+}
+
+- (void)testConcurrentRefreshesShareTheRequests
+{
+    [dataSource finalizeInitialization];
+    
+    // The summaries are still being refreshed
+    __block NSUInteger completionCount = 0;
+    [dataSource refreshGroupsSummary:^{
+        completionCount++;
+    }];
+    [dataSource refreshGroupsSummary:^{
+        completionCount++;
+    }];
+    
+    [session completeRequests];
+    XCTAssertEqual(session.requestCount, 10);
+    XCTAssertEqual(completionCount, 2);
+}
+
+- (void)testUpdatedGroupsAreSorted
+{
+    [dataSource finalizeInitialization];
+    [session completeRequests];
+    
+    // Rename the first group, and the one after it
+    MXGroup *group0 = session.fakeGroups[0];
+    group0.profile = [[MXGroupProfile alloc] init];
+    group0.profile.name = @"zz";
+    MXGroup *group1 = session.fakeGroups[1];
+    group1.profile = [[MXGroupProfile alloc] init];
+    group1.profile.name = @"group5a";
+    
+    for (MXGroup *group in @[group0, group1])
+    {
+        [[NSNotificationCenter defaultCenter] postNotificationName:kMXSessionDidUpdateGroupSummaryNotification
+                                                            object:session
+                                                          userInfo:@{kMXSessionNotificationGroupKey: group}];
+    }
+    
+    // Wait for the throttled notification of the changes
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Changes notified"];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.6 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [expectation fulfill];
+    });
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    
+    XCTAssertEqual([dataSource numberOfSectionsInTableView:nil], 1);
+    
+    NSMutableArray<NSString*> *groupIds = [NSMutableArray array];
+    for (NSInteger row = 0; row < 10; row++)
+    {
+        [groupIds addObject:[dataSource cellDataAtIndex:[NSIndexPath indexPathForRow:row inSection:dataSource.joinedGroupsSection]].group.groupId];
+    }
+    
+    NSArray<NSString*> *expectedGroupIds = @[@"+group2:matrix.org", @"+group3:matrix.org", @"+group4:matrix.org", @"+group5:matrix.org",
+                                             @"+group1:matrix.org", @"+group6:matrix.org", @"+group7:matrix.org", @"+group8:matrix.org",
+                                             @"+group9:matrix.org", @"+group0:matrix.org"];
+    XCTAssertEqualObjects(groupIds, expectedGroupIds);
+}
+
+@end
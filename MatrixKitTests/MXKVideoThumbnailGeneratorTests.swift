@@ -0,0 +1,162 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+
+import XCTest
+import AVFoundation
+
+@testable import MatrixKit
+
+class MXKVideoThumbnailGeneratorTests: XCTestCase {
+    
+    private var folderURL: URL!
+    private var videoURL: URL!
+    private var generator: MXKVideoThumbnailGenerator!
+    
+    override func setUpWithError() throws {
+        folderURL = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString, isDirectory: true)
+        try FileManager.default.createDirectory(at: folderURL, withIntermediateDirectories: true, attributes: nil)
+        
+        videoURL = folderURL.appendingPathComponent("video.mp4")
+        try writeVideo(to: videoURL, size: CGSize(width: 128, height: 64))
+        
+        generator = MXKVideoThumbnailGenerator(cacheFolderURL: folderURL.appendingPathComponent("cache", isDirectory: true))
+    }
+    
+    override func tearDownWithError() throws {
+        generator = nil
+        try FileManager.default.removeItem(at: folderURL)
+    }
+    
+    // MARK: - Tests
+    
+    func testThumbnailIsCached() throws {
+        let image = try XCTUnwrap(generator.generateThumbnail(from: videoURL, with: CGSize(width: 32, height: 32)))
+        XCTAssertLessThanOrEqual(image.size.width, 32)
+        XCTAssertEqual(generator.generationCount, 1)
+        
+        XCTAssertNotNil(generator.generateThumbnail(from: videoURL, with: CGSize(width: 32, height: 32)))
+        XCTAssertEqual(generator.generationCount, 1)
+        
+        // Another size is another thumbnail
+        XCTAssertNotNil(generator.generateThumbnail(from: videoURL, with: CGSize(width: 64, height: 64)))
+        XCTAssertEqual(generator.generationCount, 2)
+    }
+    
+    func testThumbnailIsCachedOnDisk() throws {
+        XCTAssertNotNil(generator.generateThumbnail(from: videoURL))
+        
+        // A new generator finds the thumbnail stored by the previous one
+        let otherGenerator = MXKVideoThumbnailGenerator(cacheFolderURL: folderURL.appendingPathComponent("cache", isDirectory: true))
+        XCTAssertNotNil(otherGenerator.generateThumbnail(from: videoURL))
+        XCTAssertEqual(otherGenerator.generationCount, 0)
+    }
+    
+    func testDiskCacheKeepsTheMostRecentThumbnails() {
+        let cacheFolderURL = folderURL.appendingPathComponent("smallCache", isDirectory: true)
+        let smallCacheGenerator = MXKVideoThumbnailGenerator(cacheFolderURL: cacheFolderURL, diskCacheSizeLimit: 1)
+        XCTAssertNotNil(smallCacheGenerator.generateThumbnail(from: videoURL, with: CGSize(width: 32, height: 32)))
+        XCTAssertNotNil(smallCacheGenerator.generateThumbnail(from: videoURL, with: CGSize(width: 64, height: 64)))
+        
+        // Only the last stored thumbnail is kept on disk
+        let otherGenerator = MXKVideoThumbnailGenerator(cacheFolderURL: cacheFolderURL, diskCacheSizeLimit: 1)
+        XCTAssertNotNil(otherGenerator.generateThumbnail(from: videoURL, with: CGSize(width: 64, height: 64)))
+        XCTAssertEqual(otherGenerator.generationCount, 0)
+        XCTAssertNotNil(otherGenerator.generateThumbnail(from: videoURL, with: CGSize(width: 32, height: 32)))
+        XCTAssertEqual(otherGenerator.generationCount, 1)
+    }
+    
+    func testFailedGenerationIsNotCounted() {
+        let missingVideoURL = folderURL.appendingPathComponent("missing.mp4")
+        XCTAssertNil(generator.generateThumbnail(from: missingVideoURL))
+        XCTAssertEqual(generator.generationCount, 0)
+    }
+    
+    func testConcurrentRequestsAreDeduplicated() {
+        let expectation = self.expectation(description: "Thumbnails")
+        expectation.expectedFulfillmentCount = 3
+        
+        for _ in 0..<3 {
+            generator.generateThumbnail(from: videoURL, with: CGSize(width: 32, height: 32)) { image in
+                XCTAssertTrue(Thread.isMainThread)
+                XCTAssertNotNil(image)
+                expectation.fulfill()
+            }
+        }
+        
+        waitForExpectations(timeout: 10)
+        XCTAssertEqual(generator.generationCount, 1)
+    }
+    
+    func testCancelledRequestIsNotCompleted() {
+        let cancelledRequest = generator.generateThumbnail(from: videoURL, with: .zero) { _ in
+            XCTFail("A cancelled request must not be completed")
+        }
+        
+        let expectation = self.expectation(description: "Thumbnail")
+        generator.generateThumbnail(from: videoURL, with: .zero) { image in
+            XCTAssertNotNil(image)
+            expectation.fulfill()
+        }
+        cancelledRequest.cancel()
+        
+        waitForExpectations(timeout: 10)
+        XCTAssertTrue(cancelledRequest.isCancelled)
+    }
+    
+    // MARK: - Private
+    
+    /// Write a one second video of a plain color.
+    private func writeVideo(to url: URL, size: CGSize) throws {
+        let writer = try AVAssetWriter(outputURL: url, fileType: .mp4)
+        let input = AVAssetWriterInput(mediaType: .video, outputSettings: [
+            AVVideoCodecKey: AVVideoCodecType.h264,
+            AVVideoWidthKey: size.width,
+            AVVideoHeightKey: size.height
+        ])
+        let adaptor = AVAssetWriterInputPixelBufferAdaptor(assetWriterInput: input, sourcePixelBufferAttributes: [
+            kCVPixelBufferPixelFormatTypeKey as String: kCVPixelFormatType_32ARGB,
+            kCVPixelBufferWidthKey as String: size.width,
+            kCVPixelBufferHeightKey as String: size.height
+        ])
+        writer.add(input)
+        writer.startWriting()
+        writer.startSession(atSourceTime: .zero)
+        
+        for frame in 0..<2 {
+            var pixelBuffer: CVPixelBuffer?
+            CVPixelBufferCreate(kCFAllocatorDefault, Int(size.width), Int(size.height), kCVPixelFormatType_32ARGB, nil, &pixelBuffer)
+            let buffer = try XCTUnwrap(pixelBuffer)
+            
+            CVPixelBufferLockBaseAddress(buffer, [])
+            memset(CVPixelBufferGetBaseAddress(buffer), 0x80, CVPixelBufferGetDataSize(buffer))
+            CVPixelBufferUnlockBaseAddress(buffer, [])
+            
+            while !input.isReadyForMoreMediaData {
+                Thread.sleep(forTimeInterval: 0.01)
+            }
+            adaptor.append(buffer, withPresentationTime: CMTime(value: CMTimeValue(frame), timescale: 1))
+        }
+        
+        input.markAsFinished()
+        let finished = expectation(description: "Video written")
+        writer.finishWriting {
+            finished.fulfill()
+        }
+        wait(for: [finished], timeout: 10)
+        XCTAssertEqual(writer.status, .completed)
+    }
+}
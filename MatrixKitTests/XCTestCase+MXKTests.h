@@ -0,0 +1,39 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+#import <UIKit/UIKit.h>
+
+@interface XCTestCase (MXKTests)
+
+/**
+ Draw a two-color test image with a scale of 1.
+
+ @param size the size of the bitmap in pixels.
+ @param orientation the orientation of the returned image.
+ @return the image.
+ */
+- (UIImage*)mxk_imageWithPixelSize:(CGSize)size orientation:(UIImageOrientation)orientation;
+
+/**
+ Measure the duration and the memory use of a block, or only its duration before iOS 13.
+ The block is run in an autorelease pool.
+
+ @param block the measured block.
+ */
+- (void)mxk_measureClockAndMemoryOfBlock:(void (^)(void))block;
+
+@end
@@ -0,0 +1,55 @@
+/*
+ Copyright 2021 The Matrix.org Foundation C.I.C
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#import "XCTestCase+MXKTests.h"
+
+@implementation XCTestCase (MXKTests)
+
+- (UIImage*)mxk_imageWithPixelSize:(CGSize)size orientation:(UIImageOrientation)orientation
+{
+    UIGraphicsImageRendererFormat *format = [UIGraphicsImageRendererFormat defaultFormat];
+    format.scale = 1;
+    format.opaque = YES;
+    UIGraphicsImageRenderer *renderer = [[UIGraphicsImageRenderer alloc] initWithSize:size format:format];
+    UIImage *image = [renderer imageWithActions:^(UIGraphicsImageRendererContext *context) {
+        [[UIColor greenColor] setFill];
+        [context fillRect:CGRectMake(0, 0, size.width, size.height)];
+        [[UIColor purpleColor] setFill];
+        [context fillRect:CGRectMake(0, 0, size.width / 3, size.height / 5)];
+    }];
+    return [UIImage imageWithCGImage:image.CGImage scale:1 orientation:orientation];
+}
+
+- (void)mxk_measureClockAndMemoryOfBlock:(void (^)(void))block
+{
+    void (^measuredBlock)(void) = ^{
+        @autoreleasepool
+        {
+            block();
+        }
+    };
+    
+    if (@available(iOS 13.0, *))
+    {
+        [self measureWithMetrics:@[[[XCTClockMetric alloc] init], [[XCTMemoryMetric alloc] init]] block:measuredBlock];
+    }
+    else
+    {
+        [self measureBlock:measuredBlock];
+    }
+}
+
+@end